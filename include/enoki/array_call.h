@@ -11,9 +11,92 @@
 #pragma once
 
 #include <enoki/array_generic.h>
+#include <atomic>
 
 NAMESPACE_BEGIN(enoki)
 
+/// Lane utilization statistics of vectorized method calls
+struct CallStatistics {
+    /// Number of method calls dispatched over arrays of pointers
+    size_t calls = 0;
+    /// Number of times that a method of an individual instance was invoked
+    size_t instances = 0;
+    /// Number of instance invocations using masked full-width execution
+    size_t masked = 0;
+    /// Number of instance invocations using compacted sub-batches
+    size_t compacted = 0;
+    /// Number of lanes that were active in the instance invocations
+    size_t lanes_active = 0;
+    /// Number of lanes processed by the instance invocations
+    size_t lanes_processed = 0;
+
+    /// Fraction of processed lanes that were active
+    float utilization() const {
+        return lanes_processed == 0 ? 1.f : float(lanes_active) / float(lanes_processed);
+    }
+};
+
+NAMESPACE_BEGIN(detail)
+struct call_state {
+    std::atomic<float> threshold { .5f };
+    std::atomic<bool> stats_enabled { false };
+    std::atomic<size_t> calls { 0 }, instances { 0 }, masked { 0 },
+                        compacted { 0 }, lanes_active { 0 }, lanes_processed { 0 };
+
+    void record(bool compacted_, size_t lanes_active_, size_t lanes_processed_) {
+        instances.fetch_add(1, std::memory_order_relaxed);
+        (compacted_ ? compacted : masked).fetch_add(1, std::memory_order_relaxed);
+        lanes_active.fetch_add(lanes_active_, std::memory_order_relaxed);
+        lanes_processed.fetch_add(lanes_processed_, std::memory_order_relaxed);
+    }
+};
+
+inline call_state call_state_global;
+NAMESPACE_END(detail)
+
+/**
+ * \brief Set the threshold for compacted method calls on dynamic arrays
+ *
+ * When an instance covers fewer than <tt>threshold * size</tt> entries of a
+ * dynamic array of pointers, its active entries are gathered into dense
+ * temporary arrays, and the results are scattered back. Otherwise, the method
+ * processes the full arrays with a sparse mask. A value of 0 always selects
+ * masked execution, and values greater than 1 always select compaction.
+ */
+inline void call_set_compaction_threshold(float value) {
+    detail::call_state_global.threshold.store(value, std::memory_order_relaxed);
+}
+
+/// Return the threshold for compacted method calls on dynamic arrays
+inline float call_compaction_threshold() {
+    return detail::call_state_global.threshold.load(std::memory_order_relaxed);
+}
+
+/// Enable or disable the collection of \ref CallStatistics (disabled by default)
+inline void call_set_stats_enabled(bool value) {
+    detail::call_state_global.stats_enabled.store(value, std::memory_order_relaxed);
+}
+
+/// Return the statistics accumulated since the last \ref call_stats_reset()
+inline CallStatistics call_stats() {
+    auto &s = detail::call_state_global;
+    CallStatistics result;
+    result.calls           = s.calls.load(std::memory_order_relaxed);
+    result.instances       = s.instances.load(std::memory_order_relaxed);
+    result.masked          = s.masked.load(std::memory_order_relaxed);
+    result.compacted       = s.compacted.load(std::memory_order_relaxed);
+    result.lanes_active    = s.lanes_active.load(std::memory_order_relaxed);
+    result.lanes_processed = s.lanes_processed.load(std::memory_order_relaxed);
+    return result;
+}
+
+/// Reset the method call statistics
+inline void call_stats_reset() {
+    auto &s = detail::call_state_global;
+    s.calls = 0; s.instances = 0; s.masked = 0;
+    s.compacted = 0; s.lanes_active = 0; s.lanes_processed = 0;
+}
+
 template <typename Class, typename Storage> struct call_support {
     call_support(const Storage &) { }
 };
@@ -133,61 +216,92 @@ template <typename Storage_> struct call_support_base {
             std::get<Indices>(tuple)...
         ));
 
-        if constexpr (!std::is_void_v<FuncResult>) {
-            using Result = typename vectorize_result<Mask, FuncResult>::type;
-            Result result = zero<Result>(self.size());
+        constexpr bool IsVoid = std::is_void_v<FuncResult>;
+        using Result = typename vectorize_result<
+            Mask, std::conditional_t<IsVoid, bool, FuncResult>>::type;
+
+        call_state &state = call_state_global;
+        bool stats = state.stats_enabled.load(std::memory_order_relaxed);
+        if (stats)
+            state.calls.fetch_add(1, std::memory_order_relaxed);
+
+        Result result;
+        if constexpr (!IsVoid)
+            result = zero<Result>(self.size());
+
+        if constexpr (!is_cuda_array_v<Storage> && !is_dynamic_array_v<Storage>) {
+            while (any(mask)) {
+                InstancePtr value = extract(self, mask);
+                Mask active       = mask & eq(self, value);
+                mask              = andnot(mask, active);
+
+                if (stats) {
+                    using IntMask = mask_t<uint_array_t<array_t<Storage>, false>>;
+                    state.record(false, count(reinterpret_array<IntMask>(active)),
+                                 Storage::Size);
+                }
 
-            if constexpr (!is_cuda_array_v<Storage>) {
-                while (any(mask)) {
-                    InstancePtr value      = extract(self, mask);
-                    Mask active            = mask & eq(self, value);
-                    mask                   = andnot(mask, active);
+                if constexpr (!IsVoid)
                     masked(result, active) = func(value, active, std::get<Indices>(tuple)...);
-                }
+                else
+                    func(value, active, std::get<Indices>(tuple)...);
+            }
+        } else {
+            auto partitioned = partition(self & mask);
+
+            if (partitioned.size() == 1 && partitioned[0].first != nullptr) {
+                if (stats)
+                    state.record(false, self.size(), self.size());
+
+                if constexpr (!IsVoid)
+                    result = func(partitioned[0].first, true, std::get<Indices>(tuple)...);
+                else
+                    func(partitioned[0].first, true, std::get<Indices>(tuple)...);
             } else {
-                auto partitioned = partition(self & mask);
-
-                if (partitioned.size() == 1 && partitioned[0].first != nullptr) {
-                    result = func(partitioned[0].first, true,
-                                  std::get<Indices>(tuple)...);
-                } else {
-                    for (auto [value, permutation] : partitioned) {
-                        if (value == nullptr)
+                float threshold = state.threshold.load(std::memory_order_relaxed);
+
+                for (auto [value, permutation] : partitioned) {
+                    if (value == nullptr)
+                        continue;
+
+                    size_t active_count = permutation.size(),
+                           total_count  = self.size();
+
+                    /* Coherent instance: process the full arrays with a sparse
+                       mask instead of compacting the active entries */
+                    if constexpr (!is_cuda_array_v<Storage>) {
+                        if ((float) active_count >= threshold * (float) total_count) {
+                            if (stats)
+                                state.record(false, active_count, total_count);
+
+                            Mask active = mask & eq(self, value);
+                            if constexpr (!IsVoid)
+                                masked(result, active) =
+                                    func(value, active, std::get<Indices>(tuple)...);
+                            else
+                                func(value, active, std::get<Indices>(tuple)...);
                             continue;
+                        }
+                    }
 
+                    if (stats)
+                        state.record(true, active_count, active_count);
+
+                    if constexpr (!IsVoid) {
                         Result temp = func(value, true, gather_helper(
                              std::get<Indices>(tuple), permutation)...);
 
                         scatter<0, true, true>(result, temp, permutation);
-                    }
-                }
-            }
-
-            return result;
-        } else {
-            if constexpr (!is_cuda_array_v<Storage>) {
-                while (any(mask)) {
-                    InstancePtr value = extract(self, mask);
-                    Mask active       = mask & eq(self, value);
-                    mask              = andnot(mask, active);
-                    func(value, active, std::get<Indices>(tuple)...);
-                }
-            } else {
-                auto partitioned = partition(self & mask);
-
-                if (partitioned.size() == 1 && partitioned[0].first != nullptr) {
-                    func(partitioned[0].first, true, std::get<Indices>(tuple)...);
-                } else {
-                    for (auto [value, permutation] : partitioned) {
-                        if (value == nullptr)
-                            continue;
-
+                    } else {
                         func(value, true, gather_helper(
                              std::get<Indices>(tuple), permutation)...);
                     }
                 }
             }
         }
+
+        if constexpr (!IsVoid)
+            return result;
     }
 };
 
@@ -127,7 +127,7 @@ ENOKI_INLINE T poly10(const T1 &x, const T2 &c0, const T2 &c1, const T2 &c2,
             return E(name(low(x)), name(high(x)));                             \
         } else if constexpr (is_dynamic_array_v<E> &&                          \
                             !is_diff_array_v<E> &&                             \
-                            !is_cuda_array_v<E>) {                             \
+                            !is_jit_array_v<E>) {                             \
             E r = empty<E>(x.size());                                          \
             auto pr = r.packet_ptr();                                          \
             auto px = x.packet_ptr();                                          \
@@ -171,7 +171,7 @@ ENOKI_INLINE T poly10(const T1 &x, const T2 &c0, const T2 &c1, const T2 &c2,
             return std::pair<E, E>(E(l.first, h.first),                        \
                                    E(l.second, h.second));                     \
         } else if constexpr (is_dynamic_array_v<E> &&                          \
-                            !is_cuda_array_v<E> &&                             \
+                            !is_jit_array_v<E> &&                             \
                             !is_diff_array_v<E>) {                             \
             std::pair<E, E> r(empty<E>(x.size()), empty<E>(x.size()));         \
             auto pr0 = r.first.packet_ptr(),                                   \
@@ -222,7 +222,7 @@ ENOKI_INLINE T poly10(const T1 &x, const T2 &c0, const T2 &c1, const T2 &c2,
                              !std::is_same_v<T2, E>) {                         \
             return name((const E& ) x, (const E &) y);                         \
         } else if constexpr (is_dynamic_array_v<E> &&                          \
-                            !is_cuda_array_v<E> &&                             \
+                            !is_jit_array_v<E> &&                             \
                             !is_diff_array_v<E>) {                             \
             E r;                                                               \
             r.resize_like(x, y);                                               \
@@ -507,10 +507,10 @@ ENOKI_UNARY_OPERATION(asin, std::asin(x)) {
 
         r = select(mask_big, Scalar(M_PI_2) - (z1 + z1), z1);
     } else {
-        constexpr bool IsCuda = is_cuda_array_v<Value>;
+        constexpr bool IsJIT = is_jit_array_v<Value>;
         Mask mask_big = xa > Scalar(0.625);
 
-        if (IsCuda || any_nested(mask_big)) {
+        if (IsJIT || any_nested(mask_big)) {
             const Scalar pio4 = Scalar(0.78539816339744830962);
             const Scalar more_bits = Scalar(6.123233995736765886130e-17);
 
@@ -531,7 +531,7 @@ ENOKI_UNARY_OPERATION(asin, std::asin(x)) {
             r[mask_big] = z - fmsub(zz, p, more_bits) + pio4;
         }
 
-        if (IsCuda || !all_nested(mask_big)) {
+        if (IsJIT || !all_nested(mask_big)) {
             Value z = poly5(x2, -8.198089802484824371615e0,
                                  1.956261983317594739197e1,
                                 -1.626247967210700244449e1,
@@ -835,11 +835,11 @@ ENOKI_UNARY_OPERATION(log, std::log(x)) {
         z = fmadd(z, Scalar(-0.5), xm + y);
         r = fmadd(e, Scalar(0.693359375), z);
     } else {
-        constexpr bool IsCuda = is_cuda_array_v<Value>;
+        constexpr bool IsJIT = is_jit_array_v<Value>;
         const Scalar half = Scalar(0.5);
         Value r_big, r_small;
 
-        if (IsCuda || any_nested(mask_e_big)) {
+        if (IsJIT || any_nested(mask_e_big)) {
             /* logarithm using log(x) = z + z**3 P(z)/Q(z), where z = 2(x-1)/x+1) */
             Value z = xm - half;
 
@@ -860,7 +860,7 @@ ENOKI_UNARY_OPERATION(log, std::log(x)) {
             r_big = fnmadd(e, Scalar(2.121944400546905827679e-4), z) + x2;
         }
 
-        if (IsCuda || !all_nested(mask_e_big)) {
+        if (IsJIT || !all_nested(mask_e_big)) {
             /* logarithm using log(1+x) = x - .5x**2 + x**3 P(x)/Q(x) */
             Value x2 = select(mask_ge_inv_sqrt2, xm, xm + xm) - Scalar(1);
 
@@ -1007,21 +1007,21 @@ ENOKI_UNARY_OPERATION(sinh, std::sinh(x)) {
          (at x=-9.69866)
     */
 
-    constexpr bool IsCuda = is_cuda_array_v<Value>;
+    constexpr bool IsJIT = is_jit_array_v<Value>;
 
     Value xa = abs(x),
           r_small, r_big;
 
     Mask mask_big = xa > Scalar(1);
 
-    if (IsCuda || any_nested(mask_big)) {
+    if (IsJIT || any_nested(mask_big)) {
         Value exp0 = exp(x),
               exp1 = rcp(exp0);
 
         r_big = (exp0 - exp1) * Scalar(0.5);
     }
 
-    if (IsCuda || !all_nested(mask_big)) {
+    if (IsJIT || !all_nested(mask_big)) {
         Value x2 = x * x;
 
         if constexpr (Single) {
@@ -1087,7 +1087,7 @@ ENOKI_UNARY_OPERATION_PAIR(sincosh, std::make_pair(std::sinh(x), std::cosh(x)))
          (at x=-9.70164)
     */
 
-    constexpr bool IsCuda = is_cuda_array_v<Value>;
+    constexpr bool IsJIT = is_jit_array_v<Value>;
 
     const Scalar half = Scalar(0.5);
 
@@ -1099,7 +1099,7 @@ ENOKI_UNARY_OPERATION_PAIR(sincosh, std::make_pair(std::sinh(x), std::cosh(x)))
 
     Mask mask_big = xa > Scalar(1);
 
-    if (IsCuda || !all_nested(mask_big)) {
+    if (IsJIT || !all_nested(mask_big)) {
         Value x2 = x * x;
 
         if constexpr (Single) {
@@ -1141,13 +1141,13 @@ ENOKI_UNARY_OPERATION(tanh, std::tanh(x)) {
          (at x=-2.12867)
     */
 
-    constexpr bool IsCuda = is_cuda_array_v<Value>;
+    constexpr bool IsJIT = is_jit_array_v<Value>;
 
     Value r_big, r_small;
 
     Mask mask_big = abs(x) >= Scalar(0.625);
 
-    if (IsCuda || !all_nested(mask_big)) {
+    if (IsJIT || !all_nested(mask_big)) {
         Value x2 = x*x;
 
         if constexpr (Single) {
@@ -1169,7 +1169,7 @@ ENOKI_UNARY_OPERATION(tanh, std::tanh(x)) {
         r_small = fmadd(r_small, x2 * x, x);
     }
 
-    if (IsCuda || any_nested(mask_big)) {
+    if (IsJIT || any_nested(mask_big)) {
         Value e  = exp(x + x),
               e2 = rcp(e + Scalar(1));
         r_big = Scalar(1) - (e2 + e2);
@@ -1197,7 +1197,7 @@ ENOKI_UNARY_OPERATION(asinh, std::asinh(x)) {
          (at x=-1.17457)
     */
 
-    constexpr bool IsCuda = is_cuda_array_v<Value>;
+    constexpr bool IsJIT = is_jit_array_v<Value>;
 
     Value x2 = x*x,
           xa = abs(x),
@@ -1206,7 +1206,7 @@ ENOKI_UNARY_OPERATION(asinh, std::asinh(x)) {
     Mask mask_big  = xa >= Scalar(Single ? 0.51 : 0.533),
          mask_huge = xa >= Scalar(Single ? 1e10 : 1e20);
 
-    if (IsCuda || !all_nested(mask_big)) {
+    if (IsJIT || !all_nested(mask_big)) {
         if constexpr (Single) {
             r_small = poly3(x2, -1.6666288134e-1,
                                  7.4847586088e-2,
@@ -1227,7 +1227,7 @@ ENOKI_UNARY_OPERATION(asinh, std::asinh(x)) {
         r_small = fmadd(r_small, x2 * x, x);
     }
 
-    if (IsCuda || any_nested(mask_big)) {
+    if (IsJIT || any_nested(mask_big)) {
         r_big = log(xa + (sqrt(x2 + Scalar(1)) & ~mask_huge));
         r_big[mask_huge] += Scalar(M_LN2);
         r_big = copysign(r_big, x);
@@ -1251,7 +1251,7 @@ ENOKI_UNARY_OPERATION(acosh, std::acosh(x)) {
          (at x=1.02974)
     */
 
-    constexpr bool IsCuda = is_cuda_array_v<Value>;
+    constexpr bool IsJIT = is_jit_array_v<Value>;
 
     Value x1 = x - Scalar(1),
          r_big, r_small;
@@ -1259,7 +1259,7 @@ ENOKI_UNARY_OPERATION(acosh, std::acosh(x)) {
     Mask mask_big  = x1 >= Scalar(0.49),
          mask_huge = x1 >= Scalar(1e10);
 
-    if (IsCuda || !all_nested(mask_big)) {
+    if (IsJIT || !all_nested(mask_big)) {
         if constexpr (Single) {
             r_small = poly4(x1,  1.4142135263e+0,
                                 -1.1784741703e-1,
@@ -1284,7 +1284,7 @@ ENOKI_UNARY_OPERATION(acosh, std::acosh(x)) {
         r_small |= x1 < zero<Value>();
     }
 
-    if (IsCuda || any_nested(mask_big)) {
+    if (IsJIT || any_nested(mask_big)) {
         r_big = log(x + (sqrt(fmsub(x, x, Scalar(1))) & ~mask_huge));
         r_big[mask_huge] += Scalar(M_LN2);
     }
@@ -1308,14 +1308,14 @@ ENOKI_UNARY_OPERATION(atanh, std::atanh(x)) {
          (at x=-0.998962)
     */
 
-    constexpr bool IsCuda = is_cuda_array_v<Value>;
+    constexpr bool IsJIT = is_jit_array_v<Value>;
 
     Value xa = abs(x),
           r_big, r_small;
 
     Mask mask_big  = xa >= Scalar(0.5);
 
-    if (IsCuda || !all_nested(mask_big)) {
+    if (IsJIT || !all_nested(mask_big)) {
         Value x2 = x*x;
         if constexpr (Single) {
             r_small = poly4(x2, 3.33337300303e-1,
@@ -1339,7 +1339,7 @@ ENOKI_UNARY_OPERATION(atanh, std::atanh(x)) {
         r_small = fmadd(r_small, x2*x, x);
     }
 
-    if (IsCuda || any_nested(mask_big)) {
+    if (IsJIT || any_nested(mask_big)) {
         r_big = log((Scalar(1) + xa) / (Scalar(1) - xa)) * Scalar(0.5);
         r_big = copysign(r_big, x);
     }
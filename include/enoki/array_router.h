@@ -364,7 +364,8 @@ ENOKI_INLINE Expr sign(const T &a) {
         return result;
     } else if constexpr (!std::is_signed_v<Scalar>) {
         return Expr(Scalar(1));
-    } else if constexpr (!std::is_floating_point_v<Scalar> || is_diff_array_v<Expr>) {
+    } else if constexpr (!std::is_floating_point_v<Scalar> || is_diff_array_v<Expr> ||
+                         is_dual_array_v<Expr>) {
         return select(a < Scalar(0), Expr(Scalar(-1)), Expr(Scalar(1)));
     } else if constexpr (is_scalar_v<Expr>) {
         return std::copysign(Scalar(1), a);
@@ -392,7 +393,7 @@ ENOKI_INLINE Expr copysign(const T1 &a1, const T2 &a2) {
         return select((a1 ^ a2) < Scalar1(0), a1, -a1);
     } else if constexpr (is_scalar_v<Expr>) {
         return std::copysign(a1, a2);
-    } else if constexpr (is_diff_array_v<Expr>) {
+    } else if constexpr (is_diff_array_v<Expr> || is_dual_array_v<Expr>) {
         return abs(a1) * sign(a2);
     } else {
         return abs(a1) | (sign_mask<Expr>() & a2);
@@ -418,7 +419,7 @@ ENOKI_INLINE Expr copysign_neg(const T1 &a1, const T2 &a2) {
         return select((a1 ^ a2) < Scalar1(0), -a1, a1);
     } else if constexpr (is_scalar_v<Expr>) {
         return std::copysign(a1, -a2);
-    } else if constexpr (is_diff_array_v<Expr>) {
+    } else if constexpr (is_diff_array_v<Expr> || is_dual_array_v<Expr>) {
         return abs(a1) * -sign(a2);
     } else {
         return abs(a1) | andnot(sign_mask<Expr>(), a2);
@@ -444,7 +445,7 @@ ENOKI_INLINE Expr mulsign(const T1 &a1, const T2 &a2) {
         return select(a2 < Scalar1(0), -a1, a1);
     } else if constexpr (is_scalar_v<Expr>) {
         return a1 * std::copysign(Scalar1(1), a2);
-    } else if constexpr (is_diff_array_v<Expr>) {
+    } else if constexpr (is_diff_array_v<Expr> || is_dual_array_v<Expr>) {
         return a1 * sign(a2);
     } else {
         return a1 ^ (sign_mask<Expr>() & a2);
@@ -470,7 +471,7 @@ ENOKI_INLINE Expr mulsign_neg(const T1 &a1, const T2 &a2) {
         return select(a2 < Scalar1(0), a1, -a1);
     } else if constexpr (is_scalar_v<Expr>) {
         return a1 * std::copysign(Scalar1(1), -a2);
-    } else if constexpr (is_diff_array_v<Expr>) {
+    } else if constexpr (is_diff_array_v<Expr> || is_dual_array_v<Expr>) {
         return a1 * -sign(a2);
     } else {
         return a1 ^ andnot(sign_mask<Expr>(), a2);
@@ -687,7 +688,7 @@ ENOKI_INLINE auto cross(const T1 &v1, const T2 &v2) {
 
 template <typename T> decltype(auto) detach(T &value) {
     if constexpr (is_array_v<T>) {
-        if constexpr (!is_diff_array_v<T>)
+        if constexpr (!is_diff_array_v<T> && !is_dual_array_v<T>)
             return value;
         else if constexpr (array_depth_v<T> == 1)
             return value.value_();
@@ -967,13 +968,17 @@ extern ENOKI_IMPORT void cuda_set_scatter_gather_operand(uint32_t index, bool ga
 extern ENOKI_IMPORT void cuda_set_log_level(uint32_t);
 extern ENOKI_IMPORT uint32_t cuda_log_level();
 
+/* Documentation in 'cpu.h' */
+extern ENOKI_IMPORT void cpu_var_mark_dirty(uint32_t);
+extern ENOKI_IMPORT void cpu_set_scatter_gather_operand(uint32_t index, bool gather = false);
+
 /// Fancy templated 'printf', which extracts the indices of Enoki arrays
 template <typename... Args> void cuda_printf(const char *fmt, const Args&... args) {
     uint32_t indices[] = { args.index()..., 0 };
     cuda_trace_printf(fmt, (uint32_t) sizeof...(Args), indices);
 }
 
-template <typename T, enable_if_t<!is_diff_array_v<T> && !is_cuda_array_v<T>> = 0>
+template <typename T, enable_if_t<!is_diff_array_v<T> && !is_jit_array_v<T>> = 0>
 ENOKI_INLINE void set_label(T&, const char *) { }
 
 
@@ -1324,46 +1329,46 @@ bool allclose(const T1 &a, const T2 &b, float rtol = 1e-5f, float atol = 1e-8f,
 
 // -----------------------------------------------------------------------
 //! @{ \name Reduction operators that return a default argument when
-//           invoked using CUDA arrays
+//           invoked using JIT-compiled (CUDA, CPU) arrays
 // -----------------------------------------------------------------------
 
 template <bool Default, typename T> auto any_or(const T &value) {
-    if constexpr (is_cuda_array_v<T>)
+    if constexpr (is_jit_array_v<T>)
         return Default;
     else
         return any(value);
 }
 
 template <bool Default, typename T> auto any_nested_or(const T &value) {
-    if constexpr (is_cuda_array_v<T>)
+    if constexpr (is_jit_array_v<T>)
         return Default;
     else
         return any_nested(value);
 }
 
 template <bool Default, typename T> auto none_or(const T &value) {
-    if constexpr (is_cuda_array_v<T>)
+    if constexpr (is_jit_array_v<T>)
         return Default;
     else
         return none(value);
 }
 
 template <bool Default, typename T> auto none_nested_or(const T &value) {
-    if constexpr (is_cuda_array_v<T>)
+    if constexpr (is_jit_array_v<T>)
         return Default;
     else
         return none_nested(value);
 }
 
 template <bool Default, typename T> auto all_or(const T &value) {
-    if constexpr (is_cuda_array_v<T>)
+    if constexpr (is_jit_array_v<T>)
         return Default;
     else
         return all(value);
 }
 
 template <bool Default, typename T> auto all_nested_or(const T &value) {
-    if constexpr (is_cuda_array_v<T>)
+    if constexpr (is_jit_array_v<T>)
         return Default;
     else
         return all_nested(value);
@@ -1209,7 +1209,7 @@ public:
     }
 
     ENOKI_INLINE Derived& eval() {
-        if constexpr (is_cuda_array_v<Value_>) {
+        if constexpr (is_jit_array_v<Value_>) {
             for (size_t i = 0; i < Derived::Size; ++i)
                 derived().coeff(i).eval();
         }
@@ -1217,7 +1217,7 @@ public:
     }
 
     ENOKI_INLINE const Derived& eval() const {
-        if constexpr (is_cuda_array_v<Value_>) {
+        if constexpr (is_jit_array_v<Value_>) {
             for (size_t i = 0; i < Derived::Size; ++i)
                 derived().coeff(i).eval();
         }
@@ -25,6 +25,8 @@ ENOKI_INLINE Array gather(const Source &source, const Index &index,
                 cuda_set_scatter_gather_operand(source.value_().index_(), true);
         } else if constexpr (is_cuda_array_v<Source>) {
             cuda_set_scatter_gather_operand(source.index_(), true);
+        } else if constexpr (is_jit_array_v<Source>) {
+            cpu_set_scatter_gather_operand(source.index_(), true);
         }
 
         Array result = gather<Array, Stride, Packed>(source.data(), index, mask);
@@ -35,6 +37,8 @@ ENOKI_INLINE Array gather(const Source &source, const Index &index,
                 cuda_set_scatter_gather_operand(0);
         } else if constexpr (is_cuda_array_v<Source>) {
             cuda_set_scatter_gather_operand(0);
+        } else if constexpr (is_jit_array_v<Source>) {
+            cpu_set_scatter_gather_operand(0);
         }
 
        return result;
@@ -69,6 +73,8 @@ ENOKI_INLINE void scatter(Target &target,
                 cuda_set_scatter_gather_operand(target.value_().index_());
         } else if constexpr (is_cuda_array_v<Target>) {
             cuda_set_scatter_gather_operand(target.index_());
+        } else if constexpr (is_jit_array_v<Target>) {
+            cpu_set_scatter_gather_operand(target.index_());
         }
 
         scatter<Stride, Packed>(target.data(), value, index, mask);
@@ -82,6 +88,9 @@ ENOKI_INLINE void scatter(Target &target,
         } else if constexpr (is_cuda_array_v<Target>) {
             cuda_var_mark_dirty(target.index_());
             cuda_set_scatter_gather_operand(0);
+        } else if constexpr (is_jit_array_v<Target>) {
+            cpu_var_mark_dirty(target.index_());
+            cpu_set_scatter_gather_operand(0);
         }
     } else {
         struct_support_t<Target>::scatter(target, value, index, mask);
@@ -103,6 +112,8 @@ ENOKI_INLINE void scatter_add(Target &target,
                 cuda_set_scatter_gather_operand(target.value_().index_());
         } else if constexpr (is_cuda_array_v<Target>) {
             cuda_set_scatter_gather_operand(target.index_());
+        } else if constexpr (is_jit_array_v<Target>) {
+            cpu_set_scatter_gather_operand(target.index_());
         }
 
         scatter_add<Stride>(target.data(), value, index, mask);
@@ -116,6 +127,9 @@ ENOKI_INLINE void scatter_add(Target &target,
         } else if constexpr (is_cuda_array_v<Target>) {
             cuda_var_mark_dirty(target.index_());
             cuda_set_scatter_gather_operand(0);
+        } else if constexpr (is_jit_array_v<Target>) {
+            cpu_var_mark_dirty(target.index_());
+            cpu_set_scatter_gather_operand(0);
         }
     } else {
         struct_support_t<Target>::scatter_add(target, value, index, mask);
@@ -293,7 +307,7 @@ struct struct_support<T, enable_if_static_array_t<T>> {
 
     template <typename T2>
     static ENOKI_INLINE decltype(auto) detach(T2 &value) {
-        if constexpr (!is_diff_array_v<T>)
+        if constexpr (!is_diff_array_v<T> && !is_dual_array_v<T>)
             return value;
         else
             return detach(value, std::make_index_sequence<Size>());
@@ -224,6 +224,18 @@ template <typename T> struct is_diff_array<T, enable_if_array_t<T>> {
 template <typename T> constexpr bool is_diff_array_v = is_diff_array<T>::value;
 template <typename T> using enable_if_diff_array_t = enable_if_t<is_diff_array_v<T>>;
 
+/// Does this array propagate derivatives using dual numbers?
+template <typename T, typename = int> struct is_dual_array {
+    static constexpr bool value = false;
+};
+
+template <typename T> struct is_dual_array<T, enable_if_array_t<T>> {
+    static constexpr bool value = std::decay_t<T>::Derived::IsDual;
+};
+
+template <typename T> constexpr bool is_dual_array_v = is_dual_array<T>::value;
+template <typename T> using enable_if_dual_array_t = enable_if_t<is_dual_array_v<T>>;
+
 /// Does this array reside on the GPU (via CUDA)?
 template <typename T, typename = int> struct is_cuda_array {
     static constexpr bool value = false;
@@ -236,6 +248,18 @@ template <typename T> struct is_cuda_array<T, enable_if_array_t<T>> {
 template <typename T> constexpr bool is_cuda_array_v = is_cuda_array<T>::value;
 template <typename T> using enable_if_cuda_t = enable_if_t<is_cuda_array_v<T>>;
 
+/// Is this array traced and compiled lazily by a JIT backend (CUDA, CPU)?
+template <typename T, typename = int> struct is_jit_array {
+    static constexpr bool value = false;
+};
+
+template <typename T> struct is_jit_array<T, enable_if_array_t<T>> {
+    static constexpr bool value = std::decay_t<T>::Derived::IsJIT;
+};
+
+template <typename T> constexpr bool is_jit_array_v = is_jit_array<T>::value;
+template <typename T> using enable_if_jit_t = enable_if_t<is_jit_array_v<T>>;
+
 /// Determine the depth of a nested Enoki array (scalars evaluate to zero)
 template <typename T, typename = int> struct array_depth {
     static constexpr size_t value = 0;
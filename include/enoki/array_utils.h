@@ -22,7 +22,7 @@ NAMESPACE_BEGIN(enoki)
 /// Analagous to meshgrid() in NumPy or MATLAB; for dynamic arrays
 template <typename T, enable_if_dynamic_array_t<T> = 0>
 Array<T, 2> meshgrid(const T &x, const T &y) {
-    if constexpr (is_cuda_array_v<T> || is_diff_array_v<T>) {
+    if constexpr (is_jit_array_v<T> || is_diff_array_v<T>) {
         x.eval(); y.eval();
 
         if (x.size() == 1) {
@@ -14,15 +14,303 @@
 #pragma once
 
 #include <enoki/array.h>
+#include <enoki/dual.h>
 #include <vector>
+#include <optional>
 
 #define ENOKI_AUTODIFF_H 1
 
 NAMESPACE_BEGIN(enoki)
 
+/// Statistics about the regions created by \ref checkpoint()
+struct CheckpointStatistics {
+    /// Number of regions that were re-run during backward passes
+    size_t regions = 0;
+
+    /// Number of nodes recorded while re-running them
+    size_t nodes = 0;
+
+    /**
+     * Size of the edge weights of all re-run regions in bytes. Without
+     * checkpointing, this memory would have been held from the
+     * recording until the backward pass.
+     */
+    size_t bytes_total = 0;
+
+    /// Largest edge weight size of a single region in bytes (alive while it is re-run)
+    size_t bytes_peak = 0;
+};
+
+/// Profiler statistics of the nodes sharing a label and prefix, see \c set_profiling_()
+struct ProfileEntry {
+    /// Prefix (see \c push_prefix_()) and label of the nodes
+    std::string prefix, label;
+
+    /// Number of nodes processed by backward and forward passes
+    size_t backward_nodes = 0, forward_nodes = 0;
+
+    /// Wall time spent propagating gradients along their edges (microseconds)
+    double backward_time = 0, forward_time = 0;
+
+    /// Bytes held by the edge weights and gradients of the processed nodes
+    size_t weight_bytes = 0, grad_bytes = 0;
+};
+
+/**
+ * \brief Sparse Jacobian matrix in compressed sparse row (CSR) format, see
+ * \ref jacobian_sparse()
+ */
+template <typename Scalar> struct SparseJacobian {
+    /// Number of rows (outputs) and columns (inputs)
+    size_t rows = 0, cols = 0;
+
+    /// Entries of row \c i are stored at positions <tt>row_offset[i] .. row_offset[i + 1] - 1</tt>
+    std::vector<uint32_t> row_offset;
+
+    /// Column of each structurally nonzero entry (increasing within each row)
+    std::vector<uint32_t> col_index;
+
+    /// Value of each structurally nonzero entry
+    std::vector<Scalar> values;
+
+    /// Number of column colors, i.e. forward passes used to compute the matrix
+    size_t colors = 0;
+};
+
+/// Operations that can be re-evaluated by \ref FrozenGraph::eval()
+enum class ReplayOp : uint8_t {
+    Add, Sub, Mul, Div, Fmadd, Fmsub, Fnmadd, Fnmsub, Neg, Abs, Sqrt, Cbrt,
+    Rcp, Rsqrt, Min, Max, Select, Sin, Cos, Tan, Csc, Sec, Cot, Asin, Acos,
+    Atan, Atan2, Sinh, Cosh, Csch, Sech, Tanh, Asinh, Acosh, Atanh, Exp, Log,
+    Hsum, Hprod
+};
+
+/**
+ * \brief Frozen copy of the part of a graph that connects a set of inputs to
+ * a set of outputs, see \ref freeze()
+ *
+ * The edge weights are copied, hence the original graph can be freed. Replays
+ * compute products with the Jacobian at the point where the graph was
+ * recorded. When the operations were recorded along with their operands (see
+ * \c DiffArray::set_record_primal_()), \ref eval() moves this point to new
+ * input values.
+ */
+template <typename Value> struct FrozenGraph {
+    FrozenGraph();
+    FrozenGraph(FrozenGraph &&) noexcept;
+    FrozenGraph &operator=(FrozenGraph &&) noexcept;
+    ~FrozenGraph();
+
+    /**
+     * \brief Recompute the values of all nodes and the edge weights for new
+     * values of the inputs, and return the values of the outputs
+     *
+     * Subsequent calls to \ref backward() and \ref forward() use the Jacobian
+     * at the new point. The inputs must have the same sizes as when the graph
+     * was recorded. Outputs that don't depend on any input are returned as
+     * default-constructed values. Operands that weren't tracked by the graph
+     * (e.g. masks of \ref select()) keep their recorded values. Throws if
+     * \ref replayable() is \c false.
+     */
+    std::vector<Value> eval(const std::vector<Value> &inputs);
+
+    /// Propagate gradients from the outputs to the inputs (vector-Jacobian product)
+    std::vector<Value> backward(const std::vector<Value> &grad_outputs) const;
+
+    /// Propagate gradients from the inputs to the outputs (Jacobian-vector product)
+    std::vector<Value> forward(const std::vector<Value> &grad_inputs) const;
+
+    /// Can the graph be re-evaluated at new input values via \ref eval()?
+    bool replayable() const;
+
+    /// Number of inputs and outputs passed to \ref freeze()
+    size_t input_count() const;
+    size_t output_count() const;
+
+    /// Number of nodes and edges that were copied
+    size_t node_count() const;
+    size_t edge_count() const;
+
+private:
+    template <typename T> friend struct Tape;
+
+    struct Detail;
+    std::unique_ptr<Detail> d;
+};
+
+/**
+ * \brief Contents of a binary graph dump created by \ref dump_graph(), see
+ * \ref read_graph()
+ *
+ * Dumps start with the characters \c ENKG, a format version and the size of
+ * the scalar type in bytes. A sequence of records follows, each starting
+ * with a tag byte: \c 'S' defines the next string (32 bit length and
+ * characters), \c 'N' specifies a node along with its edges, and \c 'E'
+ * marks the end and repeats the number of nodes and edges. Edges only store
+ * the scale of \c Scale weights and the size of \c Full weights. Integers
+ * and floating point values are stored in the byte order of the host.
+ */
+struct GraphDump {
+    /// Representation of an edge weight
+    enum class EdgeKind : uint8_t { Identity, Negate, Scale, Full, Special };
+
+    struct Edge {
+        /// Index of the source node (refers to \ref Node::index)
+        uint32_t source;
+
+        EdgeKind kind;
+
+        /// Number of entries of the weight (0 for special edges, 1 for broadcast scalars)
+        uint32_t weight_size;
+
+        /// Weight of broadcast scalar edges (\c Identity, \c Negate and \c Scale)
+        double scale;
+    };
+
+    struct Node {
+        /// Index of the node on the tape, variable size and gradient size
+        uint32_t index, size, grad_size;
+
+        /// External and internal reference count
+        uint32_t ref_count_ext, ref_count_int;
+
+        /// Creation order
+        uint64_t seq;
+
+        /// Positions of the label and prefix in \ref strings (or \ref NoString)
+        uint32_t label, prefix;
+
+        /// Edges are stored at <tt>edges[edge_offset] .. edges[edge_offset + edge_count - 1]</tt>
+        size_t edge_offset;
+        uint32_t edge_count;
+    };
+
+    static constexpr uint32_t NoString = (uint32_t) -1;
+    static constexpr uint32_t Version = 1;
+
+    /// Size of the scalar type of the tape in bytes
+    uint32_t scalar_size = 0;
+
+    /// Nodes in the order in which they were written
+    std::vector<Node> nodes;
+    std::vector<Edge> edges;
+    std::vector<std::string> strings;
+
+    /// Label (or an empty string) of a node
+    const std::string &label(const Node &node) const {
+        static const std::string empty;
+        return node.label == NoString ? empty : strings[node.label];
+    }
+
+    /// Memory used by full edge weights in bytes
+    size_t weight_bytes() const {
+        size_t result = 0;
+        for (const Edge &edge : edges)
+            if (edge.kind == EdgeKind::Full)
+                result += (size_t) edge.weight_size * scalar_size;
+        return result;
+    }
+
+    /// Memory used by gradients in bytes
+    size_t grad_bytes() const {
+        size_t result = 0;
+        for (const Node &node : nodes)
+            result += (size_t) node.grad_size * scalar_size;
+        return result;
+    }
+};
+
+/// Read a binary graph dump created by \ref dump_graph()
+inline GraphDump read_graph(std::istream &is) {
+    auto fail = [](const std::string &msg) {
+        throw std::runtime_error("read_graph(): " + msg);
+    };
+    auto get = [&](auto &value) {
+        if (!is.read((char *) &value, sizeof(value)))
+            fail("unexpected end of file!");
+    };
+
+    char magic[4];
+    uint32_t version;
+    GraphDump result;
+    get(magic);
+    if (memcmp(magic, "ENKG", 4) != 0)
+        fail("not a graph dump!");
+    get(version);
+    if (version != GraphDump::Version)
+        fail("unsupported version " + std::to_string(version) + "!");
+    get(result.scalar_size);
+
+    while (true) {
+        char tag;
+        get(tag);
+        if (tag == 'S') {
+            uint32_t length;
+            get(length);
+            std::string str(length, '\0');
+            if (!is.read(&str[0], length))
+                fail("unexpected end of file!");
+            result.strings.push_back(std::move(str));
+        } else if (tag == 'N') {
+            GraphDump::Node node;
+            get(node.index); get(node.size); get(node.grad_size);
+            get(node.ref_count_ext); get(node.ref_count_int);
+            get(node.seq); get(node.label); get(node.prefix);
+            get(node.edge_count);
+            if ((node.label != GraphDump::NoString && node.label >= result.strings.size()) ||
+                (node.prefix != GraphDump::NoString && node.prefix >= result.strings.size()))
+                fail("invalid string reference!");
+            node.edge_offset = result.edges.size();
+            for (uint32_t i = 0; i < node.edge_count; ++i) {
+                GraphDump::Edge edge;
+                uint8_t kind;
+                get(edge.source);
+                get(kind);
+                edge.kind = (GraphDump::EdgeKind) kind;
+                edge.weight_size = 1;
+                switch (edge.kind) {
+                    case GraphDump::EdgeKind::Identity: edge.scale = 1; break;
+                    case GraphDump::EdgeKind::Negate:   edge.scale = -1; break;
+                    case GraphDump::EdgeKind::Scale:    get(edge.scale); break;
+                    case GraphDump::EdgeKind::Full:     get(edge.weight_size); edge.scale = 0; break;
+                    case GraphDump::EdgeKind::Special:  edge.weight_size = 0; edge.scale = 0; break;
+                    default: fail("invalid edge kind!");
+                }
+                result.edges.push_back(edge);
+            }
+            result.nodes.push_back(node);
+        } else if (tag == 'E') {
+            uint64_t node_count, edge_count;
+            get(node_count); get(edge_count);
+            if (node_count != result.nodes.size() || edge_count != result.edges.size())
+                fail("node/edge counts don't match!");
+            return result;
+        } else {
+            fail("invalid record!");
+        }
+    }
+}
+
+NAMESPACE_BEGIN(detail)
+/// Type-erased region created by \ref checkpoint()
+struct Checkpoint {
+    virtual ~Checkpoint() = default;
+
+    /// Re-run the region while recording, and return the input/output node indices
+    virtual void record(std::vector<uint32_t> &inputs,
+                        std::vector<uint32_t> &outputs) = 0;
+
+    /// Release the variables created by \ref record()
+    virtual void release() = 0;
+};
+NAMESPACE_END(detail)
+
 template <typename Type> struct Tape {
 private:
     template <typename T> friend struct DiffArray;
+    template <typename T> friend struct FrozenGraph;
+    template <typename T> friend struct TapeContext;
+    template <typename T> friend struct TapeScope;
 
     struct Detail;
     struct Node;
@@ -90,21 +378,42 @@ private:
     // -----------------------------------------------------------------------
 
     void set_scatter_gather_operand(Index *index, size_t size, bool permute);
+    std::vector<Index> append_checkpoint(const std::vector<Index> &inputs,
+                                         const std::vector<size_t> &output_sizes,
+                                         detail::Checkpoint *checkpoint);
+    CheckpointStatistics checkpoint_stats() const;
+    void checkpoint_stats_reset();
+    /// Aggregate time and memory per label and prefix during backward/forward passes
+    void set_profiling(bool);
+    std::vector<ProfileEntry> profile(bool by_prefix) const;
+    void profile_reset();
+    /// Record the operands of supported operations, see \ref FrozenGraph::eval()
+    void set_record_primal(bool);
+    void record_primal(Index index, ReplayOp op, uint32_t count,
+                       const Index *args, const Type *const *values);
     void push_prefix(const char *);
     void pop_prefix();
     void backward(bool free_graph);
     void forward(bool free_graph);
     void backward(Index index, bool free_graph);
     void forward(Index index, bool free_graph);
+    SparseJacobian<scalar_t<Type>> jacobian_sparse(const std::vector<Index> &outputs,
+                                                   const std::vector<Index> &inputs);
+    FrozenGraph<Type> freeze(const std::vector<Index> &outputs,
+                             const std::vector<Index> &inputs);
     void set_gradient(Index index, const Type &value,
                       bool backward = true);
     void set_label(Index index, const char *name);
     const Type &gradient(Index index);
     std::string graphviz(const std::vector<Index> &indices);
+    /// Write the nodes reachable from 'indices' (or all nodes if \c nullptr)
+    void dump_graph(const std::vector<Index> *indices, std::ostream &os);
     /// Current log level (0 == none, 1 == minimal, 2 == moderate, 3 == high, 4 == everything)
     void set_log_level(uint32_t);
     uint32_t log_level() const;
     void set_graph_simplification(bool);
+    /// Process independent nodes of the backward pass on the thread pool (experimental)
+    void set_parallel_backward(bool);
     void simplify_graph();
     std::string whos() const;
     static void cuda_callback(void*);
@@ -112,15 +421,62 @@ private:
     //! @}
     // -----------------------------------------------------------------------
 
-    static Tape* get() ENOKI_PURE;
+    /// Tape of the calling thread (not \c const: depends on \ref set_current())
+    static Tape* get();
+
+    /// Set the tape of the calling thread (\c nullptr: global tape), returns the previous one
+    static Tape* set_current(Tape *tape);
 
 public:
     ~Tape();
 
 private:
 
+    void backward_parallel(bool free_graph);
+    void backward_release(Index index, bool free_graph);
+
     static std::unique_ptr<Tape> s_tape;
     Detail *d;
+
+    /// Is \ref record_primal() enabled? (checked inline by \ref DiffArray)
+    bool m_record_primal = false;
+};
+
+/**
+ * \brief Separate tape for differentiable arrays of type \c DiffArray<Type>
+ *
+ * By default, all threads record into a single global tape, which is not
+ * thread-safe. Independent differentiation jobs can instead run in parallel
+ * and without synchronization by binding a context to each thread using
+ * \ref TapeScope. Variables must not be passed between tapes, and they must
+ * be destroyed before the context they were recorded on.
+ */
+template <typename Type> struct TapeContext {
+    static_assert(!is_cuda_array_v<Type>,
+                  "TapeContext: GPU arrays share the global trace of the CUDA backend!");
+
+    TapeContext() : tape(new Tape<Type>()) { }
+    ~TapeContext() { delete tape; }
+
+    TapeContext(const TapeContext &) = delete;
+    TapeContext &operator=(const TapeContext &) = delete;
+
+private:
+    template <typename T> friend struct TapeScope;
+    Tape<Type> *tape;
+};
+
+/// Record operations of the calling thread on a \ref TapeContext while in scope
+template <typename Type> struct TapeScope {
+    TapeScope(TapeContext<Type> &context)
+        : previous(Tape<Type>::set_current(context.tape)) { }
+    ~TapeScope() { Tape<Type>::set_current(previous); }
+
+    TapeScope(const TapeScope &) = delete;
+    TapeScope &operator=(const TapeScope &) = delete;
+
+private:
+    Tape<Type> *previous;
 };
 
 template <typename Type>
@@ -139,6 +495,7 @@ public:
     static constexpr size_t Depth = is_scalar_v<Type> ? 1 : array_depth_v<Type>;
     static constexpr bool IsMask = is_mask_v<Type>;
     static constexpr bool IsCUDA = is_cuda_array_v<Type>;
+    static constexpr bool IsJIT = is_jit_array_v<Type>;
     static constexpr bool IsDiff = true;
     static constexpr bool Enabled =
         std::is_floating_point_v<scalar_t<Type>> && !is_mask_v<Type>;
@@ -222,9 +579,12 @@ public:
         } else {
             Index index_new = 0;
             Type result = m_value + a.m_value;
-            if constexpr (Enabled)
-                index_new = tape()->append("add", slices(result), m_index,
-                                           a.m_index, 1.f, 1.f);
+            if constexpr (Enabled) {
+                Tape *tp = tape();
+                index_new = tp->append("add", slices(result), m_index,
+                                       a.m_index, 1.f, 1.f);
+                record_primal_(tp, index_new, ReplayOp::Add, *this, a);
+            }
             return DiffArray::create(index_new, std::move(result));
         }
     }
@@ -235,9 +595,12 @@ public:
         } else {
             Index index_new = 0;
             Type result = m_value - a.m_value;
-            if constexpr (Enabled)
-                index_new = tape()->append("sub", slices(result), m_index,
-                                           a.m_index, 1.f, -1.f);
+            if constexpr (Enabled) {
+                Tape *tp = tape();
+                index_new = tp->append("sub", slices(result), m_index,
+                                       a.m_index, 1.f, -1.f);
+                record_primal_(tp, index_new, ReplayOp::Sub, *this, a);
+            }
             return DiffArray::create(index_new, std::move(result));
         }
     }
@@ -248,9 +611,12 @@ public:
         } else {
             Index index_new = 0;
             Type result = m_value * a.m_value;
-            if constexpr (Enabled)
-                index_new = tape()->append("mul", slices(result), m_index,
-                                           a.m_index, a.m_value, m_value);
+            if constexpr (Enabled) {
+                Tape *tp = tape();
+                index_new = tp->append("mul", slices(result), m_index,
+                                       a.m_index, a.m_value, m_value);
+                record_primal_(tp, index_new, ReplayOp::Mul, *this, a);
+            }
             return DiffArray::create(index_new, std::move(result));
         }
     }
@@ -263,9 +629,11 @@ public:
             Type result = m_value / a.m_value;
             if constexpr (Enabled) {
                 Type rcp_a = rcp(a.m_value);
-                index_new = tape()->append("div", slices(result),
-                                           m_index, a.m_index, rcp_a,
-                                           -m_value * sqr(rcp_a));
+                Tape *tp = tape();
+                index_new = tp->append("div", slices(result),
+                                       m_index, a.m_index, rcp_a,
+                                       -m_value * sqr(rcp_a));
+                record_primal_(tp, index_new, ReplayOp::Div, *this, a);
             }
             return DiffArray::create(index_new, std::move(result));
         }
@@ -277,10 +645,13 @@ public:
         } else {
             Index index_new = 0;
             Type result = fmadd(m_value, a.m_value, b.m_value);
-            if constexpr (Enabled)
-                index_new = tape()->append("fmadd", slices(result),
-                                           m_index, a.m_index, b.m_index,
-                                           a.m_value, m_value, 1);
+            if constexpr (Enabled) {
+                Tape *tp = tape();
+                index_new = tp->append("fmadd", slices(result),
+                                       m_index, a.m_index, b.m_index,
+                                       a.m_value, m_value, 1);
+                record_primal_(tp, index_new, ReplayOp::Fmadd, *this, a, b);
+            }
             return DiffArray::create(index_new, std::move(result));
         }
     }
@@ -291,10 +662,13 @@ public:
         } else {
             Type result = fmsub(m_value, a.m_value, b.m_value);
             Index index_new = 0;
-            if constexpr (Enabled)
-                index_new = tape()->append("fmsub", slices(result),
-                                           m_index, a.m_index, b.m_index,
-                                           a.m_value, m_value, -1);
+            if constexpr (Enabled) {
+                Tape *tp = tape();
+                index_new = tp->append("fmsub", slices(result),
+                                       m_index, a.m_index, b.m_index,
+                                       a.m_value, m_value, -1);
+                record_primal_(tp, index_new, ReplayOp::Fmsub, *this, a, b);
+            }
             return DiffArray::create(index_new, std::move(result));
         }
     }
@@ -305,10 +679,13 @@ public:
         } else {
             Type result = fnmadd(m_value, a.m_value, b.m_value);
             Index index_new = 0;
-            if constexpr (Enabled)
-                index_new = tape()->append("fnmadd", slices(result),
-                                           m_index, a.m_index, b.m_index,
-                                           -a.m_value, -m_value, 1);
+            if constexpr (Enabled) {
+                Tape *tp = tape();
+                index_new = tp->append("fnmadd", slices(result),
+                                       m_index, a.m_index, b.m_index,
+                                       -a.m_value, -m_value, 1);
+                record_primal_(tp, index_new, ReplayOp::Fnmadd, *this, a, b);
+            }
             return DiffArray::create(index_new, std::move(result));
         }
     }
@@ -319,10 +696,13 @@ public:
         } else {
             Index index_new = 0;
             Type result = fnmsub(m_value, a.m_value, b.m_value);
-            if constexpr (Enabled)
-                index_new = tape()->append("fnmsub", slices(result),
-                                           m_index, a.m_index, b.m_index,
-                                           -a.m_value, -m_value, -1);
+            if constexpr (Enabled) {
+                Tape *tp = tape();
+                index_new = tp->append("fnmsub", slices(result),
+                                       m_index, a.m_index, b.m_index,
+                                       -a.m_value, -m_value, -1);
+                record_primal_(tp, index_new, ReplayOp::Fnmsub, *this, a, b);
+            }
             return DiffArray::create(index_new, std::move(result));
         }
     }
@@ -332,8 +712,11 @@ public:
             fail_unsupported("neg_");
         } else {
             Index index_new = 0;
-            if constexpr (Enabled)
-                index_new = tape()->append("neg", slices(m_value), m_index, -1.f);
+            if constexpr (Enabled) {
+                Tape *tp = tape();
+                index_new = tp->append("neg", slices(m_value), m_index, -1.f);
+                record_primal_(tp, index_new, ReplayOp::Neg, *this);
+            }
             return DiffArray::create(index_new, -m_value);
         }
     }
@@ -343,9 +726,12 @@ public:
             fail_unsupported("abs_");
         } else {
             Index index_new = 0;
-            if constexpr (Enabled)
-                index_new = tape()->append("abs", slices(m_value), m_index,
-                                           sign(m_value));
+            if constexpr (Enabled) {
+                Tape *tp = tape();
+                index_new = tp->append("abs", slices(m_value), m_index,
+                                       sign(m_value));
+                record_primal_(tp, index_new, ReplayOp::Abs, *this);
+            }
             return DiffArray::create(index_new, abs(m_value));
         }
     }
@@ -356,9 +742,12 @@ public:
         } else {
             Index index_new = 0;
             Type result = sqrt(m_value);
-            if constexpr (Enabled)
-                index_new = tape()->append("sqrt", slices(result), m_index,
-                                           .5f / result);
+            if constexpr (Enabled) {
+                Tape *tp = tape();
+                index_new = tp->append("sqrt", slices(result), m_index,
+                                       .5f / result);
+                record_primal_(tp, index_new, ReplayOp::Sqrt, *this);
+            }
             return DiffArray::create(index_new, std::move(result));
         }
     }
@@ -369,9 +758,12 @@ public:
         } else {
             Index index_new = 0;
             Type result = cbrt(m_value);
-            if constexpr (Enabled)
-                index_new = tape()->append("cbrt", slices(result), m_index,
-                                           1.f / (3 * sqr(result)));
+            if constexpr (Enabled) {
+                Tape *tp = tape();
+                index_new = tp->append("cbrt", slices(result), m_index,
+                                       1.f / (3 * sqr(result)));
+                record_primal_(tp, index_new, ReplayOp::Cbrt, *this);
+            }
             return DiffArray::create(index_new, std::move(result));
         }
     }
@@ -382,9 +774,12 @@ public:
         } else {
             Index index_new = 0;
             Type result = rcp(m_value);
-            if constexpr (Enabled)
-                index_new = tape()->append("rcp", slices(result), m_index,
-                                           -sqr(result));
+            if constexpr (Enabled) {
+                Tape *tp = tape();
+                index_new = tp->append("rcp", slices(result), m_index,
+                                       -sqr(result));
+                record_primal_(tp, index_new, ReplayOp::Rcp, *this);
+            }
             return DiffArray::create(index_new, std::move(result));
         }
     }
@@ -397,8 +792,10 @@ public:
             Type result = rsqrt(m_value);
             if constexpr (Enabled) {
                 Type rsqrt_2 = sqr(result), rsqrt_3 = result * rsqrt_2;
-                index_new = tape()->append("rsqrt", slices(result), m_index,
-                                           -.5f * rsqrt_3);
+                Tape *tp = tape();
+                index_new = tp->append("rsqrt", slices(result), m_index,
+                                       -.5f * rsqrt_3);
+                record_primal_(tp, index_new, ReplayOp::Rsqrt, *this);
             }
             return DiffArray::create(index_new, std::move(result));
         }
@@ -412,10 +809,12 @@ public:
             Type result = min(m_value, a.m_value);
             if constexpr (Enabled) {
                 mask_t<Type> m = m_value < a.m_value;
-                index_new = tape()->append("min", slices(result),
-                                           m_index, a.m_index,
-                                           select(m, Type(1), Type(0)),
-                                           select(m, Type(0), Type(1)));
+                Tape *tp = tape();
+                index_new = tp->append("min", slices(result),
+                                       m_index, a.m_index,
+                                       select(m, Type(1), Type(0)),
+                                       select(m, Type(0), Type(1)));
+                record_primal_(tp, index_new, ReplayOp::Min, *this, a);
             }
             return DiffArray::create(index_new, std::move(result));
         }
@@ -429,10 +828,12 @@ public:
             Type result = max(m_value, a.m_value);
             if constexpr (Enabled) {
                 mask_t<Type> m = m_value > a.m_value;
-                index_new = tape()->append("max", slices(result),
-                                           m_index, a.m_index,
-                                           select(m, Type(1), Type(0)),
-                                           select(m, Type(0), Type(1)));
+                Tape *tp = tape();
+                index_new = tp->append("max", slices(result),
+                                       m_index, a.m_index,
+                                       select(m, Type(1), Type(0)),
+                                       select(m, Type(0), Type(1)));
+                record_primal_(tp, index_new, ReplayOp::Max, *this, a);
             }
             return DiffArray::create(index_new, std::move(result));
         }
@@ -444,10 +845,14 @@ public:
         Index index_new = 0;
         Type result = select(m.value_(), t.m_value, f.m_value);
         if constexpr (Enabled) {
+            Type mask = select(m.value_(), Type(1), Type(0));
+            Tape *tp = tape();
             index_new =
-                tape()->append("select", slices(result), t.m_index, f.m_index,
-                               select(m.value_(), Type(1), Type(0)),
-                               select(m.value_(), Type(0), Type(1)));
+                tp->append("select", slices(result), t.m_index, f.m_index,
+                           mask, select(m.value_(), Type(0), Type(1)));
+            if (ENOKI_UNLIKELY(tp->m_record_primal))
+                record_primal_(tp, index_new, ReplayOp::Select, t, f,
+                               DiffArray(std::move(mask)));
         }
         return DiffArray::create(index_new, std::move(result));
     }
@@ -494,8 +899,11 @@ public:
         } else {
             Index index_new = 0;
             auto [s, c] = sincos(m_value);
-            if constexpr (Enabled)
-                index_new = tape()->append("sin", slices(m_value), m_index, c);
+            if constexpr (Enabled) {
+                Tape *tp = tape();
+                index_new = tp->append("sin", slices(m_value), m_index, c);
+                record_primal_(tp, index_new, ReplayOp::Sin, *this);
+            }
             return DiffArray::create(index_new, std::move(s));
         }
     }
@@ -506,8 +914,11 @@ public:
         } else {
             Index index_new = 0;
             auto [s, c] = sincos(m_value);
-            if constexpr (Enabled)
-                index_new = tape()->append("cos", slices(m_value), m_index, -s);
+            if constexpr (Enabled) {
+                Tape *tp = tape();
+                index_new = tp->append("cos", slices(m_value), m_index, -s);
+                record_primal_(tp, index_new, ReplayOp::Cos, *this);
+            }
             return DiffArray::create(index_new, std::move(c));
         }
     }
@@ -519,8 +930,11 @@ public:
             Index index_new_s = 0, index_new_c = 0;
             auto [s, c] = sincos(m_value);
             if constexpr (Enabled) {
-                index_new_s = tape()->append("sin", slices(m_value), m_index,  c);
-                index_new_c = tape()->append("cos", slices(m_value), m_index, -s);
+                Tape *tp = tape();
+                index_new_s = tp->append("sin", slices(m_value), m_index,  c);
+                index_new_c = tp->append("cos", slices(m_value), m_index, -s);
+                record_primal_(tp, index_new_s, ReplayOp::Sin, *this);
+                record_primal_(tp, index_new_c, ReplayOp::Cos, *this);
             }
             return {
                 DiffArray::create(index_new_s, std::move(s)),
@@ -534,9 +948,12 @@ public:
             fail_unsupported("tan_");
         } else {
             Index index_new = 0;
-            if constexpr (Enabled)
-                index_new = tape()->append("tan", slices(m_value), m_index,
-                                           sqr(sec(m_value)));
+            if constexpr (Enabled) {
+                Tape *tp = tape();
+                index_new = tp->append("tan", slices(m_value), m_index,
+                                       sqr(sec(m_value)));
+                record_primal_(tp, index_new, ReplayOp::Tan, *this);
+            }
             return DiffArray::create(index_new, tan(m_value));
         }
     }
@@ -547,9 +964,12 @@ public:
         } else {
             Index index_new = 0;
             Type csc_value = csc(m_value);
-            if constexpr (Enabled)
-                index_new = tape()->append("csc", slices(m_value), m_index,
-                                           -csc_value * cot(m_value));
+            if constexpr (Enabled) {
+                Tape *tp = tape();
+                index_new = tp->append("csc", slices(m_value), m_index,
+                                       -csc_value * cot(m_value));
+                record_primal_(tp, index_new, ReplayOp::Csc, *this);
+            }
             return DiffArray::create(index_new, std::move(csc_value));
         }
     }
@@ -560,9 +980,12 @@ public:
         } else {
             Index index_new = 0;
             Type sec_value = sec(m_value);
-            if constexpr (Enabled)
-                index_new = tape()->append("sec", slices(m_value), m_index,
-                                           sec_value * tan(m_value));
+            if constexpr (Enabled) {
+                Tape *tp = tape();
+                index_new = tp->append("sec", slices(m_value), m_index,
+                                       sec_value * tan(m_value));
+                record_primal_(tp, index_new, ReplayOp::Sec, *this);
+            }
             return DiffArray::create(index_new, std::move(sec_value));
         }
     }
@@ -572,9 +995,12 @@ public:
             fail_unsupported("cot_");
         } else {
             Index index_new = 0;
-            if constexpr (Enabled)
-                index_new = tape()->append("cot", slices(m_value), m_index,
-                                           -sqr(csc(m_value)));
+            if constexpr (Enabled) {
+                Tape *tp = tape();
+                index_new = tp->append("cot", slices(m_value), m_index,
+                                       -sqr(csc(m_value)));
+                record_primal_(tp, index_new, ReplayOp::Cot, *this);
+            }
             return DiffArray::create(index_new, cot(m_value));
         }
     }
@@ -584,9 +1010,12 @@ public:
             fail_unsupported("asin_");
         } else {
             Index index_new = 0;
-            if constexpr (Enabled)
-                index_new = tape()->append("asin", slices(m_value), m_index,
-                                           rsqrt(1 - sqr(m_value)));
+            if constexpr (Enabled) {
+                Tape *tp = tape();
+                index_new = tp->append("asin", slices(m_value), m_index,
+                                       rsqrt(1 - sqr(m_value)));
+                record_primal_(tp, index_new, ReplayOp::Asin, *this);
+            }
             return DiffArray::create(index_new, asin(m_value));
         }
     }
@@ -596,9 +1025,12 @@ public:
             fail_unsupported("acos_");
         } else {
             Index index_new = 0;
-            if constexpr (Enabled)
-                index_new = tape()->append("acos", slices(m_value), m_index,
-                                           -rsqrt(1 - sqr(m_value)));
+            if constexpr (Enabled) {
+                Tape *tp = tape();
+                index_new = tp->append("acos", slices(m_value), m_index,
+                                       -rsqrt(1 - sqr(m_value)));
+                record_primal_(tp, index_new, ReplayOp::Acos, *this);
+            }
             return DiffArray::create(index_new, acos(m_value));
         }
     }
@@ -608,9 +1040,12 @@ public:
             fail_unsupported("atan_");
         } else {
             Index index_new = 0;
-            if constexpr (Enabled)
-                index_new = tape()->append("atan", slices(m_value), m_index,
-                                           rcp(1 + sqr(m_value)));
+            if constexpr (Enabled) {
+                Tape *tp = tape();
+                index_new = tp->append("atan", slices(m_value), m_index,
+                                       rcp(1 + sqr(m_value)));
+                record_primal_(tp, index_new, ReplayOp::Atan, *this);
+            }
             return DiffArray::create(index_new, atan(m_value));
         }
     }
@@ -623,9 +1058,11 @@ public:
 
             if constexpr (Enabled) {
                 Type il2 = rcp(sqr(m_value) + sqr(x.m_value));
-                index_new = tape()->append("atan2", slices(il2),
-                                           m_index, x.m_index,
-                                           il2 * x.m_value, -il2 * m_value);
+                Tape *tp = tape();
+                index_new = tp->append("atan2", slices(il2),
+                                       m_index, x.m_index,
+                                       il2 * x.m_value, -il2 * m_value);
+                record_primal_(tp, index_new, ReplayOp::Atan2, *this, x);
             }
 
             return DiffArray::create(index_new, atan2(m_value, x.m_value));
@@ -638,8 +1075,11 @@ public:
         } else {
             Index index_new = 0;
             auto [s, c] = sincosh(m_value);
-            if constexpr (Enabled)
-                index_new = tape()->append("sinh", slices(m_value), m_index, c);
+            if constexpr (Enabled) {
+                Tape *tp = tape();
+                index_new = tp->append("sinh", slices(m_value), m_index, c);
+                record_primal_(tp, index_new, ReplayOp::Sinh, *this);
+            }
             return DiffArray::create(index_new, std::move(s));
         }
     }
@@ -650,8 +1090,11 @@ public:
         } else {
             Index index_new = 0;
             auto [s, c] = sincosh(m_value);
-            if constexpr (Enabled)
-                index_new = tape()->append("cosh", slices(m_value), m_index, s);
+            if constexpr (Enabled) {
+                Tape *tp = tape();
+                index_new = tp->append("cosh", slices(m_value), m_index, s);
+                record_primal_(tp, index_new, ReplayOp::Cosh, *this);
+            }
             return DiffArray::create(index_new, std::move(c));
         }
     }
@@ -662,9 +1105,12 @@ public:
         } else {
             Index index_new = 0;
             Type result = csch(m_value);
-            if constexpr (Enabled)
-                index_new = tape()->append("csch", slices(m_value), m_index,
-                                           -result * coth(m_value));
+            if constexpr (Enabled) {
+                Tape *tp = tape();
+                index_new = tp->append("csch", slices(m_value), m_index,
+                                       -result * coth(m_value));
+                record_primal_(tp, index_new, ReplayOp::Csch, *this);
+            }
             return DiffArray::create(index_new, std::move(result));
         }
     }
@@ -675,9 +1121,12 @@ public:
         } else {
             Index index_new = 0;
             Type result = sech(m_value);
-            if constexpr (Enabled)
-                index_new = tape()->append("sech", slices(m_value), m_index,
-                                           -result * tanh(m_value));
+            if constexpr (Enabled) {
+                Tape *tp = tape();
+                index_new = tp->append("sech", slices(m_value), m_index,
+                                       -result * tanh(m_value));
+                record_primal_(tp, index_new, ReplayOp::Sech, *this);
+            }
             return DiffArray::create(index_new, std::move(result));
         }
     }
@@ -688,9 +1137,12 @@ public:
         } else {
             Index index_new = 0;
             Type result = tanh(m_value);
-            if constexpr (Enabled)
-                index_new = tape()->append("index", slices(m_value), m_index,
-                                           sqr(sech(m_value)));
+            if constexpr (Enabled) {
+                Tape *tp = tape();
+                index_new = tp->append("index", slices(m_value), m_index,
+                                       sqr(sech(m_value)));
+                record_primal_(tp, index_new, ReplayOp::Tanh, *this);
+            }
             return DiffArray::create(index_new, std::move(result));
         }
     }
@@ -700,9 +1152,12 @@ public:
             fail_unsupported("asinh_");
         } else {
             Index index_new = 0;
-            if constexpr (Enabled)
-                index_new = tape()->append("asinh", slices(m_value), m_index,
-                                           rsqrt((Scalar) 1 + sqr(m_value)));
+            if constexpr (Enabled) {
+                Tape *tp = tape();
+                index_new = tp->append("asinh", slices(m_value), m_index,
+                                       rsqrt((Scalar) 1 + sqr(m_value)));
+                record_primal_(tp, index_new, ReplayOp::Asinh, *this);
+            }
             return DiffArray::create(index_new, asinh(m_value));
         }
     }
@@ -712,9 +1167,12 @@ public:
             fail_unsupported("acosh_");
         } else {
             Index index_new = 0;
-            if constexpr (Enabled)
-                index_new = tape()->append("acosh", slices(m_value), m_index,
-                                           rsqrt(sqr(m_value) - (Scalar) 1));
+            if constexpr (Enabled) {
+                Tape *tp = tape();
+                index_new = tp->append("acosh", slices(m_value), m_index,
+                                       rsqrt(sqr(m_value) - (Scalar) 1));
+                record_primal_(tp, index_new, ReplayOp::Acosh, *this);
+            }
             return DiffArray::create(index_new, acosh(m_value));
         }
     }
@@ -724,9 +1182,12 @@ public:
             fail_unsupported("atanh_");
         } else {
             Index index_new = 0;
-            if constexpr (Enabled)
-                index_new = tape()->append("atanh", slices(m_value), m_index,
-                                           rcp((Scalar) 1 - sqr(m_value)));
+            if constexpr (Enabled) {
+                Tape *tp = tape();
+                index_new = tp->append("atanh", slices(m_value), m_index,
+                                       rcp((Scalar) 1 - sqr(m_value)));
+                record_primal_(tp, index_new, ReplayOp::Atanh, *this);
+            }
             return DiffArray::create(index_new, atanh(m_value));
         }
     }
@@ -737,9 +1198,12 @@ public:
         } else {
             Index index_new = 0;
             Type result = exp(m_value);
-            if constexpr (Enabled)
-                index_new = tape()->append("exp", slices(m_value),
-                                           m_index, result);
+            if constexpr (Enabled) {
+                Tape *tp = tape();
+                index_new = tp->append("exp", slices(m_value),
+                                       m_index, result);
+                record_primal_(tp, index_new, ReplayOp::Exp, *this);
+            }
             return DiffArray::create(index_new, std::move(result));
         }
     }
@@ -749,9 +1213,12 @@ public:
             fail_unsupported("log_");
         } else {
             Index index_new = 0;
-            if constexpr (Enabled)
-                index_new = tape()->append("log", slices(m_value), m_index,
-                                           rcp(m_value));
+            if constexpr (Enabled) {
+                Tape *tp = tape();
+                index_new = tp->append("log", slices(m_value), m_index,
+                                       rcp(m_value));
+                record_primal_(tp, index_new, ReplayOp::Log, *this);
+            }
             return DiffArray::create(index_new, log(m_value));
         }
     }
@@ -1054,8 +1521,11 @@ public:
             fail_unsupported("hsum_");
         } else {
             Index index_new = 0;
-            if constexpr (Enabled)
-                index_new = tape()->append("hsum", 1, m_index, 1.f);
+            if constexpr (Enabled) {
+                Tape *tp = tape();
+                index_new = tp->append("hsum", 1, m_index, 1.f);
+                record_primal_(tp, index_new, ReplayOp::Hsum, *this);
+            }
 
             return DiffArray::create(index_new, hsum(m_value));
         }
@@ -1067,10 +1537,13 @@ public:
         } else {
             Index index_new = 0;
             Type result = hprod(m_value);
-            if constexpr (Enabled)
-                index_new = tape()->append(
+            if constexpr (Enabled) {
+                Tape *tp = tape();
+                index_new = tp->append(
                     "hprod", 1, m_index,
                     select(eq(m_value, (Scalar) 0), (Scalar) 0, result / m_value));
+                record_primal_(tp, index_new, ReplayOp::Hprod, *this);
+            }
             return DiffArray::create(index_new, std::move(result));
         }
     }
@@ -1283,6 +1756,13 @@ public:
             return tape()->graphviz(indices);
     }
 
+    static void dump_graph_(const std::vector<Index> *indices, std::ostream &os) {
+        if constexpr (!Enabled)
+            fail_unsupported("dump_graph_");
+        else
+            tape()->dump_graph(indices, os);
+    }
+
     static void push_prefix_(const char *label) {
         if constexpr (Enabled)
             tape()->push_prefix(label);
@@ -1334,6 +1814,83 @@ public:
             tape()->set_graph_simplification(level);
     }
 
+    static void set_parallel_backward_(bool value) {
+        if constexpr (Enabled)
+            tape()->set_parallel_backward(value);
+    }
+
+    static std::vector<Index> append_checkpoint_(const std::vector<Index> &inputs,
+                                                 const std::vector<size_t> &output_sizes,
+                                                 detail::Checkpoint *checkpoint) {
+        if constexpr (!Enabled || !is_dynamic_v<Type>)
+            fail_unsupported("checkpoint");
+        else
+            return tape()->append_checkpoint(inputs, output_sizes, checkpoint);
+    }
+
+    static SparseJacobian<Scalar> jacobian_sparse_(const std::vector<Index> &outputs,
+                                                   const std::vector<Index> &inputs) {
+        if constexpr (!Enabled)
+            fail_unsupported("jacobian_sparse");
+        else
+            return tape()->jacobian_sparse(outputs, inputs);
+    }
+
+    static FrozenGraph<Type> freeze_(const std::vector<Index> &outputs,
+                                     const std::vector<Index> &inputs) {
+        if constexpr (!Enabled)
+            fail_unsupported("freeze");
+        else
+            return tape()->freeze(outputs, inputs);
+    }
+
+    static CheckpointStatistics checkpoint_stats_() {
+        if constexpr (!Enabled)
+            fail_unsupported("checkpoint_stats");
+        else
+            return tape()->checkpoint_stats();
+    }
+
+    static void checkpoint_stats_reset_() {
+        if constexpr (Enabled)
+            tape()->checkpoint_stats_reset();
+    }
+
+    static void set_profiling_(bool value) {
+        if constexpr (Enabled)
+            tape()->set_profiling(value);
+    }
+
+    /**
+     * \brief Return the profiler statistics, ordered by decreasing time
+     *
+     * When \c by_prefix is \c true, the statistics of all labels sharing a
+     * prefix are merged, and the labels of the result are empty.
+     */
+    static std::vector<ProfileEntry> profile_(bool by_prefix = false) {
+        if constexpr (!Enabled)
+            fail_unsupported("profile");
+        else
+            return tape()->profile(by_prefix);
+    }
+
+    static void profile_reset_() {
+        if constexpr (Enabled)
+            tape()->profile_reset();
+    }
+
+    /**
+     * \brief Record the operands of supported operations, so that graphs
+     * frozen via \ref freeze() can be re-evaluated at new input values
+     *
+     * This stores a copy of the operands of each operation (unsupported ones,
+     * such as gathers, are not recorded) and must be enabled before recording.
+     */
+    static void set_record_primal_(bool value) {
+        if constexpr (Enabled)
+            tape()->set_record_primal(value);
+    }
+
     static void simplify_graph_() {
         if constexpr (Enabled)
             tape()->simplify_graph();
@@ -1393,6 +1950,17 @@ public:
 private:
     ENOKI_INLINE static Tape* tape() { return Tape::get(); }
 
+    /// Record the operation that computed 'index' on 'tp' if enabled (see \ref set_record_primal_())
+    template <typename... Args>
+    ENOKI_INLINE static void record_primal_(Tape *tp, Index index, ReplayOp op,
+                                            const Args &... args) {
+        if (ENOKI_UNLIKELY(tp->m_record_primal) && index != 0) {
+            Index indices[] = { args.m_index... };
+            const Type *values[] = { &args.m_value... };
+            tp->record_primal(index, op, (uint32_t) sizeof...(Args), indices, values);
+        }
+    }
+
     using Arg = std::conditional_t<std::is_scalar_v<Type>, Type, Type&&>;
 
     ENOKI_INLINE static DiffArray create(Index index, Arg value) {
@@ -1530,6 +2098,260 @@ template <typename T> std::string graphviz(const T &value) {
     return detail::diff_type_t<T>::graphviz_(indices);
 }
 
+/**
+ * \brief Write the part of the graph that \c value depends on to \c os in a
+ * compact binary format, see \ref GraphDump and \ref read_graph()
+ */
+template <typename T> void dump_graph(const T &value, std::ostream &os) {
+    std::vector<uint32_t> indices;
+    detail::collect_indices(value, indices);
+    detail::diff_type_t<T>::dump_graph_(&indices, os);
+}
+
+/// Write the entire graph of the tape associated with \c T, see \ref GraphDump
+template <typename T> void dump_graph(std::ostream &os) {
+    T::dump_graph_(nullptr, os);
+}
+
+namespace detail {
+    template <typename T> struct is_std_tuple : std::false_type { };
+    template <typename... Ts> struct is_std_tuple<std::tuple<Ts...>> : std::true_type { };
+    template <typename T1, typename T2> struct is_std_tuple<std::pair<T1, T2>> : std::true_type { };
+
+    /// Invoke \c func on all variables of type \c Diff within a tuple/array hierarchy
+    template <typename Diff, typename T, typename Func>
+    void for_each_diff(T &value, Func &func) {
+        if constexpr (std::is_same_v<T, Diff>) {
+            func(value);
+        } else if constexpr (is_std_tuple<T>::value) {
+            std::apply([&](auto &... v) { (for_each_diff<Diff>(v, func), ...); }, value);
+        } else if constexpr (is_diff_array_v<T> && array_depth_v<T> >= 2) {
+            for (size_t i = 0; i < T::Size; ++i)
+                for_each_diff<Diff>(value.coeff(i), func);
+        }
+    }
+
+    template <typename Diff, typename Func, typename... Args>
+    struct CheckpointImpl : Checkpoint {
+        using Output = std::decay_t<std::invoke_result_t<Func &, Args &...>>;
+
+        CheckpointImpl(Func &&func, const Args &... args)
+            : func(std::move(func)), inputs(args...) { }
+
+        void record(std::vector<uint32_t> &input_indices,
+                    std::vector<uint32_t> &output_indices) override {
+            inputs_rec.emplace(inputs);
+            size_t i = 0;
+            auto enable = [&](Diff &v) {
+                if (active[i++])
+                    v.set_requires_gradient_(true);
+                input_indices.push_back(v.index_());
+            };
+            for_each_diff<Diff>(*inputs_rec, enable);
+
+            output_rec.emplace(std::apply(func, *inputs_rec));
+            auto collect = [&](Diff &v) { output_indices.push_back(v.index_()); };
+            for_each_diff<Diff>(*output_rec, collect);
+        }
+
+        void release() override {
+            output_rec.reset();
+            inputs_rec.reset();
+        }
+
+        Func func;
+
+        /// Detached inputs, and which of them originally required gradients
+        std::tuple<Args...> inputs;
+        std::vector<bool> active;
+
+        /// Variables of the ongoing re-run
+        std::optional<std::tuple<Args...>> inputs_rec;
+        std::optional<Output> output_rec;
+    };
+}
+
+/**
+ * \brief Evaluate \c func(args...) without recording its intermediate steps
+ * on the tape (gradient checkpointing).
+ *
+ * Only the inputs and outputs of the region are kept alive. The backward pass
+ * re-runs \c func with gradient tracking enabled to differentiate it, which
+ * trades computation for memory. The arguments and the return value can be
+ * differentiable dynamic arrays, static arrays thereof, and \c std::pair or
+ * \c std::tuple instances combining these. Gradients only propagate through
+ * the arguments, hence \c func must not capture differentiable variables.
+ * Forward mode differentiation is not supported.
+ */
+template <typename Func, typename... Args>
+auto checkpoint(Func func, const Args &... args) {
+    using Tuple = std::tuple<Args...>;
+    using Diff = detail::diff_type_t<std::tuple_element_t<0, Tuple>>;
+    using Index = typename Diff::Index;
+    using Impl = detail::CheckpointImpl<Diff, Func, Args...>;
+
+    std::unique_ptr<Impl> impl(new Impl(std::move(func), args...));
+
+    /* Detach the inputs and evaluate the region without recording */
+    std::vector<Index> inputs;
+    auto detach_input = [&](Diff &v) {
+        inputs.push_back(v.index_());
+        impl->active.push_back(v.index_() != 0);
+        v.set_requires_gradient_(false);
+    };
+    detail::for_each_diff<Diff>(impl->inputs, detach_input);
+
+    typename Impl::Output output = std::apply(impl->func, impl->inputs);
+
+    bool requires_gradient = false;
+    for (Index index : inputs)
+        requires_gradient |= index != 0;
+    if (!requires_gradient)
+        return output;
+
+    std::vector<size_t> output_sizes;
+    auto collect_size = [&](Diff &v) { output_sizes.push_back(slices(v)); };
+    detail::for_each_diff<Diff>(output, collect_size);
+
+    std::vector<Index> outputs =
+        Diff::append_checkpoint_(inputs, output_sizes, impl.release());
+
+    size_t i = 0;
+    auto attach_output = [&](Diff &v) {
+        Index index = outputs[i++];
+        v.set_index_(index);
+        Diff::dec_ref_ext_(index);
+    };
+    detail::for_each_diff<Diff>(output, attach_output);
+
+    return output;
+}
+
+/**
+ * \brief Compute the Jacobian of \c outputs with respect to \c inputs, whose
+ * entries are expected to be sparse
+ *
+ * The sparsity pattern is found by following the edges of the graph from each
+ * output to the inputs it depends on. Columns that don't share a row are then
+ * merged by a greedy coloring, and one forward pass per color recovers all of
+ * their entries at once. Structurally nonzero entries are returned in CSR
+ * format, even if their value is zero.
+ *
+ * Since the pattern is detected per variable, all inputs and outputs must be
+ * single-entry differentiable variables (e.g. \c DiffArray<float>, or dynamic
+ * arrays of size 1). Inputs that don't require gradients produce empty
+ * columns. The graph is not freed.
+ */
+template <typename T>
+SparseJacobian<scalar_t<T>> jacobian_sparse(const std::vector<T> &outputs,
+                                            const std::vector<T> &inputs) {
+    static_assert(is_diff_array_v<T> && array_depth_v<T> == 1,
+                  "jacobian_sparse(): expected differentiable variables!");
+
+    std::vector<typename T::Index> output_indices, input_indices;
+    output_indices.reserve(outputs.size());
+    input_indices.reserve(inputs.size());
+    for (const T &value : outputs)
+        output_indices.push_back(value.index_());
+    for (const T &value : inputs)
+        input_indices.push_back(value.index_());
+
+    return T::jacobian_sparse_(output_indices, input_indices);
+}
+
+/**
+ * \brief Copy the part of the graph connecting \c inputs to \c outputs into a
+ * \ref FrozenGraph that can be replayed many times
+ *
+ * Loops that record an identical graph in every iteration only to propagate
+ * different gradients through it can record it once instead. Replays operate
+ * on flat arrays in topological order and skip the graph traversal and
+ * reference counting of regular \ref backward() and \ref forward() passes.
+ *
+ * Variables of any size are supported, and gradients of size 1 are broadcast.
+ * Nodes that aren't located on a path from an input to an output are dropped,
+ * and calling \c simplify_graph_() beforehand reduces the number of edges.
+ * Graphs containing gather, scatter or \ref checkpoint() operations can't be
+ * frozen. The original graph is not freed.
+ *
+ * The edges store partial derivatives at the input values of the recording.
+ * When the graph was recorded with \c DiffArray::set_record_primal_()
+ * enabled, \ref FrozenGraph::eval() instead recomputes the node values and
+ * edge weights for new input values. This requires that all operations
+ * between the inputs and outputs support replays (arithmetic, transcendental
+ * functions, \ref select(), \ref hsum() and \ref hprod()), and that the graph
+ * wasn't simplified before freezing. Otherwise, computations with new input
+ * values must be recorded (and frozen) again.
+ */
+template <typename T>
+FrozenGraph<typename T::UnderlyingType> freeze(const std::vector<T> &outputs,
+                                               const std::vector<T> &inputs) {
+    static_assert(is_diff_array_v<T> && array_depth_v<T> == 1,
+                  "freeze(): expected differentiable variables!");
+
+    std::vector<typename T::Index> output_indices, input_indices;
+    output_indices.reserve(outputs.size());
+    input_indices.reserve(inputs.size());
+    for (const T &value : outputs)
+        output_indices.push_back(value.index_());
+    for (const T &value : inputs)
+        input_indices.push_back(value.index_());
+
+    return T::freeze_(output_indices, input_indices);
+}
+
+namespace detail {
+    /**
+     * Argument and return types of \ref hvp(): replace the differentiable
+     * arrays within a static array hierarchy by dual and detached arrays
+     */
+    template <typename T, typename = int> struct hvp_types {
+        using Dual = DualArray<T, 1>;
+        using Result = typename T::UnderlyingType;
+    };
+
+    template <typename T> struct hvp_types<T, enable_if_t<(array_depth_v<T> >= 2)>> {
+        using Nested = hvp_types<value_t<T>>;
+        using Dual = typename T::template ReplaceValue<typename Nested::Dual>;
+        using Result = typename T::template ReplaceValue<typename Nested::Result>;
+    };
+}
+
+/**
+ * \brief Compute the Hessian-vector product of \c func at \c x along \c v
+ *
+ * \c func receives a differentiable array (or a static array of them, e.g. a
+ * \c Vector3fD) and returns a differentiable array. When it has several
+ * entries, the Hessian of their sum is used. \c func is invoked once with
+ * dual numbers of type <tt>DualArray<FloatD, 1></tt> whose tangents are set
+ * to \c v. The tangent of the result is the directional derivative
+ * <tt>grad(func)(x) . v</tt>, which is recorded on the tape along with the
+ * function value. A single backward pass from it then yields <tt>H . v</tt>
+ * without ever forming the Hessian matrix \c H, at a few times the cost of a
+ * gradient evaluation.
+ *
+ * The product is returned as a detached array (e.g. \c Vector3fX).
+ * Derivatives don't propagate to variables that \c x depends on, and \c func
+ * must not capture other differentiable variables.
+ */
+template <typename Func, typename T>
+typename detail::hvp_types<T>::Result hvp(Func func, const T &x, const T &v) {
+    using Dual = typename detail::hvp_types<T>::Dual;
+    using Result = typename detail::hvp_types<T>::Result;
+
+    T x_leaf(detach(x));
+    set_requires_gradient(x_leaf);
+
+    Dual x_dual(x_leaf);
+    set_tangent(x_dual, 0, detach(v));
+
+    auto dir = tangent(func(x_dual), 0);
+    if (requires_gradient(dir))
+        backward(dir);
+
+    return Result(gradient(x_leaf));
+}
+
 #if defined(ENOKI_AUTODIFF_BUILD)
 #  define ENOKI_AUTODIFF_EXTERN extern
 #  define ENOKI_AUTODIFF_EXPORT ENOKI_EXPORT
@@ -1545,24 +2367,30 @@ template <typename T> std::string graphviz(const T &value) {
 #if !defined(ENOKI_BUILD)
     ENOKI_AUTODIFF_EXTERN template struct ENOKI_AUTODIFF_EXPORT Tape<float>;
     ENOKI_AUTODIFF_EXTERN template struct ENOKI_AUTODIFF_EXPORT DiffArray<float>;
+    ENOKI_AUTODIFF_EXTERN template struct ENOKI_AUTODIFF_EXPORT FrozenGraph<float>;
 
     ENOKI_AUTODIFF_EXTERN template struct ENOKI_AUTODIFF_EXPORT Tape<double>;
     ENOKI_AUTODIFF_EXTERN template struct ENOKI_AUTODIFF_EXPORT DiffArray<double>;
+    ENOKI_AUTODIFF_EXTERN template struct ENOKI_AUTODIFF_EXPORT FrozenGraph<double>;
 
 #  if defined(ENOKI_DYNAMIC_H)
         ENOKI_AUTODIFF_EXTERN template struct ENOKI_AUTODIFF_EXPORT Tape<DynamicArray<Packet<float>>>;
         ENOKI_AUTODIFF_EXTERN template struct ENOKI_AUTODIFF_EXPORT DiffArray<DynamicArray<Packet<float>>>;
+        ENOKI_AUTODIFF_EXTERN template struct ENOKI_AUTODIFF_EXPORT FrozenGraph<DynamicArray<Packet<float>>>;
 
         ENOKI_AUTODIFF_EXTERN template struct ENOKI_AUTODIFF_EXPORT Tape<DynamicArray<Packet<double>>>;
         ENOKI_AUTODIFF_EXTERN template struct ENOKI_AUTODIFF_EXPORT DiffArray<DynamicArray<Packet<double>>>;
+        ENOKI_AUTODIFF_EXTERN template struct ENOKI_AUTODIFF_EXPORT FrozenGraph<DynamicArray<Packet<double>>>;
 #  endif
 
 #  if defined(ENOKI_CUDA_H)
         ENOKI_AUTODIFF_EXTERN template struct ENOKI_AUTODIFF_EXPORT Tape<CUDAArray<float>>;
         ENOKI_AUTODIFF_EXTERN template struct ENOKI_AUTODIFF_EXPORT DiffArray<CUDAArray<float>>;
+        ENOKI_AUTODIFF_EXTERN template struct ENOKI_AUTODIFF_EXPORT FrozenGraph<CUDAArray<float>>;
 
         ENOKI_AUTODIFF_EXTERN template struct ENOKI_AUTODIFF_EXPORT Tape<CUDAArray<double>>;
         ENOKI_AUTODIFF_EXTERN template struct ENOKI_AUTODIFF_EXPORT DiffArray<CUDAArray<double>>;
+        ENOKI_AUTODIFF_EXTERN template struct ENOKI_AUTODIFF_EXPORT FrozenGraph<CUDAArray<double>>;
 #  endif
 #endif
 
@@ -0,0 +1,734 @@
+/*
+    enoki/cpu.h -- CPU-backed Enoki dynamic array with JIT compilation
+
+    Enoki is a C++ template library that enables transparent vectorization
+    of numerical kernels using SIMD instruction sets available on current
+    processor architectures.
+
+    Copyright (c) 2019 Wenzel Jakob <wenzel.jakob@epfl.ch>
+
+    All rights reserved. Use of this source code is governed by a BSD-style
+    license that can be found in the LICENSE file.
+*/
+
+#pragma once
+
+#define ENOKI_CPU_H 1
+
+#include <enoki/array.h>
+
+NAMESPACE_BEGIN(enoki)
+
+// -----------------------------------------------------------------------
+//! @{ \name Imports from libenoki-cpu.so
+// -----------------------------------------------------------------------
+
+/// Initialize the tracing JIT
+extern ENOKI_IMPORT void cpu_init();
+
+/// Delete the trace, requires a subsequent call by cpu_init()
+extern ENOKI_IMPORT void cpu_shutdown();
+
+/// Compile and evaluate the trace up to the current instruction
+extern ENOKI_IMPORT void cpu_eval(bool log_assembly = false);
+
+/// Invokes 'cpu_eval' if the given variable has not been evaluated yet
+extern ENOKI_IMPORT void cpu_eval_var(uint32_t index, bool log_assembly = false);
+
+/// Increase the reference count of a variable
+extern ENOKI_IMPORT void cpu_inc_ref_ext(uint32_t);
+
+/// Decrease the reference count of a variable
+extern ENOKI_IMPORT void cpu_dec_ref_ext(uint32_t);
+
+/// Return the size of a variable
+extern ENOKI_IMPORT size_t cpu_var_size(uint32_t);
+
+/// Return the pointer address of a variable
+extern ENOKI_IMPORT void* cpu_var_ptr(uint32_t);
+
+/// Retroactively adjust the recorded size of a variable
+extern ENOKI_IMPORT uint32_t cpu_var_set_size(uint32_t index, size_t size, bool copy = false);
+
+/// Mark a variable as dirty (e.g. due to scatter)
+extern ENOKI_IMPORT void cpu_var_mark_dirty(uint32_t);
+
+/// Attach a label to a variable (written to the generated C code)
+extern ENOKI_IMPORT void cpu_var_set_label(uint32_t, const char *);
+
+/// Needed to mark certain instructions with side effects (e.g. scatter)
+extern ENOKI_IMPORT void cpu_var_mark_side_effect(uint32_t);
+
+/// Set the current scatter/source operand array
+extern ENOKI_IMPORT void cpu_set_scatter_gather_operand(uint32_t index, bool gather);
+
+/**
+ * \brief Append an operation to the trace (0 arguments)
+ *
+ * Operations are C statements, in which \c $r1 refers to the output and
+ * \c $r2 .. \c $r4 to the arguments. \c $t<n> expands to the C type of
+ * operand \c n, \c $b<n> to its bit pattern as an unsigned integer, and
+ * \c $c<n>(...) converts such a bit pattern back into the type of operand
+ * \c n.
+ */
+extern ENOKI_IMPORT uint32_t cpu_trace_append(EnokiType type,
+                                              const char *op);
+
+/// Append an operation to the trace (1 argument)
+extern ENOKI_IMPORT uint32_t cpu_trace_append(EnokiType type,
+                                              const char *op,
+                                              uint32_t arg1);
+
+/// Append an operation to the trace (2 arguments)
+extern ENOKI_IMPORT uint32_t cpu_trace_append(EnokiType type,
+                                              const char *op,
+                                              uint32_t arg1,
+                                              uint32_t arg2);
+
+/// Append an operation to the trace (3 arguments)
+extern ENOKI_IMPORT uint32_t cpu_trace_append(EnokiType type,
+                                              const char *op,
+                                              uint32_t arg1,
+                                              uint32_t arg2,
+                                              uint32_t arg3);
+
+/// Copy some host memory region and wrap it in a variable
+extern ENOKI_IMPORT uint32_t cpu_var_copy(EnokiType type, size_t size,
+                                          const void *value);
+
+/// Create a variable that stores a pointer to some memory region
+extern ENOKI_IMPORT uint32_t cpu_var_register_ptr(const void *ptr);
+
+/// Register a memory region as a variable
+extern ENOKI_IMPORT uint32_t cpu_var_register(EnokiType type, size_t size,
+                                              void *ptr, bool dealloc);
+
+/// Fetch a scalar value from a CPU array
+extern ENOKI_IMPORT void cpu_fetch_element(void *, uint32_t, size_t, size_t);
+
+/// Allocate memory for a variable (64-byte aligned)
+extern ENOKI_IMPORT void* cpu_malloc(size_t);
+
+/// Release memory allocated by 'cpu_malloc()'
+extern ENOKI_IMPORT void cpu_free(void *);
+
+/// Print detailed information about currently allocated arrays
+extern ENOKI_IMPORT char *cpu_whos();
+
+/**
+ * \brief Kernel cache statistics: number of kernels found in memory, loaded
+ * from the on-disk cache (see \c ENOKI_CACHE_DIR), and compiled from scratch
+ */
+extern ENOKI_IMPORT void cpu_kernel_cache_stats(size_t *hits, size_t *hits_disk,
+                                                size_t *misses);
+
+/**
+ * \brief Kernel launch statistics: number of launched kernels, total number
+ * of operations, and number of operations fused into the largest kernel
+ */
+extern ENOKI_IMPORT void cpu_kernel_stats(size_t *launches, size_t *ops,
+                                          size_t *ops_max);
+
+/**
+ * \brief Execute kernels using a built-in interpreter instead of compiling
+ * them to machine code (default: \c false unless \c ENOKI_CPU_INTERPRET is set)
+ */
+extern ENOKI_IMPORT void cpu_set_interpreter(bool value);
+extern ENOKI_IMPORT bool cpu_interpreter();
+
+/**
+ * \brief Current log level (0: none, 1: kernel launches,
+ * 2: +compiler invocations, 3: +C source, 4: +jit trace, 5: +ref counting)
+ */
+extern ENOKI_IMPORT void cpu_set_log_level(uint32_t);
+extern ENOKI_IMPORT uint32_t cpu_log_level();
+
+//! @}
+// -----------------------------------------------------------------------
+
+template <typename Value>
+struct CPUArray : ArrayBase<value_t<Value>, CPUArray<Value>> {
+    template <typename T> friend struct CPUArray;
+    using Index = uint32_t;
+
+    static constexpr EnokiType Type = enoki_type_v<Value>;
+    static constexpr bool IsJIT = true;
+    template <typename T> using ReplaceValue = CPUArray<T>;
+    using MaskType = CPUArray<bool>;
+    using ArrayType = CPUArray;
+
+    static_assert(Type != EnokiType::Float16,
+                  "CPUArray: half precision arrays are not supported!");
+
+    CPUArray() = default;
+
+    ~CPUArray() {
+        cpu_dec_ref_ext(m_index);
+    }
+
+    CPUArray(const CPUArray &a) : m_index(a.m_index) {
+        cpu_inc_ref_ext(m_index);
+    }
+
+    CPUArray(CPUArray &&a) : m_index(a.m_index) {
+        a.m_index = 0;
+    }
+
+    template <typename T> CPUArray(const CPUArray<T> &v) {
+        m_index = cpu_trace_append(Type, "$r1 = ($t1) $r2", v.index_());
+    }
+
+    template <typename T>
+    CPUArray(const CPUArray<T> &v, detail::reinterpret_flag) {
+        static_assert(sizeof(T) == sizeof(Value));
+        if (std::is_integral_v<T> != std::is_integral_v<Value>) {
+            m_index = cpu_trace_append(Type, "$r1 = $c1($b2)", v.index_());
+        } else {
+            m_index = v.index_();
+            cpu_inc_ref_ext(m_index);
+        }
+    }
+
+    template <typename T, enable_if_t<std::is_scalar_v<T>> = 0>
+    CPUArray(const T &value, detail::reinterpret_flag)
+        : CPUArray(memcpy_cast<Value>(value)) { }
+
+    template <typename T, enable_if_t<std::is_scalar_v<T>> = 0>
+    CPUArray(T value) : CPUArray((Value) value) { }
+
+    CPUArray(Value value) {
+        const char *fmt = nullptr;
+
+        switch (sizeof(Value)) {
+            case 1:  fmt = "$r1 = $c1(0x%02x)"; break;
+            case 2:  fmt = "$r1 = $c1(0x%04x)"; break;
+            case 4:  fmt = "$r1 = $c1(0x%08xu)"; break;
+            default: fmt = "$r1 = $c1(0x%016llxull)"; break;
+        }
+
+        char tmp[48];
+        snprintf(tmp, 48, fmt, memcpy_cast<uint_array_t<Value>>(value));
+
+        m_index = cpu_trace_append(Type, tmp);
+    }
+
+    template <typename... Args, enable_if_t<(sizeof...(Args) > 1)> = 0>
+    CPUArray(Args&&... args) {
+        Value data[] = { (Value) args... };
+        m_index = cpu_var_copy(Type, sizeof...(Args), data);
+    }
+
+    CPUArray &operator=(const CPUArray &a) {
+        cpu_inc_ref_ext(a.m_index);
+        cpu_dec_ref_ext(m_index);
+        m_index = a.m_index;
+        return *this;
+    }
+
+    CPUArray &operator=(CPUArray &&a) {
+        std::swap(m_index, a.m_index);
+        return *this;
+    }
+
+    CPUArray add_(const CPUArray &v) const {
+        return CPUArray::from_index_(cpu_trace_append(Type,
+            "$r1 = $r2 + $r3", index_(), v.index_()));
+    }
+
+    CPUArray sub_(const CPUArray &v) const {
+        return CPUArray::from_index_(cpu_trace_append(Type,
+            "$r1 = $r2 - $r3", index_(), v.index_()));
+    }
+
+    CPUArray mul_(const CPUArray &v) const {
+        return CPUArray::from_index_(cpu_trace_append(Type,
+            "$r1 = $r2 * $r3", index_(), v.index_()));
+    }
+
+    CPUArray mulhi_(const CPUArray &v) const {
+        const char *op;
+        if constexpr (sizeof(Value) == 8)
+            op = std::is_signed_v<Value>
+                ? "$r1 = ($t1) (((__int128) $r2 * $r3) >> 64)"
+                : "$r1 = ($t1) (((unsigned __int128) $r2 * $r3) >> 64)";
+        else
+            op = std::is_signed_v<Value>
+                ? "$r1 = ($t1) (((int64_t) $r2 * $r3) >> (8 * sizeof($t1)))"
+                : "$r1 = ($t1) (((uint64_t) $r2 * $r3) >> (8 * sizeof($t1)))";
+
+        return CPUArray::from_index_(
+            cpu_trace_append(Type, op, index_(), v.index_()));
+    }
+
+    CPUArray div_(const CPUArray &v) const {
+        return CPUArray::from_index_(cpu_trace_append(Type,
+            "$r1 = $r2 / $r3", index_(), v.index_()));
+    }
+
+    CPUArray mod_(const CPUArray &v) const {
+        return CPUArray::from_index_(cpu_trace_append(Type,
+            "$r1 = $r2 % $r3", index_(), v.index_()));
+    }
+
+    CPUArray fmadd_(const CPUArray &a, const CPUArray &b) const {
+        return CPUArray::from_index_(cpu_trace_append(Type,
+            "$r1 = $r2 * $r3 + $r4", index_(), a.index_(), b.index_()));
+    }
+
+    CPUArray fmsub_(const CPUArray &a, const CPUArray &b) const {
+        return fmadd_(a, -b);
+    }
+
+    CPUArray fnmadd_(const CPUArray &a, const CPUArray &b) const {
+        return fmadd_(-a, b);
+    }
+
+    CPUArray fnmsub_(const CPUArray &a, const CPUArray &b) const {
+        return -fmadd_(a, b);
+    }
+
+    CPUArray max_(const CPUArray &v) const {
+        return CPUArray::from_index_(cpu_trace_append(Type,
+            "$r1 = $r2 > $r3 ? $r2 : $r3", index_(), v.index_()));
+    }
+
+    CPUArray min_(const CPUArray &v) const {
+        return CPUArray::from_index_(cpu_trace_append(Type,
+            "$r1 = $r2 < $r3 ? $r2 : $r3", index_(), v.index_()));
+    }
+
+    CPUArray abs_() const {
+        const char *op;
+        if constexpr (std::is_floating_point_v<Value>)
+            op = Single ? "$r1 = fabsf($r2)" : "$r1 = fabs($r2)";
+        else
+            op = "$r1 = $r2 < 0 ? -$r2 : $r2";
+        return CPUArray::from_index_(cpu_trace_append(Type, op, index_()));
+    }
+
+    CPUArray neg_() const {
+        return CPUArray::from_index_(cpu_trace_append(Type,
+            "$r1 = -$r2", index_()));
+    }
+
+    CPUArray sqrt_() const {
+        return CPUArray::from_index_(cpu_trace_append(Type,
+            Single ? "$r1 = sqrtf($r2)" : "$r1 = sqrt($r2)", index_()));
+    }
+
+    CPUArray rcp_() const {
+        return CPUArray::from_index_(cpu_trace_append(Type,
+            "$r1 = 1 / $r2", index_()));
+    }
+
+    CPUArray rsqrt_() const {
+        return CPUArray::from_index_(cpu_trace_append(Type,
+            Single ? "$r1 = 1 / sqrtf($r2)" : "$r1 = 1 / sqrt($r2)", index_()));
+    }
+
+    CPUArray floor_() const {
+        return CPUArray::from_index_(cpu_trace_append(Type,
+            Single ? "$r1 = floorf($r2)" : "$r1 = floor($r2)", index_()));
+    }
+
+    CPUArray ceil_() const {
+        return CPUArray::from_index_(cpu_trace_append(Type,
+            Single ? "$r1 = ceilf($r2)" : "$r1 = ceil($r2)", index_()));
+    }
+
+    CPUArray round_() const {
+        return CPUArray::from_index_(cpu_trace_append(Type,
+            Single ? "$r1 = rintf($r2)" : "$r1 = rint($r2)", index_()));
+    }
+
+    CPUArray trunc_() const {
+        return CPUArray::from_index_(cpu_trace_append(Type,
+            Single ? "$r1 = truncf($r2)" : "$r1 = trunc($r2)", index_()));
+    }
+
+    template <typename T> T floor2int_() const {
+        return T::from_index_(cpu_trace_append(T::Type,
+            Single ? "$r1 = ($t1) floorf($r2)" : "$r1 = ($t1) floor($r2)",
+            index_()));
+    }
+
+    template <typename T> T ceil2int_() const {
+        return T::from_index_(cpu_trace_append(T::Type,
+            Single ? "$r1 = ($t1) ceilf($r2)" : "$r1 = ($t1) ceil($r2)",
+            index_()));
+    }
+
+    CPUArray sl_(const CPUArray &v) const {
+        return CPUArray::from_index_(cpu_trace_append(Type,
+            "$r1 = $r2 << $r3", index_(), v.index_()));
+    }
+
+    CPUArray sr_(const CPUArray &v) const {
+        return CPUArray::from_index_(cpu_trace_append(Type,
+            "$r1 = $r2 >> $r3", index_(), v.index_()));
+    }
+
+    CPUArray sl_(size_t value) const { return sl_(CPUArray((Value) value)); }
+    CPUArray sr_(size_t value) const { return sr_(CPUArray((Value) value)); }
+
+    template <size_t Imm> CPUArray sl_() const { return sl_(Imm); }
+    template <size_t Imm> CPUArray sr_() const { return sr_(Imm); }
+
+    CPUArray not_() const {
+        const char *op = std::is_same_v<Value, bool>
+            ? "$r1 = !$r2" : "$r1 = $c1(~$b2)";
+        return CPUArray::from_index_(cpu_trace_append(Type, op, index_()));
+    }
+
+    CPUArray popcnt_() const {
+        return CPUArray::from_index_(cpu_trace_append(Type,
+            sizeof(Value) == 8 ? "$r1 = __builtin_popcountll($b2)"
+                               : "$r1 = __builtin_popcount($b2)", index_()));
+    }
+
+    CPUArray lzcnt_() const {
+        const char *op = sizeof(Value) == 8
+            ? "$r1 = $b2 ? __builtin_clzll($b2) : 64"
+            : "$r1 = $b2 ? __builtin_clz($b2) - (32 - 8 * sizeof($t1)) : 8 * sizeof($t1)";
+        return CPUArray::from_index_(cpu_trace_append(Type, op, index_()));
+    }
+
+    CPUArray tzcnt_() const {
+        const char *op = sizeof(Value) == 8
+            ? "$r1 = $b2 ? __builtin_ctzll($b2) : 64"
+            : "$r1 = $b2 ? __builtin_ctz($b2) : 8 * sizeof($t1)";
+        return CPUArray::from_index_(cpu_trace_append(Type, op, index_()));
+    }
+
+    template <typename T>
+    CPUArray or_(const CPUArray<T> &v) const {
+        Value all_ones = memcpy_cast<Value>(int_array_t<Value>(-1));
+        ENOKI_MARK_USED(all_ones);
+
+        if constexpr (std::is_same_v<T, Value>)
+            return CPUArray::from_index_(cpu_trace_append(Type,
+                "$r1 = $c1($b2 | $b3)", index_(), v.index_()));
+        else
+            return CPUArray::from_index_(cpu_trace_append(Type,
+                "$r1 = $r4 ? $r2 : $r3", CPUArray(all_ones).index_(),
+                index_(), v.index_()));
+    }
+
+    template <typename T>
+    CPUArray and_(const CPUArray<T> &v) const {
+        Value all_zeros = memcpy_cast<Value>(int_array_t<Value>(0));
+        ENOKI_MARK_USED(all_zeros);
+
+        if constexpr (std::is_same_v<T, Value>)
+            return CPUArray::from_index_(cpu_trace_append(Type,
+                "$r1 = $c1($b2 & $b3)", index_(), v.index_()));
+        else
+            return CPUArray::from_index_(cpu_trace_append(Type,
+                "$r1 = $r4 ? $r2 : $r3", index_(),
+                CPUArray(all_zeros).index_(), v.index_()));
+    }
+
+    template <typename T> CPUArray andnot_(const CPUArray<T> &v) const {
+        return and_(!v);
+    }
+
+    CPUArray xor_(const CPUArray &v) const {
+        return CPUArray::from_index_(cpu_trace_append(Type,
+            "$r1 = $c1($b2 ^ $b3)", index_(), v.index_()));
+    }
+
+    MaskType gt_(const CPUArray &v) const {
+        return MaskType::from_index_(cpu_trace_append(
+            EnokiType::Bool, "$r1 = $r2 > $r3", index_(), v.index_()));
+    }
+
+    MaskType ge_(const CPUArray &v) const {
+        return MaskType::from_index_(cpu_trace_append(
+            EnokiType::Bool, "$r1 = $r2 >= $r3", index_(), v.index_()));
+    }
+
+    MaskType lt_(const CPUArray &v) const {
+        return MaskType::from_index_(cpu_trace_append(
+            EnokiType::Bool, "$r1 = $r2 < $r3", index_(), v.index_()));
+    }
+
+    MaskType le_(const CPUArray &v) const {
+        return MaskType::from_index_(cpu_trace_append(
+            EnokiType::Bool, "$r1 = $r2 <= $r3", index_(), v.index_()));
+    }
+
+    MaskType eq_(const CPUArray &v) const {
+        return MaskType::from_index_(cpu_trace_append(
+            EnokiType::Bool, "$r1 = $r2 == $r3", index_(), v.index_()));
+    }
+
+    MaskType neq_(const CPUArray &v) const {
+        return MaskType::from_index_(cpu_trace_append(
+            EnokiType::Bool, "$r1 = $r2 != $r3", index_(), v.index_()));
+    }
+
+    static CPUArray select_(const MaskType &m, const CPUArray &t, const CPUArray &f) {
+        return CPUArray::from_index_(cpu_trace_append(Type,
+            "$r1 = $r4 ? $r2 : $r3", t.index_(), f.index_(), m.index_()));
+    }
+
+    static CPUArray arange_(ssize_t start, ssize_t stop, ssize_t step) {
+        size_t size = size_t((stop - start + step - (step > 0 ? 1 : -1)) / step);
+
+        using UInt32 = CPUArray<uint32_t>;
+        UInt32 index = UInt32::from_index_(
+            cpu_trace_append(EnokiType::UInt32, "$r1 = $r2", 1));
+        cpu_var_set_size(index.index_(), size);
+
+        if (start == 0 && step == 1)
+            return index;
+        else
+            return fmadd(index, CPUArray((Value) step), CPUArray((Value) start));
+    }
+
+    static CPUArray linspace_(Value min, Value max, size_t size) {
+        using UInt32 = CPUArray<uint32_t>;
+        UInt32 index = UInt32::from_index_(
+            cpu_trace_append(EnokiType::UInt32, "$r1 = $r2", 1));
+        cpu_var_set_size(index.index_(), size);
+
+        Value step = (max - min) / Value(size - 1);
+        return fmadd(index, CPUArray(step), CPUArray(min));
+    }
+
+    static CPUArray empty_(size_t size) {
+        return CPUArray::from_index_(cpu_var_register(
+            Type, size, cpu_malloc(size * sizeof(Value)), true));
+    }
+
+    static CPUArray zero_(size_t size) {
+        return full_(Value(0), size);
+    }
+
+    static CPUArray full_(const Value &value, size_t size) {
+        /* Broadcast lazily so that constants fuse into consumers */
+        CPUArray result(value);
+        if (size != 1)
+            result.m_index = cpu_var_set_size(result.m_index, size, true);
+        return result;
+    }
+
+    CPUArray hsum_() const {
+        size_t n = size();
+        if (n == 1)
+            return *this;
+        const Value *ptr = eval().data();
+        Value result = ptr[0];
+        for (size_t i = 1; i < n; ++i)
+            result += ptr[i];
+        return CPUArray(result);
+    }
+
+    CPUArray hprod_() const {
+        size_t n = size();
+        if (n == 1)
+            return *this;
+        const Value *ptr = eval().data();
+        Value result = ptr[0];
+        for (size_t i = 1; i < n; ++i)
+            result *= ptr[i];
+        return CPUArray(result);
+    }
+
+    CPUArray hmax_() const {
+        size_t n = size();
+        if (n == 1)
+            return *this;
+        const Value *ptr = eval().data();
+        Value result = ptr[0];
+        for (size_t i = 1; i < n; ++i)
+            result = std::max(result, ptr[i]);
+        return CPUArray(result);
+    }
+
+    CPUArray hmin_() const {
+        size_t n = size();
+        if (n == 1)
+            return *this;
+        const Value *ptr = eval().data();
+        Value result = ptr[0];
+        for (size_t i = 1; i < n; ++i)
+            result = std::min(result, ptr[i]);
+        return CPUArray(result);
+    }
+
+    CPUArray psum_() const {
+        size_t n = size();
+        if (n <= 1)
+            return *this;
+        const Value *ptr = eval().data();
+        Value *result = (Value *) cpu_malloc(n * sizeof(Value)), accum = 0;
+        for (size_t i = 0; i < n; ++i)
+            result[i] = accum = accum + ptr[i];
+        return map(result, n, true);
+    }
+
+    CPUArray reverse_() const {
+        size_t n = size();
+        if (n <= 1)
+            return *this;
+        const Value *ptr = eval().data();
+        Value *result = (Value *) cpu_malloc(n * sizeof(Value));
+        for (size_t i = 0; i < n; ++i)
+            result[i] = ptr[n - 1 - i];
+        return map(result, n, true);
+    }
+
+    bool all_() const {
+        const Value *ptr = eval().data();
+        for (size_t i = 0, n = size(); i < n; ++i) {
+            if (!ptr[i])
+                return false;
+        }
+        return true;
+    }
+
+    bool any_() const {
+        const Value *ptr = eval().data();
+        for (size_t i = 0, n = size(); i < n; ++i) {
+            if (ptr[i])
+                return true;
+        }
+        return false;
+    }
+
+    size_t count_() const {
+        const Value *ptr = eval().data();
+        size_t result = 0;
+        for (size_t i = 0, n = size(); i < n; ++i)
+            result += ptr[i] ? 1 : 0;
+        return result;
+    }
+
+    CPUArray &eval() {
+        cpu_eval_var(m_index);
+        return *this;
+    }
+
+    const CPUArray &eval() const {
+        cpu_eval_var(m_index);
+        return *this;
+    }
+
+    static CPUArray map(void *ptr, size_t size, bool dealloc = false) {
+        return CPUArray::from_index_(cpu_var_register(Type, size, ptr, dealloc));
+    }
+
+    static CPUArray copy(const void *ptr, size_t size) {
+        return CPUArray::from_index_(cpu_var_copy(Type, size, ptr));
+    }
+
+    template <size_t Stride, typename Index, typename Mask>
+    static CPUArray gather_(const void *ptr_, const Index &index,
+                            const Mask &mask) {
+        using UInt64 = CPUArray<uint64_t>;
+
+        UInt64 ptr    = UInt64::from_index_(cpu_var_register_ptr(ptr_)),
+               addr   = fmadd(UInt64(index), (uint64_t) Stride, ptr);
+
+        return CPUArray::from_index_(cpu_trace_append(Type,
+            "$r1 = $r3 ? *(const $t1 *) (uintptr_t) $r2 : 0",
+            addr.index_(), mask.index_()));
+    }
+
+    template <size_t Stride, typename Index, typename Mask>
+    ENOKI_INLINE void scatter_(void *ptr_, const Index &index, const Mask &mask) const {
+        using UInt64 = CPUArray<uint64_t>;
+
+        UInt64 ptr    = UInt64::from_index_(cpu_var_register_ptr(ptr_)),
+               addr   = fmadd(UInt64(index), (uint64_t) Stride, ptr);
+
+        CPUArray::Index var = cpu_trace_append(EnokiType::UInt64,
+            "if ($r4) *($t3 *) (uintptr_t) $r2 = $r3",
+            addr.index_(), m_index, mask.index_()
+        );
+
+        cpu_var_mark_side_effect(var);
+    }
+
+    template <size_t Stride, typename Index, typename Mask>
+    void scatter_add_(void *ptr_, const Index &index, const Mask &mask) const {
+        using UInt64 = CPUArray<uint64_t>;
+
+        UInt64 ptr    = UInt64::from_index_(cpu_var_register_ptr(ptr_)),
+               addr   = fmadd(UInt64(index), (uint64_t) Stride, ptr);
+
+        CPUArray::Index var = cpu_trace_append(Type,
+            "if ($r4) *($t1 *) (uintptr_t) $r2 += $r3",
+            addr.index_(), m_index, mask.index_()
+        );
+
+        cpu_var_mark_side_effect(var);
+    }
+
+    template <typename Mask> CPUArray compress_(const Mask &mask) const {
+        if (mask.size() == 0)
+            return CPUArray();
+        else if (size() == 1 && mask.size() != 0)
+            return *this;
+        else if (mask.size() != size())
+            throw std::runtime_error("CPUArray::compress_(): size mismatch!");
+        eval();
+        mask.eval();
+
+        size_t n = size(), new_size = 0;
+        const Value *ptr = data();
+        const bool *mask_ptr = mask.data();
+        Value *result = (Value *) cpu_malloc(n * sizeof(Value));
+        for (size_t i = 0; i < n; ++i) {
+            if (mask_ptr[i])
+                result[new_size++] = ptr[i];
+        }
+
+        if (new_size == 0) {
+            cpu_free(result);
+            return CPUArray();
+        }
+
+        return map(result, new_size, true);
+    }
+
+    Index index_() const { return m_index; }
+    size_t size() const { return cpu_var_size(m_index); }
+    bool empty() const { return size() == 0; }
+    const Value *data() const { return (const Value *) cpu_var_ptr(m_index); }
+    Value *data() { return (Value *) cpu_var_ptr(m_index); }
+    void resize(size_t size) {
+        m_index = cpu_var_set_size(m_index, size, true);
+    }
+
+    Value coeff(size_t i) const {
+        Value result = (Value) 0;
+        cpu_fetch_element(&result, m_index, i, sizeof(Value));
+        return result;
+    }
+
+    static CPUArray from_index_(Index index) {
+        CPUArray a;
+        a.m_index = index;
+        return a;
+    }
+
+protected:
+    static constexpr bool Single = std::is_same_v<Value, float>;
+
+    Index m_index = 0;
+};
+
+template <typename T, enable_if_t<!is_diff_array_v<T> && is_jit_array_v<T> &&
+                                  !is_cuda_array_v<T>> = 0>
+ENOKI_INLINE void set_label(const T& a, const char *label) {
+    if constexpr (array_depth_v<T> >= 2) {
+        for (size_t i = 0; i < T::Size; ++i)
+            set_label(a.coeff(i), (std::string(label) + "." + std::to_string(i)).c_str());
+    } else {
+        cpu_var_set_label(a.index_(), label);
+    }
+}
+
+NAMESPACE_END(enoki)
@@ -183,6 +183,13 @@ extern ENOKI_IMPORT void cuda_sync();
 /// Print detailed information about currently allocated arrays
 extern ENOKI_IMPORT char *cuda_whos();
 
+/**
+ * \brief Kernel cache statistics: number of kernels found in memory, loaded
+ * from the on-disk cache (see \c ENOKI_CACHE_DIR), and compiled from scratch
+ */
+extern ENOKI_IMPORT void cuda_kernel_cache_stats(size_t *hits, size_t *hits_disk,
+                                                 size_t *misses);
+
 /// Convert a variable into managed memory (if applicable)
 extern ENOKI_IMPORT void cuda_make_managed(uint32_t);
 
@@ -209,6 +216,7 @@ struct CUDAArray : ArrayBase<value_t<Value>, CUDAArray<Value>> {
 
     static constexpr EnokiType Type = enoki_type_v<Value>;
     static constexpr bool IsCUDA = true;
+    static constexpr bool IsJIT = true;
     template <typename T> using ReplaceValue = CUDAArray<T>;
     using MaskType = CUDAArray<bool>;
     using ArrayType = CUDAArray;
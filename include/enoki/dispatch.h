@@ -0,0 +1,250 @@
+/*
+    enoki/dispatch.h -- Select among variants of a function compiled for
+    different instruction sets at runtime
+
+    Enoki is a C++ template library that enables transparent vectorization
+    of numerical kernels using SIMD instruction sets available on current
+    processor architectures.
+
+    Copyright (c) 2019 Wenzel Jakob <wenzel.jakob@epfl.ch>
+
+    All rights reserved. Use of this source code is governed by a BSD-style
+    license that can be found in the LICENSE file.
+*/
+
+#pragma once
+
+#include <enoki/fwd.h>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#  include <intrin.h>
+#  define ENOKI_DISPATCH_X86 1
+#elif defined(__x86_64__) || defined(__i386__)
+#  include <cpuid.h>
+#  define ENOKI_DISPATCH_X86 1
+#endif
+
+NAMESPACE_BEGIN(enoki)
+
+/// Instruction sets targeted by \ref enoki_dispatch_sources(), in increasing order
+enum class Isa : uint32_t { Generic = 0, SSE42, AVX, AVX2, AVX512_SKX };
+
+/// Name of an instruction set (matches the values of \c ENOKI_DISPATCH_ISA)
+inline const char *isa_name(Isa isa) {
+    switch (isa) {
+        case Isa::SSE42:      return "sse42";
+        case Isa::AVX:        return "avx";
+        case Isa::AVX2:       return "avx2";
+        case Isa::AVX512_SKX: return "avx512_skx";
+        default:              return "generic";
+    }
+}
+
+NAMESPACE_BEGIN(detail)
+
+#if defined(ENOKI_DISPATCH_X86)
+inline void cpuid(uint32_t leaf, uint32_t subleaf, uint32_t regs[4]) {
+#  if defined(_MSC_VER)
+    __cpuidex((int *) regs, (int) leaf, (int) subleaf);
+#  else
+    __cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+#  endif
+}
+
+/// Register state that the operating system saves on context switches
+inline uint64_t xgetbv() {
+#  if defined(_MSC_VER)
+    return (uint64_t) _xgetbv(0);
+#  else
+    uint32_t eax, edx;
+    __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+    return ((uint64_t) edx << 32) | eax;
+#  endif
+}
+#endif
+
+/**
+ * \brief Query the best instruction set supported by the processor and the
+ * operating system. Each level requires the features enabled by the
+ * corresponding compiler flags (e.g. FMA, F16C, BMI and LZCNT for AVX2).
+ */
+inline Isa host_isa_detect() {
+    Isa result = Isa::Generic;
+#if defined(ENOKI_DISPATCH_X86)
+    uint32_t r[4];
+    cpuid(0, 0, r);
+    uint32_t max_leaf = r[0];
+    if (max_leaf < 1)
+        return result;
+
+    cpuid(1, 0, r);
+    uint32_t ecx1 = r[2];
+    if (!(ecx1 & (1u << 20)) || !(ecx1 & (1u << 23))) // SSE4.2, POPCNT
+        return result;
+    result = Isa::SSE42;
+
+    bool osxsave = (ecx1 & (1u << 27)) != 0,
+         avx     = (ecx1 & (1u << 28)) != 0;
+    uint64_t xcr0 = osxsave ? xgetbv() : 0;
+    if (!avx || (xcr0 & 0x6) != 0x6) // XMM and YMM state
+        return result;
+    result = Isa::AVX;
+
+    if (max_leaf < 7)
+        return result;
+    cpuid(7, 0, r);
+    uint32_t ebx7 = r[1];
+
+    cpuid(0x80000000u, 0, r);
+    bool lzcnt = false;
+    if (r[0] >= 0x80000001u) {
+        cpuid(0x80000001u, 0, r);
+        lzcnt = (r[2] & (1u << 5)) != 0;
+    }
+
+    bool fma  = (ecx1 & (1u << 12)) != 0,
+         f16c = (ecx1 & (1u << 29)) != 0,
+         avx2 = (ebx7 & (1u << 5)) != 0,
+         bmi1 = (ebx7 & (1u << 3)) != 0,
+         bmi2 = (ebx7 & (1u << 8)) != 0;
+    if (!(avx2 && fma && f16c && bmi1 && bmi2 && lzcnt))
+        return result;
+    result = Isa::AVX2;
+
+    const uint32_t avx512_skx = (1u << 16)  // AVX512F
+                              | (1u << 17)  // AVX512DQ
+                              | (1u << 28)  // AVX512CD
+                              | (1u << 30)  // AVX512BW
+                              | (1u << 31); // AVX512VL
+    if ((ebx7 & avx512_skx) != avx512_skx || (xcr0 & 0xE6) != 0xE6) // + opmask and ZMM state
+        return result;
+    result = Isa::AVX512_SKX;
+#endif
+    return result;
+}
+
+NAMESPACE_END(detail)
+
+/**
+ * \brief Instruction set used by dispatched functions on this machine
+ *
+ * This is the best instruction set supported by the host, optionally capped
+ * via the environment variable \c ENOKI_MAX_ISA (e.g. <tt>ENOKI_MAX_ISA=avx2</tt>).
+ * The value is determined once and then cached.
+ */
+inline Isa host_isa() {
+    static const Isa isa = []() {
+        Isa result = detail::host_isa_detect();
+        const char *max_isa = getenv("ENOKI_MAX_ISA");
+        if (max_isa) {
+            for (uint32_t i = 0; i <= (uint32_t) Isa::AVX512_SKX; ++i) {
+                if (strcmp(max_isa, isa_name(Isa(i))) == 0 && Isa(i) < result)
+                    result = Isa(i);
+            }
+        }
+        return result;
+    }();
+    return isa;
+}
+
+NAMESPACE_BEGIN(detail)
+
+/// Pick the best available variant (entries are \c nullptr for variants that weren't compiled)
+template <typename Func>
+Func dispatch_select(Func generic, Func sse42, Func avx, Func avx2, Func avx512_skx) {
+    Func variants[] = { generic, sse42, avx, avx2, avx512_skx };
+    for (uint32_t i = (uint32_t) host_isa(); i > 0; --i) {
+        if (variants[i])
+            return variants[i];
+    }
+    return generic;
+}
+
+NAMESPACE_END(detail)
+NAMESPACE_END(enoki)
+
+#if defined(ENOKI_DISPATCH_HAS_SSE42)
+#  define ENOKI_DISPATCH_IF_SSE42(x, y) x
+#else
+#  define ENOKI_DISPATCH_IF_SSE42(x, y) y
+#endif
+
+#if defined(ENOKI_DISPATCH_HAS_AVX)
+#  define ENOKI_DISPATCH_IF_AVX(x, y) x
+#else
+#  define ENOKI_DISPATCH_IF_AVX(x, y) y
+#endif
+
+#if defined(ENOKI_DISPATCH_HAS_AVX2)
+#  define ENOKI_DISPATCH_IF_AVX2(x, y) x
+#else
+#  define ENOKI_DISPATCH_IF_AVX2(x, y) y
+#endif
+
+#if defined(ENOKI_DISPATCH_HAS_AVX512_SKX)
+#  define ENOKI_DISPATCH_IF_AVX512_SKX(x, y) x
+#else
+#  define ENOKI_DISPATCH_IF_AVX512_SKX(x, y) y
+#endif
+
+/**
+ * \brief Open/close a namespace whose contents are compiled once per
+ * instruction set (see \ref ENOKI_DISPATCH)
+ *
+ * Within files passed to \c enoki_dispatch_sources(), all functions and
+ * templates must be defined inside such a namespace, which receives a nested
+ * inline namespace named after the instruction set (e.g. \c mylib::avx2).
+ */
+#if defined(ENOKI_DISPATCH_ISA)
+#  define ENOKI_DISPATCH_BEGIN(name) namespace name { inline namespace ENOKI_DISPATCH_ISA {
+#  define ENOKI_DISPATCH_END(name) } }
+#else
+#  define ENOKI_DISPATCH_BEGIN(name) namespace name {
+#  define ENOKI_DISPATCH_END(name) }
+#endif
+
+/**
+ * \brief Declare a function whose definition is compiled once per instruction
+ * set via the CMake function \c enoki_dispatch_sources().
+ *
+ * Example: a header included by both the dispatched source file and its callers
+ * contains the declaration
+ *
+ * \code
+ * NAMESPACE_BEGIN(mylib)
+ * ENOKI_DISPATCH(void, saxpy, (float a, const float *x, float *y, size_t n), (a, x, y, n))
+ * NAMESPACE_END(mylib)
+ * \endcode
+ *
+ * and the dispatched source file defines the function between
+ * <tt>ENOKI_DISPATCH_BEGIN(mylib)</tt> and <tt>ENOKI_DISPATCH_END(mylib)</tt>.
+ *
+ * Within the dispatched source file, this simply declares the function.
+ * Elsewhere, it declares the variants (e.g. \c mylib::avx2::saxpy) and
+ * defines a function \c mylib::saxpy that forwards each call to the variant
+ * matching \ref host_isa(). The function must not be overloaded.
+ */
+#if defined(ENOKI_DISPATCH_ISA)
+#  define ENOKI_DISPATCH(Ret, Name, Args, Params)                              \
+    inline namespace ENOKI_DISPATCH_ISA { Ret Name Args; }
+#else
+#  define ENOKI_DISPATCH(Ret, Name, Args, Params)                              \
+    namespace generic { Ret Name Args; }                                       \
+    ENOKI_DISPATCH_IF_SSE42(namespace sse42 { Ret Name Args; }, )              \
+    ENOKI_DISPATCH_IF_AVX(namespace avx { Ret Name Args; }, )                  \
+    ENOKI_DISPATCH_IF_AVX2(namespace avx2 { Ret Name Args; }, )                \
+    ENOKI_DISPATCH_IF_AVX512_SKX(namespace avx512_skx { Ret Name Args; }, )    \
+    inline Ret Name Args {                                                     \
+        using Func = Ret (*) Args;                                             \
+        static const Func func = enoki::detail::dispatch_select<Func>(         \
+            &generic::Name,                                                    \
+            ENOKI_DISPATCH_IF_SSE42(&sse42::Name, nullptr),                    \
+            ENOKI_DISPATCH_IF_AVX(&avx::Name, nullptr),                        \
+            ENOKI_DISPATCH_IF_AVX2(&avx2::Name, nullptr),                      \
+            ENOKI_DISPATCH_IF_AVX512_SKX(&avx512_skx::Name, nullptr));         \
+        return func Params;                                                    \
+    }
+#endif
@@ -0,0 +1,780 @@
+/*
+    enoki/dual.h -- Tape-free forward mode automatic differentiation using
+    dual numbers
+
+    Enoki is a C++ template library that enables transparent vectorization
+    of numerical kernels using SIMD instruction sets available on current
+    processor architectures.
+
+    Copyright (c) 2019 Wenzel Jakob <wenzel.jakob@epfl.ch>
+
+    All rights reserved. Use of this source code is governed by a BSD-style
+    license that can be found in the LICENSE file.
+*/
+
+#pragma once
+
+#include <enoki/array.h>
+
+#define ENOKI_DUAL_H 1
+
+NAMESPACE_BEGIN(enoki)
+
+NAMESPACE_BEGIN(detail)
+/// Placeholder for the tangents of mask and integer dual arrays
+struct dual_no_tangent { };
+NAMESPACE_END(detail)
+
+/**
+ * \brief Forward mode differentiable array based on dual numbers
+ *
+ * Each entry of the underlying scalar or (non-nested) static or dynamic array
+ * \c Type is paired with \c Lanes tangents, i.e. directional derivatives along
+ * \c Lanes independent input directions. Every operation updates the tangents
+ * right away using the chain rule, hence nothing is recorded on a tape, and the
+ * cost of an operation is roughly that of <tt>Lanes + 1</tt> primal ones.
+ *
+ * Tangents are seeded using \ref set_tangent() and queried using
+ * \ref tangent(). Values constructed from non-dual types have zero tangents.
+ * Static arrays, matrices, complex numbers, etc. of dual arrays are supported
+ * as well.
+ *
+ * \c Type can also be a differentiable array (e.g. <tt>DiffArray<FloatX></tt>),
+ * in which case values and tangents are both recorded on the reverse-mode
+ * tape. This is used by \ref hvp() to compute second derivatives.
+ */
+template <typename Type, size_t Lanes>
+struct DualArray : ArrayBase<value_t<Type>, DualArray<Type, Lanes>> {
+public:
+    using Base = enoki::ArrayBase<value_t<Type>, DualArray<Type, Lanes>>;
+    using typename Base::Scalar;
+
+    using UnderlyingType = Type;
+    using ArrayType = DualArray;
+    using MaskType = DualArray<mask_t<Type>, Lanes>;
+
+    static constexpr size_t Size = is_scalar_v<Type> ? 1 : array_size_v<Type>;
+    static constexpr size_t Depth = is_scalar_v<Type> ? 1 : array_depth_v<Type>;
+    static constexpr bool IsMask = is_mask_v<Type>;
+    static constexpr bool IsDual = true;
+    static constexpr bool Enabled =
+        std::is_floating_point_v<scalar_t<Type>> && !is_mask_v<Type>;
+
+    /// Storage of the tangent lanes (only present for floating point arrays)
+    using Tangent = std::conditional_t<Enabled, Array<Type, Lanes>,
+                                       detail::dual_no_tangent>;
+
+    template <typename T>
+    using ReplaceValue = DualArray<replace_scalar_t<Type, T, false>, Lanes>;
+
+    static_assert(array_depth_v<Type> <= 1 && !is_dual_array_v<Type>,
+                  "DualArray requires a scalar or (non-nested) static or "
+                  "dynamic Enoki array as template parameter.");
+    static_assert(Lanes > 0, "DualArray requires at least one tangent lane.");
+
+    // -----------------------------------------------------------------------
+    //! @{ \name Constructors
+    // -----------------------------------------------------------------------
+
+    DualArray() = default;
+    DualArray(const DualArray &) = default;
+    DualArray(DualArray &&) = default;
+    DualArray &operator=(const DualArray &) = default;
+    DualArray &operator=(DualArray &&) = default;
+
+    template <typename Type2, enable_if_t<!std::is_same_v<Type, Type2>> = 0>
+    DualArray(const DualArray<Type2, Lanes> &a) : m_value(a.value_()) {
+        if constexpr (Enabled) {
+            if constexpr (DualArray<Type2, Lanes>::Enabled)
+                m_tangent = Tangent(a.tangent_());
+            else
+                m_tangent = zero<Tangent>();
+        }
+    }
+
+    template <typename T>
+    DualArray(const DualArray<T, Lanes> &a, detail::reinterpret_flag)
+        : m_value(reinterpret_array<Type>(a.value_())),
+          m_tangent(tangent_zero()) { /* no derivatives */ }
+
+    template <typename... Args,
+             enable_if_t<sizeof...(Args) != 0 && std::conjunction_v<
+                  std::negation<is_dual_array<Args>>...>> = 0>
+    DualArray(Args&&... args)
+        : m_value(std::forward<Args>(args)...), m_tangent(tangent_zero()) { }
+
+    //! @}
+    // -----------------------------------------------------------------------
+
+    // -----------------------------------------------------------------------
+    //! @{ \name Vertical operations
+    // -----------------------------------------------------------------------
+
+    DualArray add_(const DualArray &a) const {
+        if constexpr (!Enabled)
+            return create(m_value + a.m_value);
+        else
+            return create(m_value + a.m_value, m_tangent + a.m_tangent);
+    }
+
+    DualArray sub_(const DualArray &a) const {
+        if constexpr (!Enabled)
+            return create(m_value - a.m_value);
+        else
+            return create(m_value - a.m_value, m_tangent - a.m_tangent);
+    }
+
+    DualArray mul_(const DualArray &a) const {
+        if constexpr (!Enabled)
+            return create(m_value * a.m_value);
+        else
+            return create(m_value * a.m_value,
+                          tangent_fmadd(m_tangent, a.m_value,
+                                        a.m_tangent, m_value));
+    }
+
+    DualArray div_(const DualArray &a) const {
+        if constexpr (!Enabled) {
+            return create(m_value / a.m_value);
+        } else {
+            Type rcp_a = rcp(a.m_value), result = m_value * rcp_a;
+            return create(result, tangent_fmadd(m_tangent, rcp_a, a.m_tangent,
+                                                -result * rcp_a));
+        }
+    }
+
+    DualArray fmadd_(const DualArray &a, const DualArray &b) const {
+        if constexpr (!Enabled)
+            return create(fmadd(m_value, a.m_value, b.m_value));
+        else
+            return create(fmadd(m_value, a.m_value, b.m_value),
+                          tangent_fmadd(m_tangent, a.m_value, a.m_tangent,
+                                        m_value) + b.m_tangent);
+    }
+
+    DualArray fmsub_(const DualArray &a, const DualArray &b) const {
+        if constexpr (!Enabled)
+            return create(fmsub(m_value, a.m_value, b.m_value));
+        else
+            return create(fmsub(m_value, a.m_value, b.m_value),
+                          tangent_fmadd(m_tangent, a.m_value, a.m_tangent,
+                                        m_value) - b.m_tangent);
+    }
+
+    DualArray fnmadd_(const DualArray &a, const DualArray &b) const {
+        if constexpr (!Enabled)
+            return create(fnmadd(m_value, a.m_value, b.m_value));
+        else
+            return create(fnmadd(m_value, a.m_value, b.m_value),
+                          b.m_tangent - tangent_fmadd(m_tangent, a.m_value,
+                                                      a.m_tangent, m_value));
+    }
+
+    DualArray fnmsub_(const DualArray &a, const DualArray &b) const {
+        if constexpr (!Enabled)
+            return create(fnmsub(m_value, a.m_value, b.m_value));
+        else
+            return create(fnmsub(m_value, a.m_value, b.m_value),
+                          -(tangent_fmadd(m_tangent, a.m_value, a.m_tangent,
+                                          m_value) + b.m_tangent));
+    }
+
+    DualArray neg_() const {
+        if constexpr (!Enabled)
+            return create(-m_value);
+        else
+            return create(-m_value, -m_tangent);
+    }
+
+    DualArray abs_() const {
+        if constexpr (!Enabled)
+            return create(abs(m_value));
+        else
+            return create(abs(m_value), tangent_mul(m_tangent, sign(m_value)));
+    }
+
+    DualArray sqrt_() const {
+        Type result = sqrt(m_value);
+        return create(result, tangent_mul(m_tangent, .5f / result));
+    }
+
+    DualArray cbrt_() const {
+        Type result = cbrt(m_value);
+        return create(result, tangent_mul(m_tangent, 1.f / (3 * sqr(result))));
+    }
+
+    DualArray rcp_() const {
+        Type result = rcp(m_value);
+        return create(result, tangent_mul(m_tangent, -sqr(result)));
+    }
+
+    DualArray rsqrt_() const {
+        Type result = rsqrt(m_value);
+        return create(result, tangent_mul(m_tangent, -.5f * sqr(result) * result));
+    }
+
+    DualArray min_(const DualArray &a) const {
+        if constexpr (!Enabled) {
+            return create(min(m_value, a.m_value));
+        } else {
+            mask_t<Type> m = m_value < a.m_value;
+            return create(min(m_value, a.m_value),
+                          tangent_select(m, m_tangent, a.m_tangent));
+        }
+    }
+
+    DualArray max_(const DualArray &a) const {
+        if constexpr (!Enabled) {
+            return create(max(m_value, a.m_value));
+        } else {
+            mask_t<Type> m = m_value > a.m_value;
+            return create(max(m_value, a.m_value),
+                          tangent_select(m, m_tangent, a.m_tangent));
+        }
+    }
+
+    static DualArray select_(const MaskType &m, const DualArray &t,
+                             const DualArray &f) {
+        if constexpr (!Enabled)
+            return create(select(m.value_(), t.m_value, f.m_value));
+        else
+            return create(select(m.value_(), t.m_value, f.m_value),
+                          tangent_select(m.value_(), t.m_tangent, f.m_tangent));
+    }
+
+    DualArray floor_() const { return create(floor(m_value)); }
+    DualArray ceil_()  const { return create(ceil(m_value)); }
+    DualArray trunc_() const { return create(trunc(m_value)); }
+    DualArray round_() const { return create(round(m_value)); }
+
+    template <typename T> T ceil2int_() const {
+        return T(ceil2int<typename T::UnderlyingType>(m_value));
+    }
+
+    template <typename T> T floor2int_() const {
+        return T(floor2int<typename T::UnderlyingType>(m_value));
+    }
+
+    DualArray sin_() const {
+        auto [s, c] = sincos(m_value);
+        return create(s, tangent_mul(m_tangent, c));
+    }
+
+    DualArray cos_() const {
+        auto [s, c] = sincos(m_value);
+        return create(c, tangent_mul(m_tangent, -s));
+    }
+
+    std::pair<DualArray, DualArray> sincos_() const {
+        auto [s, c] = sincos(m_value);
+        return { create(s, tangent_mul(m_tangent, c)),
+                 create(c, tangent_mul(m_tangent, -s)) };
+    }
+
+    DualArray tan_() const {
+        Type result = tan(m_value);
+        return create(result, tangent_mul(m_tangent, fmadd(result, result, 1)));
+    }
+
+    DualArray cot_() const {
+        Type result = cot(m_value);
+        return create(result, tangent_mul(m_tangent, -fmadd(result, result, 1)));
+    }
+
+    DualArray asin_() const {
+        return create(asin(m_value),
+                      tangent_mul(m_tangent, rsqrt(1 - sqr(m_value))));
+    }
+
+    DualArray acos_() const {
+        return create(acos(m_value),
+                      tangent_mul(m_tangent, -rsqrt(1 - sqr(m_value))));
+    }
+
+    DualArray atan_() const {
+        return create(atan(m_value),
+                      tangent_mul(m_tangent, rcp(1 + sqr(m_value))));
+    }
+
+    DualArray atan2_(const DualArray &x) const {
+        Type il2 = rcp(sqr(m_value) + sqr(x.m_value));
+        return create(atan2(m_value, x.m_value),
+                      tangent_fmadd(m_tangent, il2 * x.m_value,
+                                    x.m_tangent, -il2 * m_value));
+    }
+
+    DualArray sinh_() const {
+        auto [s, c] = sincosh(m_value);
+        return create(s, tangent_mul(m_tangent, c));
+    }
+
+    DualArray cosh_() const {
+        auto [s, c] = sincosh(m_value);
+        return create(c, tangent_mul(m_tangent, s));
+    }
+
+    std::pair<DualArray, DualArray> sincosh_() const {
+        auto [s, c] = sincosh(m_value);
+        return { create(s, tangent_mul(m_tangent, c)),
+                 create(c, tangent_mul(m_tangent, s)) };
+    }
+
+    DualArray tanh_() const {
+        Type result = tanh(m_value);
+        return create(result, tangent_mul(m_tangent, fnmadd(result, result, 1)));
+    }
+
+    DualArray asinh_() const {
+        return create(asinh(m_value),
+                      tangent_mul(m_tangent, rsqrt(1 + sqr(m_value))));
+    }
+
+    DualArray acosh_() const {
+        return create(acosh(m_value),
+                      tangent_mul(m_tangent, rsqrt(sqr(m_value) - 1)));
+    }
+
+    DualArray atanh_() const {
+        return create(atanh(m_value),
+                      tangent_mul(m_tangent, rcp(1 - sqr(m_value))));
+    }
+
+    DualArray exp_() const {
+        Type result = exp(m_value);
+        return create(result, tangent_mul(m_tangent, result));
+    }
+
+    DualArray log_() const {
+        return create(log(m_value), tangent_mul(m_tangent, rcp(m_value)));
+    }
+
+    DualArray ldexp_(const DualArray &e) const {
+        return create(ldexp(m_value, e.m_value),
+                      tangent_mul(m_tangent, ldexp(Type(1), e.m_value)));
+    }
+
+    std::pair<DualArray, DualArray> frexp_() const {
+        auto [m, e] = frexp(m_value);
+        Tangent t = tangent_mul(m_tangent, ldexp(Type(1), -e));
+        return { create(m, std::move(t)), create(e) };
+    }
+
+    //! @}
+    // -----------------------------------------------------------------------
+
+    // -----------------------------------------------------------------------
+    //! @{ \name Bit operations with masks
+    // -----------------------------------------------------------------------
+
+    DualArray or_(const DualArray &m) const {
+        static_assert(!Enabled, "DualArray: bit operations on floating point "
+                                "arrays are not differentiable!");
+        return create(m_value | m.m_value);
+    }
+
+    template <typename Mask> DualArray or_(const Mask &m) const {
+        if constexpr (!Enabled) {
+            return create(m_value | m.value_());
+        } else {
+            const Type ones(memcpy_cast<Scalar>(int_array_t<Scalar>(-1)));
+            return create(select(m.value_(), ones, m_value),
+                          tangent_select(m.value_(), tangent_zero(), m_tangent));
+        }
+    }
+
+    DualArray and_(const DualArray &m) const {
+        static_assert(!Enabled, "DualArray: bit operations on floating point "
+                                "arrays are not differentiable!");
+        return create(m_value & m.m_value);
+    }
+
+    template <typename Mask> DualArray and_(const Mask &m) const {
+        if constexpr (!Enabled)
+            return create(m_value & m.value_());
+        else
+            return create(select(m.value_(), m_value, Type(0)),
+                          tangent_select(m.value_(), m_tangent, tangent_zero()));
+    }
+
+    DualArray xor_(const DualArray &m) const {
+        static_assert(!Enabled, "DualArray: bit operations on floating point "
+                                "arrays are not differentiable!");
+        return create(m_value ^ m.m_value);
+    }
+
+    template <typename Mask> DualArray xor_(const Mask &m) const {
+        static_assert(!Enabled, "DualArray: bit operations on floating point "
+                                "arrays are not differentiable!");
+        return create(m_value ^ m.value_());
+    }
+
+    DualArray andnot_(const DualArray &m) const {
+        static_assert(!Enabled, "DualArray: bit operations on floating point "
+                                "arrays are not differentiable!");
+        return create(andnot(m_value, m.m_value));
+    }
+
+    template <typename Mask> DualArray andnot_(const Mask &m) const {
+        if constexpr (!Enabled)
+            return create(andnot(m_value, m.value_()));
+        else
+            return create(select(m.value_(), Type(0), m_value),
+                          tangent_select(m.value_(), tangent_zero(), m_tangent));
+    }
+
+    DualArray not_() const { return create(~m_value); }
+
+    //! @}
+    // -----------------------------------------------------------------------
+
+    // -----------------------------------------------------------------------
+    //! @{ \name Operations that don't require derivatives
+    // -----------------------------------------------------------------------
+
+    DualArray mod_(const DualArray &a) const { return create(m_value % a.m_value); }
+    DualArray mulhi_(const DualArray &a) const { return create(mulhi(m_value, a.m_value)); }
+    DualArray lzcnt_() const { return create(lzcnt(m_value)); }
+    DualArray tzcnt_() const { return create(tzcnt(m_value)); }
+    DualArray popcnt_() const { return create(popcnt(m_value)); }
+
+    template <size_t Imm> DualArray sl_() const { return create(sl<Imm>(m_value)); }
+    template <size_t Imm> DualArray sr_() const { return create(sr<Imm>(m_value)); }
+    DualArray sl_(const DualArray &a) const { return create(m_value << a.m_value); }
+    DualArray sr_(const DualArray &a) const { return create(m_value >> a.m_value); }
+    DualArray sl_(size_t size) const { return create(m_value << size); }
+    DualArray sr_(size_t size) const { return create(m_value >> size); }
+
+    auto eq_ (const DualArray &d) const { return MaskType(eq(m_value, d.m_value)); }
+    auto neq_(const DualArray &d) const { return MaskType(neq(m_value, d.m_value)); }
+    auto lt_ (const DualArray &d) const { return MaskType(m_value < d.m_value); }
+    auto le_ (const DualArray &d) const { return MaskType(m_value <= d.m_value); }
+    auto gt_ (const DualArray &d) const { return MaskType(m_value > d.m_value); }
+    auto ge_ (const DualArray &d) const { return MaskType(m_value >= d.m_value); }
+
+    //! @}
+    // -----------------------------------------------------------------------
+
+    // -----------------------------------------------------------------------
+    //! @{ \name Gather operations
+    // -----------------------------------------------------------------------
+
+    /// Gathered values are constants, hence their tangents are zero
+    template <size_t Stride, typename Offset, typename Mask>
+    static DualArray gather_(const void *ptr, const Offset &offset,
+                             const Mask &mask) {
+        return create(gather<Type, Stride>(ptr, offset.value_(), mask.value_()));
+    }
+
+    //! @}
+    // -----------------------------------------------------------------------
+
+    // -----------------------------------------------------------------------
+    //! @{ \name Horizontal operations
+    // -----------------------------------------------------------------------
+
+    using Horizontal =
+        DualArray<std::decay_t<decltype(hsum(std::declval<const Type &>()))>, Lanes>;
+
+    auto all_() const { return all(m_value); }
+    auto any_() const { return any(m_value); }
+    auto count_() const { return count(m_value); }
+
+    DualArray reverse_() const {
+        if constexpr (!Enabled)
+            return create(reverse(m_value));
+        else
+            return create(reverse(m_value), tangent_map(m_tangent,
+                          [](const Type &t) { return reverse(t); }));
+    }
+
+    DualArray psum_() const {
+        if constexpr (!Enabled)
+            return create(psum(m_value));
+        else
+            return create(psum(m_value), tangent_map(m_tangent,
+                          [](const Type &t) { return psum(t); }));
+    }
+
+    Horizontal hsum_() const {
+        if constexpr (is_scalar_v<Type>)
+            return *this;
+        else if constexpr (!Enabled)
+            return Horizontal(hsum(m_value));
+        else
+            return Horizontal::create(hsum(m_value), tangent_reduce(Type(1)));
+    }
+
+    Horizontal hprod_() const {
+        if constexpr (is_scalar_v<Type>) {
+            return *this;
+        } else if constexpr (!Enabled) {
+            return Horizontal(hprod(m_value));
+        } else {
+            typename Horizontal::UnderlyingType result = hprod(m_value);
+            return Horizontal::create(
+                result, tangent_reduce(select(eq(m_value, Scalar(0)), Scalar(0),
+                                              result / m_value)));
+        }
+    }
+
+    Horizontal hmax_() const {
+        if constexpr (is_scalar_v<Type>)
+            return *this;
+        else
+            return extract_(eq(m_value, hmax(m_value)));
+    }
+
+    Horizontal hmin_() const {
+        if constexpr (is_scalar_v<Type>)
+            return *this;
+        else
+            return extract_(eq(m_value, hmin(m_value)));
+    }
+
+    /// Extract the first entry (value and tangents) where \c mask is set
+    template <typename Mask> Horizontal extract_(const Mask &mask_) const {
+        static_assert(!is_dynamic_v<Type>,
+                      "DualArray: extract(), hmax() and hmin() are not "
+                      "supported for dynamic arrays!");
+        const mask_t<Type> &mask = mask_value(mask_);
+        if constexpr (is_scalar_v<Type>) {
+            return *this;
+        } else {
+            size_t index = 0;
+            for (size_t i = 0; i < Size; ++i) {
+                if (mask.coeff(i)) {
+                    index = i;
+                    break;
+                }
+            }
+            if constexpr (!Enabled) {
+                return Horizontal(m_value.coeff(index));
+            } else {
+                typename Horizontal::Tangent t;
+                for (size_t i = 0; i < Lanes; ++i)
+                    t.coeff(i) = m_tangent.coeff(i).coeff(index);
+                return Horizontal::create(m_value.coeff(index), std::move(t));
+            }
+        }
+    }
+
+    //! @}
+    // -----------------------------------------------------------------------
+
+    // -----------------------------------------------------------------------
+    //! @{ \name Access to internals
+    // -----------------------------------------------------------------------
+
+    Type &value_() { return m_value; }
+    const Type &value_() const { return m_value; }
+    Tangent &tangent_() { return m_tangent; }
+    const Tangent &tangent_() const { return m_tangent; }
+
+    ENOKI_INLINE static DualArray create(const Type &value) {
+        DualArray result;
+        result.m_value = value;
+        result.m_tangent = tangent_zero();
+        return result;
+    }
+
+    ENOKI_INLINE static DualArray create(const Type &value, Tangent &&tangent) {
+        DualArray result;
+        result.m_value = value;
+        result.m_tangent = std::move(tangent);
+        return result;
+    }
+
+    //! @}
+    // -----------------------------------------------------------------------
+
+    // -----------------------------------------------------------------------
+    //! @{ \name Coefficient access
+    // -----------------------------------------------------------------------
+
+    ENOKI_INLINE size_t size() const {
+        if constexpr (is_scalar_v<Type>)
+            return 1;
+        else
+            return slices(m_value);
+    }
+
+    ENOKI_INLINE bool empty() const { return size() == 0; }
+
+    ENOKI_NOINLINE void resize(size_t size) {
+        ENOKI_MARK_USED(size);
+        if constexpr (is_dynamic_v<Type>) {
+            m_value.resize(size);
+            if constexpr (Enabled) {
+                for (size_t i = 0; i < Lanes; ++i)
+                    m_tangent.coeff(i).resize(size);
+            }
+        }
+    }
+
+    ENOKI_INLINE Scalar *data() {
+        if constexpr (is_scalar_v<Type>)
+            return &m_value;
+        else
+            return m_value.data();
+    }
+
+    ENOKI_INLINE const Scalar *data() const {
+        if constexpr (is_scalar_v<Type>)
+            return &m_value;
+        else
+            return m_value.data();
+    }
+
+    template <typename... Args>
+    ENOKI_INLINE decltype(auto) coeff(Args... args) {
+        static_assert(sizeof...(Args) == Depth, "coeff(): Invalid number of arguments!");
+        if constexpr (is_scalar_v<Type>)
+            return m_value;
+        else
+            return m_value.coeff((size_t) args...);
+    }
+
+    template <typename... Args>
+    ENOKI_INLINE decltype(auto) coeff(Args... args) const {
+        static_assert(sizeof...(Args) == Depth, "coeff(): Invalid number of arguments!");
+        if constexpr (is_scalar_v<Type>)
+            return m_value;
+        else
+            return m_value.coeff((size_t) args...);
+    }
+
+    //! @}
+    // -----------------------------------------------------------------------
+
+    // -----------------------------------------------------------------------
+    //! @{ \name Standard initializers
+    // -----------------------------------------------------------------------
+
+    template <typename... Args>
+    static DualArray empty_(Args... args) { return create(enoki::empty<Type>(args...)); }
+    template <typename... Args>
+    static DualArray zero_(Args... args) { return create(zero<Type>(args...)); }
+    template <typename... Args>
+    static DualArray arange_(Args... args) { return create(arange<Type>(args...)); }
+    template <typename... Args>
+    static DualArray linspace_(Args... args) { return create(linspace<Type>(args...)); }
+    template <typename... Args>
+    static DualArray full_(Args... args) { return create(full<Type>(args...)); }
+
+    //! @}
+    // -----------------------------------------------------------------------
+
+private:
+    template <typename, size_t> friend struct DualArray;
+
+    ENOKI_INLINE static Tangent tangent_zero() {
+        if constexpr (Enabled)
+            return zero<Tangent>();
+        else
+            return Tangent();
+    }
+
+    /// Apply \c func to every tangent lane
+    template <typename Func>
+    ENOKI_INLINE static Tangent tangent_map(const Tangent &t, Func func) {
+        Tangent result;
+        for (size_t i = 0; i < Lanes; ++i)
+            result.coeff(i) = func(t.coeff(i));
+        return result;
+    }
+
+    /// Tangent of a unary operation with local derivative \c d
+    ENOKI_INLINE static Tangent tangent_mul(const Tangent &t, const Type &d) {
+        if constexpr (is_scalar_v<Type>)
+            return t * d;
+        else
+            return tangent_map(t, [&](const Type &t) { return t * d; });
+    }
+
+    /// Tangent of a binary operation with local derivatives \c d1 and \c d2
+    ENOKI_INLINE static Tangent tangent_fmadd(const Tangent &t1, const Type &d1,
+                                              const Tangent &t2, const Type &d2) {
+        if constexpr (is_scalar_v<Type>) {
+            return fmadd(t1, d1, t2 * d2);
+        } else {
+            Tangent result;
+            for (size_t i = 0; i < Lanes; ++i)
+                result.coeff(i) = fmadd(t1.coeff(i), d1, t2.coeff(i) * d2);
+            return result;
+        }
+    }
+
+    ENOKI_INLINE static Tangent tangent_select(const mask_t<Type> &m,
+                                               const Tangent &t,
+                                               const Tangent &f) {
+        if constexpr (is_scalar_v<Type>) {
+            return m ? t : f;
+        } else {
+            Tangent result;
+            for (size_t i = 0; i < Lanes; ++i)
+                result.coeff(i) = select(m, t.coeff(i), f.coeff(i));
+            return result;
+        }
+    }
+
+    /// Horizontal sum of the tangent lanes weighted by \c w
+    ENOKI_INLINE typename Horizontal::Tangent tangent_reduce(const Type &w) const {
+        typename Horizontal::Tangent result;
+        for (size_t i = 0; i < Lanes; ++i)
+            result.coeff(i) = hsum(m_tangent.coeff(i) * w);
+        return result;
+    }
+
+    template <typename Mask>
+    ENOKI_INLINE static decltype(auto) mask_value(const Mask &mask) {
+        if constexpr (is_dual_array_v<Mask>)
+            return mask.value_();
+        else
+            return mask;
+    }
+
+    Type m_value;
+    Tangent m_tangent;
+};
+
+/**
+ * \brief Return the tangent lane \c lane of a dual array, or of a static array
+ * (vector, matrix, ..) of dual arrays
+ */
+template <typename T> auto tangent(const T &a, size_t lane) {
+    if constexpr (is_dual_array_v<T> && array_depth_v<T> >= 2) {
+        using Value = decltype(tangent(a.coeff(0), lane));
+        using Result = typename T::template ReplaceValue<Value>;
+        Result result;
+        for (size_t i = 0; i < T::Size; ++i)
+            result.coeff(i) = tangent(a.coeff(i), lane);
+        return result;
+    } else if constexpr (is_dual_array_v<T>) {
+        return a.tangent_().coeff(lane);
+    } else {
+        static_assert(detail::false_v<T>, "tangent(): expected a dual array!");
+    }
+}
+
+/**
+ * \brief Set the tangent lane \c lane of a dual array, or of a static array of
+ * dual arrays. \c value must have the shape of <tt>detach(a)</tt>, or be a
+ * scalar that is broadcast to all entries.
+ */
+template <typename T1, typename T2> void set_tangent(T1 &a, size_t lane, const T2 &value) {
+    if constexpr (is_dual_array_v<T1> && array_depth_v<T1> >= 2) {
+        for (size_t i = 0; i < T1::Size; ++i) {
+            if constexpr (is_array_v<T2>)
+                set_tangent(a.coeff(i), lane, value.coeff(i));
+            else
+                set_tangent(a.coeff(i), lane, value);
+        }
+    } else if constexpr (is_dual_array_v<T1>) {
+        using Type = typename T1::UnderlyingType;
+        a.tangent_().coeff(lane) = Type(value);
+    } else {
+        static_assert(detail::false_v<T1, T2>, "set_tangent(): expected a dual array!");
+    }
+}
+
+NAMESPACE_END(enoki)
@@ -14,6 +14,8 @@
 #pragma once
 
 #include <enoki/array.h>
+#include <vector>
+#include <unordered_map>
 
 #if defined(__GNUC__) && !defined(__clang__)
 #  pragma GCC diagnostic push
@@ -22,8 +24,82 @@
 
 #define ENOKI_DYNAMIC_H 1
 
+/// Number of entries per chunk of the tree reductions over dynamic arrays
+#if !defined(ENOKI_REDUCE_BLOCK_SIZE)
+#  define ENOKI_REDUCE_BLOCK_SIZE 16384
+#endif
+
 NAMESPACE_BEGIN(enoki)
 
+namespace detail {
+    /// Execution policy of reductions: process all chunks on the calling thread
+    struct reduce_serial {
+        template <typename Body>
+        ENOKI_INLINE void operator()(size_t chunk_count, Body &&body) const {
+            body((size_t) 0, chunk_count);
+        }
+    };
+
+    /**
+     * \brief Reduce \c chunk_count partial results using a fixed pairwise tree
+     *
+     * The partial result of each chunk is computed by \c chunk_func, and the
+     * policy decides on which threads this happens. Since the order of
+     * operations only depends on \c chunk_count, the result is reproducible
+     * regardless of the policy and the number of threads.
+     */
+    template <typename Policy, typename T, typename ChunkFunc, typename Combine>
+    T reduce_chunked(const Policy &policy, size_t chunk_count, const T &identity,
+                     ChunkFunc &&chunk_func, Combine &&combine) {
+        if (chunk_count == 0)
+            return identity;
+        else if (chunk_count == 1)
+            return chunk_func((size_t) 0);
+
+        std::vector<T> partial(chunk_count);
+        policy(chunk_count, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i)
+                partial[i] = chunk_func(i);
+        });
+
+        for (size_t stride = 1; stride < chunk_count; stride *= 2)
+            for (size_t i = 0; i + stride < chunk_count; i += 2 * stride)
+                partial[i] = combine(partial[i], partial[i + stride]);
+
+        return partial[0];
+    }
+
+    /// In-register inclusive prefix sum of a packet (log-step scan for native SIMD types)
+    template <size_t Step = 1, typename Packet>
+    ENOKI_INLINE Packet psum_packet(const Packet &value) {
+        if constexpr (!Packet::IsNative) {
+            return psum(value);
+        } else if constexpr (Step >= Packet::Size) {
+            return value;
+        } else {
+            using Scalar = scalar_t<Packet>;
+            Packet shifted = select(arange<Packet>() >= Scalar(Step),
+                                    ror_array<Step>(value), zero<Packet>());
+            return psum_packet<Step * 2>(value + shifted);
+        }
+    }
+
+    /// Shift the entries of a packet by one position and zero-fill (inclusive -> exclusive scan)
+    template <typename Packet>
+    ENOKI_INLINE Packet psum_packet_shift(const Packet &value) {
+        using Scalar = scalar_t<Packet>;
+        return select(arange<Packet>() > Scalar(0), ror_array<1>(value), zero<Packet>());
+    }
+
+    /// Error-free addition of two floating point packets (Neumaier's variant of Kahan summation)
+    template <typename Packet>
+    ENOKI_INLINE void kahan_add(Packet &sum, Packet &comp, const Packet &value) {
+        Packet t = sum + value;
+        comp += select(abs(sum) >= abs(value), (sum - t) + value, (value - t) + sum);
+        sum = t;
+    }
+}
+
 template <typename Packet_>
 struct DynamicArrayReference : ArrayBase<value_t<Packet_>, DynamicArrayReference<Packet_>> {
     using Base = ArrayBase<value_t<Packet_>, DynamicArrayReference<Packet_>>;
@@ -112,6 +188,11 @@ struct DynamicArrayImpl : ArrayBase<value_t<Packet_>, Derived_> {
         operator=(value);
     }
 
+    template <typename Node>
+    DynamicArrayImpl(const DynamicExpr<Node> &expr) {
+        operator=(expr);
+    }
+
     template <typename Packet2, typename Derived2>
     DynamicArrayImpl(const DynamicArrayImpl<Packet2, Derived2> &other,
                      detail::reinterpret_flag) {
@@ -182,6 +263,18 @@ struct DynamicArrayImpl : ArrayBase<value_t<Packet_>, Derived_> {
         return derived();
     }
 
+    /// Evaluate a lazy expression (see \ref lazy()) in a single pass over the packets
+    template <typename Node>
+    ENOKI_NOINLINE DynamicArrayImpl &operator=(const DynamicExpr<Node> &expr) {
+        /* Write to a temporary, since 'expr' may reference this array */
+        Derived result;
+        result.resize(expr.size());
+        Packet *pr = result.packet_ptr();
+        ENOKI_IVDEP for (size_t i = 0, n = result.packets(); i < n; ++i)
+            pr[i] = Packet(expr.packet(i));
+        return operator=(std::move(result));
+    }
+
     ENOKI_INLINE DynamicArrayImpl &operator=(DynamicArrayImpl &&other) {
         m_packets.swap(other.m_packets);
         std::swap(m_packets_allocated, other.m_packets_allocated);
@@ -616,53 +709,177 @@ struct DynamicArrayImpl : ArrayBase<value_t<Packet_>, Derived_> {
     }
 
     Derived psum_() const {
+        return psum_(detail::reduce_serial(), false);
+    }
+
+    /**
+     * \brief Inclusive or exclusive prefix sum
+     *
+     * Two-pass scan: each chunk of \ref ENOKI_REDUCE_BLOCK_SIZE entries is first
+     * scanned locally using in-register prefix sums of its packets, after which
+     * the offsets of the preceding chunks are propagated. The order of
+     * operations does not depend on the policy.
+     */
+    template <typename Policy>
+    Derived psum_(const Policy &policy, bool exclusive) const {
         Derived result;
         set_slices(result, size());
 
-        if (!empty()) {
-            // Difficult to vectorize this..
-            result.coeff(0) = coeff(0);
-            for (size_t i = 1; i < size(); ++i)
-                result.coeff(i) = result.coeff(i - 1) + coeff(i);
+        size_t packet_count = packets(),
+               chunk_size = reduce_chunk_size_(),
+               chunk_count = (packet_count + chunk_size - 1) / chunk_size;
+
+        if (packet_count == 0)
+            return result;
+
+        std::vector<Value> offset(chunk_count);
+        policy(chunk_count, [&](size_t begin, size_t end) {
+            for (size_t chunk = begin; chunk < end; ++chunk) {
+                size_t start = chunk * chunk_size,
+                       stop = std::min(start + chunk_size, packet_count);
+                Value carry = Value(0);
+                for (size_t i = start; i < stop; ++i) {
+                    Packet sum = detail::psum_packet(packet(i));
+                    if (exclusive)
+                        result.packet(i) = detail::psum_packet_shift(sum) + carry;
+                    else
+                        result.packet(i) = sum + carry;
+                    carry += sum.coeff(PacketSize - 1);
+                }
+                offset[chunk] = carry;
+            }
+        });
+
+        if (chunk_count == 1)
+            return result;
+
+        Value accum = Value(0);
+        for (size_t chunk = 0; chunk < chunk_count; ++chunk) {
+            Value total = offset[chunk];
+            offset[chunk] = accum;
+            accum += total;
         }
 
+        policy(chunk_count, [&](size_t begin, size_t end) {
+            for (size_t chunk = std::max(begin, (size_t) 1); chunk < end; ++chunk) {
+                Packet value(offset[chunk]);
+                for (size_t i = chunk * chunk_size,
+                            stop = std::min(i + chunk_size, packet_count); i < stop; ++i)
+                    result.packet(i) += value;
+            }
+        });
+
         return result;
     }
 
     Value hsum_() const {
+        return hsum_(detail::reduce_serial());
+    }
+
+    template <typename Policy> Value hsum_(const Policy &policy) const {
         if (size() == 0) {
             return Value(Scalar(0));
         } else if (size() == 1) {
             return coeff(0);
         } else {
-            Packet result = zero<Packet>();
-            for (size_t i = 0, count = packets() - (PacketSize > 1 ? 1 : 0); i < count; ++i)
-                result += packet(i);
-
-            if constexpr (PacketSize > 1) {
-                result[arange<IndexPacket>() <= IndexScalar((size() - 1) % PacketSize)] +=
-                    packet(packets() - 1);
-            }
-            return hsum(result);
+            return hsum(reduce_packets_(policy, zero<Packet>(),
+                [](const Packet &a, const Packet &b) { return a + b; }));
         }
     }
 
     Value hprod_() const {
+        return hprod_(detail::reduce_serial());
+    }
+
+    template <typename Policy> Value hprod_(const Policy &policy) const {
         if (size() == 0) {
             return Value(Scalar(1));
         } else if (size() == 1) {
             return coeff(0);
         } else {
-            Packet result = Scalar(1);
-            for (size_t i = 0, count = packets() - (PacketSize > 1 ? 1 : 0); i < count; ++i)
-                result *= packet(i);
+            return hprod(reduce_packets_(policy, Packet(Scalar(1)),
+                [](const Packet &a, const Packet &b) { return a * b; }));
+        }
+    }
 
-            if constexpr (PacketSize > 1) {
-                result[arange<IndexPacket>() <= IndexScalar((size() - 1) % PacketSize)] *=
-                    packet(packets() - 1);
-            }
-            return hprod(result);
+    /// Compensated (Kahan-Neumaier) summation for improved accuracy
+    template <typename Policy = detail::reduce_serial>
+    Value hsum_kahan_(const Policy &policy = Policy()) const {
+        static_assert(std::is_floating_point_v<Scalar>,
+                      "hsum_kahan(): requires a floating point array!");
+        using Pair = std::pair<Packet, Packet>;
+
+        size_t packet_count = packets(),
+               chunk_size = reduce_chunk_size_(),
+               chunk_count = (packet_count + chunk_size - 1) / chunk_size;
+
+        Pair result = detail::reduce_chunked(
+            policy, chunk_count, Pair(zero<Packet>(), zero<Packet>()),
+            [&](size_t chunk) {
+                size_t start = chunk * chunk_size,
+                       end = std::min(start + chunk_size, packet_count);
+                Packet sum = zero<Packet>(), comp = zero<Packet>();
+                for (size_t i = start; i < end; ++i) {
+                    if (i + 1 == packet_count && PacketSize > 1)
+                        detail::kahan_add(sum, comp, select(
+                            arange<IndexPacket>() <= IndexScalar((size() - 1) % PacketSize),
+                            packet(i), zero<Packet>()));
+                    else
+                        detail::kahan_add(sum, comp, packet(i));
+                }
+                return Pair(sum, comp);
+            },
+            [](const Pair &a, const Pair &b) {
+                Pair result = a;
+                detail::kahan_add(result.first, result.second, b.first);
+                result.second += b.second;
+                return result;
+            });
+
+        Scalar sum = 0, comp = 0;
+        for (size_t i = 0; i < PacketSize; ++i) {
+            detail::kahan_add(sum, comp, result.first.coeff(i));
+            comp += result.second.coeff(i);
         }
+        return Value(sum + comp);
+    }
+
+    /// Number of packets per chunk of \ref reduce_packets_()
+    static constexpr size_t reduce_chunk_size_() {
+        return ENOKI_REDUCE_BLOCK_SIZE / PacketSize > 0 ?
+               ENOKI_REDUCE_BLOCK_SIZE / PacketSize : 1;
+    }
+
+    /**
+     * \brief Reduce the packets of the array using a deterministic chunked tree
+     *
+     * Packets are accumulated sequentially within chunks of
+     * \ref ENOKI_REDUCE_BLOCK_SIZE entries, which are then combined pairwise
+     * (see \ref detail::reduce_chunked()). Inactive entries of the last packet
+     * are left untouched.
+     */
+    template <typename Policy, typename Op>
+    Packet reduce_packets_(const Policy &policy, const Packet &identity, Op &&op) const {
+        size_t packet_count = packets(),
+               chunk_size = reduce_chunk_size_(),
+               chunk_count = (packet_count + chunk_size - 1) / chunk_size;
+
+        return detail::reduce_chunked(policy, chunk_count, identity,
+            [&](size_t chunk) {
+                size_t start = chunk * chunk_size,
+                       end = std::min(start + chunk_size, packet_count);
+                bool last = end == packet_count && PacketSize > 1;
+
+                Packet result = identity;
+                for (size_t i = start, count = end - (last ? 1 : 0); i < count; ++i)
+                    result = op(result, packet(i));
+
+                if (last) {
+                    result[arange<IndexPacket>() <= IndexScalar((size() - 1) % PacketSize)] =
+                        op(result, packet(end - 1));
+                }
+                return result;
+            }, op);
     }
 
     Value hmin_() const {
@@ -751,6 +968,54 @@ struct DynamicArrayImpl : ArrayBase<value_t<Packet_>, Derived_> {
         return result;
     }
 
+    /**
+     * \brief Group the entries of a pointer array by value
+     *
+     * Returns a list of (instance, index array) pairs in order of first
+     * occurrence, where each index array lists the positions of the instance.
+     * The implementation performs a single hashing pass to count the entries
+     * of each instance, followed by a pass that scatters the indices.
+     */
+    template <typename T = Value, enable_if_t<std::is_pointer_v<T>> = 0>
+    auto partition_() const {
+        using UInt32X = DynamicArray<uint32_array_t<IndexPacket>>;
+        using Entry = std::pair<Value, UInt32X>;
+
+        size_t n = size();
+        std::vector<Entry> result;
+        std::vector<uint32_t> bucket(n), counts;
+        std::unordered_map<Value, uint32_t> lookup;
+
+        Value prev = nullptr;
+        uint32_t prev_id = (uint32_t) -1;
+        for (size_t i = 0; i < n; ++i) {
+            Value value = coeff(i);
+            if (value != prev || prev_id == (uint32_t) -1) {
+                /* Neighboring entries frequently coincide: skip the hash table */
+                auto [it, inserted] = lookup.try_emplace(value, (uint32_t) counts.size());
+                if (inserted) {
+                    result.emplace_back(value, UInt32X());
+                    counts.push_back(0);
+                }
+                prev = value;
+                prev_id = it->second;
+            }
+            bucket[i] = prev_id;
+            counts[prev_id]++;
+        }
+
+        std::vector<uint32_t *> target(result.size());
+        for (size_t j = 0; j < result.size(); ++j) {
+            set_slices(result[j].second, counts[j]);
+            target[j] = result[j].second.data();
+        }
+
+        for (size_t i = 0; i < n; ++i)
+            *target[bucket[i]]++ = (uint32_t) i;
+
+        return result;
+    }
+
     //! @}
     // -----------------------------------------------------------------------
 
@@ -1008,77 +1273,110 @@ namespace detail {
     /// Vectorized inner loop (void return value)
     template <typename Func, typename... Args, size_t... Index>
     ENOKI_INLINE void vectorize_inner_1(std::index_sequence<Index...>, Func &&f,
-                                        size_t packet_count, Args &&... args) {
-        ENOKI_NOUNROLL ENOKI_IVDEP for (size_t i = 0; i < packet_count; ++i)
+                                        size_t packet_start, size_t packet_end,
+                                        Args &&... args) {
+        ENOKI_NOUNROLL ENOKI_IVDEP for (size_t i = packet_start; i < packet_end; ++i)
             f(packet(args, i)...);
     }
 
     /// Vectorized inner loop (non-void return value)
     template <typename Func, typename Out, typename... Args, size_t... Index>
     ENOKI_INLINE void vectorize_inner_2(std::index_sequence<Index...>, Func &&f,
-                                        size_t packet_count, Out &&out, Args &&... args) {
-        ENOKI_NOUNROLL ENOKI_IVDEP for (size_t i = 0; i < packet_count; ++i)
+                                        size_t packet_start, size_t packet_end,
+                                        Out &&out, Args &&... args) {
+        ENOKI_NOUNROLL ENOKI_IVDEP for (size_t i = packet_start; i < packet_end; ++i)
             packet(out, i) = f(packet(args, i)...);
     }
-}
 
-template <bool Resize = false, typename Func, typename... Args>
-auto vectorize(Func &&f, Args &&... args)
-    -> make_dynamic_t<decltype(f(packet(args, 0)...))> /* LLVM bug #39326 */ {
-#if defined(NDEBUG)
-    constexpr bool Check = false;
-#else
-    constexpr bool Check = true;
-#endif
+    /// Execution policy of vectorize(): process all packets on the calling thread
+    struct vectorize_serial {
+        template <typename Body>
+        ENOKI_INLINE void operator()(size_t packet_count, size_t /* slice_count */,
+                                     Body &&body) const {
+            body((size_t) 0, packet_count);
+        }
+    };
 
-    /** Determine the number of slices and packets of the input arrays,
-        and broadcast scalar input arrays if requested */
-    size_t packet_count = 0, slice_count = 0;
+    template <bool Resize, typename Policy, typename Func, typename... Args>
+    auto vectorize(const Policy &policy, Func &&f, Args &&... args)
+        -> make_dynamic_t<decltype(f(packet(args, 0)...))> /* LLVM bug #39326 */ {
+    #if defined(NDEBUG)
+        constexpr bool Check = false;
+    #else
+        constexpr bool Check = true;
+    #endif
 
-    bool unused1[] = { ((packet_count = !is_dynamic_v<Args> ? packet_count
-        : (Resize ? std::max(packet_count, packets(args)) : packets(args))), false)... };
+        /** Determine the number of slices and packets of the input arrays,
+            and broadcast scalar input arrays if requested */
+        size_t packet_count = 0, slice_count = 0;
 
-    bool unused2[] = { ((slice_count = !is_dynamic_v<Args> ? slice_count
-        : (Resize ? std::max(slice_count, slices(args)) : slices(args))), false)... };
+        bool unused1[] = { ((packet_count = !is_dynamic_v<Args> ? packet_count
+            : (Resize ? std::max(packet_count, packets(args)) : packets(args))), false)... };
 
-    (void) unused1; (void) unused2;
+        bool unused2[] = { ((slice_count = !is_dynamic_v<Args> ? slice_count
+            : (Resize ? std::max(slice_count, slices(args)) : slices(args))), false)... };
 
-    if constexpr (Check || Resize) {
-        size_t status[] = { (
-            (!is_dynamic_v<Args> || array_size_v<Args> == 0) ||
-            ((slice_count != 1 && slices(args) == 1 && Resize)
-                 ? (set_slices((detail::mutable_ref_t<decltype(args)>) args, slice_count), true)
-                 : (slices(args) == slice_count)))... };
+        (void) unused1; (void) unused2;
 
-        bool status_combined = true;
-        for (bool s : status)
-            status_combined &= s;
+        if constexpr (Check || Resize) {
+            size_t status[] = { (
+                (!is_dynamic_v<Args> || array_size_v<Args> == 0) ||
+                ((slice_count != 1 && slices(args) == 1 && Resize)
+                     ? (set_slices((detail::mutable_ref_t<decltype(args)>) args, slice_count), true)
+                     : (slices(args) == slice_count)))... };
 
-        if (!status_combined)
-            throw std::runtime_error("vectorize(): vector arguments have incompatible lengths");
-    }
+            bool status_combined = true;
+            for (bool s : status)
+                status_combined &= s;
 
-    using Result = make_dynamic_t<decltype(f(packet(args, 0)...))>;
-    if constexpr (std::is_void_v<Result>) {
-        detail::vectorize_inner_1(std::make_index_sequence<sizeof...(Args)>(),
-                                  f, packet_count, ref_wrap(args)...);
-    } else {
-        Result result;
-        set_slices(result, slice_count);
+            if (!status_combined)
+                throw std::runtime_error("vectorize(): vector arguments have incompatible lengths");
+        }
 
-        detail::vectorize_inner_2(std::make_index_sequence<sizeof...(Args)>(),
-                                  f, packet_count, ref_wrap(result),
-                                  ref_wrap(args)...);
-        return result;
+        using Result = make_dynamic_t<decltype(f(packet(args, 0)...))>;
+        if constexpr (std::is_void_v<Result>) {
+            policy(packet_count, slice_count, [&](size_t start, size_t end) {
+                detail::vectorize_inner_1(std::make_index_sequence<sizeof...(Args)>(),
+                                          f, start, end, ref_wrap(args)...);
+            });
+        } else {
+            Result result;
+            set_slices(result, slice_count);
+
+            policy(packet_count, slice_count, [&](size_t start, size_t end) {
+                detail::vectorize_inner_2(std::make_index_sequence<sizeof...(Args)>(),
+                                          f, start, end, ref_wrap(result),
+                                          ref_wrap(args)...);
+            });
+            return result;
+        }
     }
 }
 
+template <bool Resize = false, typename Func, typename... Args>
+auto vectorize(Func &&f, Args &&... args)
+    -> make_dynamic_t<decltype(f(packet(args, 0)...))> /* LLVM bug #39326 */ {
+    return detail::vectorize<Resize>(detail::vectorize_serial(), f, args...);
+}
+
 template <typename Func, typename... Args>
 auto vectorize_safe(Func &&f, Args &&... args)
     -> decltype(vectorize<true>(f, args...)) /* LLVM bug #39326 */ {
     return vectorize<true>(f, args...);
 }
 
+/// Exclusive prefix sum of a dynamic array
+template <typename Array, enable_if_dynamic_array_t<Array> = 0>
+auto psum_exclusive(const Array &a) {
+    return a.psum_(detail::reduce_serial(), true);
+}
+
+/// Compensated horizontal sum of a floating point dynamic array
+template <typename Array, enable_if_dynamic_array_t<Array> = 0>
+auto hsum_kahan(const Array &a) {
+    return a.hsum_kahan_();
+}
+
 namespace detail {
     template <typename T>
     using reference_dynamic_t = std::conditional_t<
@@ -1130,6 +1428,208 @@ auto vectorize_wrapper(Return (Class::*f)(Arg...) const) {
         (Return(*)(const Class *, Arg...)) nullptr);
 }
 
+// -----------------------------------------------------------------------
+//! @{ \name Lazily evaluated expressions over dynamic arrays
+// -----------------------------------------------------------------------
+
+/**
+ * \brief Node of a lazily evaluated expression over dynamic arrays
+ *
+ * Arithmetic involving dynamic arrays normally allocates and writes a
+ * temporary array for every operation. Expressions created via \ref lazy()
+ * instead build a tree of \c DynamicExpr nodes that is evaluated packet by
+ * packet in a single pass once it is assigned to a dynamic array or passed
+ * to \ref eval(). Nodes store references to the underlying arrays, which
+ * must therefore outlive the expression.
+ */
+template <typename Node_> struct DynamicExpr : Node_ {
+    using Node   = Node_;
+    using Packet = typename Node::Packet;
+    using Array  = DynamicArray<Packet>;
+
+    using Node::Node;
+
+    Array eval() const { return Array(*this); }
+};
+
+namespace detail {
+    /// Leaf node referencing a dynamic array (arrays of size 1 are broadcast)
+    template <typename Array> struct dynamic_expr_array {
+        using Packet = typename Array::Packet;
+
+        dynamic_expr_array(const Array &array)
+            : m_packets(array.packet_ptr()), m_size(array.size()),
+              m_stride(array.size() == 1 ? 0 : 1) { }
+
+        size_t size() const { return m_size; }
+
+        ENOKI_INLINE const Packet &packet(size_t i) const {
+            return m_packets[i * m_stride];
+        }
+
+    private:
+        const Packet *m_packets;
+        size_t m_size, m_stride;
+    };
+
+    /// Leaf node holding a broadcast scalar
+    template <typename Packet_> struct dynamic_expr_scalar {
+        using Packet = Packet_;
+
+        dynamic_expr_scalar(const Packet &value) : m_value(value) { }
+
+        size_t size() const { return 1; }
+
+        ENOKI_INLINE const Packet &packet(size_t) const { return m_value; }
+
+    private:
+        Packet m_value;
+    };
+
+    /// Interior node applying 'Func' to the packets of its operands
+    template <typename Func, typename... Args> struct dynamic_expr_op {
+        using Packet = std::decay_t<decltype(
+            Func()(std::declval<typename Args::Packet>()...))>;
+
+        dynamic_expr_op(const Args &... args)
+            : m_args(args...), m_size(std::max({ args.size()... })) {
+            if ((... || (args.size() != m_size && args.size() != 1)))
+                throw std::runtime_error(
+                    "Incompatible sizes in dynamic array operation");
+        }
+
+        size_t size() const { return m_size; }
+
+        ENOKI_INLINE Packet packet(size_t i) const {
+            return packet_(i, std::index_sequence_for<Args...>());
+        }
+
+    private:
+        template <size_t... Is>
+        ENOKI_INLINE Packet packet_(size_t i, std::index_sequence<Is...>) const {
+            return Func()(std::get<Is>(m_args).packet(i)...);
+        }
+
+        std::tuple<Args...> m_args;
+        size_t m_size;
+    };
+
+    template <typename T> struct is_dynamic_expr : std::false_type { };
+    template <typename Node> struct is_dynamic_expr<DynamicExpr<Node>> : std::true_type { };
+
+    template <typename T>
+    using has_packet_ptr = decltype(std::declval<const T &>().packet_ptr());
+
+    /// Values that can be combined with a lazy expression
+    template <typename T> constexpr bool is_dynamic_expr_operand_v =
+        !is_dynamic_expr<T>::value &&
+        (is_scalar_v<T> || (is_dynamic_array_v<T> && is_detected_v<has_packet_ptr, T>));
+
+    /// Turn an operand into an expression node (scalars are broadcast to 'Packet')
+    template <typename Packet, typename T>
+    ENOKI_INLINE auto dynamic_expr_wrap(const T &value) {
+        if constexpr (is_dynamic_expr<T>::value)
+            return value;
+        else if constexpr (is_scalar_v<T>)
+            return DynamicExpr<dynamic_expr_scalar<Packet>>(Packet(scalar_t<Packet>(value)));
+        else
+            return DynamicExpr<dynamic_expr_array<T>>(value);
+    }
+
+    template <typename Func, typename... Args>
+    ENOKI_INLINE auto dynamic_expr_make(const Args &... args) {
+        return DynamicExpr<dynamic_expr_op<Func, Args...>>(args...);
+    }
+}
+
+/// Start a lazily evaluated expression involving the dynamic array 'array'
+template <typename Array,
+          enable_if_t<detail::is_dynamic_expr_operand_v<Array> && !is_scalar_v<Array>> = 0>
+ENOKI_INLINE auto lazy(const Array &array) {
+    return DynamicExpr<detail::dynamic_expr_array<Array>>(array);
+}
+
+/// Evaluate a lazy expression into a dynamic array
+template <typename Node> auto eval(const DynamicExpr<Node> &expr) {
+    return expr.eval();
+}
+
+#define ENOKI_DYNAMIC_EXPR_UNARY(tag, name, op)                                \
+    namespace detail {                                                         \
+        struct dynamic_expr_##tag {                                            \
+            template <typename T>                                              \
+            ENOKI_INLINE auto operator()(const T &a) const { return op; }      \
+        };                                                                     \
+    }                                                                          \
+    template <typename N>                                                      \
+    ENOKI_INLINE auto name(const DynamicExpr<N> &a) {                          \
+        return detail::dynamic_expr_make<detail::dynamic_expr_##tag>(a);       \
+    }
+
+#define ENOKI_DYNAMIC_EXPR_BINARY(tag, name, op)                               \
+    namespace detail {                                                         \
+        struct dynamic_expr_##tag {                                            \
+            template <typename T1, typename T2>                                \
+            ENOKI_INLINE auto operator()(const T1 &a1, const T2 &a2) const {   \
+                return op;                                                     \
+            }                                                                  \
+        };                                                                     \
+    }                                                                          \
+    template <typename N1, typename N2>                                        \
+    ENOKI_INLINE auto name(const DynamicExpr<N1> &a1,                          \
+                           const DynamicExpr<N2> &a2) {                        \
+        return detail::dynamic_expr_make<detail::dynamic_expr_##tag>(a1, a2);  \
+    }                                                                          \
+    template <typename N1, typename T2,                                        \
+              enable_if_t<detail::is_dynamic_expr_operand_v<T2>> = 0>          \
+    ENOKI_INLINE auto name(const DynamicExpr<N1> &a1, const T2 &a2) {          \
+        using P = typename DynamicExpr<N1>::Packet;                            \
+        return name(a1, detail::dynamic_expr_wrap<P>(a2));                     \
+    }                                                                          \
+    template <typename T1, typename N2,                                        \
+              enable_if_t<detail::is_dynamic_expr_operand_v<T1>> = 0>          \
+    ENOKI_INLINE auto name(const T1 &a1, const DynamicExpr<N2> &a2) {          \
+        using P = typename DynamicExpr<N2>::Packet;                            \
+        return name(detail::dynamic_expr_wrap<P>(a1), a2);                     \
+    }
+
+ENOKI_DYNAMIC_EXPR_UNARY(neg,  operator-, -a)
+ENOKI_DYNAMIC_EXPR_UNARY(abs,  abs,  abs(a))
+ENOKI_DYNAMIC_EXPR_UNARY(sqrt, sqrt, sqrt(a))
+ENOKI_DYNAMIC_EXPR_UNARY(rcp,  rcp,  rcp(a))
+
+ENOKI_DYNAMIC_EXPR_BINARY(add, operator+, a1 + a2)
+ENOKI_DYNAMIC_EXPR_BINARY(sub, operator-, a1 - a2)
+ENOKI_DYNAMIC_EXPR_BINARY(mul, operator*, a1 * a2)
+ENOKI_DYNAMIC_EXPR_BINARY(div, operator/, a1 / a2)
+ENOKI_DYNAMIC_EXPR_BINARY(min, min, min(a1, a2))
+ENOKI_DYNAMIC_EXPR_BINARY(max, max, max(a1, a2))
+
+#undef ENOKI_DYNAMIC_EXPR_UNARY
+#undef ENOKI_DYNAMIC_EXPR_BINARY
+
+namespace detail {
+    struct dynamic_expr_fmadd {
+        template <typename T1, typename T2, typename T3>
+        ENOKI_INLINE auto operator()(const T1 &a1, const T2 &a2, const T3 &a3) const {
+            return fmadd(a1, a2, a3);
+        }
+    };
+}
+
+/// Fused multiply-add of lazy expressions (the first argument selects this overload)
+template <typename N1, typename T2, typename T3,
+          enable_if_t<(detail::is_dynamic_expr<T2>::value || detail::is_dynamic_expr_operand_v<T2>) &&
+                      (detail::is_dynamic_expr<T3>::value || detail::is_dynamic_expr_operand_v<T3>)> = 0>
+ENOKI_INLINE auto fmadd(const DynamicExpr<N1> &a1, const T2 &a2, const T3 &a3) {
+    using P = typename DynamicExpr<N1>::Packet;
+    return detail::dynamic_expr_make<detail::dynamic_expr_fmadd>(
+        a1, detail::dynamic_expr_wrap<P>(a2), detail::dynamic_expr_wrap<P>(a3));
+}
+
+//! @}
+// -----------------------------------------------------------------------
+
 #if defined(ENOKI_AUTODIFF_H) && !defined(ENOKI_BUILD)
     extern ENOKI_IMPORT template struct Tape<DynamicArray<Packet<float>>>;
     extern ENOKI_IMPORT template struct DiffArray<DynamicArray<Packet<float>>>;
@@ -79,6 +79,29 @@
 
 #define ENOKI_MARK_USED(x) (void) x
 
+#if defined(ENOKI_DISPATCH_ISA)
+/* Code compiled for runtime dispatch (see dispatch.h) places the contents of
+   namespace 'enoki' into an inline namespace named after the instruction set.
+   Otherwise, the linker would merge template instantiations that were compiled
+   for different instruction sets. Other namespaces are left as they are. */
+#  define ENOKI_DISPATCH_EXPAND(x) x
+#  define ENOKI_DISPATCH_SECOND(a, b, ...) b
+#  define ENOKI_DISPATCH_CHECK(...) ENOKI_DISPATCH_EXPAND(ENOKI_DISPATCH_SECOND(__VA_ARGS__, 0, ~))
+#  define ENOKI_DISPATCH_CAT(a, b) ENOKI_DISPATCH_CAT_2(a, b)
+#  define ENOKI_DISPATCH_CAT_2(a, b) a##b
+#  define ENOKI_DISPATCH_PROBE_enoki ~, 1
+#  define ENOKI_DISPATCH_OPEN_0
+#  define ENOKI_DISPATCH_OPEN_1 inline namespace ENOKI_DISPATCH_ISA {
+#  define ENOKI_DISPATCH_CLOSE_0
+#  define ENOKI_DISPATCH_CLOSE_1 }
+#  undef NAMESPACE_BEGIN
+#  undef NAMESPACE_END
+#  define NAMESPACE_BEGIN(name) namespace name { ENOKI_DISPATCH_CAT(ENOKI_DISPATCH_OPEN_, \
+          ENOKI_DISPATCH_CHECK(ENOKI_DISPATCH_PROBE_##name))
+#  define NAMESPACE_END(name) ENOKI_DISPATCH_CAT(ENOKI_DISPATCH_CLOSE_, \
+          ENOKI_DISPATCH_CHECK(ENOKI_DISPATCH_PROBE_##name)) }
+#endif
+
 #if !defined(NAMESPACE_BEGIN)
 #  define NAMESPACE_BEGIN(name) namespace name {
 #endif
@@ -280,9 +303,15 @@ struct PacketMask;
 template <typename Packet_> struct DynamicArray;
 template <typename Packet_> struct DynamicMask;
 
+/// Lazily evaluated expression over dynamic arrays (see \ref lazy())
+template <typename Node_> struct DynamicExpr;
+
 /// Reverse-mode autodiff array
 template <typename Value> struct DiffArray;
 
+/// Forward-mode autodiff array based on dual numbers
+template <typename Value, size_t Lanes = 1> struct DualArray;
+
 template <typename Value_, size_t Size_>
 struct Matrix;
 
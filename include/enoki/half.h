@@ -19,11 +19,11 @@ NAMESPACE_BEGIN(enoki)
 struct half;
 NAMESPACE_END(enoki)
 
-NAMESPACE_BEGIN(std)
+namespace std {
 template<> struct is_floating_point<enoki::half> : true_type { };
 template<> struct is_arithmetic<enoki::half> : true_type { };
 template<> struct is_signed<enoki::half> : true_type { };
-NAMESPACE_END(std)
+}
 
 NAMESPACE_BEGIN(enoki)
 struct half {
@@ -159,7 +159,7 @@ public:
 
 NAMESPACE_END(enoki)
 
-NAMESPACE_BEGIN(std)
+namespace std {
 
 template<> struct numeric_limits<enoki::half> {
     static constexpr bool is_signed = true;
@@ -189,5 +189,5 @@ template<> struct numeric_limits<enoki::half> {
     static enoki::half denorm_min() noexcept { return enoki::half::from_binary(0x0001); }
 };
 
-NAMESPACE_END(std)
+}
 
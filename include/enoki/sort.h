@@ -0,0 +1,252 @@
+/*
+    enoki/sort.h -- LSD radix sort, argsort and key-value sort for dynamic
+    arrays
+
+    Enoki is a C++ template library that enables transparent vectorization
+    of numerical kernels using SIMD instruction sets available on current
+    processor architectures.
+
+    Copyright (c) 2019 Wenzel Jakob <wenzel.jakob@epfl.ch>
+
+    All rights reserved. Use of this source code is governed by a BSD-style
+    license that can be found in the LICENSE file.
+*/
+
+#pragma once
+
+#define ENOKI_SORT_H 1
+
+#include <enoki/dynamic.h>
+
+/// Number of entries per chunk of the radix sort histogram and scatter passes
+#if !defined(ENOKI_SORT_BLOCK_SIZE)
+#  define ENOKI_SORT_BLOCK_SIZE 65536
+#endif
+
+NAMESPACE_BEGIN(enoki)
+NAMESPACE_BEGIN(detail)
+
+/**
+ * \brief Map a packet of keys to unsigned integers with the same ordering
+ *
+ * Signed integers have their sign bit flipped. Positive floating point values
+ * have their sign bit flipped, and negative ones are inverted entirely.
+ */
+template <typename Packet> ENOKI_INLINE auto radix_key(const Packet &value) {
+    using Scalar = scalar_t<Packet>;
+    using UInt = uint_array_t<Packet>;
+    using UIntScalar = scalar_t<UInt>;
+    constexpr size_t Shift = sizeof(Scalar) * 8 - 1;
+    const UInt sign_bit = UIntScalar(1) << Shift;
+
+    UInt u = reinterpret_array<UInt>(value);
+    if constexpr (std::is_floating_point_v<Scalar>)
+        return u ^ (sign_bit | (UInt(0) - sr<Shift>(u)));
+    else if constexpr (std::is_signed_v<Scalar>)
+        return u ^ sign_bit;
+    else
+        return u;
+}
+
+/// Inverse of \ref radix_key()
+template <typename Packet, typename UInt> ENOKI_INLINE Packet radix_key_inverse(const UInt &u) {
+    using Scalar = scalar_t<Packet>;
+    using UIntScalar = scalar_t<UInt>;
+    constexpr size_t Shift = sizeof(Scalar) * 8 - 1;
+    const UInt sign_bit = UIntScalar(1) << Shift;
+
+    if constexpr (std::is_floating_point_v<Scalar>)
+        return reinterpret_array<Packet>(u ^ (sign_bit | (sr<Shift>(u) - UIntScalar(1))));
+    else if constexpr (std::is_signed_v<Scalar>)
+        return reinterpret_array<Packet>(u ^ sign_bit);
+    else
+        return reinterpret_array<Packet>(u);
+}
+
+/**
+ * \brief Stable LSD radix sort of \c keys (and optionally a payload \c index)
+ *
+ * Processes 8-bit digits, skipping digits that are identical for all keys.
+ * Each pass builds one histogram per chunk of \ref ENOKI_SORT_BLOCK_SIZE
+ * entries and then scatters the entries of every chunk to their final
+ * position. The policy determines on which threads the chunks are processed;
+ * the result does not depend on it. The sorted data ends up in \c keys and
+ * \c index, and \c keys_tmp and \c index_tmp are used as scratch space.
+ */
+template <typename Policy, typename KeyX, typename IndexX>
+void radix_sort(const Policy &policy, size_t size, KeyX &keys, KeyX &keys_tmp,
+                IndexX *index, IndexX *index_tmp) {
+    using Key = scalar_t<KeyX>;
+    constexpr size_t Digits = sizeof(Key), Radix = 256;
+
+    size_t chunk_size = ENOKI_SORT_BLOCK_SIZE,
+           chunk_count = (size + chunk_size - 1) / chunk_size;
+
+    if (size <= 1)
+        return;
+
+    /* Determine which digits differ between the keys */
+    const Key first = keys.coeff(0);
+    Key diff = reduce_chunked(
+        policy, chunk_count, Key(0),
+        [&](size_t chunk) {
+            const Key *ptr = keys.data();
+            size_t start = chunk * chunk_size,
+                   end = std::min(start + chunk_size, size);
+            Key result = 0;
+            ENOKI_IVDEP for (size_t i = start; i < end; ++i)
+                result |= ptr[i] ^ first;
+            return result;
+        },
+        [](Key a, Key b) { return a | b; });
+
+    std::unique_ptr<uint32_t[]> hist(new uint32_t[chunk_count * Radix]);
+
+    for (size_t digit = 0; digit < Digits; ++digit) {
+        size_t shift = digit * 8;
+        if (((diff >> shift) & 0xFF) == 0)
+            continue;
+
+        /* Pass 1: per-chunk histograms */
+        policy(chunk_count, [&](size_t begin, size_t end) {
+            for (size_t chunk = begin; chunk < end; ++chunk) {
+                uint32_t *h = hist.get() + chunk * Radix;
+                memset(h, 0, Radix * sizeof(uint32_t));
+                const Key *ptr = keys.data();
+                for (size_t i = chunk * chunk_size,
+                            stop = std::min(i + chunk_size, size); i < stop; ++i)
+                    h[(ptr[i] >> shift) & 0xFF]++;
+            }
+        });
+
+        /* Exclusive prefix sum over (digit, chunk) pairs */
+        uint32_t accum = 0;
+        for (size_t d = 0; d < Radix; ++d) {
+            for (size_t chunk = 0; chunk < chunk_count; ++chunk) {
+                uint32_t &h = hist[chunk * Radix + d], count = h;
+                h = accum;
+                accum += count;
+            }
+        }
+
+        /* Pass 2: stable scatter */
+        policy(chunk_count, [&](size_t begin, size_t end) {
+            for (size_t chunk = begin; chunk < end; ++chunk) {
+                uint32_t *offset = hist.get() + chunk * Radix;
+                const Key *src = keys.data();
+                Key *dst = keys_tmp.data();
+                size_t i = chunk * chunk_size,
+                       stop = std::min(i + chunk_size, size);
+                if (index) {
+                    const uint32_t *src_i = index->data();
+                    uint32_t *dst_i = index_tmp->data();
+                    for (; i < stop; ++i) {
+                        uint32_t pos = offset[(src[i] >> shift) & 0xFF]++;
+                        dst[pos] = src[i];
+                        dst_i[pos] = src_i[i];
+                    }
+                } else {
+                    for (; i < stop; ++i)
+                        dst[offset[(src[i] >> shift) & 0xFF]++] = src[i];
+                }
+            }
+        });
+
+        std::swap(keys, keys_tmp);
+        if (index)
+            std::swap(*index, *index_tmp);
+    }
+}
+
+template <typename Policy, typename Array>
+auto radix_sort_keys(const Policy &policy, const Array &a) {
+    using KeyX = DynamicArray<uint_array_t<typename Array::Packet>>;
+    static_assert(std::is_arithmetic_v<scalar_t<Array>> && !Array::IsMask,
+                  "sort(): expected an integer or floating point array!");
+
+    size_t size = a.size(), packet_count = a.packets();
+    KeyX keys;
+    set_slices(keys, size);
+
+    policy((packet_count + ENOKI_SORT_BLOCK_SIZE - 1) / ENOKI_SORT_BLOCK_SIZE,
+           [&](size_t begin, size_t end) {
+        for (size_t i = begin * ENOKI_SORT_BLOCK_SIZE,
+                    stop = std::min(end * ENOKI_SORT_BLOCK_SIZE, packet_count);
+             i < stop; ++i)
+            keys.packet(i) = radix_key(a.packet(i));
+    });
+
+    return keys;
+}
+
+template <typename Policy, typename Array>
+Array sort(const Policy &policy, const Array &a) {
+    using KeyX = DynamicArray<uint_array_t<typename Array::Packet>>;
+    using IndexX = DynamicArray<uint32_array_t<typename Array::Packet>>;
+
+    size_t size = a.size();
+    if (size > (size_t) std::numeric_limits<uint32_t>::max())
+        throw std::runtime_error("sort(): arrays with more than 2^32 entries are not supported!");
+
+    KeyX keys = radix_sort_keys(policy, a), keys_tmp;
+    set_slices(keys_tmp, size);
+    radix_sort(policy, size, keys, keys_tmp, (IndexX *) nullptr, (IndexX *) nullptr);
+
+    Array result;
+    set_slices(result, size);
+    for (size_t i = 0; i < result.packets(); ++i)
+        result.packet(i) = radix_key_inverse<typename Array::Packet>(keys.packet(i));
+    return result;
+}
+
+template <typename Policy, typename Array>
+auto argsort(const Policy &policy, const Array &a) {
+    using KeyX = DynamicArray<uint_array_t<typename Array::Packet>>;
+    using IndexX = DynamicArray<uint32_array_t<typename Array::Packet>>;
+
+    size_t size = a.size();
+    if (size > (size_t) std::numeric_limits<uint32_t>::max())
+        throw std::runtime_error("argsort(): arrays with more than 2^32 entries are not supported!");
+
+    KeyX keys = radix_sort_keys(policy, a), keys_tmp;
+    IndexX index = arange<IndexX>(size), index_tmp;
+    set_slices(keys_tmp, size);
+    set_slices(index_tmp, size);
+    radix_sort(policy, size, keys, keys_tmp, &index, &index_tmp);
+    return index;
+}
+
+template <typename Policy, typename Keys, typename Values>
+std::pair<Keys, Values> sort_by_key(const Policy &policy, const Keys &keys,
+                                    const Values &values) {
+    auto index = argsort(policy, keys);
+    return { gather<Keys>(keys, index), gather<Values>(values, index) };
+}
+
+NAMESPACE_END(detail)
+
+/// Sort the entries of an integer or floating point dynamic array
+template <typename Array, enable_if_dynamic_array_t<Array> = 0>
+Array sort(const Array &a) {
+    return detail::sort(detail::reduce_serial(), a);
+}
+
+/**
+ * \brief Return the permutation (as a \c uint32_t array) that stably sorts
+ * the entries of an integer or floating point dynamic array
+ */
+template <typename Array, enable_if_dynamic_array_t<Array> = 0>
+auto argsort(const Array &a) {
+    return detail::argsort(detail::reduce_serial(), a);
+}
+
+/**
+ * \brief Stably sort the dynamic array \c keys and apply the same permutation
+ * to \c values, which can also be a dynamic data structure
+ */
+template <typename Keys, typename Values, enable_if_dynamic_array_t<Keys> = 0>
+std::pair<Keys, Values> sort_by_key(const Keys &keys, const Values &values) {
+    return detail::sort_by_key(detail::reduce_serial(), keys, values);
+}
+
+NAMESPACE_END(enoki)
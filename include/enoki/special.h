@@ -71,14 +71,14 @@ Expr erfc(const T &x) {
         Expr q  = rcp(xa),
              y  = q*q, p_small, p_large;
 
-        if (is_cuda_array_v<Expr> || !all_nested(large_mask))
+        if (is_jit_array_v<Expr> || !all_nested(large_mask))
             p_small = poly8(y, 5.638259427386472e-1, -2.741127028184656e-1,
                                3.404879937665872e-1, -4.944515323274145e-1,
                                6.210004621745983e-1, -5.824733027278666e-1,
                                3.687424674597105e-1, -1.387039388740657e-1,
                                2.326819970068386e-2);
 
-        if (is_cuda_array_v<Expr> || any_nested(large_mask))
+        if (is_jit_array_v<Expr> || any_nested(large_mask))
             p_large = poly7(y, 5.641895067754075e-1, -2.820767439740514e-1,
                                4.218463358204948e-1, -1.015265279202700e+0,
                                2.921019019210786e+0, -7.495518717768503e+0,
@@ -87,7 +87,7 @@ Expr erfc(const T &x) {
     } else {
         Expr p_small, p_large, q_small, q_large;
 
-        if (is_cuda_array_v<Expr> || !all_nested(large_mask)) {
+        if (is_jit_array_v<Expr> || !all_nested(large_mask)) {
             p_small = poly8(xa, 5.57535335369399327526e2, 1.02755188689515710272e3,
                                 9.34528527171957607540e2, 5.26445194995477358631e2,
                                 1.96520832956077098242e2, 4.86371970985681366614e1,
@@ -102,7 +102,7 @@ Expr erfc(const T &x) {
         }
 
 
-        if (is_cuda_array_v<Expr> || any_nested(large_mask)) {
+        if (is_jit_array_v<Expr> || any_nested(large_mask)) {
             p_large = poly5(xa, 2.97886665372100240670e0, 7.40974269950448939160e0,
                                 6.16021097993053585195e0, 5.01905042251180477414e0,
                                 1.27536670759978104416e0, 5.64189583547755073984e-1);
@@ -122,7 +122,7 @@ Expr erfc(const T &x) {
     r[x < Scalar(0)] = Scalar(2) - r;
 
     if constexpr (Recurse) {
-        if (ENOKI_UNLIKELY(is_cuda_array_v<Expr> || any_nested(erf_mask)))
+        if (ENOKI_UNLIKELY(is_jit_array_v<Expr> || any_nested(erf_mask)))
             r[erf_mask] = Scalar(1) - erf<T, false>(x);
     }
     return r;
@@ -156,7 +156,7 @@ Expr erf(const T &x) {
     r *= x;
 
     if constexpr (Recurse) {
-        if (ENOKI_UNLIKELY(is_cuda_array_v<Expr> || any_nested(erfc_mask)))
+        if (ENOKI_UNLIKELY(is_jit_array_v<Expr> || any_nested(erfc_mask)))
             r[erfc_mask] = Scalar(1) - erfc<T, false>(x);
     }
 
@@ -300,7 +300,7 @@ template <typename Value> Value lgamma(Value x_) {
     // gamma(x) = sqrt(2*pi) * sum * b^(x + .5) / exp(b)
     Value result = ((log_sqrt2pi + log(sum)) - b) + log(b) * (x + .5f);
 
-    if (is_cuda_array_v<Value> || any_nested(reflect)) {
+    if (is_jit_array_v<Value> || any_nested(reflect)) {
         masked(result, reflect) = log(abs(Scalar(M_PI) / sin(Scalar(M_PI) * x_))) - result;
         masked(result, reflect && eq(x_, round(x_))) = std::numeric_limits<Scalar>::infinity();
     }
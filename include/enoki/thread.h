@@ -0,0 +1,269 @@
+/*
+    enoki/thread.h -- Work-stealing thread pool for parallel loops over
+    dynamic arrays
+
+    Enoki is a C++ template library that enables transparent vectorization
+    of numerical kernels using SIMD instruction sets available on current
+    processor architectures.
+
+    Copyright (c) 2019 Wenzel Jakob <wenzel.jakob@epfl.ch>
+
+    All rights reserved. Use of this source code is governed by a BSD-style
+    license that can be found in the LICENSE file.
+*/
+
+#pragma once
+
+#define ENOKI_THREAD_H 1
+
+#include <enoki/dynamic.h>
+#include <enoki/sort.h>
+
+/// Number of entries processed by a single task of vectorize_parallel()
+#if !defined(ENOKI_THREAD_BLOCK_SIZE)
+#  define ENOKI_THREAD_BLOCK_SIZE 4096
+#endif
+
+NAMESPACE_BEGIN(enoki)
+
+// -----------------------------------------------------------------------
+//! @{ \name Imports from libenoki-thread.so
+// -----------------------------------------------------------------------
+
+/**
+ * \brief Process the range <tt>[0, size)</tt> in parallel
+ *
+ * The range is split into blocks of \c grain entries that are distributed
+ * over the threads of a process-wide work-stealing pool. The calling thread
+ * participates and returns once \c func has been invoked on every block.
+ * Calls from within a worker thread are processed serially. Exceptions
+ * raised by \c func are propagated to the caller. The pool is shared by all
+ * parallel features of Enoki to avoid oversubscribing the machine.
+ */
+extern ENOKI_IMPORT void thread_parallel_for(size_t size, size_t grain,
+                                             void (*func)(size_t, size_t, void *),
+                                             void *payload);
+
+/// Return the number of threads (including the caller) used by parallel loops
+extern ENOKI_IMPORT size_t thread_count();
+
+/**
+ * \brief Set the number of threads (including the caller) used by parallel loops
+ *
+ * The default is the number of hardware threads, or the value of the
+ * \c ENOKI_NUM_THREADS environment variable if specified. A value of 1
+ * disables parallelization.
+ */
+extern ENOKI_IMPORT void thread_set_count(size_t count);
+
+/// Pin the worker threads to separate cores? (only supported on Linux)
+extern ENOKI_IMPORT void thread_set_affinity(bool value);
+
+/// Are the worker threads pinned to separate cores?
+extern ENOKI_IMPORT bool thread_affinity();
+
+//! @}
+// -----------------------------------------------------------------------
+
+/**
+ * \brief Process the range <tt>[0, size)</tt> in parallel
+ *
+ * Invokes <tt>func(begin, end)</tt> on blocks of at most \c grain entries.
+ */
+template <typename Func> void parallel_for(size_t size, size_t grain, Func &&func) {
+    using FuncType = std::decay_t<Func>;
+    thread_parallel_for(
+        size, grain,
+        [](size_t begin, size_t end, void *payload) {
+            (*(FuncType *) payload)(begin, end);
+        },
+        (void *) &func);
+}
+
+/**
+ * \brief Process the packets of a dynamic array in parallel
+ *
+ * Invokes <tt>func(begin, end)</tt> on ranges of packet indices that cover
+ * approximately \c grain entries of \c array.
+ */
+template <typename Array, typename Func, enable_if_dynamic_array_t<Array> = 0>
+void parallel_for(const Array &array, size_t grain, Func &&func) {
+    parallel_for(packets(array), std::max(grain / Array::PacketSize, (size_t) 1),
+                 std::forward<Func>(func));
+}
+
+NAMESPACE_BEGIN(detail)
+
+/// Execution policy of vectorize_parallel(): spread packets over the thread pool
+struct vectorize_threaded {
+    template <typename Body>
+    ENOKI_INLINE void operator()(size_t packet_count, size_t slice_count,
+                                 Body &&body) const {
+        size_t grain = std::max((size_t) 1, (size_t) ENOKI_THREAD_BLOCK_SIZE *
+                                packet_count / std::max(slice_count, (size_t) 1));
+        if (packet_count <= grain)
+            body((size_t) 0, packet_count);
+        else
+            parallel_for(packet_count, grain, body);
+    }
+};
+
+/// Execution policy of the parallel reductions: one task per chunk
+struct reduce_threaded {
+    template <typename Body>
+    ENOKI_INLINE void operator()(size_t chunk_count, Body &&body) const {
+        parallel_for(chunk_count, 1, body);
+    }
+};
+
+NAMESPACE_END(detail)
+
+/**
+ * \brief Parallel version of \ref vectorize()
+ *
+ * Splits the packets of the dynamic input arrays into blocks of
+ * \ref ENOKI_THREAD_BLOCK_SIZE entries and processes them on the thread pool.
+ * Since every packet is handled by exactly one invocation of \c f, the result
+ * is identical to that of the serial version. The function \c f must be safe
+ * to call from several threads at once.
+ */
+template <bool Resize = false, typename Func, typename... Args>
+auto vectorize_parallel(Func &&f, Args &&... args)
+    -> make_dynamic_t<decltype(f(packet(args, 0)...))> /* LLVM bug #39326 */ {
+    return detail::vectorize<Resize>(detail::vectorize_threaded(), f, args...);
+}
+
+/// Parallel version of \ref vectorize_safe()
+template <typename Func, typename... Args>
+auto vectorize_parallel_safe(Func &&f, Args &&... args)
+    -> decltype(vectorize_parallel<true>(f, args...)) /* LLVM bug #39326 */ {
+    return vectorize_parallel<true>(f, args...);
+}
+
+// -----------------------------------------------------------------------
+//! @{ \name Parallel horizontal reductions and prefix sums
+// -----------------------------------------------------------------------
+
+/*
+ * The following functions distribute the chunks of the tree reductions and
+ * two-pass prefix sums performed by the serial horizontal operations of
+ * dynamic arrays over the thread pool. The order of operations is independent
+ * of the number of threads, hence the results are bitwise identical to e.g.
+ * \ref hsum() and \ref psum().
+ */
+
+template <typename Array, enable_if_dynamic_array_t<Array> = 0>
+auto psum_parallel(const Array &a) {
+    return a.psum_(detail::reduce_threaded(), false);
+}
+
+template <typename Array, enable_if_dynamic_array_t<Array> = 0>
+auto psum_exclusive_parallel(const Array &a) {
+    return a.psum_(detail::reduce_threaded(), true);
+}
+
+template <typename Array, enable_if_dynamic_array_t<Array> = 0>
+auto hsum_parallel(const Array &a) {
+    return a.hsum_(detail::reduce_threaded());
+}
+
+template <typename Array, enable_if_dynamic_array_t<Array> = 0>
+auto hprod_parallel(const Array &a) {
+    return a.hprod_(detail::reduce_threaded());
+}
+
+template <typename Array, enable_if_dynamic_array_t<Array> = 0>
+auto hsum_kahan_parallel(const Array &a) {
+    return a.hsum_kahan_(detail::reduce_threaded());
+}
+
+template <typename Array, enable_if_dynamic_array_t<Array> = 0>
+auto hmin_parallel(const Array &a) {
+    using Packet = typename Array::Packet;
+    if (a.size() <= 1)
+        return hmin(a);
+    return hmin(a.reduce_packets_(detail::reduce_threaded(), Packet(a.coeff(0)),
+        [](const Packet &x, const Packet &y) { return min(x, y); }));
+}
+
+template <typename Array, enable_if_dynamic_array_t<Array> = 0>
+auto hmax_parallel(const Array &a) {
+    using Packet = typename Array::Packet;
+    if (a.size() <= 1)
+        return hmax(a);
+    return hmax(a.reduce_packets_(detail::reduce_threaded(), Packet(a.coeff(0)),
+        [](const Packet &x, const Packet &y) { return max(x, y); }));
+}
+
+template <typename Array, enable_if_dynamic_array_t<Array> = 0>
+bool any_parallel(const Array &a) {
+    using Packet = typename Array::Packet;
+    if (a.size() <= 1)
+        return any(a);
+    return any(a.reduce_packets_(detail::reduce_threaded(), Packet(false),
+        [](const Packet &x, const Packet &y) { return x | y; }));
+}
+
+template <typename Array, enable_if_dynamic_array_t<Array> = 0>
+bool all_parallel(const Array &a) {
+    using Packet = typename Array::Packet;
+    if (a.size() <= 1)
+        return all(a);
+    return all(a.reduce_packets_(detail::reduce_threaded(), Packet(true),
+        [](const Packet &x, const Packet &y) { return x & y; }));
+}
+
+template <typename Array, enable_if_dynamic_array_t<Array> = 0>
+size_t count_parallel(const Array &a) {
+    using IndexPacket = typename Array::IndexPacket;
+    using IndexScalar = typename Array::IndexScalar;
+    constexpr size_t PacketSize = Array::PacketSize;
+
+    size_t packet_count = a.packets(),
+           chunk_size = Array::reduce_chunk_size_(),
+           chunk_count = (packet_count + chunk_size - 1) / chunk_size;
+
+    return detail::reduce_chunked(
+        detail::reduce_threaded(), chunk_count, (size_t) 0,
+        [&](size_t chunk) {
+            size_t start = chunk * chunk_size,
+                   end = std::min(start + chunk_size, packet_count),
+                   result = 0;
+            for (size_t i = start; i < end; ++i) {
+                if (i + 1 == packet_count && PacketSize > 1)
+                    result += count(a.packet(i) &
+                        (arange<IndexPacket>() <= IndexScalar((a.size() - 1) % PacketSize)));
+                else
+                    result += count(a.packet(i));
+            }
+            return result;
+        },
+        [](size_t x, size_t y) { return x + y; });
+}
+
+//! @}
+// -----------------------------------------------------------------------
+
+// -----------------------------------------------------------------------
+//! @{ \name Parallel sorting (see enoki/sort.h)
+// -----------------------------------------------------------------------
+
+template <typename Array, enable_if_dynamic_array_t<Array> = 0>
+Array sort_parallel(const Array &a) {
+    return detail::sort(detail::reduce_threaded(), a);
+}
+
+template <typename Array, enable_if_dynamic_array_t<Array> = 0>
+auto argsort_parallel(const Array &a) {
+    return detail::argsort(detail::reduce_threaded(), a);
+}
+
+template <typename Keys, typename Values, enable_if_dynamic_array_t<Keys> = 0>
+std::pair<Keys, Values> sort_by_key_parallel(const Keys &keys, const Values &values) {
+    return detail::sort_by_key(detail::reduce_threaded(), keys, values);
+}
+
+//! @}
+// -----------------------------------------------------------------------
+
+NAMESPACE_END(enoki)
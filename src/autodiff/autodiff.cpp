@@ -16,9 +16,17 @@
 #include <enoki/cuda.h>
 #endif
 #include <enoki/autodiff.h>
+#if defined(ENOKI_AUTODIFF_THREAD)
+#include <enoki/thread.h>
+#endif
 
+#include <algorithm>
+#include <unordered_set>
 #include <unordered_map>
-#include <set>
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <numeric>
 #include <sstream>
 #include <iomanip>
 
@@ -31,9 +39,19 @@
 /// Max. allowed cost in number of arithmetic operations that a simplification can do
 #define ENOKI_AUTODIFF_MAX_SIMPLIFICATION_COST 10
 
+/// Fixed cost of an edge traversal or of a product of edge weights (in array entries)
+#define ENOKI_AUTODIFF_EDGE_OVERHEAD 16
+
+/// Nodes are allocated in blocks of 2^ENOKI_AUTODIFF_BLOCK_SHIFT entries
+#define ENOKI_AUTODIFF_BLOCK_SHIFT 12
+
+/// Min. number of gradient entries in a level to process it on the thread pool
+#define ENOKI_AUTODIFF_PARALLEL_THRESHOLD 65536
+
 NAMESPACE_BEGIN(enoki)
 
 using Index = uint32_t;
+using Clock = std::chrono::high_resolution_clock;
 
 template <typename Value>
 Value safe_mul(const Value &value1, const Value &value2);
@@ -41,13 +59,28 @@ template <typename Value>
 Value safe_fmadd(const Value &value1, const Value &value2, const Value &value3);
 
 template <typename Value> struct Tape<Value>::Node {
-    /// Descriptive label
-    std::string label;
+    /// Descriptive label (string literal or interned string, may be \c nullptr)
+    const char *label = nullptr;
+
+    /// Prefix stack at creation time (interned string, may be \c nullptr)
+    const char *prefix = nullptr;
+
+    /// Creation order (zero for unused nodes)
+    uint64_t seq = 0;
+
+    /// Traversal epoch of the last visit by \ref Detail::dfs()
+    uint32_t visited = 0;
+
+    /// Parallel backward pass: level of this node, and of its deepest source
+    uint32_t level = 0, level_release = 0;
+
+    /// Does the backward pass through this node re-run a checkpointed region?
+    bool recompute = false;
 
     /// Gradient value
     Value grad;
 
-    /// Pointer to incident edge linked list
+    /// Incident edges (capacity is retained when the node is recycled)
     std::vector<Edge> edges;
 
     /// Reverse edge list
@@ -62,9 +95,6 @@ template <typename Value> struct Tape<Value>::Node {
     /// Size of the variable
     uint32_t size = 0;
 
-    Node(size_t size, const char *label)
-        : label(label ? label : ""), size((uint32_t) size) { }
-
     bool is_scalar() const {
         return size == 1;
     }
@@ -103,27 +133,160 @@ template <typename Value> struct Tape<Value>::Node {
     Node& operator=(Node&&) = default;
 };
 
+/// Representation of the weight of an edge
+enum class EdgeKind : uint8_t {
+    /// The weight is 1 (e.g. addition)
+    Identity,
+
+    /// The weight is -1 (e.g. subtraction)
+    Negate,
+
+    /// The weight is the broadcast scalar 'Edge::scale'
+    Scale,
+
+    /// The weight is stored in the array 'Edge::weight'
+    Full
+};
+
+/// Profiler counters of a label/prefix pair, see \ref Tape::set_profiling()
+struct ProfileCounters {
+    size_t backward_nodes = 0, forward_nodes = 0;
+
+    /// Wall time in nanoseconds
+    uint64_t backward_time = 0, forward_time = 0;
+
+    size_t weight_bytes = 0, grad_bytes = 0;
+};
+
+/// Profiler key: interned prefix and label (or string literal)
+using ProfileKey = std::pair<const char *, const char *>;
+
+struct ProfileKeyHash {
+    size_t operator()(const ProfileKey &key) const {
+        size_t h1 = std::hash<const char *>()(key.first),
+               h2 = std::hash<const char *>()(key.second);
+        return h1 ^ (h2 + 0x9e3779b9 + (h1 << 6) + (h1 >> 2));
+    }
+};
+
+/// Statistics of \ref Tape::simplify_graph(), reported by \ref Tape::whos()
+struct SimplificationStatistics {
+    /// Number of calls that processed the graph
+    size_t runs = 0;
+
+    /// Nodes that were collapsed, rejected by the cost model, or that can't be collapsed
+    size_t collapsed = 0, rejected = 0, skipped = 0;
+
+    /// Number of computed edge weight products
+    size_t products = 0;
+
+    /// Estimated memory traffic saved by the collapsed nodes (in array entries)
+    int64_t saved = 0;
+
+    /// Time spent in all calls and in the last one (microseconds)
+    size_t time_total = 0, time_last = 0;
+};
+
+/// Operation and operands of a node, see \ref Tape::record_primal()
+template <typename Value> struct PrimalRecord {
+    ReplayOp op;
+    uint32_t count = 0;
+
+    /// Operand nodes (or 0) and their creation order, which detects recycled indices
+    Index arg[3] { };
+    uint64_t arg_seq[3] { };
+
+    /// Operand values at the time of recording
+    Value value[3];
+};
+
 template <typename Value> struct Tape<Value>::Edge {
+    using Scalar = scalar_t<Value>;
+
     /// Source node ID associated with this edge
     Index source;
 
-    /// Edge weight
+    /// How the edge weight is represented
+    EdgeKind kind = EdgeKind::Full;
+
+    /// Edge weight (\ref EdgeKind::Scale)
+    Scalar scale = 0;
+
+    /// Edge weight (\ref EdgeKind::Full)
     Value weight;
 
     /// Optional: special operation (scatter/gather/reduction)
     std::unique_ptr<Special> special;
 
-    /// Pointer to next edge
-    std::unique_ptr<Edge> next;
-
-    Edge(Index source, const Value &weight)
-        : source(source), weight(weight) { }
+    Edge(Index source, const Value &weight) : source(source) {
+        set_weight(weight);
+    }
 
     Edge(Index source, Special *special)
         : source(source), special(special) { }
 
     bool is_special() const { return special != nullptr; }
 
+    /**
+     * \brief Set the weight of the edge
+     *
+     * Broadcast scalars of dynamic arrays don't need an array of their own.
+     * Zero and non-finite scalars keep the \ref safe_mul() semantics of
+     * full weights.
+     */
+    void set_weight(const Value &value) {
+        if constexpr (is_dynamic_v<Value> && !is_cuda_array_v<Value>) {
+            if (value.size() == 1) {
+                Scalar s = value.coeff(0);
+                if (s != 0 && std::isfinite(s)) {
+                    kind = s == 1 ? EdgeKind::Identity
+                                  : (s == -1 ? EdgeKind::Negate : EdgeKind::Scale);
+                    scale = s;
+                    weight = Value();
+                    return;
+                }
+            }
+        }
+        kind = EdgeKind::Full;
+        weight = value;
+    }
+
+    /// Return the weight as an array (broadcast scalars have size 1)
+    Value weight_value() const {
+        if (kind == EdgeKind::Full)
+            return weight;
+        else
+            return Value(scale);
+    }
+
+    /// Multiply 'value' by the weight
+    Value mul(const Value &value) const {
+        switch (kind) {
+            case EdgeKind::Identity: return value;
+            case EdgeKind::Negate:   return -value;
+            case EdgeKind::Scale:    return value * scale;
+            default:                 return safe_mul(weight, value);
+        }
+    }
+
+    /// Compute <tt>weight * value1 + value2</tt>
+    Value fmadd(const Value &value1, const Value &value2) const {
+        switch (kind) {
+            case EdgeKind::Identity: return value2 + value1;
+            case EdgeKind::Negate:   return value2 - value1;
+            case EdgeKind::Scale:    return enoki::fmadd(value1, scale, value2);
+            default:                 return safe_fmadd(weight, value1, value2);
+        }
+    }
+
+    /// Number of entries of the weight (1 for broadcast scalars)
+    size_t weight_size() const {
+        if constexpr (is_dynamic_v<Value>)
+            return kind == EdgeKind::Full ? weight.size() : 1;
+        else
+            return 1;
+    }
+
     Edge() = default;
     Edge(const Edge &) = delete;
     Edge(Edge&&) = default;
@@ -144,35 +307,139 @@ template <typename Value> struct Tape<Value>::Special {
 };
 
 template <typename Value> struct Tape<Value>::Detail {
-    Index node_counter = 1,
-          node_counter_last = 1;
+    static constexpr Index BlockShift = ENOKI_AUTODIFF_BLOCK_SHIFT,
+                           BlockSize  = 1u << BlockShift;
+
+    /// Number of created nodes
+    uint64_t node_counter = 1,
+             node_counter_last = 1;
+
+    /// Node storage. Blocks are never moved, hence node references are stable
+    std::vector<std::unique_ptr<Node[]>> node_blocks;
 
-    std::unordered_map<Index, Node> nodes;
-    std::vector<std::string> prefix;
+    /// Indices of unused nodes within 'node_blocks' (in LIFO order)
+    std::vector<Index> node_free;
+
+    /// First index that has never been handed out
+    Index node_end = 1;
+
+    /// Number of live nodes
+    size_t node_count = 0;
+
+    /// Interned labels and prefixes (owned by the tape)
+    std::unordered_set<std::string> strings;
+
+    /// Stack of prefixes, each entry includes the preceding ones
+    std::vector<const char *> prefix;
     Index *scatter_gather_index = nullptr;
     size_t scatter_gather_size = 0;
     bool scatter_gather_permute = false;
     uint32_t log_level = ENOKI_AUTODIFF_DEFAULT_LOG_LEVEL;
     bool graph_simplification = true,
-         is_simplified = true;
+         is_simplified = true,
+         parallel_backward = false;
+
+    /**
+     * Nodes selected for the next backward/forward pass in DFS post-order.
+     * Traversing this list in reverse yields a topological order.
+     */
+    std::vector<Index> scheduled;
+
+    /// Traversal epoch of 'scheduled', used to mark visited nodes
+    uint32_t epoch = 0;
+
+    /// Explicit DFS stack: node index and position of the next edge to visit
+    std::vector<std::pair<Index, uint32_t>> dfs_stack;
+
+    /// Nodes waiting to be freed by \ref Tape::free_node()
+    std::vector<Index> free_queue;
+    bool freeing = false;
 
-    /// Set of indices selected for next backward pass
-    std::set<uint32_t> scheduled;
+    /// Parallel backward pass: nodes bucketed by level and by release level
+    std::vector<Index> level_nodes, release_nodes;
+    std::vector<size_t> level_offset, release_offset, level_work;
+    std::vector<bool> level_serial;
+
+    /// Traversals ignore nodes created before this point (used when re-running checkpoints)
+    uint64_t seq_min = 0;
+
+    CheckpointStatistics checkpoint_stats;
+    SimplificationStatistics simplification_stats;
+
+    /// Profiler: counters per prefix/label pair (the mutex guards parallel backward passes)
+    bool profiling = false;
+    std::unordered_map<ProfileKey, ProfileCounters, ProfileKeyHash> profile;
+    std::mutex profile_mutex;
+
+    /// Operations of nodes created while \ref Tape::set_record_primal() was enabled
+    std::unordered_map<Index, PrimalRecord<Value>> primal;
 
     Node &node(Index index) {
-        auto it = nodes.find(index);
-        if (it == nodes.end())
-            throw std::runtime_error("autodiff: Detail::node(): Unknown index " +
-                                     std::to_string(index));
-        return it->second;
+        if (ENOKI_LIKELY(index < node_end)) {
+            Node &n = node_blocks[index >> BlockShift][index & (BlockSize - 1)];
+            if (ENOKI_LIKELY(n.seq != 0))
+                return n;
+        }
+        throw std::runtime_error("autodiff: Detail::node(): Unknown index " +
+                                 std::to_string(index));
     }
 
-    void dfs(Index k, bool backward, bool clear_grad) {
-        if (scheduled.find(k) != scheduled.end())
-            return;
-        scheduled.insert(k);
+    /// Fetch an unused node (recycled if possible)
+    Index alloc_node() {
+        Index index;
+        if (!node_free.empty()) {
+            index = node_free.back();
+            node_free.pop_back();
+        } else {
+            if (ENOKI_UNLIKELY(node_end == 0))
+                throw std::runtime_error("autodiff: Detail::alloc_node(): out of node indices!");
+            index = node_end++;
+            if ((index >> BlockShift) == node_blocks.size())
+                node_blocks.emplace_back(new Node[BlockSize]);
+        }
+        Node &n = node_blocks[index >> BlockShift][index & (BlockSize - 1)];
+        n.seq = node_counter++;
+        node_count++;
+        return index;
+    }
+
+    /// Return a node to the free list while keeping the capacity of its edge lists
+    void release_node(Index index) {
+        Node &n = node(index);
+        n.edges.clear();
+        n.edges_rev.clear();
+        n.grad = Value();
+        n.label = n.prefix = nullptr;
+        n.seq = 0;
+        n.visited = 0;
+        n.recompute = false;
+        n.ref_count_ext = n.ref_count_int = n.size = 0;
+        if (ENOKI_UNLIKELY(!primal.empty()))
+            primal.erase(index);
+        node_free.push_back(index);
+        node_count--;
+    }
+
+    /// Call \c func(index, node) for every live node
+    template <typename Func> void for_each_node(Func &&func) {
+        for (Index i = 1; i < node_end; ++i) {
+            Node &n = node_blocks[i >> BlockShift][i & (BlockSize - 1)];
+            if (n.seq != 0)
+                func(i, n);
+        }
+    }
+
+    const char *intern(const std::string &str) {
+        return strings.insert(str).first->c_str();
+    }
 
+    /// Mark a node as visited, returns \c false if it was already visited
+    bool visit(Index k, bool clear_grad) {
         Node &n = node(k);
+        if (n.visited == epoch || n.seq < seq_min)
+            return false;
+        n.visited = epoch;
+
         if (clear_grad) {
             if (is_dynamic_v<Value>)
                 n.grad = Value();
@@ -180,12 +447,189 @@ template <typename Value> struct Tape<Value>::Detail {
                 n.grad = zero<Value>();
         }
 
+        return true;
+    }
+
+    /**
+     * \brief Append the unvisited nodes reachable from \c k to \c scheduled
+     *
+     * Performs an iterative depth-first search along the edges (\c backward ==
+     * true) or reverse edges (\c backward == false) and records the nodes in
+     * post-order. Several calls accumulate into the same schedule until it is
+     * cleared.
+     */
+    void dfs(Index k, bool backward, bool clear_grad) {
+        if (scheduled.empty()) {
+            /* Start a new traversal */
+            if (ENOKI_UNLIKELY(++epoch == 0)) {
+                for_each_node([](Index, Node &n) { n.visited = 0; });
+                epoch = 1;
+            }
+        }
+
+        if (!visit(k, clear_grad))
+            return;
+        dfs_stack.emplace_back(k, 0);
+
+        while (!dfs_stack.empty()) {
+            auto &[index, pos] = dfs_stack.back();
+            Node &n = node(index);
+            size_t count = backward ? n.edges.size() : n.edges_rev.size();
+
+            if (pos == count) {
+                scheduled.push_back(index);
+                dfs_stack.pop_back();
+                continue;
+            }
+
+            Index next = backward ? n.edges[pos].source : n.edges_rev[pos];
+            pos++;
+            if (visit(next, clear_grad))
+                dfs_stack.emplace_back(next, 0);
+        }
+    }
+
+    /**
+     * \brief Estimate how much memory traffic (in array entries) collapsing
+     * 'node' saves, counting both the backward pass and the simplification
+     *
+     * Propagating a gradient of 'size' entries along an edge reads it and
+     * updates the gradient of the other node (3 * size), and it reads full
+     * weights (another 'size'). A product of two weights is free when both are
+     * broadcast scalars, and otherwise reads the full weight(s) and writes the
+     * result. Collapsing removes the edges of the node and its gradient, but
+     * creates an edge for each pair of consumer and source unless they are
+     * already connected. A negative value means that collapsing doesn't pay off.
+     */
+    int64_t collapse_savings(Index index, const Node &n) {
+        constexpr int64_t Overhead = ENOKI_AUTODIFF_EDGE_OVERHEAD;
+        int64_t size = (int64_t) n.size;
+        auto traverse = [&](bool full) { return (full ? 4 : 3) * size + Overhead; };
+
+        int64_t before = size, after = 0;
+        for (const Edge &edge : n.edges)
+            before += traverse(edge.kind == EdgeKind::Full);
+
+        for (Index k : n.edges_rev) {
+            Node &other = node(k);
+            bool full1 = other.edge(index)->kind == EdgeKind::Full;
+            before += traverse(full1);
+
+            for (const Edge &edge : n.edges) {
+                bool full2 = edge.kind == EdgeKind::Full;
+                after += (full1 && full2 ? 3 : (full1 || full2 ? 2 : 0)) * size + 2 * Overhead;
+                if (other.edge(edge.source) == nullptr)
+                    after += traverse(full1 || full2);
+            }
+        }
+
+        return before - after;
+    }
+
+    /// Profiler: attribute the time since 'start' and the memory of 'n' to its label
+    void profile_node(const Node &n, Clock::time_point start, bool backward) {
+        uint64_t time = (uint64_t) std::chrono::duration_cast<
+            std::chrono::nanoseconds>(Clock::now() - start).count();
+
+        size_t weight_entries = 0, grad_entries = 1;
+        for (const Edge &edge : n.edges) {
+            if (!edge.is_special() && edge.kind == EdgeKind::Full)
+                weight_entries += edge.weight_size();
+        }
+        if constexpr (is_dynamic_v<Value>)
+            grad_entries = n.grad.size();
+
+        std::lock_guard<std::mutex> guard(profile_mutex);
+        ProfileCounters &counters = profile[{ n.prefix, n.label }];
         if (backward) {
-            for (const Edge &edge : n.edges)
-                dfs(edge.source, backward, clear_grad);
+            counters.backward_nodes++;
+            counters.backward_time += time;
+        } else {
+            counters.forward_nodes++;
+            counters.forward_time += time;
+        }
+        counters.weight_bytes += weight_entries * sizeof(scalar_t<Value>);
+        counters.grad_bytes += grad_entries * sizeof(scalar_t<Value>);
+    }
+
+    /// Make sure that the gradient of a node has the right size
+    void check_grad_size(Node &n, const char *func) {
+        if constexpr (is_dynamic_v<Value>) {
+            if (ENOKI_UNLIKELY(n.size != n.grad.size())) {
+                if (n.grad.size() == 1)
+                    set_slices(n.grad, n.size);
+                else
+                    throw std::runtime_error(
+                        std::string(func) + ": gradient sizes don't match: expected " +
+                        std::to_string(n.size) + ", got " +
+                        std::to_string(n.grad.size()));
+            }
+        }
+    }
+
+    /// Propagate the gradient of 'source' along all of its outgoing edges (forward mode)
+    void forward_node(Index source_idx, Node &source) {
+        if constexpr (is_dynamic_v<Value>) {
+            if (source.size == 1 && source.grad.size() > 1)
+                source.grad = hsum(source.grad);
+        }
+
+        for (Index target_idx : source.edges_rev) {
+            Node &target = node(target_idx);
+            Edge *edge = target.edge(source_idx);
+            if (edge == nullptr)
+                throw std::runtime_error("forward(): invalid graph structure!");
+
+            if (ENOKI_LIKELY(!edge->is_special()))
+                accumulate(*edge, source.grad, target.grad, target.size);
+            else
+                edge->special->forward(this, target_idx, *edge);
+            if constexpr (is_dynamic_v<Value>) {
+                if (ENOKI_UNLIKELY(target.size != target.grad.size())) {
+                    if (target.grad.size() == 1)
+                        set_slices(target.grad, target.size);
+                    else
+                        throw std::runtime_error(
+                            "forward(): gradient sizes don't match: expected " +
+                            std::to_string(target.size) + ", got " +
+                            std::to_string(target.grad.size()));
+                }
+            }
+        }
+    }
+
+    /// Propagate the gradient of 'target' along 'edge' (reverse mode)
+    void backward_edge(Index target_idx, const Node &target, Node &source, Edge &edge) {
+        if (ENOKI_LIKELY(!edge.is_special()))
+            accumulate(edge, target.grad, source.grad, source.size);
+        else
+            edge.special->backward(this, target_idx, edge);
+    }
+
+    /**
+     * \brief Add the product of the weight of 'edge' and 'grad_in' to
+     * 'grad_out', which belongs to a variable with 'size_out' entries
+     *
+     * Contributions to single-entry variables are reduced, and empty
+     * gradients of dynamic arrays are treated as zero.
+     */
+    static void accumulate(const Edge &edge, const Value &grad_in,
+                           Value &grad_out, uint32_t size_out) {
+        if constexpr (is_dynamic_v<Value>) {
+            if (size_out == 1 && (edge.weight_size() != 1 || grad_in.size() != 1)) {
+                if (grad_out.empty())
+                    grad_out = hsum(edge.mul(grad_in));
+                else
+                    grad_out += hsum(edge.mul(grad_in));
+            } else {
+                if (grad_out.empty())
+                    grad_out = edge.mul(grad_in);
+                else
+                    grad_out = edge.fmadd(grad_in, grad_out);
+            }
         } else {
-            for (Index k2: n.edges_rev)
-                dfs(k2, backward, clear_grad);
+            ENOKI_MARK_USED(size_out);
+            grad_out = edge.fmadd(grad_in, grad_out);
         }
     }
 };
@@ -203,13 +647,27 @@ template <typename Value> struct Tape<Value>::SimplificationLock {
     bool state = false;
 };
 
+/// Tape bound to the calling thread by \ref TapeScope (\c nullptr: global tape)
+template <typename Value> Tape<Value> *&current_tape() {
+    static thread_local Tape<Value> *tape = nullptr;
+    return tape;
+}
+
 template <typename Value> std::unique_ptr<Tape<Value>> Tape<Value>::s_tape;
-template <typename Value> ENOKI_PURE Tape<Value> *Tape<Value>::get() {
+template <typename Value> Tape<Value> *Tape<Value>::get() {
+    if (Tape *tape = current_tape<Value>(); tape != nullptr)
+        return tape;
     if (ENOKI_UNLIKELY(!s_tape))
         s_tape = std::unique_ptr<Tape>(new Tape());
     return s_tape.get();
 }
 
+template <typename Value> Tape<Value> *Tape<Value>::set_current(Tape *tape) {
+    Tape *previous = current_tape<Value>();
+    current_tape<Value>() = tape;
+    return previous;
+}
+
 template <typename Value> Tape<Value>::Tape() {
     d = new Detail();
 
@@ -225,17 +683,17 @@ template <typename Value> Tape<Value>::~Tape() {
         if (d->node_counter != 1)
             std::cerr << "autodiff: shutdown." << std::endl;
         size_t n_live = 0;
-        for (const auto &it : d->nodes) {
+        d->for_each_node([&](Index index, const Node &node) {
             if (n_live < 10)
-                std::cerr << "autodiff: variable " << it.first
+                std::cerr << "autodiff: variable " << index
                           << " still live at shutdown. (ref_count_int="
-                          << it.second.ref_count_int
-                          << ", ref_count_ext=" << it.second.ref_count_ext << ")"
+                          << node.ref_count_int
+                          << ", ref_count_ext=" << node.ref_count_ext << ")"
                           << std::endl;
             if (n_live == 9)
                 std::cerr << "(skipping remainder)" << std::endl;
             n_live++;
-        }
+        });
         if (n_live > 0)
             std::cerr << "autodiff: " << n_live
                       << " variables were still live at shutdown." << std::endl;
@@ -311,12 +769,13 @@ Index Tape<Value>::append(const char *label, size_t size, Index i1, Index i2, In
 
 template <typename Value>
 Index Tape<Value>::append_node(size_t size, const char *label) {
-    Index idx = d->node_counter++;
-    auto result = d->nodes.emplace(std::make_pair(idx, Node(size, label)));
+    Index idx = d->alloc_node();
 
-    Node &node = result.first->second;
-    for (auto it = d->prefix.rbegin(); it != d->prefix.rend(); ++it)
-        node.label = *it + '/' + node.label;
+    Node &node = d->node(idx);
+    node.label = label;
+    node.size = (uint32_t) size;
+    if (!d->prefix.empty())
+        node.prefix = d->prefix.back();
 
 #if !defined(NDEBUG)
     if (d->log_level >= 3)
@@ -344,9 +803,8 @@ void Tape<Value>::set_label(Index idx, const char *label) {
     if (d->log_level >= 3)
         std::cerr << "autodiff: set_label(" << idx << ") -> " << label << std::endl;
 #endif
-    std::string name = "'" + std::string(label) + "'";
     Node &n = d->node(idx);
-    n.label = name;
+    n.label = d->intern("'" + std::string(label) + "'");
     enoki::set_label(n.grad, (label + std::string(".grad")).c_str());
 }
 
@@ -606,6 +1064,243 @@ void Tape<Value>::append_scatter(Index source, const Int64 &offset, const Mask &
     }
 }
 
+template <typename Value>
+std::vector<uint32_t> Tape<Value>::append_checkpoint(const std::vector<Index> &inputs,
+                                                     const std::vector<size_t> &output_sizes,
+                                                     detail::Checkpoint *checkpoint_) {
+    std::unique_ptr<detail::Checkpoint> checkpoint(checkpoint_);
+
+    if constexpr (is_dynamic_v<Value>) {
+        /**
+         * The region is represented by a hub node that has special edges to
+         * the inputs. Every output has a special edge to the hub, which stores
+         * the output gradient. Since the hub is processed after all outputs,
+         * the first input edge can re-run the region with all gradients known.
+         */
+        struct State {
+            Tape *tape;
+            std::unique_ptr<detail::Checkpoint> checkpoint;
+            std::vector<Value> grad_out, grad_in;
+            bool done = false;
+
+            void run(Detail *d) {
+                if (done)
+                    return;
+                done = true;
+
+                /* Preserve the state of the enclosing backward pass */
+                std::vector<Index> scheduled, level_nodes, release_nodes;
+                std::vector<size_t> level_offset, release_offset, level_work;
+                std::vector<bool> level_serial;
+                uint64_t seq_min = d->node_counter;
+                auto swap_state = [&]() {
+                    std::swap(scheduled, d->scheduled);
+                    std::swap(level_nodes, d->level_nodes);
+                    std::swap(release_nodes, d->release_nodes);
+                    std::swap(level_offset, d->level_offset);
+                    std::swap(release_offset, d->release_offset);
+                    std::swap(level_work, d->level_work);
+                    std::swap(level_serial, d->level_serial);
+                    std::swap(seq_min, d->seq_min);
+                };
+
+                swap_state();
+                try {
+                    std::vector<Index> in, out;
+                    checkpoint->record(in, out);
+
+                    for (size_t i = 0; i < out.size(); ++i) {
+                        if (out[i] == 0 || grad_out[i].empty())
+                            continue;
+                        /* Combine the gradients of repeated outputs */
+                        for (size_t j = i + 1; j < out.size(); ++j) {
+                            if (out[j] == out[i] && !grad_out[j].empty()) {
+                                grad_out[i] += grad_out[j];
+                                grad_out[j] = Value();
+                            }
+                        }
+                        tape->set_gradient(out[i], grad_out[i], true);
+                    }
+                    grad_out.clear();
+
+                    size_t bytes = 0;
+                    for (Index index : d->scheduled) {
+                        for (const Edge &edge : d->node(index).edges) {
+                            if (!edge.is_special())
+                                bytes += edge.weight.size() * sizeof(scalar_t<Value>);
+                        }
+                    }
+
+                    CheckpointStatistics &stats = d->checkpoint_stats;
+                    stats.regions++;
+                    stats.nodes += d->scheduled.size();
+                    stats.bytes_total += bytes;
+                    stats.bytes_peak = std::max(stats.bytes_peak, bytes);
+
+                    if (!d->scheduled.empty())
+                        tape->backward(true);
+
+                    grad_in.resize(in.size());
+                    for (size_t i = 0; i < in.size(); ++i) {
+                        if (in[i] != 0)
+                            grad_in[i] = d->node(in[i]).grad;
+                    }
+                    checkpoint->release();
+                } catch (...) {
+                    swap_state();
+                    throw;
+                }
+                swap_state();
+            }
+        };
+
+        struct CheckpointOutput : Special {
+            std::shared_ptr<State> state;
+            size_t slot;
+
+            void backward(Detail *detail, Index target_idx, const Edge &) const override {
+                state->grad_out[slot] = detail->node(target_idx).grad;
+            }
+        };
+
+        struct CheckpointInput : Special {
+            std::shared_ptr<State> state;
+            std::vector<size_t> slots;
+
+            void backward(Detail *detail, Index, const Edge &edge) const override {
+                state->run(detail);
+
+                Node &source = detail->node(edge.source);
+                for (size_t slot : slots) {
+                    Value &grad = state->grad_in[slot];
+                    if (grad.empty())
+                        continue;
+                    if (source.size == 1 && grad.size() != 1)
+                        grad = hsum(grad);
+                    if (source.grad.empty())
+                        source.grad = grad;
+                    else
+                        source.grad += grad;
+                    grad = Value();
+                }
+            }
+        };
+
+        auto state = std::make_shared<State>();
+        state->tape = this;
+        state->checkpoint = std::move(checkpoint);
+        state->grad_out.resize(output_sizes.size());
+
+        Index hub = append_node(0, "checkpoint");
+        d->node(hub).recompute = true;
+
+        for (size_t i = 0; i < inputs.size(); ++i) {
+            Index source = inputs[i];
+            if (source == 0)
+                continue;
+            Node &hub_node = d->node(hub);
+            if (Edge *edge = hub_node.edge(source); edge != nullptr) {
+                /* The same variable was passed multiple times */
+                ((CheckpointInput *) edge->special.get())->slots.push_back(i);
+                continue;
+            }
+            CheckpointInput *s = new CheckpointInput();
+            s->state = state;
+            s->slots.push_back(i);
+            hub_node.edges.emplace_back(source, s);
+            inc_ref_int(source, hub);
+        }
+
+        std::vector<Index> outputs(output_sizes.size());
+        for (size_t i = 0; i < output_sizes.size(); ++i) {
+            CheckpointOutput *s = new CheckpointOutput();
+            s->state = state;
+            s->slot = i;
+            Index target = append_node(output_sizes[i], "checkpoint_output");
+            d->node(target).edges.emplace_back(hub, s);
+            inc_ref_int(hub, target);
+            outputs[i] = target;
+        }
+
+        dec_ref_ext(hub);
+
+#if !defined(NDEBUG)
+        if (d->log_level >= 3)
+            std::cerr << "autodiff: append_checkpoint(" << inputs.size()
+                      << " inputs, " << outputs.size() << " outputs) -> "
+                      << hub << std::endl;
+#endif
+
+        return outputs;
+    } else {
+        throw std::runtime_error("append_checkpoint(): internal error!");
+    }
+}
+
+template <typename Value>
+CheckpointStatistics Tape<Value>::checkpoint_stats() const {
+    return d->checkpoint_stats;
+}
+
+template <typename Value>
+void Tape<Value>::checkpoint_stats_reset() {
+    d->checkpoint_stats = CheckpointStatistics();
+}
+
+template <typename Value> void Tape<Value>::set_profiling(bool value) {
+    d->profiling = value;
+}
+
+template <typename Value> void Tape<Value>::set_record_primal(bool value) {
+    m_record_primal = value;
+}
+
+template <typename Value>
+void Tape<Value>::record_primal(Index index, ReplayOp op, uint32_t count,
+                                const Index *args, const Value *const *values) {
+    PrimalRecord<Value> &record = d->primal[index];
+    record.op = op;
+    record.count = count;
+    for (uint32_t k = 0; k < count; ++k) {
+        record.arg[k] = args[k];
+        record.arg_seq[k] = args[k] != 0 ? d->node(args[k]).seq : 0;
+        record.value[k] = *values[k];
+    }
+}
+
+template <typename Value>
+std::vector<ProfileEntry> Tape<Value>::profile(bool by_prefix) const {
+    std::map<std::pair<std::string, std::string>, ProfileEntry> merged;
+    for (const auto &[key, counters] : d->profile) {
+        std::string prefix = key.first ? key.first : "",
+                    label = (key.second && !by_prefix) ? key.second : "";
+        ProfileEntry &entry = merged[{ prefix, label }];
+        entry.prefix = prefix;
+        entry.label = label;
+        entry.backward_nodes += counters.backward_nodes;
+        entry.forward_nodes += counters.forward_nodes;
+        entry.backward_time += (double) counters.backward_time * 1e-3;
+        entry.forward_time += (double) counters.forward_time * 1e-3;
+        entry.weight_bytes += counters.weight_bytes;
+        entry.grad_bytes += counters.grad_bytes;
+    }
+
+    std::vector<ProfileEntry> result;
+    result.reserve(merged.size());
+    for (auto &kv : merged)
+        result.push_back(std::move(kv.second));
+    std::stable_sort(result.begin(), result.end(),
+                     [](const ProfileEntry &a, const ProfileEntry &b) {
+                         return a.backward_time + a.forward_time >
+                                b.backward_time + b.forward_time;
+                     });
+    return result;
+}
+
+template <typename Value> void Tape<Value>::profile_reset() {
+    d->profile.clear();
+}
+
 template <typename Value>
 void Tape<Value>::append_edge(Index source_idx, Index target_idx,
                               const Value &weight) {
@@ -628,7 +1323,7 @@ void Tape<Value>::append_edge(Index source_idx, Index target_idx,
                       << std::endl;
 #endif
         SimplificationLock lock(*this);
-        edge->weight += weight;
+        edge->set_weight(edge->weight_value() + weight);
     } else {
 #if !defined(NDEBUG)
         if (d->log_level >= 4)
@@ -650,7 +1345,7 @@ void Tape<Value>::append_edge_prod(Index source_idx, Index target_idx,
 
     Node &target = d->node(target_idx);
     if (Edge *edge = target.edge(source_idx); edge != nullptr) {
-        Value weight = safe_fmadd(weight1, weight2, edge->weight);
+        Value weight = safe_fmadd(weight1, weight2, edge->weight_value());
 #if !defined(NDEBUG)
         if (d->log_level >= 4) {
             std::cerr << "autodiff: append_edge_prod(" << target_idx << " <- "
@@ -660,7 +1355,7 @@ void Tape<Value>::append_edge_prod(Index source_idx, Index target_idx,
                                       std::to_string(target_idx) + "]").c_str());
         }
 #endif
-        edge->weight = weight;
+        edge->set_weight(weight);
     } else {
         Value weight = safe_mul(weight1, weight2);
 #if !defined(NDEBUG)
@@ -760,20 +1455,31 @@ template <typename Value> void Tape<Value>::free_node(Index index) {
         std::cerr << "autodiff: free_node(" << index << ")" << std::endl;
 #endif
 
-    auto it = d->nodes.find(index);
-    if (it == d->nodes.end())
-        throw std::runtime_error("autodiff: free_node(): Unknown index " +
-                                 std::to_string(index));
+    /* Nodes whose reference count drops to zero in the process are queued
+       rather than freed recursively, which bounds the stack depth */
+    d->free_queue.push_back(index);
+    if (d->freeing)
+        return;
 
-    Node &node = it->second;
-    for (const Edge &edge : node.edges)
-        dec_ref_int(edge.source, index);
+    d->freeing = true;
+    while (!d->free_queue.empty()) {
+        Index next = d->free_queue.back();
+        d->free_queue.pop_back();
 
-    d->nodes.erase(it);
+        Node &node = d->node(next);
+        for (const Edge &edge : node.edges)
+            dec_ref_int(edge.source, next);
+
+        d->release_node(next);
+    }
+    d->freeing = false;
 }
 
 template <typename Value> void Tape<Value>::push_prefix(const char *value) {
-    d->prefix.push_back(value);
+    std::string prefix = value;
+    if (!d->prefix.empty())
+        prefix = d->prefix.back() + ('/' + prefix);
+    d->prefix.push_back(d->intern(prefix));
 }
 
 template <typename Value> void Tape<Value>::pop_prefix() {
@@ -819,81 +1525,724 @@ void Tape<Value>::forward(Index index, bool free_graph) {
 }
 
 template <typename Value>
-void Tape<Value>::set_gradient(Index index, const Value &value, bool backward) {
-    if (index == 0)
-        throw std::runtime_error(
-            "set_gradient(): no gradients are associated with this variable (a "
-            "prior call to requires_gradient() is required.) ");
+SparseJacobian<scalar_t<Value>>
+Tape<Value>::jacobian_sparse(const std::vector<Index> &outputs,
+                             const std::vector<Index> &inputs) {
+    using Scalar = scalar_t<Value>;
+    constexpr uint32_t Unassigned = (uint32_t) -1;
 
-    d->dfs(index, backward, true);
-    Node &node = d->node(index);
-    node.grad = value;
-    if constexpr (is_dynamic_v<Value>) {
-        if (node.size > 1 && node.grad.size() == 1)
-            set_slices(node.grad, node.size);
+    SimplificationLock lock(*this);
+
+    SparseJacobian<Scalar> result;
+    result.rows = outputs.size();
+    result.cols = inputs.size();
+
+    auto check_size = [&](Index index, const char *what) {
+        if (index != 0 && d->node(index).size != 1)
+            throw std::runtime_error(
+                std::string("jacobian_sparse(): ") + what +
+                " must be single-entry variables, got size " +
+                std::to_string(d->node(index).size));
+    };
+
+    /* Map node indices to the columns and rows that refer to them */
+    std::unordered_map<Index, std::vector<uint32_t>> col_map, row_map;
+    for (uint32_t j = 0; j < (uint32_t) inputs.size(); ++j) {
+        check_size(inputs[j], "inputs");
+        if (inputs[j] != 0)
+            col_map[inputs[j]].push_back(j);
+    }
+    for (uint32_t i = 0; i < (uint32_t) outputs.size(); ++i) {
+        check_size(outputs[i], "outputs");
+        if (outputs[i] != 0)
+            row_map[outputs[i]].push_back(i);
     }
-}
 
-template <typename Value>
-void Tape<Value>::backward(bool free_graph) {
+    /* 1. Sparsity pattern: the inputs reachable from each output */
     auto &scheduled = d->scheduled;
-
-    if (free_graph) {
-        for (auto it = scheduled.begin(); it != scheduled.end(); ++it)
-            inc_ref_ext(*it);
+    scheduled.clear();
+    result.row_offset.reserve(outputs.size() + 1);
+    result.row_offset.push_back(0);
+    for (Index output : outputs) {
+        size_t offset = result.col_index.size();
+        if (output != 0) {
+            d->dfs(output, true, false);
+            for (Index index : scheduled) {
+                auto it = col_map.find(index);
+                if (it != col_map.end())
+                    result.col_index.insert(result.col_index.end(),
+                                            it->second.begin(), it->second.end());
+            }
+            scheduled.clear();
+        }
+        std::sort(result.col_index.begin() + (ptrdiff_t) offset, result.col_index.end());
+        result.row_offset.push_back((uint32_t) result.col_index.size());
+    }
+    size_t nnz = result.col_index.size();
+    result.values.resize(nnz, Scalar(0));
+
+    /* 2. Greedy coloring of the columns, largest columns first */
+    std::vector<uint32_t> col_offset(inputs.size() + 1, 0), col_rows(nnz);
+    for (uint32_t j : result.col_index)
+        col_offset[j + 1]++;
+    for (size_t j = 0; j < inputs.size(); ++j)
+        col_offset[j + 1] += col_offset[j];
+    {
+        std::vector<uint32_t> pos(col_offset.begin(), col_offset.end() - 1);
+        for (uint32_t i = 0; i < (uint32_t) outputs.size(); ++i)
+            for (uint32_t k = result.row_offset[i]; k < result.row_offset[i + 1]; ++k)
+                col_rows[pos[result.col_index[k]]++] = i;
     }
 
-    for (auto it = scheduled.rbegin(); it != scheduled.rend(); ++it) {
-        Index target_idx = *it;
-        Node &target = d->node(target_idx);
-
-        if constexpr (is_dynamic_v<Value>) {
-            if (ENOKI_UNLIKELY(target.size != target.grad.size())) {
-                if (target.grad.size() == 1)
-                    set_slices(target.grad, target.size);
-                else
-                    throw std::runtime_error(
-                        "backward(): gradient sizes don't match: expected " +
-                        std::to_string(target.size) + ", got " +
-                        std::to_string(target.grad.size()));
+    std::vector<uint32_t> order(inputs.size());
+    std::iota(order.begin(), order.end(), 0u);
+    std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+        return col_offset[a + 1] - col_offset[a] > col_offset[b + 1] - col_offset[b];
+    });
+
+    std::vector<uint32_t> color(inputs.size(), Unassigned), forbidden;
+    for (uint32_t j : order) {
+        if (col_offset[j] == col_offset[j + 1])
+            continue; /* Empty column, no forward pass necessary */
+        for (uint32_t k = col_offset[j]; k < col_offset[j + 1]; ++k) {
+            uint32_t i = col_rows[k];
+            for (uint32_t l = result.row_offset[i]; l < result.row_offset[i + 1]; ++l) {
+                uint32_t c = color[result.col_index[l]];
+                if (c != Unassigned)
+                    forbidden[c] = j;
             }
         }
+        uint32_t c = 0;
+        while (c < forbidden.size() && forbidden[c] == j)
+            ++c;
+        if (c == forbidden.size())
+            forbidden.push_back(Unassigned);
+        color[j] = c;
+    }
+    result.colors = forbidden.size();
+
+    /* 3. One forward pass per color */
+    for (uint32_t c = 0; c < (uint32_t) result.colors; ++c) {
+        for (uint32_t j = 0; j < (uint32_t) inputs.size(); ++j) {
+            if (color[j] == c)
+                d->dfs(inputs[j], false, true);
+        }
+        for (uint32_t j = 0; j < (uint32_t) inputs.size(); ++j) {
+            if (color[j] == c)
+                d->node(inputs[j]).grad = Value(Scalar(1));
+        }
 
-        for (Edge &edge : target.edges) {
-            Node &source = d->node(edge.source);
-            if (ENOKI_LIKELY(!edge.is_special())) {
+        for (auto it = scheduled.rbegin(); it != scheduled.rend(); ++it) {
+            Index source_idx = *it;
+            Node &source = d->node(source_idx);
+            d->forward_node(source_idx, source);
+
+            /* All contributions to 'source' have arrived, record its entries */
+            auto it2 = row_map.find(source_idx);
+            if (it2 != row_map.end()) {
+                Scalar value = Scalar(0);
                 if constexpr (is_dynamic_v<Value>) {
-                    if (source.size == 1 && (edge.weight.size() != 1 || target.grad.size() != 1)) {
-                        if (source.grad.empty())
-                            source.grad = hsum(safe_mul(edge.weight, target.grad));
-                        else
-                            source.grad += hsum(safe_mul(edge.weight, target.grad));
-                    } else {
-                        if (source.grad.empty())
-                            source.grad = safe_mul(edge.weight, target.grad);
-                        else
-                            source.grad = safe_fmadd(edge.weight, target.grad, source.grad);
-                    }
+                    if (!source.grad.empty())
+                        value = source.grad.coeff(0);
                 } else {
-                    source.grad = safe_fmadd(edge.weight, target.grad, source.grad);
+                    value = source.grad;
+                }
+                for (uint32_t i : it2->second) {
+                    for (uint32_t k = result.row_offset[i]; k < result.row_offset[i + 1]; ++k) {
+                        if (color[result.col_index[k]] == c)
+                            result.values[k] = value;
+                    }
                 }
-            } else {
-                edge.special->backward(d, target_idx, edge);
-            }
-            if (free_graph) {
-                dec_ref_int(edge.source, target_idx);
-                edge.source = 0;
             }
+
+            if (source.ref_count_int > 0)
+                source.grad = Value();
         }
-        if (free_graph) {
-            if (target.edges.size() > 0) {
-                target.edges.clear();
-                target.grad = Value();
+        scheduled.clear();
+    }
+
+    if (d->log_level >= 1)
+        std::cerr << "autodiff: jacobian_sparse(): " << result.rows << "x"
+                  << result.cols << " matrix with " << nnz << " entries, "
+                  << result.colors << " colors." << std::endl;
+
+    return result;
+}
+
+/**
+ * \brief Evaluate the operation 'op' and its partial derivatives with respect
+ * to the operands 'arg' (see \ref FrozenGraph::eval())
+ *
+ * The formulas must match those used by the corresponding \ref DiffArray
+ * operations, which is checked for every operation by \c test52_freeze_eval_ops.
+ */
+template <typename Value>
+void replay_eval(ReplayOp op, const Value *const *arg, Value &result, Value *weight) {
+    using Scalar = scalar_t<Value>;
+    const Value &a = *arg[0];
+    const Value one = Scalar(1), zero = Scalar(0);
+
+    switch (op) {
+        case ReplayOp::Add:
+            result = a + *arg[1];
+            weight[0] = weight[1] = one;
+            break;
+
+        case ReplayOp::Sub:
+            result = a - *arg[1];
+            weight[0] = one;
+            weight[1] = -one;
+            break;
+
+        case ReplayOp::Mul:
+            result = a * *arg[1];
+            weight[0] = *arg[1];
+            weight[1] = a;
+            break;
+
+        case ReplayOp::Div: {
+                Value rcp_b = rcp(*arg[1]);
+                result = a / *arg[1];
+                weight[0] = rcp_b;
+                weight[1] = -a * sqr(rcp_b);
             }
-            dec_ref_ext(target_idx);
+            break;
+
+        case ReplayOp::Fmadd:
+        case ReplayOp::Fmsub:
+        case ReplayOp::Fnmadd:
+        case ReplayOp::Fnmsub: {
+                const Value &b = *arg[1], &c = *arg[2];
+                bool neg_prod = op == ReplayOp::Fnmadd || op == ReplayOp::Fnmsub,
+                     neg_add  = op == ReplayOp::Fmsub  || op == ReplayOp::Fnmsub;
+                result = neg_prod ? (neg_add ? fnmsub(a, b, c) : fnmadd(a, b, c))
+                                  : (neg_add ? fmsub(a, b, c) : fmadd(a, b, c));
+                weight[0] = neg_prod ? -b : b;
+                weight[1] = neg_prod ? -a : a;
+                weight[2] = neg_add ? -one : one;
+            }
+            break;
+
+        case ReplayOp::Neg:   result = -a;       weight[0] = -one;                        break;
+        case ReplayOp::Abs:   result = abs(a);   weight[0] = sign(a);                     break;
+        case ReplayOp::Sqrt:  result = sqrt(a);  weight[0] = Scalar(.5) / result;         break;
+        case ReplayOp::Cbrt:  result = cbrt(a);  weight[0] = one / (Scalar(3) * sqr(result)); break;
+        case ReplayOp::Rcp:   result = rcp(a);   weight[0] = -sqr(result);                break;
+        case ReplayOp::Rsqrt: result = rsqrt(a); weight[0] = Scalar(-.5) * result * sqr(result); break;
+
+        case ReplayOp::Min:
+        case ReplayOp::Max: {
+                const Value &b = *arg[1];
+                auto m = op == ReplayOp::Min ? a < b : a > b;
+                result = op == ReplayOp::Min ? min(a, b) : max(a, b);
+                weight[0] = select(m, one, zero);
+                weight[1] = select(m, zero, one);
+            }
+            break;
+
+        case ReplayOp::Select: {
+                /* The third operand holds the mask as 0/1 values */
+                const Value &mask = *arg[2];
+                result = select(neq(mask, zero), a, *arg[1]);
+                weight[0] = mask;
+                weight[1] = one - mask;
+            }
+            break;
+
+        case ReplayOp::Sin:
+        case ReplayOp::Cos: {
+                auto [s, c] = sincos(a);
+                result = op == ReplayOp::Sin ? s : c;
+                weight[0] = op == ReplayOp::Sin ? c : -s;
+            }
+            break;
+
+        case ReplayOp::Tan:  result = tan(a); weight[0] = sqr(sec(a));       break;
+        case ReplayOp::Csc:  result = csc(a); weight[0] = -result * cot(a);  break;
+        case ReplayOp::Sec:  result = sec(a); weight[0] = result * tan(a);   break;
+        case ReplayOp::Cot:  result = cot(a); weight[0] = -sqr(csc(a));      break;
+        case ReplayOp::Asin: result = asin(a); weight[0] = rsqrt(one - sqr(a));  break;
+        case ReplayOp::Acos: result = acos(a); weight[0] = -rsqrt(one - sqr(a)); break;
+        case ReplayOp::Atan: result = atan(a); weight[0] = rcp(one + sqr(a));    break;
+
+        case ReplayOp::Atan2: {
+                const Value &x = *arg[1];
+                Value il2 = rcp(sqr(a) + sqr(x));
+                result = atan2(a, x);
+                weight[0] = il2 * x;
+                weight[1] = -il2 * a;
+            }
+            break;
+
+        case ReplayOp::Sinh:
+        case ReplayOp::Cosh: {
+                auto [s, c] = sincosh(a);
+                result = op == ReplayOp::Sinh ? s : c;
+                weight[0] = op == ReplayOp::Sinh ? c : s;
+            }
+            break;
+
+        case ReplayOp::Csch:  result = csch(a);  weight[0] = -result * coth(a);      break;
+        case ReplayOp::Sech:  result = sech(a);  weight[0] = -result * tanh(a);      break;
+        case ReplayOp::Tanh:  result = tanh(a);  weight[0] = sqr(sech(a));           break;
+        case ReplayOp::Asinh: result = asinh(a); weight[0] = rsqrt(one + sqr(a));    break;
+        case ReplayOp::Acosh: result = acosh(a); weight[0] = rsqrt(sqr(a) - one);    break;
+        case ReplayOp::Atanh: result = atanh(a); weight[0] = rcp(one - sqr(a));      break;
+        case ReplayOp::Exp:   result = exp(a);   weight[0] = result;                 break;
+        case ReplayOp::Log:   result = log(a);   weight[0] = rcp(a);                 break;
+        case ReplayOp::Hsum:  result = Value(hsum(a)); weight[0] = one;              break;
+
+        case ReplayOp::Hprod:
+            result = Value(hprod(a));
+            weight[0] = select(eq(a, zero), zero, result / a);
+            break;
+    }
+}
+
+template <typename Value> struct FrozenGraph<Value>::Detail {
+    using Edge = typename Tape<Value>::Edge;
+    static constexpr uint32_t Invalid = (uint32_t) -1;
+
+    /// Operation of a node that is re-evaluated by \ref FrozenGraph::eval()
+    struct Op {
+        ReplayOp op;
+        uint32_t count = 0;
+
+        /// Position of each operand, or 'Invalid' if it is a constant stored in 'value'
+        uint32_t arg[3];
+
+        /// Edge that receives the partial derivative with respect to each operand (or 'Invalid')
+        uint32_t edge[3];
+
+        Value value[3];
+    };
+
+    /// Operations of all nodes (leaves have none), empty if the graph isn't replayable
+    std::vector<Op> ops;
+    bool replayable = false;
+
+    /// Sizes of the variables in topological order (sources before targets)
+    std::vector<uint32_t> size;
+
+    /// Edges of node \c i are stored at <tt>edge_offset[i] .. edge_offset[i + 1] - 1</tt>
+    std::vector<uint32_t> edge_offset;
+
+    /// Edges with weights, 'Edge::source' refers to the position in 'size'
+    std::vector<Edge> edges;
+
+    /// Last node that has an edge to each node (forward mode: release its gradient)
+    std::vector<uint32_t> last_use;
+
+    /// Nodes whose gradients are returned by replays
+    std::vector<bool> keep;
+
+    /// Nodes whose values are specified by \ref FrozenGraph::eval()
+    std::vector<bool> is_input;
+
+    /// Positions of the inputs and outputs (or 'Invalid'), and their sizes
+    std::vector<uint32_t> inputs, outputs, input_size, output_size;
+
+    /// Check the size of 'grad' after all contributions to node 'i' have arrived
+    void finalize(uint32_t i, Value &grad, const char *func) const {
+        if constexpr (is_dynamic_v<Value>) {
+            if (grad.empty() || grad.size() == size[i])
+                return;
+            if (size[i] == 1)
+                grad = hsum(grad);
+            else if (grad.size() == 1)
+                set_slices(grad, size[i]);
+            else
+                throw std::runtime_error(
+                    std::string(func) + ": gradient sizes don't match: expected " +
+                    std::to_string(size[i]) + ", got " + std::to_string(grad.size()));
         } else {
-            if (target.ref_count_int > 0)
-                target.grad = Value();
+            ENOKI_MARK_USED(i);
+            ENOKI_MARK_USED(grad);
+            ENOKI_MARK_USED(func);
+        }
+    }
+
+    /// Add the gradients in 'values' to the nodes at 'positions'
+    void seed(std::vector<Value> &grad, const std::vector<uint32_t> &positions,
+              const std::vector<Value> &values, const char *func) const {
+        if (values.size() != positions.size())
+            throw std::runtime_error(std::string(func) + ": expected " +
+                                     std::to_string(positions.size()) +
+                                     " gradients, got " +
+                                     std::to_string(values.size()));
+        for (size_t k = 0; k < positions.size(); ++k) {
+            uint32_t i = positions[k];
+            if (i == Invalid)
+                continue;
+            if constexpr (is_dynamic_v<Value>) {
+                if (grad[i].empty()) {
+                    grad[i] = values[k];
+                    continue;
+                }
+            }
+            grad[i] += values[k];
+        }
+    }
+
+    /// Gather the gradients of the nodes at 'positions'
+    std::vector<Value> collect(std::vector<Value> &grad,
+                               const std::vector<uint32_t> &positions,
+                               const std::vector<uint32_t> &sizes) const {
+        std::vector<Value> result(positions.size());
+        for (size_t k = 0; k < positions.size(); ++k) {
+            uint32_t i = positions[k];
+            if constexpr (is_dynamic_v<Value>) {
+                if (i == Invalid || grad[i].empty())
+                    result[k] = zero<Value>(sizes[k]);
+                else
+                    result[k] = grad[i];
+            } else {
+                if (i != Invalid)
+                    result[k] = grad[i];
+            }
+        }
+        return result;
+    }
+};
+
+template <typename Value> FrozenGraph<Value>::FrozenGraph() : d(new Detail()) { }
+template <typename Value> FrozenGraph<Value>::FrozenGraph(FrozenGraph &&) noexcept = default;
+template <typename Value> FrozenGraph<Value> &FrozenGraph<Value>::operator=(FrozenGraph &&) noexcept = default;
+template <typename Value> FrozenGraph<Value>::~FrozenGraph() = default;
+
+template <typename Value> size_t FrozenGraph<Value>::input_count() const { return d->inputs.size(); }
+template <typename Value> size_t FrozenGraph<Value>::output_count() const { return d->outputs.size(); }
+template <typename Value> size_t FrozenGraph<Value>::node_count() const { return d->size.size(); }
+template <typename Value> size_t FrozenGraph<Value>::edge_count() const { return d->edges.size(); }
+template <typename Value> bool FrozenGraph<Value>::replayable() const { return d->replayable; }
+
+template <typename Value>
+std::vector<Value> FrozenGraph<Value>::eval(const std::vector<Value> &inputs) {
+    const char *func = "FrozenGraph::eval()";
+    using Detail = typename FrozenGraph<Value>::Detail;
+    constexpr uint32_t Invalid = Detail::Invalid;
+
+    if (!d->replayable)
+        throw std::runtime_error(
+            std::string(func) + ": the graph contains operations that weren't "
+            "recorded via set_record_primal_() or that can't be re-evaluated!");
+    if (inputs.size() != d->inputs.size())
+        throw std::runtime_error(std::string(func) + ": expected " +
+                                 std::to_string(d->inputs.size()) +
+                                 " inputs, got " + std::to_string(inputs.size()));
+
+    std::vector<Value> value(d->size.size());
+    for (size_t k = 0; k < inputs.size(); ++k) {
+        uint32_t i = d->inputs[k];
+        if (i == Invalid)
+            continue;
+        if constexpr (is_dynamic_v<Value>) {
+            if (inputs[k].size() != d->input_size[k])
+                throw std::runtime_error(
+                    std::string(func) + ": input sizes don't match: expected " +
+                    std::to_string(d->input_size[k]) + ", got " +
+                    std::to_string(inputs[k].size()));
+        }
+        value[i] = inputs[k];
+    }
+
+    Value result, weight[3];
+    for (uint32_t i = 0; i < (uint32_t) d->size.size(); ++i) {
+        const typename Detail::Op &op = d->ops[i];
+        if (op.count == 0)
+            continue;
+
+        const Value *args[3] = { };
+        for (uint32_t k = 0; k < op.count; ++k)
+            args[k] = op.arg[k] != Invalid ? &value[op.arg[k]] : &op.value[k];
+        replay_eval(op.op, args, result, weight);
+
+        for (uint32_t k = 0; k < op.count; ++k) {
+            if (op.edge[k] != Invalid)
+                d->edges[op.edge[k]].set_weight(weight[k]);
+        }
+
+        /* Release operands that aren't needed anymore */
+        for (uint32_t k = 0; k < op.count; ++k) {
+            uint32_t j = op.arg[k];
+            if (j != Invalid && d->last_use[j] == i && !d->keep[j])
+                value[j] = Value();
+        }
+
+        if (!d->is_input[i])
+            value[i] = std::move(result);
+    }
+
+    std::vector<Value> outputs(d->outputs.size());
+    for (size_t k = 0; k < outputs.size(); ++k) {
+        if (d->outputs[k] != Invalid)
+            outputs[k] = value[d->outputs[k]];
+    }
+    return outputs;
+}
+
+template <typename Value>
+std::vector<Value> FrozenGraph<Value>::backward(const std::vector<Value> &grad_outputs) const {
+    const char *func = "FrozenGraph::backward()";
+    std::vector<Value> grad(d->size.size());
+    d->seed(grad, d->outputs, grad_outputs, func);
+
+    for (uint32_t i = (uint32_t) d->size.size(); i-- > 0; ) {
+        Value &target = grad[i];
+        if constexpr (is_dynamic_v<Value>) {
+            if (target.empty())
+                continue;
+        }
+        d->finalize(i, target, func);
+
+        for (uint32_t k = d->edge_offset[i]; k < d->edge_offset[i + 1]; ++k) {
+            const auto &edge = d->edges[k];
+            Tape<Value>::Detail::accumulate(edge, target, grad[edge.source],
+                                            d->size[edge.source]);
+        }
+
+        if (!d->keep[i])
+            target = Value();
+    }
+
+    return d->collect(grad, d->inputs, d->input_size);
+}
+
+template <typename Value>
+std::vector<Value> FrozenGraph<Value>::forward(const std::vector<Value> &grad_inputs) const {
+    const char *func = "FrozenGraph::forward()";
+    std::vector<Value> grad(d->size.size());
+    d->seed(grad, d->inputs, grad_inputs, func);
+
+    for (uint32_t i = 0; i < (uint32_t) d->size.size(); ++i) {
+        Value &target = grad[i];
+        for (uint32_t k = d->edge_offset[i]; k < d->edge_offset[i + 1]; ++k) {
+            const auto &edge = d->edges[k];
+            Value &source = grad[edge.source];
+            if constexpr (is_dynamic_v<Value>) {
+                if (source.empty())
+                    continue;
+            }
+            Tape<Value>::Detail::accumulate(edge, source, target, d->size[i]);
+            if (d->last_use[edge.source] == i && !d->keep[edge.source])
+                source = Value();
+        }
+        d->finalize(i, target, func);
+    }
+
+    return d->collect(grad, d->outputs, d->output_size);
+}
+
+template <typename Value>
+FrozenGraph<Value> Tape<Value>::freeze(const std::vector<Index> &outputs,
+                                       const std::vector<Index> &inputs) {
+    using FrozenDetail = typename FrozenGraph<Value>::Detail;
+    constexpr uint32_t Invalid = FrozenDetail::Invalid;
+
+    FrozenGraph<Value> result;
+    FrozenDetail &fd = *result.d;
+    auto &scheduled = d->scheduled;
+    scheduled.clear();
+
+    /* 1. Nodes that can reach an output, in topological order */
+    for (Index index : outputs) {
+        if (index != 0)
+            d->dfs(index, true, false);
+    }
+    std::vector<Index> order(scheduled);
+    scheduled.clear();
+
+    /* 2. .. and that can be reached from an input */
+    for (Index index : inputs) {
+        if (index != 0)
+            d->dfs(index, false, false);
+    }
+    scheduled.clear();
+
+    std::unordered_map<Index, uint32_t> position;
+    for (Index index : order) {
+        if (d->node(index).visited == d->epoch) {
+            uint32_t i = (uint32_t) position.size();
+            position[index] = i;
+        }
+    }
+
+    /* 3. Can the graph be re-evaluated? All nodes need a record, except for
+          leaves. Its operands must match the edges, which graph
+          simplification may have rewired. */
+    auto position_of = [&](Index index) {
+        auto it = index != 0 ? position.find(index) : position.end();
+        return it != position.end() ? it->second : Invalid;
+    };
+
+    std::vector<const PrimalRecord<Value> *> records;
+    bool replayable = !d->primal.empty();
+    for (Index index : order) {
+        if (!replayable)
+            break;
+        if (position_of(index) == Invalid)
+            continue;
+        Node &node = d->node(index);
+        auto it = d->primal.find(index);
+        const PrimalRecord<Value> *record =
+            it != d->primal.end() ? &it->second : nullptr;
+
+        for (const Edge &edge : node.edges) {
+            if (position_of(edge.source) == Invalid)
+                continue;
+            bool found = false;
+            for (uint32_t k = 0; record && k < record->count; ++k)
+                found |= record->arg[k] == edge.source;
+            replayable &= found;
+        }
+        for (uint32_t k = 0; record && k < record->count; ++k) {
+            Index arg = record->arg[k];
+            if (position_of(arg) != Invalid)
+                replayable &= d->node(arg).seq == record->arg_seq[k] &&
+                              node.edge(arg) != nullptr;
+        }
+        records.push_back(record);
+    }
+
+    /* 4. Copy the nodes and edges between them */
+    size_t n = position.size();
+    fd.size.reserve(n);
+    fd.edge_offset.reserve(n + 1);
+    fd.edge_offset.push_back(0);
+    fd.last_use.assign(n, Invalid);
+    fd.keep.assign(n, false);
+    fd.is_input.assign(n, false);
+    fd.replayable = replayable;
+    if (replayable)
+        fd.ops.resize(n);
+
+    for (Index index : order) {
+        auto it = position.find(index);
+        if (it == position.end())
+            continue;
+        const Node &node = d->node(index);
+
+        if (replayable) {
+            /* Create one edge per operand, weighted by the partial
+               derivatives at the recorded operand values */
+            const PrimalRecord<Value> *record = records[it->second];
+            if (record) {
+                typename FrozenDetail::Op &op = fd.ops[it->second];
+                const Value *args[3] = { &record->value[0], &record->value[1],
+                                         &record->value[2] };
+                Value result, weight[3];
+                replay_eval(record->op, args, result, weight);
+
+                op.op = record->op;
+                op.count = record->count;
+                for (uint32_t k = 0; k < record->count; ++k) {
+                    uint32_t source = position_of(record->arg[k]);
+                    op.arg[k] = source;
+                    op.edge[k] = Invalid;
+                    if (source == Invalid) {
+                        op.value[k] = record->value[k];
+                        continue;
+                    }
+                    op.edge[k] = (uint32_t) fd.edges.size();
+                    fd.edges.emplace_back(source, weight[k]);
+                    fd.last_use[source] = it->second;
+                }
+            }
+            fd.size.push_back(node.size);
+            fd.edge_offset.push_back((uint32_t) fd.edges.size());
+            continue;
+        }
+
+        for (const Edge &edge : node.edges) {
+            auto it2 = position.find(edge.source);
+            if (it2 == position.end())
+                continue;
+            if (edge.is_special())
+                throw std::runtime_error(
+                    "freeze(): graphs containing gather, scatter or "
+                    "checkpoint operations can't be frozen!");
+            Edge copy;
+            copy.source = it2->second;
+            copy.kind = edge.kind;
+            copy.scale = edge.scale;
+            copy.weight = edge.weight;
+            fd.edges.push_back(std::move(copy));
+            fd.last_use[it2->second] = it->second;
+        }
+
+        fd.size.push_back(node.size);
+        fd.edge_offset.push_back((uint32_t) fd.edges.size());
+    }
+
+    auto map = [&](const std::vector<Index> &indices, std::vector<uint32_t> &positions,
+                   std::vector<uint32_t> &sizes) {
+        positions.reserve(indices.size());
+        sizes.reserve(indices.size());
+        for (Index index : indices) {
+            uint32_t i = position_of(index);
+            positions.push_back(i);
+            sizes.push_back(index != 0 ? d->node(index).size : 1u);
+            if (i != Invalid)
+                fd.keep[i] = true;
+        }
+    };
+    map(inputs, fd.inputs, fd.input_size);
+    map(outputs, fd.outputs, fd.output_size);
+    for (uint32_t i : fd.inputs) {
+        if (i != Invalid)
+            fd.is_input[i] = true;
+    }
+
+    if (d->log_level >= 1)
+        std::cerr << "autodiff: freeze(): copied " << fd.size.size()
+                  << " nodes and " << fd.edges.size() << " edges"
+                  << (replayable ? " (replayable)." : ".") << std::endl;
+
+    return result;
+}
+
+template <typename Value>
+void Tape<Value>::set_gradient(Index index, const Value &value, bool backward) {
+    if (index == 0)
+        throw std::runtime_error(
+            "set_gradient(): no gradients are associated with this variable (a "
+            "prior call to requires_gradient() is required.) ");
+
+    d->dfs(index, backward, true);
+    Node &node = d->node(index);
+    node.grad = value;
+    if constexpr (is_dynamic_v<Value>) {
+        if (node.size > 1 && node.grad.size() == 1)
+            set_slices(node.grad, node.size);
+    }
+}
+
+template <typename Value>
+void Tape<Value>::backward(bool free_graph) {
+    auto &scheduled = d->scheduled;
+
+    if (free_graph) {
+        for (Index index : scheduled)
+            inc_ref_ext(index);
+    }
+
+    if (d->parallel_backward) {
+        backward_parallel(free_graph);
+    } else {
+        for (auto it = scheduled.rbegin(); it != scheduled.rend(); ++it) {
+            Index target_idx = *it;
+            Node &target = d->node(target_idx);
+            Clock::time_point start;
+            if (ENOKI_UNLIKELY(d->profiling))
+                start = Clock::now();
+            d->check_grad_size(target, "backward()");
+
+            for (Edge &edge : target.edges)
+                d->backward_edge(target_idx, target, d->node(edge.source), edge);
+
+            if (ENOKI_UNLIKELY(d->profiling))
+                d->profile_node(target, start, true);
+            backward_release(target_idx, free_graph);
         }
     }
 
@@ -908,61 +2257,177 @@ void Tape<Value>::backward(bool free_graph) {
     scheduled.clear();
 }
 
+template <typename Value>
+void Tape<Value>::backward_release(Index index, bool free_graph) {
+    Node &target = d->node(index);
+    if (free_graph) {
+        for (Edge &edge : target.edges) {
+            dec_ref_int(edge.source, index);
+            edge.source = 0;
+        }
+        if (target.edges.size() > 0) {
+            target.edges.clear();
+            target.grad = Value();
+        }
+        dec_ref_ext(index);
+    } else {
+        if (target.ref_count_int > 0)
+            target.grad = Value();
+    }
+}
+
+/**
+ * Level-synchronous variant of the backward pass: nodes are grouped into
+ * levels such that all consumers of a node reside in earlier levels. The
+ * nodes of a level are independent and gather ("pull") the contributions of
+ * their consumers, hence every gradient is only written by a single thread.
+ * Nodes are released once the deepest of their sources has been processed.
+ */
+template <typename Value>
+void Tape<Value>::backward_parallel(bool free_graph) {
+#if defined(ENOKI_AUTODIFF_THREAD)
+    if constexpr (is_dynamic_v<Value> && !is_cuda_array_v<Value>) {
+        auto &scheduled = d->scheduled;
+        uint32_t epoch = d->epoch, level_count = 0;
+
+        /* Assign levels in topological order. Levels that re-run a
+           checkpointed region modify the graph and are processed serially */
+        d->level_serial.clear();
+        for (auto it = scheduled.rbegin(); it != scheduled.rend(); ++it) {
+            Node &n = d->node(*it);
+            uint32_t level = 0;
+            bool serial = false;
+            for (Index t : n.edges_rev) {
+                const Node &target = d->node(t);
+                if (target.visited == epoch) {
+                    level = std::max(level, target.level + 1);
+                    serial |= target.recompute;
+                }
+            }
+            for (Index t : n.edges_rev) {
+                Node &target = d->node(t);
+                if (target.visited == epoch)
+                    target.level_release = std::max(target.level_release, level);
+            }
+            n.level = n.level_release = level;
+            if (level >= level_count) {
+                level_count = level + 1;
+                d->level_serial.resize(level_count, false);
+            }
+            if (serial)
+                d->level_serial[level] = true;
+        }
+
+        /* Bucket nodes by level and by release level (counting sort) */
+        auto &level_offset = d->level_offset, &release_offset = d->release_offset,
+             &level_work = d->level_work;
+        auto &level_nodes = d->level_nodes, &release_nodes = d->release_nodes;
+        level_offset.assign(level_count + 1, 0);
+        release_offset.assign(level_count + 1, 0);
+        level_work.assign(level_count, 0);
+        level_nodes.resize(scheduled.size());
+        release_nodes.resize(scheduled.size());
+
+        for (Index index : scheduled) {
+            const Node &n = d->node(index);
+            level_offset[n.level + 1]++;
+            release_offset[n.level_release + 1]++;
+            level_work[n.level] += n.size;
+        }
+        for (uint32_t i = 0; i < level_count; ++i) {
+            level_offset[i + 1] += level_offset[i];
+            release_offset[i + 1] += release_offset[i];
+        }
+        for (auto it = scheduled.rbegin(); it != scheduled.rend(); ++it) {
+            const Node &n = d->node(*it);
+            level_nodes[level_offset[n.level]++] = *it;
+            release_nodes[release_offset[n.level_release]++] = *it;
+        }
+        for (uint32_t i = level_count; i > 0; --i) {
+            level_offset[i] = level_offset[i - 1];
+            release_offset[i] = release_offset[i - 1];
+        }
+        level_offset[0] = release_offset[0] = 0;
+
+        auto pull = [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                Index source_idx = level_nodes[i];
+                Node &source = d->node(source_idx);
+                Clock::time_point start;
+                if (ENOKI_UNLIKELY(d->profiling))
+                    start = Clock::now();
+                for (Index target_idx : source.edges_rev) {
+                    Node &target = d->node(target_idx);
+                    if (target.visited != epoch)
+                        continue;
+                    Edge *edge = target.edge(source_idx);
+                    if (ENOKI_UNLIKELY(edge == nullptr))
+                        throw std::runtime_error("backward(): invalid graph structure!");
+                    d->backward_edge(target_idx, target, source, *edge);
+                }
+                d->check_grad_size(source, "backward()");
+
+                /* Time spent pulling into 'source' (instead of pushing
+                   out of its consumers as in the serial pass) */
+                if (ENOKI_UNLIKELY(d->profiling))
+                    d->profile_node(source, start, true);
+            }
+        };
+
+        for (uint32_t level = 0; level < level_count; ++level) {
+            size_t begin = level_offset[level], end = level_offset[level + 1];
+
+            if (end - begin > 1 && !d->level_serial[level] &&
+                level_work[level] >= ENOKI_AUTODIFF_PARALLEL_THRESHOLD)
+                parallel_for(end - begin, 1, [&](size_t b, size_t e) {
+                    pull(begin + b, begin + e);
+                });
+            else
+                pull(begin, end);
+
+            for (size_t i = release_offset[level]; i < release_offset[level + 1]; ++i)
+                backward_release(release_nodes[i], free_graph);
+        }
+        return;
+    }
+#endif
+    ENOKI_MARK_USED(free_graph);
+    throw std::runtime_error("backward_parallel(): unsupported!");
+}
+
+template <typename Value>
+void Tape<Value>::set_parallel_backward(bool value) {
+#if defined(ENOKI_AUTODIFF_THREAD)
+    if constexpr (is_dynamic_v<Value> && !is_cuda_array_v<Value>) {
+        d->parallel_backward = value;
+        return;
+    }
+#endif
+    if (value)
+        throw std::runtime_error(
+            "set_parallel_backward(): only supported for dynamic CPU arrays "
+            "when Enoki is compiled with ENOKI_THREAD!");
+}
+
 template <typename Value>
 void Tape<Value>::forward(bool free_graph) {
     auto &scheduled = d->scheduled;
 
     if (free_graph) {
-        for (auto it = scheduled.begin(); it != scheduled.end(); ++it)
-            inc_ref_ext(*it);
+        for (Index index : scheduled)
+            inc_ref_ext(index);
     }
 
-    for (auto it = scheduled.begin(); it != scheduled.end(); ++it) {
+    for (auto it = scheduled.rbegin(); it != scheduled.rend(); ++it) {
         Index source_idx = *it;
         Node &source = d->node(source_idx);
 
-        if constexpr (is_dynamic_v<Value>) {
-            if (source.size == 1 && source.grad.size() > 1)
-                source.grad = hsum(source.grad);
-        }
-
-        for (Index target_idx : source.edges_rev) {
-            Node &target = d->node(target_idx);
-            Edge *edge = target.edge(source_idx);
-            if (edge == nullptr)
-                throw std::runtime_error("forward(): invalid graph structure!");
-
-            if (ENOKI_LIKELY(!edge->is_special())) {
-                if constexpr (is_dynamic_v<Value>) {
-                    if (target.size == 1 && (edge->weight.size() != 1 || source.grad.size() != 1)) {
-                        if (target.grad.empty())
-                            target.grad = hsum(safe_mul(edge->weight, source.grad));
-                        else
-                            target.grad += hsum(safe_mul(edge->weight, source.grad));
-                    } else {
-                        if (target.grad.empty())
-                            target.grad = safe_mul(edge->weight, source.grad);
-                        else
-                            target.grad = safe_fmadd(edge->weight, source.grad, target.grad);
-                    }
-                } else {
-                    target.grad = safe_fmadd(edge->weight, source.grad, target.grad);
-                }
-            } else {
-                edge->special->forward(d, target_idx, *edge);
-            }
-            if constexpr (is_dynamic_v<Value>) {
-                if (ENOKI_UNLIKELY(target.size != target.grad.size())) {
-                    if (target.grad.size() == 1)
-                        set_slices(target.grad, target.size);
-                    else
-                        throw std::runtime_error(
-                            "forward(): gradient sizes don't match: expected " +
-                            std::to_string(target.size) + ", got " +
-                            std::to_string(target.grad.size()));
-                }
-            }
-        }
+        Clock::time_point start;
+        if (ENOKI_UNLIKELY(d->profiling))
+            start = Clock::now();
+        d->forward_node(source_idx, source);
+        if (ENOKI_UNLIKELY(d->profiling))
+            d->profile_node(source, start, false);
         if (source.ref_count_int > 0)
             source.grad = Value();
         if (free_graph) {
@@ -994,25 +2459,52 @@ template <typename Value> void Tape<Value>::simplify_graph() {
     if (d->log_level >= 2)
         std::cerr << "autodiff: simplify_graph(): starting.." << std::endl;
 
-    std::set<std::pair<Index, Index>> todo;
-    std::vector<std::pair<Index, Index>> update;
-    std::vector<Index> edges_rev;
-    for (const auto &it : d->nodes)
-        todo.emplace(it.second.score(), it.first);
+    constexpr uint32_t MaxScore = ENOKI_AUTODIFF_MAX_SIMPLIFICATION_COST,
+                       NotQueued = (uint32_t) -1,
+                       Overflow = (uint32_t) -2;
+    auto start = std::chrono::high_resolution_clock::now();
+    SimplificationStatistics &stats = d->simplification_stats;
+
+    /* Bucketed priority queue: 'bucket[s]' contains nodes with score 's'.
+       Entries are invalidated lazily by comparing against 'queued[index]',
+       which is the score of the live entry, 'NotQueued', or 'Overflow' (the
+       score is too high but may still decrease). */
+    std::vector<std::vector<Index>> bucket(MaxScore + 1);
+    std::vector<uint32_t> queued(d->node_end, NotQueued);
+    uint32_t current = 0;
+
+    auto push = [&](Index index, uint32_t score) {
+        if (score > MaxScore) {
+            queued[index] = Overflow;
+        } else {
+            queued[index] = score;
+            bucket[score].push_back(index);
+            current = std::min(current, score);
+        }
+    };
+
+    d->for_each_node([&](Index index, const Node &node) {
+        if (node.collapse_allowed())
+            push(index, node.score());
+    });
+
+    std::vector<Index> update, edges_rev;
     size_t cost = 0;
 
-    while (!todo.empty()) {
-        auto it = todo.begin();
-        uint32_t score = it->first, index = it->second;
-        todo.erase(it);
+    while (true) {
+        while (current <= MaxScore && bucket[current].empty())
+            current++;
+        if (current > MaxScore)
+            break;
+        Index index = bucket[current].back();
+        bucket[current].pop_back();
+        if (queued[index] != current)
+            continue; /* Stale entry */
+        queued[index] = NotQueued;
+
         Node &node = d->node(index);
         if (!node.collapse_allowed())
             continue;
-        if (score > ENOKI_AUTODIFF_MAX_SIMPLIFICATION_COST) {
-            if (d->log_level >= 2)
-                std::cerr << "autodiff: simplify_graph(): cost of next simplification = " << cost << ", giving up." << std::endl;
-            break;
-        }
 
         update.clear();
         bool skip = false;
@@ -1023,21 +2515,36 @@ template <typename Value> void Tape<Value>::simplify_graph() {
                 assert(e != nullptr);
                 if (e->is_special())
                     skip = true;
-                update.emplace_back(d->node(k).score(), k);
+                update.push_back(k);
             }
             for (const Edge &edge : node.edges) {
                 const Node &node2 = d->node(edge.source);
-                update.emplace_back(node2.score(), edge.source);
+                update.push_back(edge.source);
                 if ((node.size == 1 && (node2.size != node.size)) || edge.is_special())
                     skip = true;
             }
         }
 
-        if (skip)
+        if (skip) {
+            stats.skipped++;
             continue;
+        }
+
+        /* GPU arrays always collapse: their weights are often not evaluated
+           yet, and the products end up in registers of the same kernel */
+        int64_t savings = 0;
+        if constexpr (!is_cuda_array_v<Value>) {
+            savings = d->collapse_savings(index, node);
+            if (savings < 0) {
+                stats.rejected++;
+                continue;
+            }
+        }
 
         if (d->log_level >= 3)
-            std::cerr << "autodiff: simplify_graph(): collapsing node " << index << ", cost = " << score << std::endl;
+            std::cerr << "autodiff: simplify_graph(): collapsing node " << index
+                      << ", score = " << current << ", savings = " << savings
+                      << std::endl;
 
         /* Remove node and create edges */ {
             edges_rev = node.edges_rev;
@@ -1045,30 +2552,37 @@ template <typename Value> void Tape<Value>::simplify_graph() {
                 Edge edge1 = d->node(other).remove_edge(index);
 
                 for (auto const &edge2 : node.edges) {
-                    append_edge_prod(edge2.source, other, edge1.weight, edge2.weight);
+                    append_edge_prod(edge2.source, other, edge1.weight_value(),
+                                     edge2.weight_value());
                     cost++;
                 }
 
                 dec_ref_int(index, other);
             }
         }
-
-        /* Update costs (if changed) */ {
-            for (auto [old_score, id] : update) {
-                auto it = todo.find({ old_score, id });
-                if (it == todo.end())
-                    continue;
-                uint32_t new_score = d->node(id).score();
-                if (old_score != new_score) {
-                    todo.erase(it);
-                    todo.emplace(new_score, id);
-                }
-            }
+        stats.collapsed++;
+        stats.saved += savings;
+
+        /* Update the scores of nodes that are still queued */
+        for (Index id : update) {
+            if (queued[id] == NotQueued)
+                continue;
+            uint32_t score = d->node(id).score();
+            if (score != queued[id])
+                push(id, score);
         }
     }
 
+    auto end = std::chrono::high_resolution_clock::now();
+    stats.runs++;
+    stats.products += cost;
+    stats.time_last = (size_t) std::chrono::duration_cast<
+        std::chrono::microseconds>(end - start).count();
+    stats.time_total += stats.time_last;
+
     if (d->log_level >= 2)
-        std::cerr << "autodiff: simplify_graph(): done. (cost = " << cost << ")" << std::endl;
+        std::cerr << "autodiff: simplify_graph(): done. (cost = " << cost
+                  << ", " << stats.time_last << " us)" << std::endl;
     d->is_simplified = true;
 }
 
@@ -1091,16 +2605,9 @@ std::string Tape<Value>::graphviz(const std::vector<Index> &indices_) {
 
     for (Index index : indices) {
         const Node &node = d->node(index);
-        if (node.label.empty())
-            continue;
-        std::string label = node.label;
-
-        auto sepidx = label.rfind("/");
-        std::string path, suffix;
-        if (sepidx != std::string::npos) {
-            path = label.substr(0, sepidx);
-            label = label.substr(sepidx + 1);
-        }
+        std::string label = node.label ? node.label : "",
+                    path = node.prefix ? node.prefix : "";
+        size_t sepidx;
 
         if (current_path != path) {
             for (int i = 0; i < current_depth; ++i)
@@ -1133,7 +2640,7 @@ std::string Tape<Value>::graphviz(const std::vector<Index> &indices_) {
             << std::to_string(node.ref_count_ext) << "/"
             << std::to_string(node.ref_count_int) << "]"
             << "\"";
-        if (node.label[0] == '\'')
+        if (node.label && node.label[0] == '\'')
             oss << " fillcolor=salmon style=filled";
         oss << "];" << std::endl;
     }
@@ -1161,28 +2668,118 @@ std::string Tape<Value>::graphviz(const std::vector<Index> &indices_) {
     return oss.str();
 }
 
+template <typename Value>
+void Tape<Value>::dump_graph(const std::vector<Index> *indices, std::ostream &os) {
+    using DumpKind = GraphDump::EdgeKind;
+
+    auto put = [&](const auto &value) {
+        os.write((const char *) &value, sizeof(value));
+    };
+
+    std::unordered_map<const char *, uint32_t> string_ids;
+    auto string_id = [&](const char *str) -> uint32_t {
+        if (!str)
+            return GraphDump::NoString;
+        auto [it, inserted] = string_ids.emplace(str, (uint32_t) string_ids.size());
+        if (inserted) {
+            uint32_t length = (uint32_t) strlen(str);
+            put('S');
+            put(length);
+            os.write(str, length);
+        }
+        return it->second;
+    };
+
+    uint64_t node_count = 0, edge_count = 0;
+    auto write_node = [&](Index index, const Node &node) {
+        uint32_t label = string_id(node.label),
+                 prefix = string_id(node.prefix),
+                 grad_size = 0;
+        if constexpr (is_dynamic_v<Value>)
+            grad_size = (uint32_t) node.grad.size();
+        else
+            grad_size = 1;
+
+        put('N');
+        put(index); put(node.size); put(grad_size);
+        put(node.ref_count_ext); put(node.ref_count_int);
+        put(node.seq); put(label); put(prefix);
+        put((uint32_t) node.edges.size());
+
+        for (const Edge &edge : node.edges) {
+            DumpKind kind = DumpKind::Special;
+            if (!edge.is_special()) {
+                switch (edge.kind) {
+                    case EdgeKind::Identity: kind = DumpKind::Identity; break;
+                    case EdgeKind::Negate:   kind = DumpKind::Negate; break;
+                    case EdgeKind::Scale:    kind = DumpKind::Scale; break;
+                    default:                 kind = DumpKind::Full; break;
+                }
+            }
+            put(edge.source);
+            put((uint8_t) kind);
+            if (kind == DumpKind::Scale)
+                put((double) edge.scale);
+            else if (kind == DumpKind::Full)
+                put((uint32_t) edge.weight_size());
+        }
+
+        node_count++;
+        edge_count += node.edges.size();
+    };
+
+    os.write("ENKG", 4);
+    put(GraphDump::Version);
+    put((uint32_t) sizeof(scalar_t<Value>));
+
+    if (indices) {
+        auto &scheduled = d->scheduled;
+        scheduled.clear();
+        for (Index index : *indices) {
+            if (index != 0)
+                d->dfs(index, true, false);
+        }
+        for (Index index : scheduled)
+            write_node(index, d->node(index));
+        scheduled.clear();
+    } else {
+        d->for_each_node(write_node);
+    }
+
+    put('E');
+    put(node_count);
+    put(edge_count);
+
+    if (!os)
+        throw std::runtime_error("dump_graph(): could not write to stream!");
+}
+
 template <typename Value> std::string Tape<Value>::whos() const {
     std::ostringstream oss;
     oss << std::endl
         << "  ID      E/I Refs   Size        Label" << std::endl
         << "  ====================================" << std::endl;
 
-    std::vector<uint32_t> indices;
-    indices.reserve(d->nodes.size());
-    for (const auto& it : d->nodes)
-        indices.push_back(it.first);
-    std::sort(indices.begin(), indices.end());
-
-    for (uint32_t id : indices) {
-        const Node &n = d->node(id);
+    d->for_each_node([&](Index id, const Node &n) {
         oss << "  " << std::left << std::setw(7) << id << " ";
         oss << std::left << std::setw(10) << (std::to_string(n.ref_count_ext) + " / " + std::to_string(n.ref_count_int)) << " ";
         oss << std::left << std::setw(12) << n.size;
-        oss << n.label;
+        if (n.prefix)
+            oss << n.prefix << '/';
+        if (n.label)
+            oss << n.label;
         oss << std::endl;
-    }
-
-    oss << "  ====================================" << std::endl << std::endl;
+    });
+
+    const SimplificationStatistics &stats = d->simplification_stats;
+    oss << "  ====================================" << std::endl << std::endl
+        << "  Graph simplification : " << stats.runs << " runs, "
+        << stats.time_total << " us (last: " << stats.time_last << " us)" << std::endl
+        << "  Nodes                : " << stats.collapsed << " collapsed, "
+        << stats.rejected << " rejected by cost model, "
+        << stats.skipped << " not collapsible" << std::endl
+        << "  Weight products      : " << stats.products << std::endl
+        << "  Est. traffic savings : " << stats.saved << " entries" << std::endl << std::endl;
 
     return oss.str();
 }
@@ -1221,22 +2818,28 @@ template <typename Value> Value safe_fmadd(const Value &value1, const Value &val
 
 template struct ENOKI_EXPORT Tape<float>;
 template struct ENOKI_EXPORT DiffArray<float>;
+template struct ENOKI_EXPORT FrozenGraph<float>;
 
 template struct ENOKI_EXPORT Tape<double>;
 template struct ENOKI_EXPORT DiffArray<double>;
+template struct ENOKI_EXPORT FrozenGraph<double>;
 
 template struct ENOKI_EXPORT Tape<DynamicArray<Packet<float>>>;
 template struct ENOKI_EXPORT DiffArray<DynamicArray<Packet<float>>>;
+template struct ENOKI_EXPORT FrozenGraph<DynamicArray<Packet<float>>>;
 
 template struct ENOKI_EXPORT Tape<DynamicArray<Packet<double>>>;
 template struct ENOKI_EXPORT DiffArray<DynamicArray<Packet<double>>>;
+template struct ENOKI_EXPORT FrozenGraph<DynamicArray<Packet<double>>>;
 
 #if defined(ENOKI_CUDA)
     template struct ENOKI_EXPORT Tape<CUDAArray<float>>;
     template struct ENOKI_EXPORT DiffArray<CUDAArray<float>>;
+    template struct ENOKI_EXPORT FrozenGraph<CUDAArray<float>>;
 
     template struct ENOKI_EXPORT Tape<CUDAArray<double>>;
     template struct ENOKI_EXPORT DiffArray<CUDAArray<double>>;
+    template struct ENOKI_EXPORT FrozenGraph<CUDAArray<double>>;
 #endif
 
 NAMESPACE_END(enoki)
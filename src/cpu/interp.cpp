@@ -0,0 +1,528 @@
+/*
+    src/cpu/interp.cpp -- Interpreter for the traces recorded by the CPU backend
+
+    Executes the same fused kernels as the JIT compiler without invoking a C
+    compiler: each instruction processes a block of entries at a time, which
+    keeps dispatch overheads low and lets the inner loops vectorize.
+
+    Enoki is a C++ template library that enables transparent vectorization
+    of numerical kernels using SIMD instruction sets available on current
+    processor architectures.
+
+    Copyright (c) 2019 Wenzel Jakob <wenzel.jakob@epfl.ch>
+
+    All rights reserved. Use of this source code is governed by a BSD-style
+    license that can be found in the LICENSE file.
+*/
+
+#include "interp.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <unordered_map>
+
+NAMESPACE_BEGIN(enoki)
+NAMESPACE_BEGIN(detail)
+
+// -----------------------------------------------------------------------
+//! @{ \name Instruction decoding
+// -----------------------------------------------------------------------
+
+static const std::unordered_map<std::string, InterpOp> &interp_ops() {
+    static const std::unordered_map<std::string, InterpOp> ops = {
+        { "$r1 = $r2", InterpOp::Mov },
+        { "$r1 = ($t1) $r2", InterpOp::Cast },
+        { "$r1 = $c1($b2)", InterpOp::Bitcast },
+
+        { "$r1 = $r2 + $r3", InterpOp::Add },
+        { "$r1 = $r2 - $r3", InterpOp::Sub },
+        { "$r1 = $r2 * $r3", InterpOp::Mul },
+        { "$r1 = ($t1) (((__int128) $r2 * $r3) >> 64)", InterpOp::Mulhi },
+        { "$r1 = ($t1) (((unsigned __int128) $r2 * $r3) >> 64)", InterpOp::Mulhi },
+        { "$r1 = ($t1) (((int64_t) $r2 * $r3) >> (8 * sizeof($t1)))", InterpOp::Mulhi },
+        { "$r1 = ($t1) (((uint64_t) $r2 * $r3) >> (8 * sizeof($t1)))", InterpOp::Mulhi },
+        { "$r1 = $r2 / $r3", InterpOp::Div },
+        { "$r1 = $r2 % $r3", InterpOp::Mod },
+        { "$r1 = $r2 * $r3 + $r4", InterpOp::Fmadd },
+        { "$r1 = -$r2", InterpOp::Neg },
+        { "$r1 = fabsf($r2)", InterpOp::Abs },
+        { "$r1 = fabs($r2)", InterpOp::Abs },
+        { "$r1 = $r2 < 0 ? -$r2 : $r2", InterpOp::Abs },
+        { "$r1 = $r2 < $r3 ? $r2 : $r3", InterpOp::Min },
+        { "$r1 = $r2 > $r3 ? $r2 : $r3", InterpOp::Max },
+
+        { "$r1 = sqrtf($r2)", InterpOp::Sqrt },
+        { "$r1 = sqrt($r2)", InterpOp::Sqrt },
+        { "$r1 = 1 / $r2", InterpOp::Rcp },
+        { "$r1 = 1 / sqrtf($r2)", InterpOp::Rsqrt },
+        { "$r1 = 1 / sqrt($r2)", InterpOp::Rsqrt },
+        { "$r1 = floorf($r2)", InterpOp::Floor },
+        { "$r1 = floor($r2)", InterpOp::Floor },
+        { "$r1 = ceilf($r2)", InterpOp::Ceil },
+        { "$r1 = ceil($r2)", InterpOp::Ceil },
+        { "$r1 = rintf($r2)", InterpOp::Rint },
+        { "$r1 = rint($r2)", InterpOp::Rint },
+        { "$r1 = truncf($r2)", InterpOp::Trunc },
+        { "$r1 = trunc($r2)", InterpOp::Trunc },
+        { "$r1 = ($t1) floorf($r2)", InterpOp::Floor2Int },
+        { "$r1 = ($t1) floor($r2)", InterpOp::Floor2Int },
+        { "$r1 = ($t1) ceilf($r2)", InterpOp::Ceil2Int },
+        { "$r1 = ($t1) ceil($r2)", InterpOp::Ceil2Int },
+
+        { "$r1 = $r2 << $r3", InterpOp::Shl },
+        { "$r1 = $r2 >> $r3", InterpOp::Shr },
+        { "$r1 = !$r2", InterpOp::Not },
+        { "$r1 = $c1(~$b2)", InterpOp::Not },
+        { "$r1 = $c1($b2 & $b3)", InterpOp::And },
+        { "$r1 = $c1($b2 | $b3)", InterpOp::Or },
+        { "$r1 = $c1($b2 ^ $b3)", InterpOp::Xor },
+        { "$r1 = __builtin_popcount($b2)", InterpOp::Popcnt },
+        { "$r1 = __builtin_popcountll($b2)", InterpOp::Popcnt },
+        { "$r1 = $b2 ? __builtin_clz($b2) - (32 - 8 * sizeof($t1)) : 8 * sizeof($t1)", InterpOp::Lzcnt },
+        { "$r1 = $b2 ? __builtin_clzll($b2) : 64", InterpOp::Lzcnt },
+        { "$r1 = $b2 ? __builtin_ctz($b2) : 8 * sizeof($t1)", InterpOp::Tzcnt },
+        { "$r1 = $b2 ? __builtin_ctzll($b2) : 64", InterpOp::Tzcnt },
+
+        { "$r1 = $r2 == $r3", InterpOp::Eq },
+        { "$r1 = $r2 != $r3", InterpOp::Neq },
+        { "$r1 = $r2 < $r3", InterpOp::Lt },
+        { "$r1 = $r2 <= $r3", InterpOp::Le },
+        { "$r1 = $r2 > $r3", InterpOp::Gt },
+        { "$r1 = $r2 >= $r3", InterpOp::Ge },
+        { "$r1 = $r4 ? $r2 : $r3", InterpOp::Select },
+
+        { "$r1 = $r3 ? *(const $t1 *) (uintptr_t) $r2 : 0", InterpOp::Gather },
+        { "if ($r4) *($t3 *) (uintptr_t) $r2 = $r3", InterpOp::Scatter },
+        { "if ($r4) *($t1 *) (uintptr_t) $r2 += $r3", InterpOp::ScatterAdd }
+    };
+    return ops;
+}
+
+//! @}
+// -----------------------------------------------------------------------
+
+// -----------------------------------------------------------------------
+//! @{ \name Type dispatch
+// -----------------------------------------------------------------------
+
+enum InterpKind { KindFloat = 1, KindInt = 2, KindBool = 4,
+                  KindArith = KindFloat | KindInt,
+                  KindAll = KindFloat | KindInt | KindBool };
+
+/// Invoke 'func' with a value of the C++ type associated with 'type' (if it belongs to 'Kinds')
+template <int Kinds, typename Func> void interp_dispatch(EnokiType type, Func &&func) {
+    switch (type) {
+#define ENOKI_INTERP_CASE(Name, Type, Kind)                                    \
+        case EnokiType::Name:                                                  \
+            if constexpr ((Kinds & Kind) != 0) { func(Type()); return; }       \
+            break;
+
+        ENOKI_INTERP_CASE(Int8,    int8_t,   KindInt)
+        ENOKI_INTERP_CASE(UInt8,   uint8_t,  KindInt)
+        ENOKI_INTERP_CASE(Int16,   int16_t,  KindInt)
+        ENOKI_INTERP_CASE(UInt16,  uint16_t, KindInt)
+        ENOKI_INTERP_CASE(Int32,   int32_t,  KindInt)
+        ENOKI_INTERP_CASE(UInt32,  uint32_t, KindInt)
+        ENOKI_INTERP_CASE(Int64,   int64_t,  KindInt)
+        ENOKI_INTERP_CASE(UInt64,  uint64_t, KindInt)
+        ENOKI_INTERP_CASE(Pointer, uint64_t, KindInt)
+        ENOKI_INTERP_CASE(Float32, float,    KindFloat)
+        ENOKI_INTERP_CASE(Float64, double,   KindFloat)
+        ENOKI_INTERP_CASE(Bool,    bool,     KindBool)
+
+#undef ENOKI_INTERP_CASE
+        default: break;
+    }
+    throw std::runtime_error("cpu_interp_run(): unsupported type!");
+}
+
+template <size_t Size> struct interp_bits { };
+template <> struct interp_bits<1> { using type = uint8_t;  };
+template <> struct interp_bits<2> { using type = uint16_t; };
+template <> struct interp_bits<4> { using type = uint32_t; };
+template <> struct interp_bits<8> { using type = uint64_t; };
+
+/// Unsigned integer type used to manipulate the bit representation of 'T'
+template <typename T> using interp_bits_t = typename interp_bits<sizeof(T)>::type;
+
+static size_t interp_type_size(EnokiType type) {
+    size_t result = 0;
+    interp_dispatch<KindAll>(type, [&](auto v) { result = sizeof(v); });
+    return result;
+}
+
+//! @}
+// -----------------------------------------------------------------------
+
+// -----------------------------------------------------------------------
+//! @{ \name Instruction execution
+// -----------------------------------------------------------------------
+
+template <typename R, typename A, typename Func>
+ENOKI_INLINE void interp_map1(const InterpInstr &instr, void **reg, size_t n, Func func) {
+    R *r = (R *) reg[instr.out];
+    const A *a = (const A *) reg[instr.dep[0]];
+    for (size_t i = 0; i < n; ++i)
+        r[i] = func(a[i]);
+}
+
+template <typename R, typename A, typename B, typename Func>
+ENOKI_INLINE void interp_map2(const InterpInstr &instr, void **reg, size_t n, Func func) {
+    R *r = (R *) reg[instr.out];
+    const A *a = (const A *) reg[instr.dep[0]];
+    const B *b = (const B *) reg[instr.dep[1]];
+    for (size_t i = 0; i < n; ++i)
+        r[i] = func(a[i], b[i]);
+}
+
+template <typename R, typename A, typename B, typename C, typename Func>
+ENOKI_INLINE void interp_map3(const InterpInstr &instr, void **reg, size_t n, Func func) {
+    R *r = (R *) reg[instr.out];
+    const A *a = (const A *) reg[instr.dep[0]];
+    const B *b = (const B *) reg[instr.dep[1]];
+    const C *c = (const C *) reg[instr.dep[2]];
+    for (size_t i = 0; i < n; ++i)
+        r[i] = func(a[i], b[i], c[i]);
+}
+
+#define ENOKI_INTERP_UNARY(Op, Kinds, Expr)                                    \
+    case InterpOp::Op:                                                         \
+        interp_dispatch<Kinds>(instr.type, [&](auto v) {                       \
+            using T = decltype(v); (void) v;                                   \
+            interp_map1<T, T>(instr, reg, n, [](T a) -> T { return Expr; });   \
+        });                                                                    \
+        break;
+
+#define ENOKI_INTERP_BINARY(Op, Kinds, Expr)                                   \
+    case InterpOp::Op:                                                         \
+        interp_dispatch<Kinds>(instr.type, [&](auto v) {                       \
+            using T = decltype(v); (void) v;                                   \
+            interp_map2<T, T, T>(instr, reg, n,                                \
+                                 [](T a, T b) -> T { return Expr; });          \
+        });                                                                    \
+        break;
+
+#define ENOKI_INTERP_BITWISE(Op, Expr)                                         \
+    case InterpOp::Op:                                                         \
+        interp_dispatch<KindAll>(instr.type, [&](auto v) {                     \
+            using B = interp_bits_t<decltype(v)>; (void) v;                    \
+            interp_map2<B, B, B>(instr, reg, n,                                \
+                                 [](B a, B b) -> B { return Expr; });          \
+        });                                                                    \
+        break;
+
+#define ENOKI_INTERP_COMPARE(Op, Expr)                                         \
+    case InterpOp::Op:                                                         \
+        interp_dispatch<KindAll>(instr.type_dep, [&](auto v) {                 \
+            using T = decltype(v); (void) v;                                   \
+            interp_map2<bool, T, T>(instr, reg, n,                             \
+                                    [](T a, T b) -> bool { return Expr; });    \
+        });                                                                    \
+        break;
+
+#define ENOKI_INTERP_ROUND2INT(Op, Func)                                       \
+    case InterpOp::Op:                                                         \
+        interp_dispatch<KindInt>(instr.type, [&](auto v1) {                    \
+            interp_dispatch<KindFloat>(instr.type_dep, [&](auto v2) {          \
+                using R = decltype(v1); using A = decltype(v2);                \
+                interp_map1<R, A>(instr, reg, n,                               \
+                                  [](A a) -> R { return (R) Func(a); });       \
+            });                                                                \
+        });                                                                    \
+        break;
+
+#define ENOKI_INTERP_COUNT(Op, Expr)                                           \
+    case InterpOp::Op:                                                         \
+        interp_dispatch<KindInt>(instr.type, [&](auto v) {                     \
+            using T = decltype(v); (void) v;                                   \
+            using B = interp_bits_t<T>;                                        \
+            constexpr int Bits = 8 * sizeof(T);                                \
+            interp_map1<T, B>(instr, reg, n, [](B b) -> T { return (T) (Expr); }); \
+        });                                                                    \
+        break;
+
+/// Execute an instruction for 'n' consecutive entries
+static void interp_exec(const InterpInstr &instr, void **reg, size_t n) {
+    switch (instr.op) {
+        case InterpOp::Literal:
+            interp_dispatch<KindAll>(instr.type, [&](auto v) {
+                using T = decltype(v);
+                using B = interp_bits_t<T>;
+                if constexpr (std::is_floating_point<T>::value) {
+                    B bits = (B) instr.literal;
+                    memcpy(&v, &bits, sizeof(T));
+                } else {
+                    v = (T) instr.literal;
+                }
+                std::fill((T *) reg[instr.out], (T *) reg[instr.out] + n, v);
+            });
+            break;
+
+        case InterpOp::Mov:
+        case InterpOp::Bitcast:
+            memcpy(reg[instr.out], reg[instr.dep[0]], n * interp_type_size(instr.type));
+            break;
+
+        case InterpOp::Cast:
+            interp_dispatch<KindAll>(instr.type, [&](auto v1) {
+                interp_dispatch<KindAll>(instr.type_dep, [&](auto v2) {
+                    using R = decltype(v1); using A = decltype(v2);
+                    interp_map1<R, A>(instr, reg, n, [](A a) -> R { return (R) a; });
+                });
+            });
+            break;
+
+        ENOKI_INTERP_BINARY(Add, KindArith, (T) (a + b))
+        ENOKI_INTERP_BINARY(Sub, KindArith, (T) (a - b))
+        ENOKI_INTERP_BINARY(Mul, KindArith, (T) (a * b))
+        ENOKI_INTERP_BINARY(Div, KindArith, (T) (a / b))
+        ENOKI_INTERP_BINARY(Mod, KindInt,   (T) (a % b))
+        ENOKI_INTERP_BINARY(Min, KindArith, a < b ? a : b)
+        ENOKI_INTERP_BINARY(Max, KindArith, a > b ? a : b)
+        ENOKI_INTERP_BINARY(Shl, KindInt,   (T) (a << b))
+        ENOKI_INTERP_BINARY(Shr, KindInt,   (T) (a >> b))
+
+        case InterpOp::Mulhi:
+            interp_dispatch<KindInt>(instr.type, [&](auto v) {
+                using T = decltype(v); (void) v;
+                using Wide = std::conditional_t<
+                    sizeof(T) == 8,
+                    std::conditional_t<std::is_signed<T>::value, __int128, unsigned __int128>,
+                    std::conditional_t<std::is_signed<T>::value, int64_t, uint64_t>>;
+                interp_map2<T, T, T>(instr, reg, n, [](T a, T b) -> T {
+                    return (T) (((Wide) a * b) >> (8 * sizeof(T)));
+                });
+            });
+            break;
+
+        case InterpOp::Fmadd:
+            interp_dispatch<KindArith>(instr.type, [&](auto v) {
+                using T = decltype(v); (void) v;
+                interp_map3<T, T, T, T>(instr, reg, n,
+                                        [](T a, T b, T c) -> T { return (T) (a * b + c); });
+            });
+            break;
+
+        ENOKI_INTERP_UNARY(Neg,   KindArith, (T) -a)
+        ENOKI_INTERP_UNARY(Sqrt,  KindFloat, std::sqrt(a))
+        ENOKI_INTERP_UNARY(Rcp,   KindFloat, T(1) / a)
+        ENOKI_INTERP_UNARY(Rsqrt, KindFloat, T(1) / std::sqrt(a))
+        ENOKI_INTERP_UNARY(Floor, KindFloat, std::floor(a))
+        ENOKI_INTERP_UNARY(Ceil,  KindFloat, std::ceil(a))
+        ENOKI_INTERP_UNARY(Rint,  KindFloat, std::rint(a))
+        ENOKI_INTERP_UNARY(Trunc, KindFloat, std::trunc(a))
+
+        case InterpOp::Abs:
+            interp_dispatch<KindArith>(instr.type, [&](auto v) {
+                using T = decltype(v); (void) v;
+                if constexpr (std::is_floating_point<T>::value)
+                    interp_map1<T, T>(instr, reg, n, [](T a) -> T { return std::abs(a); });
+                else if constexpr (std::is_signed<T>::value)
+                    interp_map1<T, T>(instr, reg, n, [](T a) -> T { return a < 0 ? (T) -a : a; });
+                else
+                    interp_map1<T, T>(instr, reg, n, [](T a) -> T { return a; });
+            });
+            break;
+
+        ENOKI_INTERP_ROUND2INT(Floor2Int, std::floor)
+        ENOKI_INTERP_ROUND2INT(Ceil2Int, std::ceil)
+
+        case InterpOp::Not:
+            if (instr.type == EnokiType::Bool) {
+                interp_map1<bool, bool>(instr, reg, n, [](bool a) { return !a; });
+            } else {
+                interp_dispatch<KindArith>(instr.type, [&](auto v) {
+                    using B = interp_bits_t<decltype(v)>; (void) v;
+                    interp_map1<B, B>(instr, reg, n, [](B a) -> B { return (B) ~a; });
+                });
+            }
+            break;
+
+        ENOKI_INTERP_BITWISE(And, (B) (a & b))
+        ENOKI_INTERP_BITWISE(Or,  (B) (a | b))
+        ENOKI_INTERP_BITWISE(Xor, (B) (a ^ b))
+
+        ENOKI_INTERP_COUNT(Popcnt, __builtin_popcountll((uint64_t) b))
+        ENOKI_INTERP_COUNT(Lzcnt, b ? __builtin_clzll((uint64_t) b) - (64 - Bits) : Bits)
+        ENOKI_INTERP_COUNT(Tzcnt, b ? __builtin_ctzll((uint64_t) b) : Bits)
+
+        ENOKI_INTERP_COMPARE(Eq,  a == b)
+        ENOKI_INTERP_COMPARE(Neq, a != b)
+        ENOKI_INTERP_COMPARE(Lt,  a < b)
+        ENOKI_INTERP_COMPARE(Le,  a <= b)
+        ENOKI_INTERP_COMPARE(Gt,  a > b)
+        ENOKI_INTERP_COMPARE(Ge,  a >= b)
+
+        case InterpOp::Select:
+            interp_dispatch<KindAll>(instr.type, [&](auto v) {
+                using T = decltype(v); (void) v;
+                interp_map3<T, T, T, bool>(instr, reg, n,
+                                           [](T t, T f, bool m) -> T { return m ? t : f; });
+            });
+            break;
+
+        case InterpOp::Gather:
+            interp_dispatch<KindAll>(instr.type, [&](auto v) {
+                using T = decltype(v); (void) v;
+                interp_map2<T, uint64_t, bool>(instr, reg, n, [](uint64_t a, bool m) -> T {
+                    return m ? *(const T *) (uintptr_t) a : T(0);
+                });
+            });
+            break;
+
+        case InterpOp::Scatter:
+        case InterpOp::ScatterAdd:
+            interp_dispatch<KindAll>(instr.op == InterpOp::Scatter ? instr.type_dep
+                                                                    : instr.type, [&](auto v) {
+                using T = decltype(v); (void) v;
+                const uint64_t *a = (const uint64_t *) reg[instr.dep[0]];
+                const T *value = (const T *) reg[instr.dep[1]];
+                const bool *m = (const bool *) reg[instr.dep[2]];
+                if (instr.op == InterpOp::Scatter) {
+                    for (size_t i = 0; i < n; ++i) {
+                        if (m[i])
+                            *(T *) (uintptr_t) a[i] = value[i];
+                    }
+                } else {
+                    if constexpr (!std::is_same<T, bool>::value) {
+                        for (size_t i = 0; i < n; ++i) {
+                            if (m[i])
+                                *(T *) (uintptr_t) a[i] += value[i];
+                        }
+                    } else {
+                        throw std::runtime_error("cpu_interp_run(): unsupported type!");
+                    }
+                }
+            });
+            break;
+
+        default:
+            throw std::runtime_error("cpu_interp_run(): invalid instruction!");
+    }
+}
+
+#undef ENOKI_INTERP_UNARY
+#undef ENOKI_INTERP_BINARY
+#undef ENOKI_INTERP_BITWISE
+#undef ENOKI_INTERP_COMPARE
+#undef ENOKI_INTERP_ROUND2INT
+#undef ENOKI_INTERP_COUNT
+
+/// Does the instruction access memory (and thus need to be executed for every entry)?
+static bool interp_is_memory_op(InterpOp op) {
+    return op == InterpOp::Gather || op == InterpOp::Scatter ||
+           op == InterpOp::ScatterAdd;
+}
+
+//! @}
+// -----------------------------------------------------------------------
+
+NAMESPACE_END(detail)
+
+void cpu_interp_decode(InterpInstr &instr, const std::string &cmd) {
+    /* Literals, e.g. "$r1 = $c1(0x3f800000u)" */
+    const char *literal_prefix = "$r1 = $c1(0x";
+    if (cmd.compare(0, strlen(literal_prefix), literal_prefix) == 0) {
+        instr.op = InterpOp::Literal;
+        instr.literal = strtoull(cmd.c_str() + strlen(literal_prefix), nullptr, 16);
+        return;
+    }
+
+    auto const &ops = detail::interp_ops();
+    auto it = ops.find(cmd);
+    if (it == ops.end())
+        throw std::runtime_error("cpu_interp_decode(): unsupported operation \"" +
+                                 cmd + "\"!");
+    instr.op = it->second;
+}
+
+void cpu_interp_run(const InterpProgram &program, size_t size) {
+    using namespace detail;
+    const size_t block_size = ENOKI_CPU_INTERP_BLOCK_SIZE,
+                 n_regs = program.regs.size();
+
+    /* Registers that don't refer to an input or output array are backed by a
+       buffer holding one block of values (8 bytes per entry suffice for all
+       types). Registers with a nonzero stride advance through memory. */
+    size_t n_buffers = 0;
+    for (size_t i = 1; i < n_regs; ++i) {
+        auto kind = program.regs[i].kind;
+        if (kind != InterpRegister::Input && kind != InterpRegister::Output)
+            n_buffers++;
+    }
+    std::unique_ptr<uint64_t[]> buffers(new uint64_t[n_buffers * block_size]);
+
+    std::vector<void *> reg(n_regs, nullptr), base(n_regs, nullptr);
+    std::vector<size_t> stride(n_regs, 0);
+
+    /* Uniform registers hold the same value for all entries and only need to
+       be computed once: scalars, pointers, literals, and arithmetic on them */
+    std::vector<bool> uniform(n_regs, false);
+    uniform[0] = true;
+
+    uint64_t *buffer = buffers.get();
+    size_t n_init = std::min(block_size, size);
+    for (size_t i = 1; i < n_regs; ++i) {
+        const InterpRegister &r = program.regs[i];
+        switch (r.kind) {
+            case InterpRegister::Input:
+            case InterpRegister::Output:
+                base[i] = r.data;
+                stride[i] = interp_type_size(r.type);
+                continue;
+
+            case InterpRegister::InputScalar: {
+                    size_t type_size = interp_type_size(r.type);
+                    for (size_t j = 0; j < n_init; ++j)
+                        memcpy((uint8_t *) buffer + j * type_size, r.data, type_size);
+                    uniform[i] = true;
+                }
+                break;
+
+            case InterpRegister::Pointer:
+                std::fill(buffer, buffer + n_init, (uint64_t) (uintptr_t) r.data);
+                uniform[i] = true;
+                break;
+
+            default:
+                break;
+        }
+        reg[i] = buffer;
+        buffer += block_size;
+    }
+
+    std::vector<const InterpInstr *> varying;
+    varying.reserve(program.instrs.size());
+    for (const InterpInstr &instr : program.instrs) {
+        bool is_uniform = !interp_is_memory_op(instr.op) &&
+                          program.regs[instr.out].kind == InterpRegister::Temp &&
+                          uniform[instr.dep[0]] && uniform[instr.dep[1]] &&
+                          uniform[instr.dep[2]];
+        if (is_uniform) {
+            interp_exec(instr, reg.data(), n_init);
+            uniform[instr.out] = true;
+        } else {
+            varying.push_back(&instr);
+        }
+    }
+
+    for (size_t start = 0; start < size; start += block_size) {
+        size_t n = std::min(block_size, size - start);
+
+        for (size_t i = 1; i < n_regs; ++i) {
+            if (stride[i] != 0)
+                reg[i] = (uint8_t *) base[i] + start * stride[i];
+        }
+
+        uint32_t *index = (uint32_t *) reg[1];
+        for (size_t i = 0; i < n; ++i)
+            index[i] = (uint32_t) (start + i);
+
+        for (const InterpInstr *instr : varying)
+            interp_exec(*instr, reg.data(), n);
+    }
+}
+
+NAMESPACE_END(enoki)
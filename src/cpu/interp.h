@@ -0,0 +1,84 @@
+/*
+    src/cpu/interp.h -- Interpreter for the traces recorded by the CPU backend
+
+    Enoki is a C++ template library that enables transparent vectorization
+    of numerical kernels using SIMD instruction sets available on current
+    processor architectures.
+
+    Copyright (c) 2019 Wenzel Jakob <wenzel.jakob@epfl.ch>
+
+    All rights reserved. Use of this source code is governed by a BSD-style
+    license that can be found in the LICENSE file.
+*/
+
+#pragma once
+
+#include <enoki/cpu.h>
+#include <string>
+#include <vector>
+
+/// Number of entries processed by each instruction before moving on to the next one
+#if !defined(ENOKI_CPU_INTERP_BLOCK_SIZE)
+#  define ENOKI_CPU_INTERP_BLOCK_SIZE 512
+#endif
+
+NAMESPACE_BEGIN(enoki)
+
+/// Operations understood by the interpreter (one per C statement template in 'cpu.h')
+enum class InterpOp : uint8_t {
+    Invalid, Literal, Mov, Cast, Bitcast,
+    Add, Sub, Mul, Mulhi, Div, Mod, Fmadd, Neg, Abs, Min, Max,
+    Sqrt, Rcp, Rsqrt, Floor, Ceil, Rint, Trunc, Floor2Int, Ceil2Int,
+    Shl, Shr, Not, And, Or, Xor, Popcnt, Lzcnt, Tzcnt,
+    Eq, Neq, Lt, Le, Gt, Ge, Select,
+    Gather, Scatter, ScatterAdd
+};
+
+/// A single decoded instruction ('out' and 'dep' refer to registers)
+struct InterpInstr {
+    InterpOp op = InterpOp::Invalid;
+
+    /// Type of the result and of the first operand (the stored value for 'Scatter')
+    EnokiType type = EnokiType::Invalid, type_dep = EnokiType::Invalid;
+
+    uint32_t out = 0;
+    uint32_t dep[3] = { 0, 0, 0 };
+
+    /// Bit pattern of 'Literal' instructions
+    uint64_t literal = 0;
+};
+
+/// Register of an interpreted kernel
+struct InterpRegister {
+    enum Kind : uint8_t {
+        /// Intermediate value that only exists while processing a block
+        Temp,
+        /// Array that is read (a size of 1 is broadcast)
+        Input, InputScalar,
+        /// Array that receives the value computed by an instruction
+        Output,
+        /// Pointer value (from 'cpu_var_register_ptr()')
+        Pointer
+    };
+
+    EnokiType type = EnokiType::Invalid;
+    Kind kind = Temp;
+    void *data = nullptr;
+};
+
+/// A fused kernel in the form expected by \ref cpu_interp_run()
+struct InterpProgram {
+    /// Registers (0: unused, 1: loop index)
+    std::vector<InterpRegister> regs;
+
+    /// Instructions in execution order
+    std::vector<InterpInstr> instrs;
+};
+
+/// Look up the interpreter operation for a C statement template (throws if unsupported)
+extern void cpu_interp_decode(InterpInstr &instr, const std::string &cmd);
+
+/// Run the kernel over the entries [0, size)
+extern void cpu_interp_run(const InterpProgram &program, size_t size);
+
+NAMESPACE_END(enoki)
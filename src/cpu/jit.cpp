@@ -0,0 +1,1493 @@
+/*
+    src/cpu/jit.cpp -- CPU backend (Tracing JIT compiler)
+
+    Enoki is a C++ template library that enables transparent vectorization
+    of numerical kernels using SIMD instruction sets available on current
+    processor architectures.
+
+    Copyright (c) 2019 Wenzel Jakob <wenzel.jakob@epfl.ch>
+
+    All rights reserved. Use of this source code is governed by a BSD-style
+    license that can be found in the LICENSE file.
+*/
+
+#include <enoki/cpu.h>
+#include "../kernel_cache.h"
+#include "../trace.h"
+#include "interp.h"
+#include <vector>
+#include <iostream>
+#include <iomanip>
+#include <array>
+#include <algorithm>
+#include <sstream>
+#include <fstream>
+#include <set>
+#include <cassert>
+#include <cstring>
+#include <unordered_map>
+#include <unordered_set>
+#include <map>
+#include <chrono>
+#include <dlfcn.h>
+#include <unistd.h>
+
+#if defined(ENOKI_CPU_THREAD)
+#  include <enoki/thread.h>
+#endif
+
+#if defined(NDEBUG)
+#  define ENOKI_CPU_DEFAULT_LOG_LEVEL 0
+#else
+#  define ENOKI_CPU_DEFAULT_LOG_LEVEL 1
+#endif
+
+/// Reserved variable indices (0: invalid, 1: loop index)
+#define ENOKI_CPU_REG_RESERVED 2
+
+/// Compiler used to translate the generated C code (overridable via $ENOKI_CPU_CC)
+#define ENOKI_CPU_DEFAULT_CC "cc"
+
+/// Flags passed to the compiler
+#define ENOKI_CPU_CFLAGS "-std=gnu99 -O3 -march=native -fno-math-errno -fPIC -shared"
+
+/// Number of entries per block when kernels are distributed over the thread pool
+#if !defined(ENOKI_CPU_PARALLEL_GRAIN)
+#  define ENOKI_CPU_PARALLEL_GRAIN 16384
+#endif
+
+NAMESPACE_BEGIN(enoki)
+
+using TimePoint = std::chrono::time_point<std::chrono::high_resolution_clock>;
+
+/// Signature of the generated kernels: process the entries [start, end)
+using KernelFunc = void (*)(void **ptr, size_t start, size_t end);
+
+// Forward declarations
+ENOKI_EXPORT void cpu_inc_ref_ext(uint32_t);
+ENOKI_EXPORT void cpu_inc_ref_int(uint32_t);
+ENOKI_EXPORT void cpu_dec_ref_ext(uint32_t);
+ENOKI_EXPORT void cpu_dec_ref_int(uint32_t);
+ENOKI_EXPORT size_t cpu_register_size(EnokiType type);
+
+// -----------------------------------------------------------------------
+//! @{ \name 'Variable' type that is used to record instruction traces
+// -----------------------------------------------------------------------
+
+struct Variable {
+    /// Data type of this variable
+    EnokiType type;
+
+    /// C statement to compute it
+    std::string cmd;
+
+    /// Associated label (mainly for debugging)
+    std::string label;
+
+    /// Number of entries
+    size_t size = 0;
+
+    /// Pointer to host memory
+    void *data = nullptr;
+
+    /// External (i.e. by Enoki) reference count
+    uint32_t ref_count_ext = 0;
+
+    /// Internal (i.e. within the generated code) reference count
+    uint32_t ref_count_int = 0;
+
+    /// Dependencies of this instruction
+    std::array<uint32_t, 3> dep = { 0, 0, 0 };
+
+    /// Extra dependency (which is not directly used in arithmetic, e.g. scatter/gather)
+    uint32_t extra_dep = 0;
+
+    /// Does the instruction have side effects (e.g. 'scatter')
+    bool side_effect = false;
+
+    /// A variable is 'dirty' if there are pending scatter operations to it
+    bool dirty = false;
+
+    /// Free 'data' after this variable is no longer referenced?
+    bool free = true;
+
+    /// Optimization: is this a direct pointer (rather than an array which stores a pointer?)
+    bool direct_pointer = false;
+
+    /// Size of the (heuristic for instruction scheduling)
+    uint32_t subtree_size = 0;
+
+    Variable(EnokiType type) : type(type) { }
+
+    ~Variable() { if (free && data != nullptr) cpu_free(data); }
+
+    bool is_collected() const {
+        return ref_count_int == 0 && ref_count_ext == 0;
+    }
+};
+
+/// A compiled kernel, i.e. a shared library that was loaded via dlopen()
+struct Kernel {
+    void *handle = nullptr;
+    KernelFunc func = nullptr;
+};
+
+ENOKI_EXPORT void cpu_shutdown();
+
+struct Context {
+    /// Current variable index
+    uint32_t ctr = 0;
+
+    /// Enumerates "live" (externally referenced) variables and statements with side effects
+    std::set<uint32_t> live;
+
+    /// Enumerates "dirty" variables (targets of 'scatter' operations that have not yet executed)
+    std::vector<uint32_t> dirty;
+
+    /// Stores the mapping from variable indices to variables
+    std::unordered_map<uint32_t, Variable> variables;
+
+    /// Stores the mapping from pointer addresses to variable indices
+    std::unordered_map<const void *, uint32_t> ptr_map;
+
+    /// Current operand array for scatter/gather
+    uint32_t scatter_gather_operand = 0;
+
+    /// Current log level (0 == none, 1 == minimal, 2 == moderate, 3 == max.)
+    uint32_t log_level = ENOKI_CPU_DEFAULT_LOG_LEVEL;
+
+    /// Hash table of previously compiled kernels
+    std::unordered_map<std::string, Kernel> kernels;
+
+    /// Directory receiving the generated sources and shared libraries
+    std::string temp_dir;
+
+    /// Compiler command
+    std::string compiler;
+
+    /// Number of compiler invocations so far (used to create unique file names)
+    size_t compile_count = 0;
+
+    /// On-disk kernel cache (empty if disabled)
+    std::string cache_dir;
+
+    /// Host processor, which determines the target of '-march=native'
+    std::string host_id;
+    bool cache_dir_created = false;
+
+    /// Kernel cache statistics
+    size_t cache_hits = 0, cache_hits_disk = 0, cache_misses = 0;
+
+    /// Execute kernels using the interpreter instead of compiling them?
+    bool interpret = false;
+
+    /// Kernel launch statistics: launches, operations, and operations of the largest kernel
+    size_t launches = 0, launch_ops = 0, launch_ops_max = 0;
+
+    ~Context() { clear(); }
+
+    Variable &operator[](uint32_t i) {
+        auto it = variables.find(i);
+        if (it == variables.end())
+            throw std::runtime_error("CPUBackend: referenced unknown variable " + std::to_string(i));
+        return it->second;
+    }
+
+    void clear() {
+#if !defined(NDEBUG)
+        if (log_level >= 1) {
+            size_t n_live = 0;
+            for (auto const &var : variables) {
+                if (var.first < ENOKI_CPU_REG_RESERVED)
+                    continue;
+                if (n_live < 10) {
+                    std::cerr << "cpu_shutdown(): variable " << var.first << " is still live. "<< std::endl;
+                    if (n_live == 9)
+                        std::cerr << "(skipping remainder)" << std::endl;
+                }
+                ++n_live;
+            }
+            if (n_live > 0)
+                std::cerr << "cpu_shutdown(): " << n_live
+                          << " variables were still live at shutdown." << std::endl;
+        }
+#endif
+        ctr = 0;
+        dirty.clear();
+        variables.clear();
+        live.clear();
+        ptr_map.clear();
+        scatter_gather_operand = 0;
+
+        for (auto &kv : kernels)
+            dlclose(kv.second.handle);
+        kernels.clear();
+
+        if (!temp_dir.empty()) {
+            rmdir(temp_dir.c_str());
+            temp_dir.clear();
+        }
+    }
+
+    Variable& append(EnokiType type) {
+        return variables.emplace(ctr++, type).first->second;
+    }
+};
+
+static Context *__context = nullptr;
+static bool installed_shutdown_handler = false;
+
+inline static Context &context() {
+    if (ENOKI_UNLIKELY(__context == nullptr))
+        cpu_init();
+    return *__context;
+}
+
+ENOKI_EXPORT void cpu_init() {
+    /// Reserve indices for reserved kernel variables
+    if (__context)
+        delete __context;
+    __context = new Context();
+    Context &ctx = *__context;
+    ctx.append(EnokiType::Invalid);
+    ctx.append(EnokiType::UInt32);
+
+    const char *cc = getenv("ENOKI_CPU_CC");
+    ctx.compiler = cc ? cc : ENOKI_CPU_DEFAULT_CC;
+    ctx.cache_dir = kernel_cache_dir();
+    ctx.host_id = kernel_cache_host_id();
+    ctx.kernels.reserve(1000);
+
+    const char *interpret = getenv("ENOKI_CPU_INTERPRET");
+    ctx.interpret = interpret && *interpret && strcmp(interpret, "0") != 0;
+
+    if (!installed_shutdown_handler) {
+        installed_shutdown_handler = true;
+        atexit(cpu_shutdown);
+    }
+}
+
+ENOKI_EXPORT void cpu_shutdown() {
+    if (__context) {
+        __context->clear();
+        delete __context;
+        __context = nullptr;
+    }
+}
+
+ENOKI_EXPORT void* cpu_malloc(size_t size) {
+    if (size == 0)
+        return nullptr;
+    void *ptr = aligned_alloc(64, (size + 63) / 64 * 64);
+    if (ENOKI_UNLIKELY(!ptr))
+        throw std::runtime_error("cpu_malloc(): out of memory!");
+    return ptr;
+}
+
+ENOKI_EXPORT void cpu_free(void *ptr) {
+    free(ptr);
+}
+
+ENOKI_EXPORT void *cpu_var_ptr(uint32_t index) {
+    return context()[index].data;
+}
+
+ENOKI_EXPORT size_t cpu_var_size(uint32_t index) {
+    return context()[index].size;
+}
+
+ENOKI_EXPORT void cpu_var_set_label(uint32_t index, const char *str) {
+    Context &ctx = context();
+    ctx[index].label = str;
+#if !defined(NDEBUG)
+    if (ctx.log_level >= 4)
+        std::cerr << "cpu_var_set_label(" << index << "): " << str << std::endl;
+#endif
+}
+
+ENOKI_EXPORT uint32_t cpu_var_set_size(uint32_t index, size_t size, bool copy) {
+    Context &ctx = context();
+#if !defined(NDEBUG)
+    if (ctx.log_level >= 4)
+        std::cerr << "cpu_var_set_size(" << index << "): " << size << std::endl;
+#endif
+
+    Variable &var = ctx[index];
+    if (var.size == size)
+        return index;
+
+    if (var.data != nullptr || var.ref_count_int > 0) {
+        if (var.size == 1 && copy) {
+            uint32_t index_new =
+                cpu_trace_append(var.type, "$r1 = $r2", index);
+            ctx[index_new].size = size;
+            cpu_dec_ref_ext(index);
+            return index_new;
+        }
+
+        throw std::runtime_error(
+            "cpu_var_set_size(): attempted to resize variable " +
+            std::to_string(index) +
+            " which was already allocated (current size = " +
+            std::to_string(var.size) +
+            ", requested size = " + std::to_string(size) + ")");
+    }
+    var.size = size;
+    return index;
+}
+
+ENOKI_EXPORT uint32_t cpu_var_register(EnokiType type, size_t size,
+                                       void *ptr, bool free) {
+    Context &ctx = context();
+    uint32_t idx = ctx.ctr;
+#if !defined(NDEBUG)
+    if (ctx.log_level >= 4)
+        std::cerr << "cpu_var_register(" << idx << "): " << ptr
+                  << ", size=" << size << ", free=" << free << std::endl;
+#endif
+    if (size == 0)
+        throw std::runtime_error("cpu_var_register(): attempted to create a "
+                                 "variable of size zero!");
+    Variable &v = ctx.append(type);
+    v.data = ptr;
+    v.size = size;
+    v.free = free;
+    cpu_inc_ref_ext(idx);
+    return idx;
+}
+
+ENOKI_EXPORT uint32_t cpu_var_register_ptr(const void *ptr) {
+    Context &ctx = context();
+    auto it = ctx.ptr_map.find(ptr);
+    if (it != ctx.ptr_map.end()) {
+        cpu_inc_ref_ext(it->second);
+        return it->second;
+    }
+
+    uint32_t idx = ctx.ctr;
+#if !defined(NDEBUG)
+    if (ctx.log_level >= 4)
+        std::cerr << "cpu_var_register_ptr(" << idx << "): " << ptr
+                  << std::endl;
+#endif
+    Variable &v = ctx.append(EnokiType::Pointer);
+    v.data = (void *) ptr;
+    v.size = 1;
+    v.free = false;
+    v.direct_pointer = true;
+    cpu_inc_ref_ext(idx);
+    ctx.ptr_map[ptr] = idx;
+    return idx;
+}
+
+ENOKI_EXPORT uint32_t cpu_var_copy(EnokiType type, size_t size,
+                                   const void *value) {
+    size_t total_size = size * cpu_register_size(type);
+    void *ptr = cpu_malloc(total_size);
+    memcpy(ptr, value, total_size);
+    return cpu_var_register(type, size, ptr, true);
+}
+
+ENOKI_EXPORT void cpu_var_free(uint32_t idx) {
+    Context &ctx = context();
+    Variable &v = ctx[idx];
+#if !defined(NDEBUG)
+    if (ctx.log_level >= 5) {
+        std::cerr << "cpu_var_free(" << idx << ") = " << v.data;
+        if (!v.free)
+            std::cerr << " (not deleted)";
+        std::cerr << std::endl;
+    }
+#endif
+    if (v.direct_pointer) {
+        auto it = ctx.ptr_map.find(v.data);
+        assert(it != ctx.ptr_map.end());
+        ctx.ptr_map.erase(it);
+    }
+    for (int i = 0; i < 3; ++i)
+        cpu_dec_ref_int(v.dep[i]);
+    cpu_dec_ref_ext(v.extra_dep);
+    ctx.variables.erase(idx); // invokes Variable destructor + cpu_free().
+}
+
+ENOKI_EXPORT void cpu_set_scatter_gather_operand(uint32_t idx, bool gather) {
+    Context &ctx = context();
+    if (idx != 0) {
+        Variable &v = ctx[idx];
+        if (v.data == nullptr || (gather && v.dirty))
+            cpu_eval();
+    }
+    ctx.scatter_gather_operand = idx;
+}
+
+//! @}
+// -----------------------------------------------------------------------
+
+// -----------------------------------------------------------------------
+//! @{ \name Common functionality to distinguish types
+// -----------------------------------------------------------------------
+
+ENOKI_EXPORT size_t cpu_register_size(EnokiType type) {
+    switch (type) {
+        case EnokiType::UInt8:
+        case EnokiType::Int8:
+        case EnokiType::Bool: return 1;
+        case EnokiType::UInt16:
+        case EnokiType::Int16: return 2;
+        case EnokiType::UInt32:
+        case EnokiType::Int32:
+        case EnokiType::Float32: return 4;
+        case EnokiType::UInt64:
+        case EnokiType::Int64:
+        case EnokiType::Pointer:
+        case EnokiType::Float64: return 8;
+        default: return (size_t) -1;
+    }
+}
+
+/// C type name of a variable
+ENOKI_EXPORT const char *cpu_register_type(EnokiType type) {
+    switch (type) {
+        case EnokiType::UInt8: return "uint8_t";
+        case EnokiType::Int8: return "int8_t";
+        case EnokiType::UInt16: return "uint16_t";
+        case EnokiType::Int16: return "int16_t";
+        case EnokiType::UInt32: return "uint32_t";
+        case EnokiType::Int32: return "int32_t";
+        case EnokiType::Pointer: return "uintptr_t";
+        case EnokiType::UInt64: return "uint64_t";
+        case EnokiType::Int64: return "int64_t";
+        case EnokiType::Float32: return "float";
+        case EnokiType::Float64: return "double";
+        case EnokiType::Bool: return "bool";
+        default: return nullptr;
+    }
+}
+
+/// C type name of the bit pattern of a variable (used by '$b' and '$c')
+ENOKI_EXPORT const char *cpu_register_type_bin(EnokiType type) {
+    switch (type) {
+        case EnokiType::UInt8:
+        case EnokiType::Int8: return "uint8_t";
+        case EnokiType::UInt16:
+        case EnokiType::Int16: return "uint16_t";
+        case EnokiType::UInt32:
+        case EnokiType::Int32:
+        case EnokiType::Float32: return "uint32_t";
+        case EnokiType::UInt64:
+        case EnokiType::Int64:
+        case EnokiType::Pointer:
+        case EnokiType::Float64: return "uint64_t";
+        case EnokiType::Bool: return "bool";
+        default: return nullptr;
+    }
+}
+
+//! @}
+// -----------------------------------------------------------------------
+
+// -----------------------------------------------------------------------
+//! @{ \name Reference counting (internal means: dependency within
+//           JIT trace, external means: referenced by an Enoki array)
+// -----------------------------------------------------------------------
+
+ENOKI_EXPORT void cpu_inc_ref_ext(uint32_t index) {
+    if (index < ENOKI_CPU_REG_RESERVED)
+        return;
+    Context &ctx = context();
+    Variable &v = ctx[index];
+    v.ref_count_ext++;
+
+#if !defined(NDEBUG)
+    if (ctx.log_level >= 5)
+        std::cerr << "cpu_inc_ref_ext(" << index << ") -> "
+                  << v.ref_count_ext << std::endl;
+#endif
+}
+
+ENOKI_EXPORT void cpu_inc_ref_int(uint32_t index) {
+    if (index < ENOKI_CPU_REG_RESERVED)
+        return;
+    Context &ctx = context();
+    Variable &v = ctx[index];
+    v.ref_count_int++;
+
+#if !defined(NDEBUG)
+    if (ctx.log_level >= 5)
+        std::cerr << "cpu_inc_ref_int(" << index << ") -> "
+                  << v.ref_count_int << std::endl;
+#endif
+}
+
+ENOKI_EXPORT void cpu_dec_ref_ext(uint32_t index) {
+    if (index < ENOKI_CPU_REG_RESERVED || __context == nullptr)
+        return;
+    Context &ctx = *__context;
+    Variable &v = ctx[index];
+
+    if (ENOKI_UNLIKELY(v.ref_count_ext == 0)) {
+        fprintf(stderr, "cpu_dec_ref_ext(): Node %u has no external references!\n", index);
+        exit(EXIT_FAILURE);
+    }
+
+#if !defined(NDEBUG)
+    if (ctx.log_level >= 5)
+        std::cerr << "cpu_dec_ref_ext(" << index << ") -> "
+                  << (v.ref_count_ext - 1) << std::endl;
+#endif
+
+    v.ref_count_ext--;
+
+    if (v.ref_count_ext == 0 && !v.side_effect)
+        ctx.live.erase(index);
+
+    if (v.is_collected())
+        cpu_var_free(index);
+}
+
+ENOKI_EXPORT void cpu_dec_ref_int(uint32_t index) {
+    if (index < ENOKI_CPU_REG_RESERVED)
+        return;
+    Context &ctx = context();
+    Variable &v = ctx[index];
+
+    if (ENOKI_UNLIKELY(v.ref_count_int == 0)) {
+        fprintf(stderr, "cpu_dec_ref_int(): Node %u has no internal references!\n", index);
+        exit(EXIT_FAILURE);
+    }
+
+#if !defined(NDEBUG)
+    if (ctx.log_level >= 5)
+        std::cerr << "cpu_dec_ref_int(" << index << ") -> "
+                  << (v.ref_count_int - 1) << std::endl;
+#endif
+
+    v.ref_count_int--;
+
+    if (v.is_collected())
+        cpu_var_free(index);
+}
+
+ENOKI_EXPORT void cpu_var_mark_side_effect(uint32_t index) {
+    Context &ctx = context();
+#if !defined(NDEBUG)
+    if (ctx.log_level >= 4)
+        std::cerr << "cpu_var_mark_side_effect(" << index << ")" << std::endl;
+#endif
+
+    assert(index >= ENOKI_CPU_REG_RESERVED);
+    ctx[index].side_effect = true;
+}
+
+ENOKI_EXPORT void cpu_var_mark_dirty(uint32_t index) {
+    Context &ctx = context();
+#if !defined(NDEBUG)
+    if (ctx.log_level >= 4)
+        std::cerr << "cpu_var_mark_dirty(" << index << ")" << std::endl;
+#endif
+
+    assert(index >= ENOKI_CPU_REG_RESERVED);
+    ctx[index].dirty = true;
+    ctx.dirty.push_back(index);
+}
+
+//! @}
+// -----------------------------------------------------------------------
+
+// -----------------------------------------------------------------------
+//! @{ \name JIT trace append routines
+// -----------------------------------------------------------------------
+
+/// Does the given statement dereference an address computed by the trace?
+static bool cpu_is_memory_op(const std::string &cmd) {
+    return cmd.find("(uintptr_t)") != std::string::npos;
+}
+
+ENOKI_EXPORT uint32_t cpu_trace_append(EnokiType type,
+                                       const char *cmd) {
+    Context &ctx = context();
+    uint32_t idx = ctx.ctr;
+#if !defined(NDEBUG)
+    if (ctx.log_level >= 4)
+        std::cerr << "cpu_trace_append(" << idx << "): " << cmd << std::endl;
+#endif
+    Variable &v = ctx.append(type);
+    v.cmd = cmd;
+    v.subtree_size = 1;
+    v.size = 1;
+    cpu_inc_ref_ext(idx);
+    ctx.live.insert(idx);
+    return idx;
+}
+
+ENOKI_EXPORT uint32_t cpu_trace_append(EnokiType type,
+                                       const char *cmd,
+                                       uint32_t arg1) {
+    if (ENOKI_UNLIKELY(arg1 == 0))
+        throw std::runtime_error(
+            "cpu_trace_append(): arithmetic involving "
+                        "uninitialized variable!");
+    Context &ctx = context();
+    const Variable &v1 = ctx[arg1];
+
+    if (v1.dirty)
+        cpu_eval();
+
+    uint32_t idx = ctx.ctr;
+
+#if !defined(NDEBUG)
+    if (ctx.log_level >= 4)
+        std::cerr << "cpu_trace_append(" << idx << " <- " << arg1 << "): " << cmd
+                  << std::endl;
+#endif
+
+    Variable &v = ctx.append(type);
+    v.size = v1.size;
+    v.dep[0] = arg1;
+    v.cmd = cmd;
+    v.subtree_size = v1.subtree_size + 1;
+    cpu_inc_ref_int(arg1);
+    cpu_inc_ref_ext(idx);
+    ctx.live.insert(idx);
+    return idx;
+}
+
+ENOKI_EXPORT uint32_t cpu_trace_append(EnokiType type,
+                                       const char *cmd,
+                                       uint32_t arg1,
+                                       uint32_t arg2) {
+    if (ENOKI_UNLIKELY(arg1 == 0 || arg2 == 0))
+        throw std::runtime_error(
+            "cpu_trace_append(): arithmetic involving "
+                        "uninitialized variable!");
+
+    Context &ctx = context();
+    const Variable &v1 = ctx[arg1],
+                   &v2 = ctx[arg2];
+
+    if (v1.dirty || v2.dirty)
+        cpu_eval();
+
+    uint32_t idx = ctx.ctr;
+
+#if !defined(NDEBUG)
+    if (ctx.log_level >= 4)
+        std::cerr << "cpu_trace_append(" << idx << " <- " << arg1 << ", " << arg2
+                  << "): " << cmd << std::endl;
+#endif
+
+    size_t size = std::max(v1.size, v2.size);
+    if (ENOKI_UNLIKELY((v1.size != 1 && v1.size != size) ||
+                       (v2.size != 1 && v2.size != size)))
+        throw std::runtime_error("cpu_trace_append(): arithmetic involving "
+                                 "arrays of incompatible size (" +
+                                 std::to_string(v1.size) + " and " + std::to_string(v2.size) +
+                                 "). The instruction was \"" + cmd + "\".");
+
+    Variable &v = ctx.append(type);
+    v.size = size;
+    v.dep = { arg1, arg2, 0 };
+    v.cmd = cmd;
+    v.subtree_size = v1.subtree_size + v2.subtree_size + 1;
+    cpu_inc_ref_int(arg1);
+    cpu_inc_ref_int(arg2);
+    cpu_inc_ref_ext(idx);
+    ctx.live.insert(idx);
+
+    if (cpu_is_memory_op(v.cmd)) {
+        v.extra_dep = ctx.scatter_gather_operand;
+        cpu_inc_ref_ext(v.extra_dep);
+    }
+
+    return idx;
+}
+
+ENOKI_EXPORT uint32_t cpu_trace_append(EnokiType type,
+                                       const char *cmd,
+                                       uint32_t arg1,
+                                       uint32_t arg2,
+                                       uint32_t arg3) {
+    if (ENOKI_UNLIKELY(arg1 == 0 || arg2 == 0 || arg3 == 0))
+        throw std::runtime_error("cpu_trace_append(): arithmetic involving "
+                                 "uninitialized variable!");
+
+    Context &ctx = context();
+    const Variable &v1 = ctx[arg1],
+                   &v2 = ctx[arg2],
+                   &v3 = ctx[arg3];
+
+    if (v1.dirty || v2.dirty || v3.dirty)
+        cpu_eval();
+
+    uint32_t idx = ctx.ctr;
+
+#if !defined(NDEBUG)
+    if (ctx.log_level >= 4)
+        std::cerr << "cpu_trace_append(" << idx << " <- " << arg1 << ", " << arg2
+                  << ", " << arg3 << "): " << cmd << std::endl;
+#endif
+
+    size_t size = std::max(std::max(v1.size, v2.size), v3.size);
+    if (ENOKI_UNLIKELY((v1.size != 1 && v1.size != size) ||
+                       (v2.size != 1 && v2.size != size) ||
+                       (v3.size != 1 && v3.size != size)))
+        throw std::runtime_error("cpu_trace_append(): arithmetic involving "
+                                 "arrays of incompatible size (" +
+                                 std::to_string(v1.size) + ", " + std::to_string(v2.size) +
+                                 " and " + std::to_string(v3.size) + "). The instruction was \"" +
+                                 cmd + "\".");
+
+    Variable &v = ctx.append(type);
+    v.size = size;
+    v.dep = { arg1, arg2, arg3 };
+    v.cmd = cmd;
+    v.subtree_size = v1.subtree_size +
+                     v2.subtree_size +
+                     v3.subtree_size + 1;
+    cpu_inc_ref_int(arg1);
+    cpu_inc_ref_int(arg2);
+    cpu_inc_ref_int(arg3);
+    cpu_inc_ref_ext(idx);
+    ctx.live.insert(idx);
+
+    if (cpu_is_memory_op(v.cmd)) {
+        v.extra_dep = ctx.scatter_gather_operand;
+        cpu_inc_ref_ext(v.extra_dep);
+    }
+
+    return idx;
+}
+
+//! @}
+// -----------------------------------------------------------------------
+
+// -----------------------------------------------------------------------
+//! @{ \name JIT trace generation
+// -----------------------------------------------------------------------
+
+static std::string time_string(size_t value_) {
+    double value = (double) value_;
+    const char *suffix = "us";
+    if (value > 1000) {
+        value /= 1000;
+        suffix = "ms";
+        if (value > 1000) {
+            value /= 1000;
+            suffix = "s";
+        }
+    }
+    std::ostringstream oss;
+    oss << std::setprecision(3) << value << " " << suffix;
+    return oss.str();
+}
+
+static std::string mem_string(size_t size) {
+    const char *orders[] = { "B", "KiB", "MiB", "GiB", "TiB" };
+    double value = (double) size;
+    int i = 0;
+    for (i = 0; i < 4 && value >= 1024.0; ++i)
+        value /= 1024.0;
+    std::ostringstream oss;
+    oss << std::setprecision(i == 0 ? 0 : 3) << std::fixed << value << " " << orders[i];
+    return oss.str();
+}
+
+static void cpu_render_cmd(std::ostringstream &oss,
+                           Context &ctx,
+                           const std::unordered_map<uint32_t, uint32_t> &reg_map,
+                           uint32_t index) {
+    const Variable &var = ctx[index];
+    const std::string &cmd = var.cmd;
+
+    oss << "        ";
+    for (size_t i = 0; i < cmd.length(); ++i) {
+        if (cmd[i] != '$' || i + 2 >= cmd.length()) {
+            oss << cmd[i];
+            continue;
+        }
+
+        uint8_t type = cmd[i + 1],
+                dep_offset = cmd[i + 2] - '0';
+
+        if (type != 't' && type != 'r' && type != 'b' && type != 'c')
+            throw std::runtime_error("cpu_render_cmd: invalid '$' template!");
+
+        if (dep_offset < 1 || dep_offset > 4)
+            throw std::runtime_error("cpu_render_cmd: out of bounds!");
+
+        uint32_t dep =
+            dep_offset == 1 ? index : var.dep[dep_offset - 2];
+        EnokiType dep_type = ctx[dep].type;
+        const char *type_name = cpu_register_type(dep_type),
+                   *type_name_bin = cpu_register_type_bin(dep_type);
+
+        if (type_name == nullptr)
+            throw std::runtime_error(
+                "CPUBackend: internal error -- variable " +
+                std::to_string(index) + " references " + std::to_string(dep) +
+                " with unsupported type: " + std::string(cmd));
+
+        std::string reg;
+        if (type == 'r' || type == 'b') {
+            auto it = reg_map.find(dep);
+            if (it == reg_map.end())
+                throw std::runtime_error(
+                    "CPUBackend: internal error -- variable not found!");
+            reg = "r" + std::to_string(it->second);
+        }
+
+        switch (type) {
+            case 't':
+                oss << type_name;
+                break;
+
+            case 'r':
+                oss << reg;
+                break;
+
+            case 'b':
+                if (dep_type == EnokiType::Float32)
+                    oss << "enoki_b32(" << reg << ")";
+                else if (dep_type == EnokiType::Float64)
+                    oss << "enoki_b64(" << reg << ")";
+                else if (dep_type == EnokiType::Bool)
+                    oss << reg;
+                else
+                    oss << "((" << type_name_bin << ") " << reg << ")";
+                break;
+
+            case 'c':
+                if (dep_type == EnokiType::Float32)
+                    oss << "enoki_f32";
+                else if (dep_type == EnokiType::Float64)
+                    oss << "enoki_f64";
+                else
+                    oss << "(" << type_name << ")";
+                break;
+        }
+
+        i += 2;
+    }
+
+    oss << ";" << std::endl;
+}
+
+/// Check that a variable of the schedule can be part of a kernel of the given size
+static Variable &cpu_jit_check_var(Context &ctx, uint32_t index, size_t size) {
+    Variable &var = ctx[index];
+
+    if (var.is_collected() || (var.cmd.empty() && var.data == nullptr && !var.direct_pointer))
+        throw std::runtime_error(
+            "CPUBackend: found invalid/expired variable " + std::to_string(index) + " in schedule! ");
+
+    if (var.size != 1 && var.size != size)
+        throw std::runtime_error(
+            "CPUBackend: encountered arrays of incompatible size! (" +
+            std::to_string(size) + " vs " + std::to_string(var.size) + ")");
+
+    if (cpu_register_type(var.type) == nullptr)
+        throw std::runtime_error("CPUBackend: variable " + std::to_string(index) +
+                                 " has an unsupported type!");
+
+    return var;
+}
+
+/// Allocate memory for a computed variable if it must be stored by the kernel
+static bool cpu_jit_alloc_output(Context &ctx, uint32_t index, Variable &var,
+                                 size_t size) {
+    if (var.side_effect || var.ref_count_ext == 0 || var.size != size)
+        return false;
+
+    size_t size_in_bytes =
+        cpu_var_size(index) * cpu_register_size(var.type);
+
+    var.data = cpu_malloc(size_in_bytes);
+    var.subtree_size = 1;
+#if !defined(NDEBUG)
+    if (ctx.log_level >= 4)
+        std::cerr << "cpu_eval(): allocated variable " << index
+                  << " -> " << var.data << " (" << size_in_bytes
+                  << " bytes)" << std::endl;
+#endif
+    return true;
+}
+
+static void cpu_jit_log_launch(Context &ctx, const char *what, size_t size,
+                               size_t n_in, size_t n_out, size_t n_arith) {
+    ctx.launches++;
+    ctx.launch_ops += n_arith;
+    ctx.launch_ops_max = std::max(ctx.launch_ops_max, n_arith);
+
+    if (ctx.log_level >= 1)
+        std::cerr << "cpu_eval(): " << what << " kernel (n=" << size << ", in="
+                  << n_in << ", out=" << n_out << ", ops=" << n_arith
+                  << ")" << std::endl;
+}
+
+static std::pair<std::string, std::vector<void *>>
+cpu_jit_assemble(size_t size, const std::vector<uint32_t> &sweep, bool &side_effects) {
+    Context &ctx = context();
+    std::ostringstream oss, body;
+    std::vector<void *> ptrs;
+    size_t n_in = 0, n_out = 0, n_arith = 0;
+
+    uint32_t n_vars = ENOKI_CPU_REG_RESERVED;
+    std::unordered_map<uint32_t, uint32_t> reg_map;
+    side_effects = false;
+    for (uint32_t index : sweep) {
+#if !defined(NDEBUG)
+        if (ctx.log_level >= 4) {
+            const Variable &v = ctx[index];
+            std::cerr << "    r" << n_vars << " -> " << index;
+            const std::string &label = v.label;
+            if (!label.empty())
+                std::cerr << " \"" << label << "\"";
+            if (v.size == 1)
+                std::cerr << " [scalar]";
+            if (v.data != nullptr)
+                std::cerr << " [in]";
+            else if (v.side_effect)
+                std::cerr << " [se]";
+            else if (v.ref_count_ext > 0)
+                std::cerr << " [out]";
+            std::cerr << std::endl;
+        }
+#endif
+        side_effects |= ctx[index].side_effect;
+        reg_map[index] = n_vars++;
+    }
+    reg_map[1] = 1;
+
+    /* Arrays may only be declared 'restrict' when no scatter operation
+       could write to them through a different pointer. Outputs are freshly
+       allocated and never alias anything. */
+    const char *restrict_in = side_effects ? "" : "restrict ";
+
+    for (uint32_t index : sweep) {
+        Variable &var = cpu_jit_check_var(ctx, index, size);
+        const char *type = cpu_register_type(var.type);
+        uint32_t reg = reg_map[index];
+
+        if (var.data || var.direct_pointer) {
+            size_t idx = ptrs.size();
+            ptrs.push_back(var.data);
+
+            body << std::endl
+                 << "        // Load register r" << reg;
+            if (!var.label.empty())
+                body << ": " << var.label;
+            body << std::endl;
+
+            if (!var.direct_pointer) {
+                oss << "    const " << type << " *" << restrict_in << "p" << idx
+                    << " = (const " << type << " *) ptr[" << idx << "];" << std::endl;
+                body << "        " << type << " r" << reg << " = p" << idx
+                     << (var.size != 1 ? "[i]" : "[0]") << ";" << std::endl;
+            } else {
+                body << "        " << type << " r" << reg << " = (" << type
+                     << ") ptr[" << idx << "];" << std::endl;
+            }
+            n_in++;
+        } else {
+            if (!var.label.empty())
+                body << "        // Compute register r" << reg << ": "
+                     << var.label << std::endl;
+            body << "        " << type << " r" << reg << ";" << std::endl;
+            cpu_render_cmd(body, ctx, reg_map, index);
+            n_arith++;
+
+            if (var.side_effect) {
+                n_out++;
+                continue;
+            }
+
+            if (!cpu_jit_alloc_output(ctx, index, var, size))
+                continue;
+
+            size_t idx = ptrs.size();
+            ptrs.push_back(var.data);
+            n_out++;
+
+            oss << "    " << type << " *restrict p" << idx << " = (" << type
+                << " *) ptr[" << idx << "];" << std::endl;
+
+            body << std::endl
+                 << "        // Store register r" << reg;
+            if (!var.label.empty())
+                body << ": " << var.label;
+            body << std::endl
+                 << "        p" << idx << (var.size != 1 ? "[i]" : "[0]")
+                 << " = r" << reg << ";" << std::endl;
+        }
+    }
+
+    std::ostringstream source;
+    source << "#include <stdint.h>" << std::endl
+           << "#include <stdbool.h>" << std::endl
+           << "#include <string.h>" << std::endl
+           << "#include <math.h>" << std::endl
+           << std::endl
+           << "static inline float enoki_f32(uint32_t v) { float r; memcpy(&r, &v, 4); return r; }" << std::endl
+           << "static inline double enoki_f64(uint64_t v) { double r; memcpy(&r, &v, 8); return r; }" << std::endl
+           << "static inline uint32_t enoki_b32(float v) { uint32_t r; memcpy(&r, &v, 4); return r; }" << std::endl
+           << "static inline uint64_t enoki_b64(double v) { uint64_t r; memcpy(&r, &v, 8); return r; }" << std::endl
+           << std::endl
+           << "void enoki_kernel(void **ptr, size_t start, size_t end) {" << std::endl
+           << oss.str()
+           << std::endl
+           << "    for (size_t i = start; i < end; ++i) {" << std::endl
+           << "        uint32_t r1 = (uint32_t) i;" << std::endl
+           << body.str()
+           << "    }" << std::endl
+           << "}" << std::endl;
+
+    cpu_jit_log_launch(ctx, "launching", size, n_in, n_out, n_arith);
+
+    return { source.str(), ptrs };
+}
+
+/// Translate a schedule into a program for the interpreter (see 'interp.h')
+static InterpProgram cpu_interp_assemble(size_t size, const std::vector<uint32_t> &sweep) {
+    Context &ctx = context();
+    InterpProgram program;
+    size_t n_in = 0, n_out = 0, n_arith = 0;
+
+    uint32_t n_vars = ENOKI_CPU_REG_RESERVED;
+    std::unordered_map<uint32_t, uint32_t> reg_map;
+    for (uint32_t index : sweep)
+        reg_map[index] = n_vars++;
+    reg_map[0] = 0;
+    reg_map[1] = 1;
+
+    program.regs.resize(n_vars);
+    program.regs[1].type = EnokiType::UInt32;
+    program.instrs.reserve(sweep.size());
+
+    for (uint32_t index : sweep) {
+        Variable &var = cpu_jit_check_var(ctx, index, size);
+        InterpRegister &reg = program.regs[reg_map[index]];
+        reg.type = var.type;
+
+        if (var.data || var.direct_pointer) {
+            reg.data = var.data;
+            if (var.direct_pointer)
+                reg.kind = InterpRegister::Pointer;
+            else
+                reg.kind = var.size == 1 ? InterpRegister::InputScalar
+                                         : InterpRegister::Input;
+            n_in++;
+            continue;
+        }
+
+        InterpInstr instr;
+        cpu_interp_decode(instr, var.cmd);
+        instr.type = var.type;
+        instr.out = reg_map[index];
+        for (int j = 0; j < 3; ++j) {
+            auto it = reg_map.find(var.dep[j]);
+            if (it == reg_map.end())
+                throw std::runtime_error(
+                    "CPUBackend: internal error -- variable not found!");
+            instr.dep[j] = it->second;
+        }
+        instr.type_dep = ctx[var.dep[instr.op == InterpOp::Scatter ? 1 : 0]].type;
+        program.instrs.push_back(instr);
+        n_arith++;
+
+        if (var.side_effect) {
+            n_out++;
+        } else if (cpu_jit_alloc_output(ctx, index, var, size)) {
+            reg.kind = InterpRegister::Output;
+            reg.data = var.data;
+            n_out++;
+        }
+    }
+
+    cpu_jit_log_launch(ctx, "interpreting", size, n_in, n_out, n_arith);
+
+    return program;
+}
+
+/// Quote a path for the shell invoked by 'popen()'
+static std::string shell_quote(const std::string &str) {
+    std::string result = "'";
+    for (char c : str) {
+        if (c == '\'')
+            result += "'\\''";
+        else
+            result += c;
+    }
+    return result + "'";
+}
+
+/// Load a compiled kernel from a shared library
+static Kernel cpu_jit_load(const std::string &lib_fname) {
+    Kernel kernel;
+    kernel.handle = dlopen(lib_fname.c_str(), RTLD_NOW | RTLD_LOCAL);
+    if (!kernel.handle)
+        throw std::runtime_error(std::string("cpu_jit_load(): dlopen() failed: ") + dlerror());
+
+    kernel.func = (KernelFunc) dlsym(kernel.handle, "enoki_kernel");
+    if (!kernel.func) {
+        dlclose(kernel.handle);
+        throw std::runtime_error(std::string("cpu_jit_load(): dlsym() failed: ") + dlerror());
+    }
+
+    return kernel;
+}
+
+/**
+ * \brief Translate the given C source into a shared library and load it
+ *
+ * When the on-disk cache is enabled, the library is stored as
+ * <tt>cpu_&lt;hash&gt;.so</tt> along with the source, compiler command and
+ * host processor (<tt>cpu_&lt;hash&gt;.c</tt>), which is compared on lookup to
+ * rule out hash collisions. Libraries compiled with <tt>-march=native</tt> on
+ * a different processor are thus never loaded. Sets 'disk_hit' if compilation
+ * could be skipped.
+ */
+static Kernel cpu_jit_compile(Context &ctx, const std::string &source, bool &disk_hit) {
+    std::string key = "/* " + ctx.compiler + " " ENOKI_CPU_CFLAGS ", " +
+                      ctx.host_id + " */\n" + source,
+                key_fname, cache_fname;
+    disk_hit = false;
+
+    if (!ctx.cache_dir.empty()) {
+        std::string prefix = kernel_cache_prefix(ctx.cache_dir, "cpu", key), cached;
+        key_fname = prefix + ".c";
+        cache_fname = prefix + ".so";
+
+        if (kernel_cache_read(key_fname, cached) && cached == key) {
+            try {
+                Kernel kernel = cpu_jit_load(cache_fname);
+                disk_hit = true;
+                return kernel;
+            } catch (const std::exception &e) {
+                if (ctx.log_level >= 2)
+                    std::cerr << "cpu_jit_compile(): ignoring cache entry: "
+                              << e.what() << std::endl;
+            }
+        }
+
+        if (!ctx.cache_dir_created) {
+            ctx.cache_dir_created = kernel_cache_create_dir(ctx.cache_dir);
+            if (!ctx.cache_dir_created) {
+                if (ctx.log_level >= 1)
+                    std::cerr << "cpu_jit_compile(): could not create cache "
+                                 "directory \"" << ctx.cache_dir
+                              << "\", disabling the on-disk cache." << std::endl;
+                ctx.cache_dir.clear();
+                cache_fname.clear();
+            }
+        }
+    }
+
+    if (ctx.temp_dir.empty()) {
+        const char *tmp = getenv("TMPDIR");
+        std::string pattern = std::string(tmp ? tmp : "/tmp") + "/enoki-cpu-XXXXXX";
+        if (!mkdtemp(&pattern[0]))
+            throw std::runtime_error("cpu_jit_compile(): could not create "
+                                     "temporary directory \"" + pattern + "\"!");
+        ctx.temp_dir = pattern;
+    }
+
+    std::string prefix = ctx.temp_dir + "/kernel_" + std::to_string(ctx.compile_count++),
+                src_fname = prefix + ".c",
+                lib_fname = cache_fname.empty() ? prefix + ".so"
+                                                : kernel_cache_temp_name(cache_fname);
+
+    /* Write the source file */ {
+        std::ofstream os(src_fname);
+        os << source;
+        if (!os.good())
+            throw std::runtime_error("cpu_jit_compile(): could not write \"" +
+                                     src_fname + "\"!");
+    }
+
+    std::string cmd = ctx.compiler + " " ENOKI_CPU_CFLAGS " -o " +
+                      shell_quote(lib_fname) + " " + shell_quote(src_fname) + " 2>&1";
+
+    if (ctx.log_level >= 2)
+        std::cerr << "cpu_jit_compile(): " << cmd << std::endl;
+
+    std::string log;
+    FILE *pipe = popen(cmd.c_str(), "r");
+    if (!pipe)
+        throw std::runtime_error("cpu_jit_compile(): could not run \"" + cmd + "\"!");
+    char buf[512];
+    while (fgets(buf, sizeof(buf), pipe))
+        log += buf;
+    int rv = pclose(pipe);
+
+    unlink(src_fname.c_str());
+
+    if (rv != 0) {
+        unlink(lib_fname.c_str());
+        if (ctx.log_level >= 2)
+            std::cerr << source << std::endl;
+        throw std::runtime_error("cpu_jit_compile(): compilation failed (\"" +
+                                 cmd + "\"):\n" + log);
+    }
+
+    /* Publish the library before its key, so that a matching key always
+       refers to a complete library */
+    if (!cache_fname.empty()) {
+        if (rename(lib_fname.c_str(), cache_fname.c_str()) == 0) {
+            lib_fname = cache_fname;
+            kernel_cache_write(key_fname, key.data(), key.size());
+        } else {
+            cache_fname.clear();
+        }
+    }
+
+    Kernel kernel = cpu_jit_load(lib_fname);
+    if (cache_fname.empty())
+        unlink(lib_fname.c_str());
+
+    return kernel;
+}
+
+ENOKI_EXPORT void cpu_jit_run(Context &ctx,
+                              std::string &&source_,
+                              std::vector<void *> &ptrs,
+                              size_t size,
+                              bool side_effects,
+                              TimePoint start,
+                              TimePoint mid) {
+    auto hash_entry = ctx.kernels.emplace(std::move(source_), Kernel());
+    const std::string &source = hash_entry.first->first;
+    Kernel &kernel = hash_entry.first->second;
+
+    if (ctx.log_level >= 3)
+        std::cout << source << std::endl;
+
+    size_t duration_1 = (size_t) std::chrono::duration_cast<
+            std::chrono::microseconds>(mid - start).count();
+
+    if (hash_entry.second) {
+        bool disk_hit = false;
+        try {
+            kernel = cpu_jit_compile(ctx, source, disk_hit);
+        } catch (...) {
+            ctx.kernels.erase(hash_entry.first);
+            throw;
+        }
+
+        TimePoint end = std::chrono::high_resolution_clock::now();
+        size_t duration_2 = (size_t) std::chrono::duration_cast<
+                std::chrono::microseconds>(end - mid).count();
+
+        if (disk_hit)
+            ctx.cache_hits_disk++;
+        else
+            ctx.cache_misses++;
+
+        if (ctx.log_level >= 2)
+            std::cerr << "cpu_jit_run(): "
+                      << (disk_hit ? "cache hit (disk), jit: " : "cache miss, jit: ")
+                      << time_string(duration_1)
+                      << (disk_hit ? ", load: " : ", compilation: ")
+                      << time_string(duration_2) << std::endl;
+    } else {
+        ctx.cache_hits++;
+        if (ctx.log_level >= 2)
+            std::cerr << "cpu_jit_run(): cache hit, jit: "
+                      << time_string(duration_1) << std::endl;
+    }
+
+#if defined(ENOKI_CPU_THREAD)
+    /* Scatter operations aren't atomic, hence kernels with side effects run
+       on the calling thread */
+    if (!side_effects && size > ENOKI_CPU_PARALLEL_GRAIN) {
+        KernelFunc func = kernel.func;
+        void **args = ptrs.data();
+        parallel_for(size, ENOKI_CPU_PARALLEL_GRAIN, [func, args](size_t begin, size_t end) {
+            func(args, begin, end);
+        });
+        return;
+    }
+#else
+    (void) side_effects;
+#endif
+
+    kernel.func(ptrs.data(), 0, size);
+}
+
+ENOKI_EXPORT void cpu_eval(bool /* log_assembly */) {
+    Context &ctx = context();
+
+    TraceSchedules schedules = trace_schedule(ctx, ENOKI_CPU_REG_RESERVED);
+
+    for (auto it = schedules.rbegin(); it != schedules.rend(); ++it) {
+        size_t size = it->first;
+        const std::vector<uint32_t> &schedule = it->second.order;
+
+        TimePoint start = std::chrono::high_resolution_clock::now();
+
+        if (ctx.interpret) {
+            InterpProgram program = cpu_interp_assemble(size, schedule);
+            TimePoint mid = std::chrono::high_resolution_clock::now();
+            cpu_interp_run(program, size);
+
+            if (ctx.log_level >= 2) {
+                TimePoint end = std::chrono::high_resolution_clock::now();
+                std::cerr << "cpu_interp_run(): decode: "
+                          << time_string((size_t) std::chrono::duration_cast<
+                                 std::chrono::microseconds>(mid - start).count())
+                          << ", execution: "
+                          << time_string((size_t) std::chrono::duration_cast<
+                                 std::chrono::microseconds>(end - mid).count())
+                          << std::endl;
+            }
+            continue;
+        }
+
+        bool side_effects;
+        auto result = cpu_jit_assemble(size, schedule, side_effects);
+        TimePoint mid = std::chrono::high_resolution_clock::now();
+
+        cpu_jit_run(ctx,
+                    std::move(std::get<0>(result)),
+                    std::get<1>(result),
+                    size, side_effects, start, mid);
+    }
+
+    trace_release(ctx, schedules, cpu_dec_ref_int, cpu_dec_ref_ext);
+}
+
+ENOKI_EXPORT void cpu_eval_var(uint32_t index, bool log_assembly) {
+    Variable &var = context()[index];
+    if (var.data == nullptr || var.dirty)
+        cpu_eval(log_assembly);
+    assert(!var.dirty);
+}
+
+//! @}
+// -----------------------------------------------------------------------
+
+ENOKI_EXPORT void cpu_fetch_element(void *dst, uint32_t src, size_t offset, size_t size) {
+    Variable &var = context()[src];
+
+    if (var.data == nullptr || var.dirty)
+        cpu_eval();
+
+    if (var.dirty)
+        throw std::runtime_error("cpu_fetch_element(): element is still "
+                                 "marked as 'dirty' even after cpu_eval()!");
+    else if (var.data == nullptr)
+        throw std::runtime_error(
+            "cpu_fetch_element(): tried to read from invalid/uninitialized CPU array!");
+
+    if (var.size == 1)
+        offset = 0;
+
+    memcpy(dst, (uint8_t *) var.data + size * offset, size);
+}
+
+ENOKI_EXPORT void cpu_set_log_level(uint32_t level) {
+#if defined(NDEBUG)
+    if (level >= 4)
+        throw std::runtime_error("cpu_set_log_level(): log levels >= 4 are only supported when Enoki is compiled in debug mode!");
+#endif
+    context().log_level = level;
+}
+
+ENOKI_EXPORT uint32_t cpu_log_level() {
+    return context().log_level;
+}
+
+ENOKI_EXPORT void cpu_kernel_cache_stats(size_t *hits, size_t *hits_disk,
+                                          size_t *misses) {
+    Context &ctx = context();
+    *hits = ctx.cache_hits;
+    *hits_disk = ctx.cache_hits_disk;
+    *misses = ctx.cache_misses;
+}
+
+ENOKI_EXPORT void cpu_kernel_stats(size_t *launches, size_t *ops,
+                                   size_t *ops_max) {
+    Context &ctx = context();
+    *launches = ctx.launches;
+    *ops = ctx.launch_ops;
+    *ops_max = ctx.launch_ops_max;
+}
+
+ENOKI_EXPORT void cpu_set_interpreter(bool value) {
+    context().interpret = value;
+}
+
+ENOKI_EXPORT bool cpu_interpreter() {
+    return context().interpret;
+}
+
+ENOKI_EXPORT char *cpu_whos() {
+    std::ostringstream oss;
+    oss << std::endl
+        << "  ID        Type   E/I Refs   Size        Memory     Ready    Label" << std::endl
+        << "  =================================================================" << std::endl;
+    auto &ctx = context();
+
+    std::vector<uint32_t> indices;
+    indices.reserve(ctx.variables.size());
+    for (const auto& it : ctx.variables)
+        indices.push_back(it.first);
+    std::sort(indices.begin(), indices.end());
+
+    size_t mem_size_scheduled = 0,
+           mem_size_ready = 0,
+           mem_size_arith = 0;
+    for (uint32_t id : indices) {
+        if (id < ENOKI_CPU_REG_RESERVED)
+            continue;
+        const Variable &v = ctx[id];
+        oss << "  " << std::left << std::setw(9) << id << " ";
+        switch (v.type) {
+            case EnokiType::Int8:    oss << "i8 "; break;
+            case EnokiType::UInt8:   oss << "u8 "; break;
+            case EnokiType::Int16:   oss << "i16"; break;
+            case EnokiType::UInt16:  oss << "u16"; break;
+            case EnokiType::Int32:   oss << "i32"; break;
+            case EnokiType::UInt32:  oss << "u32"; break;
+            case EnokiType::Int64:   oss << "i64"; break;
+            case EnokiType::UInt64:  oss << "u64"; break;
+            case EnokiType::Float32: oss << "f32"; break;
+            case EnokiType::Float64: oss << "f64"; break;
+            case EnokiType::Bool:    oss << "msk"; break;
+            case EnokiType::Pointer: oss << "ptr"; break;
+            default: throw std::runtime_error("Invalid array type!");
+        }
+        size_t mem_size = v.size * cpu_register_size(v.type);
+        oss << "    ";
+        oss << std::left << std::setw(10) << (std::to_string(v.ref_count_ext) + " / " + std::to_string(v.ref_count_int)) << " ";
+        oss << std::left << std::setw(12) << v.size;
+        oss << std::left << std::setw(12) << mem_string(mem_size);
+        oss << (v.data ? "[x]" : "[ ]") << "     ";
+        oss << v.label;
+        oss << std::endl;
+        if (v.data) {
+            mem_size_ready += mem_size;
+        } else {
+            if (v.ref_count_ext == 0)
+                mem_size_arith += mem_size;
+            else
+                mem_size_scheduled += mem_size;
+        }
+    }
+
+    oss << "  =================================================================" << std::endl << std::endl
+        << "  Memory usage (ready)     : " << mem_string(mem_size_ready)     << std::endl
+        << "  Memory usage (scheduled) : " << mem_string(mem_size_ready) << " + "
+        << mem_string(mem_size_scheduled) << " = " << mem_string(mem_size_ready + mem_size_scheduled) << std::endl
+        << "  Memory savings           : " << mem_string(mem_size_arith)     << std::endl << std::endl
+        << "  Compiled kernels         : " << ctx.kernels.size() << std::endl
+        << "  Kernel cache             : " << ctx.cache_hits << " hits, "
+        << ctx.cache_hits_disk << " disk hits, " << ctx.cache_misses << " misses"
+        << std::endl
+        << "  Kernel launches          : " << ctx.launches << " ("
+        << ctx.launch_ops << " ops, largest kernel: " << ctx.launch_ops_max
+        << " ops)" << (ctx.interpret ? " [interpreted]" : "") << std::endl;
+
+    return strdup(oss.str().c_str());
+}
+
+NAMESPACE_END(enoki)
@@ -26,6 +26,8 @@
 #include <chrono>
 #include <mutex>
 #include "common.cuh"
+#include "../kernel_cache.h"
+#include "../trace.h"
 
 /// Should the implementation use streams to schedule kernels in parallel if possible?
 #define ENOKI_CUDA_USE_STREAMS 0
@@ -178,6 +180,16 @@ struct Context {
     /// Hash table of previously compiled kernels
     std::unordered_map<std::string, std::pair<CUmodule, CUfunction>, StringHasher> kernels;
 
+    /// On-disk kernel cache (empty if disabled)
+    std::string cache_dir;
+    bool cache_dir_created = false;
+
+    /// Compute capability and driver version, which determine the code of linked modules
+    std::string device_id;
+
+    /// Kernel cache statistics
+    size_t cache_hits = 0, cache_hits_disk = 0, cache_misses = 0;
+
     #if ENOKI_CUDA_USE_STREAMS == 1
         /// Streams for parallel execution
         std::vector<Stream> streams;
@@ -297,11 +309,21 @@ ENOKI_EXPORT void cuda_init() {
     #endif
 
     ctx.kernels.reserve(1000);
+    ctx.cache_dir = kernel_cache_dir();
 
     int device, num_sm;
     cudaGetDevice(&device);
     cudaDeviceGetAttribute(&num_sm, cudaDevAttrMultiProcessorCount, device);
 
+    CUdevice cu_device;
+    int cc_major = 0, cc_minor = 0, driver_version = 0;
+    cuda_check(cuDeviceGet(&cu_device, device));
+    cuda_check(cuDeviceGetAttribute(&cc_major, CU_DEVICE_ATTRIBUTE_COMPUTE_CAPABILITY_MAJOR, cu_device));
+    cuda_check(cuDeviceGetAttribute(&cc_minor, CU_DEVICE_ATTRIBUTE_COMPUTE_CAPABILITY_MINOR, cu_device));
+    cuda_check(cuDriverGetVersion(&driver_version));
+    ctx.device_id = "sm_" + std::to_string(cc_major) + std::to_string(cc_minor) +
+                    ", driver " + std::to_string(driver_version);
+
     ctx.block_count = next_power_of_two(num_sm) * 2;
     ctx.thread_count = 128;
 
@@ -1217,7 +1239,44 @@ ENOKI_EXPORT void cuda_jit_run(Context &ctx,
     size_t duration_1 = std::chrono::duration_cast<
             std::chrono::microseconds>(mid - start).count();
 
-    if (hash_entry.second) {
+    /* Look up the linked module in the on-disk cache. The driver links the
+       PTX for the GPU that is present, hence the key consists of the device's
+       compute capability, the driver version, and the PTX source. It is stored
+       next to the module and compared to rule out hash collisions. */
+    std::string cache_prefix, cache_key;
+    bool disk_hit = false;
+    if (hash_entry.second && !ctx.cache_dir.empty()) {
+        std::string cached;
+        cache_key = "// " + ctx.device_id + "\n" + source;
+        cache_prefix = kernel_cache_prefix(ctx.cache_dir, "cuda", cache_key);
+        if (kernel_cache_read(cache_prefix + ".ptx", cached) && cached == cache_key &&
+            kernel_cache_read(cache_prefix + ".cubin", cached)) {
+            CUresult ret = cuModuleLoadData(&module, cached.data());
+            if (ret == CUDA_ERROR_OUT_OF_MEMORY) {
+                cuda_malloc_trim();
+                ret = cuModuleLoadData(&module, cached.data());
+            }
+            disk_hit = ret == CUDA_SUCCESS;
+        }
+    }
+
+    if (hash_entry.second && disk_hit) {
+        ctx.cache_hits_disk++;
+
+        // Locate the kernel entry point
+        cuda_check(cuModuleGetFunction(&kernel, module, (std::string("enoki_") + kernel_name).c_str()));
+
+        if (ctx.log_level >= 2) {
+            TimePoint end = std::chrono::high_resolution_clock::now();
+            size_t duration_2 = std::chrono::duration_cast<
+                    std::chrono::microseconds>(end - mid).count();
+            std::cerr << "cuda_jit_run(): cache hit (disk), jit: "
+                      << time_string(duration_1)
+                      << ", load: " << time_string(duration_2) << std::endl;
+        }
+    } else if (hash_entry.second) {
+        ctx.cache_misses++;
+
         CUjit_option arg[5];
         void *argv[5];
         char error_log[8192], info_log[8192];
@@ -1284,9 +1343,19 @@ ENOKI_EXPORT void cuda_jit_run(Context &ctx,
         // Locate the kernel entry point
         cuda_check(cuModuleGetFunction(&kernel, module, (std::string("enoki_") + kernel_name).c_str()));
 
+        // Store the linked module in the on-disk cache (module first, then its key)
+        if (!cache_prefix.empty()) {
+            if (!ctx.cache_dir_created)
+                ctx.cache_dir_created = kernel_cache_create_dir(ctx.cache_dir);
+            if (ctx.cache_dir_created &&
+                kernel_cache_write(cache_prefix + ".cubin", link_output, link_output_size))
+                kernel_cache_write(cache_prefix + ".ptx", cache_key.c_str(), cache_key.length());
+        }
+
         // Destroy the linker invocation
         cuda_check(cuLinkDestroy(link_state));
     } else {
+        ctx.cache_hits++;
         if (ctx.log_level >= 2) {
             std::cerr << "cuda_jit_run(): cache hit, jit: "
                       << time_string(duration_1) << std::endl;
@@ -1326,64 +1395,21 @@ ENOKI_EXPORT void cuda_jit_run(Context &ctx,
     #endif
 }
 
-static void sweep_recursive(Context &ctx,
-                            std::unordered_set<uint32_t> &visited,
-                            std::vector<uint32_t> &sweep,
-                            uint32_t idx) {
-    if (visited.find(idx) != visited.end())
-        return;
-    visited.insert(idx);
-
-    std::array<uint32_t, 3> deps = ctx[idx].dep;
-
-    auto prio = [&](uint32_t i) -> uint32_t {
-        uint32_t k = deps[i];
-        if (k >= ENOKI_CUDA_REG_RESERVED)
-            return ctx[k].subtree_size;
-        else
-            return 0;
-    };
-
-    if (prio(1) < prio(2))
-        std::swap(deps[1], deps[2]);
-    if (prio(0) < prio(2))
-        std::swap(deps[0], deps[2]);
-    if (prio(0) < prio(1))
-        std::swap(deps[0], deps[1]);
-
-    for (uint32_t k : deps) {
-        if (k >= ENOKI_CUDA_REG_RESERVED)
-            sweep_recursive(ctx, visited, sweep, k);
-    }
-
-    sweep.push_back(idx);
-}
-
 ENOKI_EXPORT void cuda_eval(bool log_assembly) {
     Context &ctx = context();
 
     for (auto callback: ctx.callbacks)
         callback.first(callback.second);
 
-    std::map<size_t, std::pair<std::unordered_set<uint32_t>,
-                               std::vector<uint32_t>>> sweeps;
-    for (uint32_t idx : ctx.live) {
-        auto &sweep = sweeps[ctx[idx].size];
-        sweep_recursive(ctx, std::get<0>(sweep), std::get<1>(sweep), idx);
-    }
-    for (uint32_t idx : ctx.dirty)
-        ctx[idx].dirty = false;
+    TraceSchedules schedules = trace_schedule(ctx, ENOKI_CUDA_REG_RESERVED);
 
-    ctx.live.clear();
-    ctx.dirty.clear();
-
-    if (ctx.log_level >= 2 && sweeps.size() > 1)
+    if (ctx.log_level >= 2 && schedules.size() > 1)
         std::cerr << "cuda_eval(): begin parallel group" << std::endl;
 
     #if ENOKI_CUDA_USE_STREAMS == 1
-        if (ctx.streams.size() < sweeps.size()) {
+        if (ctx.streams.size() < schedules.size()) {
             size_t cur = ctx.streams.size();
-            ctx.streams.resize(sweeps.size());
+            ctx.streams.resize(schedules.size());
             for (size_t i = cur; i < ctx.streams.size(); ++i)
                 ctx.streams[i].init();
         }
@@ -1392,9 +1418,9 @@ ENOKI_EXPORT void cuda_eval(bool log_assembly) {
     #endif
 
     size_t stream_idx = 0;
-    for (auto it = sweeps.rbegin(); it != sweeps.rend(); ++it) {
-        size_t size = std::get<0>(*it);
-        const std::vector<uint32_t> &schedule = std::get<1>(std::get<1>(*it));
+    for (auto it = schedules.rbegin(); it != schedules.rend(); ++it) {
+        size_t size = it->first;
+        const std::vector<uint32_t> &schedule = it->second.order;
 
         #if ENOKI_CUDA_USE_STREAMS == 1
             Stream &stream = ctx.streams[stream_idx];
@@ -1421,33 +1447,10 @@ ENOKI_EXPORT void cuda_eval(bool log_assembly) {
     }
     ctx.include_printf = false;
 
-    if (ctx.log_level >= 2 && sweeps.size() > 1)
+    if (ctx.log_level >= 2 && schedules.size() > 1)
         std::cerr << "cuda_eval(): end parallel group" << std::endl;
 
-    for (auto const &sweep : sweeps) {
-        const std::vector<uint32_t> &schedule =
-            std::get<1>(std::get<1>(sweep));
-
-        for (uint32_t idx : schedule) {
-            auto it = ctx.variables.find(idx);
-            if (it == ctx.variables.end())
-                continue;
-
-            Variable &v = it->second;
-
-            if (v.data != nullptr && !v.cmd.empty()) {
-                for (int j = 0; j < 3; ++j) {
-                    cuda_dec_ref_int(v.dep[j]);
-                    v.dep[j] = 0;
-                }
-                cuda_dec_ref_ext(v.extra_dep);
-                v.extra_dep = 0;
-            }
-
-            if (v.side_effect)
-                cuda_dec_ref_ext(idx);
-        }
-    }
+    trace_release(ctx, schedules, cuda_dec_ref_int, cuda_dec_ref_ext);
 }
 
 ENOKI_EXPORT void cuda_eval_var(uint32_t index, bool log_assembly) {
@@ -1504,6 +1507,14 @@ ENOKI_EXPORT void cuda_unregister_callback(void (*callback)(void *), void *paylo
     cb.erase(it);
 }
 
+ENOKI_EXPORT void cuda_kernel_cache_stats(size_t *hits, size_t *hits_disk,
+                                           size_t *misses) {
+    Context &ctx = context();
+    *hits = ctx.cache_hits;
+    *hits_disk = ctx.cache_hits_disk;
+    *misses = ctx.cache_misses;
+}
+
 ENOKI_EXPORT char *cuda_whos() {
     std::ostringstream oss;
     oss << std::endl
@@ -1571,7 +1582,10 @@ ENOKI_EXPORT char *cuda_whos() {
         << "           max. usage: "
         << mem_string(ctx.watermark) << " device, "
         << mem_string(ctx.watermark_managed) << " managed, "
-        << mem_string(ctx.watermark_host) << " host." << std::endl;
+        << mem_string(ctx.watermark_host) << " host." << std::endl << std::endl
+        << "  Kernel cache: " << ctx.cache_hits << " hits, "
+        << ctx.cache_hits_disk << " disk hits, " << ctx.cache_misses
+        << " misses." << std::endl;
 
     return strdup(oss.str().c_str());
 }
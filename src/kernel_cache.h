@@ -0,0 +1,204 @@
+/*
+    src/kernel_cache.h -- On-disk cache of compiled kernels shared by the
+    JIT backends
+
+    Enoki is a C++ template library that enables transparent vectorization
+    of numerical kernels using SIMD instruction sets available on current
+    processor architectures.
+
+    Copyright (c) 2019 Wenzel Jakob <wenzel.jakob@epfl.ch>
+
+    All rights reserved. Use of this source code is governed by a BSD-style
+    license that can be found in the LICENSE file.
+*/
+
+#pragma once
+
+#include <string>
+#include <cstdio>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+#include <sys/stat.h>
+
+#if defined(_WIN32)
+#  include <direct.h>
+#  include <process.h>
+#else
+#  include <unistd.h>
+#endif
+
+#if (defined(__x86_64__) || defined(__i386__)) && !defined(_MSC_VER)
+#  include <cpuid.h>
+#  define ENOKI_KERNEL_CACHE_CPUID 1
+#endif
+
+NAMESPACE_BEGIN(enoki)
+
+/**
+ * \brief Hash used to name cache entries
+ *
+ * 64-bit FNV-1a: unlike std::hash, the value does not depend on the standard
+ * library or instruction set, hence cache entries remain valid across builds.
+ */
+inline uint64_t kernel_cache_hash(const std::string &str) {
+    uint64_t hash = 0xcbf29ce484222325ull;
+    for (char c : str) {
+        hash ^= (uint8_t) c;
+        hash *= 0x100000001b3ull;
+    }
+    return hash;
+}
+
+/// File name prefix of the cache entry associated with 'key' (e.g. "<dir>/cpu_<hash>")
+inline std::string kernel_cache_prefix(const std::string &dir, const char *backend,
+                                       const std::string &key) {
+    char name[17];
+    snprintf(name, sizeof(name), "%016llx",
+             (unsigned long long) kernel_cache_hash(key));
+    return dir + "/" + backend + "_" + name;
+}
+
+/**
+ * \brief Location of the on-disk kernel cache
+ *
+ * Given by the environment variable \c ENOKI_CACHE_DIR, falling back to
+ * <tt>$XDG_CACHE_HOME/enoki</tt> and <tt>$HOME/.cache/enoki</tt>. Returns an
+ * empty string when the cache is disabled (i.e. \c ENOKI_CACHE_DIR is set to
+ * an empty string, or no home directory is known).
+ */
+inline std::string kernel_cache_dir() {
+    const char *dir = getenv("ENOKI_CACHE_DIR");
+    if (dir)
+        return dir;
+    dir = getenv("XDG_CACHE_HOME");
+    if (dir && *dir)
+        return std::string(dir) + "/enoki";
+#if defined(_WIN32)
+    dir = getenv("LOCALAPPDATA");
+    if (dir && *dir)
+        return std::string(dir) + "/enoki";
+#else
+    dir = getenv("HOME");
+    if (dir && *dir)
+        return std::string(dir) + "/.cache/enoki";
+#endif
+    return std::string();
+}
+
+/**
+ * \brief Identifies the instruction set that <tt>-march=native</tt> targets
+ * on this machine
+ *
+ * Part of the key of natively compiled kernels, so that hosts with different
+ * processors can share a cache directory (e.g. on a network file system). On
+ * x86, this consists of the vendor, family/model/stepping, the feature flags
+ * reported by \c cpuid, and the register state enabled by the operating
+ * system. Elsewhere, the host name is used instead, which keeps entries of
+ * different machines apart.
+ */
+inline std::string kernel_cache_host_id() {
+    char buf[160];
+#if defined(ENOKI_KERNEL_CACHE_CPUID)
+    unsigned int vendor[3] { }, leaf1[3] { }, leaf7[3] { }, ext[2] { },
+                 xcr0 = 0, unused;
+    unsigned int max_leaf = __get_cpuid_max(0, nullptr);
+    if (max_leaf >= 1) {
+        __cpuid(0, unused, vendor[0], vendor[2], vendor[1]);
+        /* Skip ebx, which contains the APIC ID of the current core */
+        __cpuid(1, leaf1[0], unused, leaf1[1], leaf1[2]);
+        if (leaf1[1] & (1u << 27)) { // OSXSAVE
+            unsigned int xcr0_hi;
+            __asm__ volatile("xgetbv" : "=a"(xcr0), "=d"(xcr0_hi) : "c"(0));
+        }
+    }
+    if (max_leaf >= 7)
+        __cpuid_count(7, 0, unused, leaf7[0], leaf7[1], leaf7[2]);
+    if (__get_cpuid_max(0x80000000u, nullptr) >= 0x80000001u)
+        __cpuid(0x80000001u, unused, unused, ext[0], ext[1]);
+    snprintf(buf, sizeof(buf), "x86 %.12s %08x %08x %08x %08x %08x %08x %08x "
+             "%08x %08x", (const char *) vendor, leaf1[0], leaf1[1], leaf1[2],
+             xcr0, leaf7[0], leaf7[1], leaf7[2], ext[0], ext[1]);
+#elif defined(_WIN32)
+    const char *name = getenv("COMPUTERNAME");
+    snprintf(buf, sizeof(buf), "host %s", name ? name : "unknown");
+#else
+    char name[128] { };
+    if (gethostname(name, sizeof(name) - 1) != 0)
+        strcpy(name, "unknown");
+    snprintf(buf, sizeof(buf), "host %s", name);
+#endif
+    return buf;
+}
+
+/// Create the cache directory and its parents if needed (returns \c false on failure)
+inline bool kernel_cache_create_dir(const std::string &dir) {
+    for (size_t pos = 1; pos <= dir.size(); ++pos) {
+        if (pos != dir.size() && dir[pos] != '/')
+            continue;
+        std::string path = dir.substr(0, pos);
+#if defined(_WIN32)
+        int rv = _mkdir(path.c_str());
+#else
+        int rv = mkdir(path.c_str(), 0755);
+#endif
+        if (rv != 0 && errno != EEXIST)
+            return false;
+    }
+    return true;
+}
+
+/// Read a cache entry into 'out' (returns \c false if it does not exist)
+inline bool kernel_cache_read(const std::string &fname, std::string &out) {
+    FILE *f = fopen(fname.c_str(), "rb");
+    if (!f)
+        return false;
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    bool success = size >= 0;
+    if (success) {
+        out.resize((size_t) size);
+        success = fread(&out[0], 1, (size_t) size, f) == (size_t) size;
+    }
+    fclose(f);
+    return success;
+}
+
+/// Name of a temporary file that can be renamed to 'fname' once it is complete
+inline std::string kernel_cache_temp_name(const std::string &fname) {
+#if defined(_WIN32)
+    int pid = _getpid();
+#else
+    int pid = (int) getpid();
+#endif
+    return fname + "." + std::to_string(pid) + ".tmp";
+}
+
+/**
+ * \brief Atomically create or replace a cache entry
+ *
+ * The data is first written to a temporary file, which is then renamed. Other
+ * processes sharing the cache therefore never observe partially written files.
+ */
+inline bool kernel_cache_write(const std::string &fname, const void *data,
+                               size_t size) {
+    std::string temp = kernel_cache_temp_name(fname);
+    FILE *f = fopen(temp.c_str(), "wb");
+    if (!f)
+        return false;
+    bool success = fwrite(data, 1, size, f) == size;
+    success &= fclose(f) == 0;
+#if defined(_WIN32)
+    if (success)
+        remove(fname.c_str());
+#endif
+    if (success)
+        success = rename(temp.c_str(), fname.c_str()) == 0;
+    if (!success)
+        remove(temp.c_str());
+    return success;
+}
+
+NAMESPACE_END(enoki)
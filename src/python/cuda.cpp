@@ -39,6 +39,12 @@ PYBIND11_MODULE(cuda, s) {
 
     m.def("cuda_whos", []() { char *w = cuda_whos(); py::print(w); free(w); });
 
+    m.def("cuda_kernel_cache_stats", []() {
+        size_t hits = 0, hits_disk = 0, misses = 0;
+        cuda_kernel_cache_stats(&hits, &hits_disk, &misses);
+        return std::make_tuple(hits, hits_disk, misses);
+    }, "Returns the number of kernel cache hits (in memory, on disk) and misses");
+
     m.def("cuda_mem_get_info", []() {
         size_t free = 0, total = 0;
         cuda_mem_get_info(&free, &total);
@@ -1,6 +1,24 @@
 #include "common.h"
 #include <pybind11/functional.h>
 
+/// Convert profiler statistics into a list of dictionaries
+static py::list profile_list(const std::vector<ProfileEntry> &profile) {
+    py::list result;
+    for (const ProfileEntry &entry : profile) {
+        py::dict item;
+        item["prefix"] = entry.prefix;
+        item["label"] = entry.label;
+        item["backward_nodes"] = entry.backward_nodes;
+        item["forward_nodes"] = entry.forward_nodes;
+        item["backward_time"] = entry.backward_time;
+        item["forward_time"] = entry.forward_time;
+        item["weight_bytes"] = entry.weight_bytes;
+        item["grad_bytes"] = entry.grad_bytes;
+        result.append(item);
+    }
+    return result;
+}
+
 void bind_cuda_autodiff_1d(py::module& m, py::module& s) {
     auto mask_class = bind<mask_t<Float32D>>(m, s, "Mask");
     auto uint32_class = bind<UInt32D>(m, s, "UInt32");
@@ -27,6 +45,14 @@ void bind_cuda_autodiff_1d(py::module& m, py::module& s) {
              "Sets the current log level (0 == none, 1 == minimal, 2 == moderate, 3 == high, 4 == everything)")
         .def_static("log_level", []() { return Float32D::log_level_(); })
         .def_static("simplify_graph", []() { Float32D::simplify_graph_(); })
+        .def_static("push_prefix", [](const char *prefix) { Float32D::push_prefix_(prefix); })
+        .def_static("pop_prefix", []() { Float32D::pop_prefix_(); })
+        .def_static("set_profiling", [](bool value) { Float32D::set_profiling_(value); },
+             "Enables the profiler, which aggregates time and memory per label and prefix")
+        .def_static("profile",
+             [](bool by_prefix) { return profile_list(Float32D::profile_(by_prefix)); },
+             "by_prefix"_a = false)
+        .def_static("profile_reset", []() { Float32D::profile_reset_(); })
         .def_static("backward",
                     [](bool free_graph) { backward<Float32D>(free_graph); },
                     "free_graph"_a = true)
@@ -48,6 +74,14 @@ void bind_cuda_autodiff_1d(py::module& m, py::module& s) {
              "Sets the current log level (0 == none, 1 == minimal, 2 == moderate, 3 == high, 4 == everything)")
         .def_static("log_level", []() { return Float64D::log_level_(); })
         .def_static("simplify_graph", []() { Float64D::simplify_graph_(); })
+        .def_static("push_prefix", [](const char *prefix) { Float64D::push_prefix_(prefix); })
+        .def_static("pop_prefix", []() { Float64D::pop_prefix_(); })
+        .def_static("set_profiling", [](bool value) { Float64D::set_profiling_(value); },
+             "Enables the profiler, which aggregates time and memory per label and prefix")
+        .def_static("profile",
+             [](bool by_prefix) { return profile_list(Float64D::profile_(by_prefix)); },
+             "by_prefix"_a = false)
+        .def_static("profile_reset", []() { Float64D::profile_reset_(); })
         .def_static("backward",
                     [](bool free_graph) { backward<Float64D>(free_graph); },
                     "free_graph"_a = true)
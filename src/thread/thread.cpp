@@ -0,0 +1,338 @@
+/*
+    src/thread/thread.cpp -- Work-stealing thread pool for parallel loops over
+    dynamic arrays
+
+    Enoki is a C++ template library that enables transparent vectorization
+    of numerical kernels using SIMD instruction sets available on current
+    processor architectures.
+
+    Copyright (c) 2019 Wenzel Jakob <wenzel.jakob@epfl.ch>
+
+    All rights reserved. Use of this source code is governed by a BSD-style
+    license that can be found in the LICENSE file.
+*/
+
+#include <enoki/thread.h>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <exception>
+#include <vector>
+#include <cstdlib>
+
+#if defined(__linux__)
+#  include <pthread.h>
+#  include <sched.h>
+#endif
+
+NAMESPACE_BEGIN(enoki)
+
+/// Is the current thread a pool worker or already inside a parallel loop?
+static thread_local bool thread_nested = false;
+
+/// Marks the calling thread as being inside a parallel loop
+struct NestedScope {
+    NestedScope() { thread_nested = true; }
+    ~NestedScope() { thread_nested = false; }
+};
+
+/**
+ * \brief Parallel loop that is currently being processed by the pool
+ *
+ * The block range is initially split into one contiguous slice per thread.
+ * Every thread consumes blocks from the front of its own slice and steals the
+ * back half of another slice once its own slice is exhausted. A slice is a
+ * pair of 32-bit block indices packed into a single 64-bit word, hence both
+ * operations are lock-free compare-and-swap loops.
+ */
+struct Job {
+    struct alignas(64) Slice {
+        std::atomic<uint64_t> range { 0 };
+    };
+
+    static uint64_t pack(uint32_t begin, uint32_t end) {
+        return (uint64_t) begin | ((uint64_t) end << 32);
+    }
+
+    void (*func)(size_t, size_t, void *) = nullptr;
+    void *payload = nullptr;
+    size_t size = 0, grain = 0;
+
+    std::unique_ptr<Slice[]> slices;
+    size_t slice_count = 0;
+
+    /// Number of blocks that have not been processed yet
+    std::atomic<size_t> remaining { 0 };
+
+    /// Number of pool workers that are still inside 'run()'
+    std::atomic<size_t> active { 0 };
+
+    std::mutex exception_mutex;
+    std::exception_ptr exception;
+
+    /// Fetch the next block of the slice 'id' (optionally stealing from others)
+    bool next(size_t id, size_t &block) {
+        Slice &own = slices[id];
+        uint64_t value = own.range.load(std::memory_order_acquire);
+        while (true) {
+            uint32_t begin = (uint32_t) value, end = (uint32_t) (value >> 32);
+            if (begin >= end)
+                break;
+            if (own.range.compare_exchange_weak(value, pack(begin + 1, end),
+                                                std::memory_order_acq_rel)) {
+                block = begin;
+                return true;
+            }
+        }
+
+        /* The own slice is empty (and stays so until refilled below), steal
+           the back half of the next non-empty slice */
+        for (size_t i = 1; i < slice_count; ++i) {
+            Slice &victim = slices[(id + i) % slice_count];
+            value = victim.range.load(std::memory_order_acquire);
+            while (true) {
+                uint32_t begin = (uint32_t) value, end = (uint32_t) (value >> 32);
+                if (begin >= end)
+                    break;
+                uint32_t split = end - (end - begin + 1) / 2;
+                if (victim.range.compare_exchange_weak(value, pack(begin, split),
+                                                       std::memory_order_acq_rel)) {
+                    own.range.store(pack(split + 1, end), std::memory_order_release);
+                    block = split;
+                    return true;
+                }
+            }
+        }
+
+        return false;
+    }
+
+    void run(size_t id) {
+        size_t block;
+        while (next(id, block)) {
+            size_t begin = block * grain,
+                   end   = std::min(begin + grain, size);
+            try {
+                func(begin, end, payload);
+            } catch (...) {
+                std::lock_guard<std::mutex> guard(exception_mutex);
+                if (!exception)
+                    exception = std::current_exception();
+            }
+            remaining--;
+        }
+    }
+};
+
+struct ThreadPool {
+    std::vector<std::thread> workers;
+
+    std::mutex mutex;
+    std::condition_variable cv_work, cv_done;
+
+    /// Serializes parallel loops submitted by different threads
+    std::mutex submit_mutex;
+
+    Job *job = nullptr;
+    uint64_t generation = 0;
+    bool stop = false;
+
+    /// Pin workers to cores? (written under 'submit_mutex', readable without locking)
+    std::atomic<bool> affinity { false };
+
+    /// Number of threads including the caller (readable without locking)
+    std::atomic<size_t> thread_count { 1 };
+
+    ThreadPool() {
+        size_t count = std::max(1u, std::thread::hardware_concurrency());
+        if (const char *env = getenv("ENOKI_NUM_THREADS")) {
+            long value = strtol(env, nullptr, 10);
+            if (value > 0)
+                count = (size_t) value;
+        }
+        start(count);
+    }
+
+    ~ThreadPool() { shutdown(); }
+
+    size_t size() const { return thread_count; }
+
+    void start(size_t count) {
+        stop = false;
+        thread_count = count;
+        for (size_t i = 1; i < count; ++i)
+            workers.emplace_back([this, i]() { worker(i); });
+    }
+
+    void shutdown() {
+        {
+            std::lock_guard<std::mutex> guard(mutex);
+            stop = true;
+        }
+        cv_work.notify_all();
+        for (auto &w : workers)
+            w.join();
+        workers.clear();
+        thread_count = 1;
+    }
+
+    /// Replace the worker threads (waits for a running parallel loop)
+    void configure(size_t count, bool affinity_) {
+        std::lock_guard<std::mutex> submit_guard(submit_mutex);
+        shutdown();
+        affinity = affinity_;
+        start(count);
+    }
+
+    void worker(size_t id) {
+        thread_nested = true;
+        uint64_t last_generation;
+        {
+            std::lock_guard<std::mutex> guard(mutex);
+            last_generation = generation;
+        }
+
+#if defined(__linux__)
+        if (affinity) {
+            cpu_set_t available, target;
+            CPU_ZERO(&target);
+            if (sched_getaffinity(0, sizeof(cpu_set_t), &available) == 0) {
+                /* Pin worker 'id' to the id-th core available to the process */
+                size_t n = (size_t) CPU_COUNT(&available), k = id % n;
+                for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+                    if (CPU_ISSET(cpu, &available) && k-- == 0) {
+                        CPU_SET(cpu, &target);
+                        pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &target);
+                        break;
+                    }
+                }
+            }
+        }
+#endif
+
+        while (true) {
+            Job *current;
+            {
+                std::unique_lock<std::mutex> guard(mutex);
+                cv_work.wait(guard, [&] {
+                    return stop || (job && generation != last_generation);
+                });
+                if (stop)
+                    return;
+                last_generation = generation;
+                current = job;
+                current->active++;
+            }
+
+            current->run(id);
+
+            {
+                std::lock_guard<std::mutex> guard(mutex);
+                current->active--;
+            }
+            cv_done.notify_all();
+        }
+    }
+
+    void parallel_for(size_t size, size_t grain,
+                      void (*func)(size_t, size_t, void *), void *payload) {
+        /* Block indices are stored as 32 bit integers */
+        grain = std::max(grain, (size_t) ((size + 0xFFFFFFFEull) / 0xFFFFFFFFull));
+        size_t blocks = (size + grain - 1) / grain;
+
+        std::lock_guard<std::mutex> submit_guard(submit_mutex);
+
+        if (workers.empty()) {
+            NestedScope scope;
+            for (size_t begin = 0; begin < size; begin += grain)
+                func(begin, std::min(begin + grain, size), payload);
+            return;
+        }
+
+        Job local;
+        local.func = func;
+        local.payload = payload;
+        local.size = size;
+        local.grain = grain;
+        local.slice_count = workers.size() + 1;
+        local.slices = std::unique_ptr<Job::Slice[]>(new Job::Slice[local.slice_count]);
+        local.remaining = blocks;
+
+        for (size_t i = 0; i < local.slice_count; ++i)
+            local.slices[i].range = Job::pack(
+                (uint32_t) (blocks * i / local.slice_count),
+                (uint32_t) (blocks * (i + 1) / local.slice_count));
+
+        {
+            std::lock_guard<std::mutex> guard(mutex);
+            job = &local;
+            generation++;
+        }
+        cv_work.notify_all();
+
+        /* Participate, then wait for stragglers */
+        {
+            NestedScope scope;
+            local.run(0);
+        }
+
+        {
+            std::unique_lock<std::mutex> guard(mutex);
+            job = nullptr;
+            cv_done.wait(guard, [&] {
+                return local.remaining == 0 && local.active == 0;
+            });
+        }
+
+        if (local.exception)
+            std::rethrow_exception(local.exception);
+    }
+};
+
+static ThreadPool *thread_pool() {
+    static ThreadPool pool;
+    return &pool;
+}
+
+ENOKI_EXPORT void thread_parallel_for(size_t size, size_t grain,
+                                      void (*func)(size_t, size_t, void *),
+                                      void *payload) {
+    if (size == 0)
+        return;
+    if (grain == 0)
+        grain = 1;
+
+    if (thread_nested || size <= grain) {
+        /* Nested parallel loop or trivial workload: process serially */
+        for (size_t begin = 0; begin < size; begin += grain)
+            func(begin, std::min(begin + grain, size), payload);
+        return;
+    }
+
+    thread_pool()->parallel_for(size, grain, func, payload);
+}
+
+ENOKI_EXPORT size_t thread_count() {
+    return thread_pool()->size();
+}
+
+ENOKI_EXPORT void thread_set_count(size_t count) {
+    if (thread_nested)
+        throw std::runtime_error("thread_set_count(): cannot be called from within a parallel loop!");
+    ThreadPool *pool = thread_pool();
+    pool->configure(std::max(count, (size_t) 1), pool->affinity);
+}
+
+ENOKI_EXPORT void thread_set_affinity(bool value) {
+    if (thread_nested)
+        throw std::runtime_error("thread_set_affinity(): cannot be called from within a parallel loop!");
+    ThreadPool *pool = thread_pool();
+    pool->configure(pool->size(), value);
+}
+
+ENOKI_EXPORT bool thread_affinity() {
+    return thread_pool()->affinity;
+}
+
+NAMESPACE_END(enoki)
@@ -0,0 +1,134 @@
+/*
+    src/trace.h -- Instruction scheduling and dead code elimination shared by
+    the JIT backends
+
+    Enoki is a C++ template library that enables transparent vectorization
+    of numerical kernels using SIMD instruction sets available on current
+    processor architectures.
+
+    Copyright (c) 2019 Wenzel Jakob <wenzel.jakob@epfl.ch>
+
+    All rights reserved. Use of this source code is governed by a BSD-style
+    license that can be found in the LICENSE file.
+*/
+
+#pragma once
+
+#include <array>
+#include <map>
+#include <vector>
+#include <cstdint>
+#include <unordered_set>
+
+/*
+   The CUDA and CPU backends record the same kind of trace: a 'Context' maps
+   variable indices to 'Variable' records with up to three dependencies
+   ('dep'), a 'subtree_size' heuristic, and external/internal reference
+   counts. Only the code generation and the launch differ. The functions
+   below turn the set of live variables into kernels and are written against
+   that shared representation, so they can be exercised through the CPU
+   backend (and its interpreter) on machines without a GPU.
+*/
+
+NAMESPACE_BEGIN(enoki)
+
+/// Variables computed by one kernel, in execution order
+struct TraceSchedule {
+    std::unordered_set<uint32_t> visited;
+    std::vector<uint32_t> order;
+};
+
+/// One kernel per array size (launched from the largest to the smallest size)
+using TraceSchedules = std::map<size_t, TraceSchedule>;
+
+/**
+ * \brief Append \c idx and its dependencies to the schedule in topological
+ * order, visiting larger subtrees first to reduce the number of registers
+ * that are live at the same time
+ */
+template <typename Context>
+void trace_sweep_recursive(Context &ctx, uint32_t reg_reserved,
+                           TraceSchedule &schedule, uint32_t idx) {
+    if (schedule.visited.find(idx) != schedule.visited.end())
+        return;
+    schedule.visited.insert(idx);
+
+    std::array<uint32_t, 3> deps = ctx[idx].dep;
+
+    auto prio = [&](uint32_t i) -> uint32_t {
+        uint32_t k = deps[i];
+        if (k >= reg_reserved)
+            return ctx[k].subtree_size;
+        else
+            return 0;
+    };
+
+    if (prio(1) < prio(2))
+        std::swap(deps[1], deps[2]);
+    if (prio(0) < prio(2))
+        std::swap(deps[0], deps[2]);
+    if (prio(0) < prio(1))
+        std::swap(deps[0], deps[1]);
+
+    for (uint32_t k : deps) {
+        if (k >= reg_reserved)
+            trace_sweep_recursive(ctx, reg_reserved, schedule, k);
+    }
+
+    schedule.order.push_back(idx);
+}
+
+/**
+ * \brief Fuse all pending computation into one kernel per array size
+ *
+ * Only variables that are reachable from \c ctx.live (i.e. that are
+ * referenced by an Enoki array or have side effects) are scheduled, which
+ * eliminates dead code. Clears the set of live and dirty variables.
+ */
+template <typename Context>
+TraceSchedules trace_schedule(Context &ctx, uint32_t reg_reserved) {
+    TraceSchedules schedules;
+    for (uint32_t idx : ctx.live)
+        trace_sweep_recursive(ctx, reg_reserved, schedules[ctx[idx].size], idx);
+
+    for (uint32_t idx : ctx.dirty)
+        ctx[idx].dirty = false;
+
+    ctx.live.clear();
+    ctx.dirty.clear();
+
+    return schedules;
+}
+
+/**
+ * \brief Release the dependencies of variables that were computed by the
+ * kernels, which frees intermediate variables that are no longer referenced
+ */
+template <typename Context>
+void trace_release(Context &ctx, const TraceSchedules &schedules,
+                   void (*dec_ref_int)(uint32_t),
+                   void (*dec_ref_ext)(uint32_t)) {
+    for (auto const &kv : schedules) {
+        for (uint32_t idx : kv.second.order) {
+            auto it = ctx.variables.find(idx);
+            if (it == ctx.variables.end())
+                continue;
+
+            auto &v = it->second;
+
+            if (v.data != nullptr && !v.cmd.empty()) {
+                for (int j = 0; j < 3; ++j) {
+                    dec_ref_int(v.dep[j]);
+                    v.dep[j] = 0;
+                }
+                dec_ref_ext(v.extra_dep);
+                v.extra_dep = 0;
+            }
+
+            if (v.side_effect)
+                dec_ref_ext(idx);
+        }
+    }
+}
+
+NAMESPACE_END(enoki)
@@ -15,6 +15,10 @@
 #include <enoki/dynamic.h>
 #include <enoki/autodiff.h>
 #include <enoki/color.h>
+#include <thread>
+#if defined(ENOKI_AUTODIFF_THREAD)
+#  include <enoki/thread.h>
+#endif
 
 using Float  = float;
 using FloatP = Packet<Float>;
@@ -634,3 +638,640 @@ ENOKI_TEST(test37_scatter_fwd) {
     FloatX ref_gradient { 0.f, 0.f, -2.f, -1.f, 0.f, 1.f, 2.f, 0.f, 0.f, 0.f };
     assert(allclose(ref_gradient, gradient(y), 1e-4f, 1e-4f));
 }
+
+ENOKI_TEST(test38_node_recycling) {
+    FloatD::set_graph_simplification_(false);
+    uint32_t max_index = 0;
+
+    for (size_t it = 0; it < 10; ++it) {
+        FloatD x = 1.5f, y = 0.5f, z = 0.f;
+        set_requires_gradient(x);
+        set_requires_gradient(y);
+
+        /* z = sum_i (x * y + i) / x = n * y + (sum_i i) / x */
+        size_t n = 20000;
+        for (size_t i = 0; i < n; ++i) {
+            FloatD t = fmadd(x, y, Float(i)) / x;
+            z += t;
+            max_index = std::max(max_index, t.index_());
+        }
+
+        backward(z);
+        Float sum_i = Float(n * (n - 1) / 2);
+        assert(std::abs(gradient(y)[0] - Float(n)) < 1e-3f * Float(n));
+        assert(std::abs(gradient(x)[0] + sum_i / (1.5f * 1.5f)) < 1e-3f * sum_i);
+    }
+
+    /* Nodes of previous iterations are reused */
+    assert(max_index < 20000 * 4);
+    FloatD::set_graph_simplification_(true);
+}
+
+ENOKI_TEST(test39_deep_graph) {
+    FloatD::set_graph_simplification_(false);
+    size_t n = 200000;
+
+    /* Backward pass through a long chain */ {
+        FloatD x = 1.f;
+        set_requires_gradient(x);
+        FloatD y = x;
+        for (size_t i = 0; i < n; ++i)
+            y = fmadd(y, 1.f, 1e-6f);
+        backward(y);
+        assert(gradient(x)[0] == 1.f);
+    }
+
+    /* Forward pass through a long chain */ {
+        FloatD x = 1.f;
+        set_requires_gradient(x);
+        FloatD y = x;
+        for (size_t i = 0; i < n; ++i)
+            y = fmadd(y, 1.f, 1e-6f);
+        forward(x);
+        assert(gradient(y)[0] == 1.f);
+    }
+
+    /* Release a long chain without traversing it */ {
+        FloatD x = 1.f;
+        set_requires_gradient(x);
+        FloatD y = x;
+        for (size_t i = 0; i < n; ++i)
+            y = fmadd(y, 1.f, 1e-6f);
+    }
+
+    FloatD::set_graph_simplification_(true);
+}
+
+#if defined(ENOKI_AUTODIFF_THREAD)
+ENOKI_TEST(test40_parallel_backward) {
+    size_t threads = thread_count();
+
+    auto func = [](const FloatD &x, const FloatD &y) {
+        /* Several independent branches that share their inputs */
+        FloatD z = 0.f;
+        for (int i = 0; i < 8; ++i) {
+            FloatD t = sin(x * (float) i) * y + cos(y * (float) i);
+            z += t * t;
+        }
+        return hsum(z * x) + hsum(gather<FloatD>(y, UInt32D(0, 1, 2)));
+    };
+
+    size_t size = 100000;
+    const size_t thread_counts[2] = { 1, 4 };
+    FloatX grad_x[2][2], grad_y[2][2];
+
+    for (int mode = 0; mode < 2; ++mode) {
+        FloatD::set_parallel_backward_(mode == 1);
+        for (int k = 0; k < 2; ++k) {
+            thread_set_count(thread_counts[k]);
+            FloatD x = linspace<FloatD>(0.f, 1.f, size),
+                   y = linspace<FloatD>(1.f, 2.f, size);
+            set_requires_gradient(x);
+            set_requires_gradient(y);
+            FloatD z = func(x, y);
+            backward(z);
+            grad_x[mode][k] = gradient(x);
+            grad_y[mode][k] = gradient(y);
+        }
+    }
+
+    FloatD::set_parallel_backward_(false);
+    thread_set_count(threads);
+
+    /* The result of either mode does not depend on the number of threads */
+    for (int mode = 0; mode < 2; ++mode) {
+        assert(grad_x[mode][0] == grad_x[mode][1]);
+        assert(grad_y[mode][0] == grad_y[mode][1]);
+    }
+
+    /* The modes only differ by the order of the accumulation */
+    assert(allclose(grad_x[0][0], grad_x[1][0], 1e-5f, 1e-5f));
+    assert(allclose(grad_y[0][0], grad_y[1][0], 1e-5f, 1e-5f));
+}
+#endif
+
+ENOKI_TEST(test41_checkpoint) {
+    auto region = [](const FloatD &x, const Vector2fD &v) {
+        FloatD t = x;
+        for (int i = 0; i < 10; ++i)
+            t = sin(t) * v.x() + v.y();
+        return std::make_pair(t, Vector2fD(t * x, v.y() * 2.f));
+    };
+
+    FloatX grad_x[2], grad_v[2][2];
+    FloatD::checkpoint_stats_reset_();
+
+    for (int mode = 0; mode < 2; ++mode) {
+        FloatD x = linspace<FloatD>(0.f, 1.f, 1000);
+        Vector2fD v(linspace<FloatD>(1.f, 2.f, 1000), 0.5f);
+        set_requires_gradient(x);
+        set_requires_gradient(v);
+
+        auto [a, b] = mode == 0 ? region(x, v) : checkpoint(region, x, v);
+        FloatD loss = hsum(a * a + b.x() + b.y() * x);
+        backward(loss);
+
+        grad_x[mode] = gradient(x);
+        grad_v[mode][0] = gradient(v.x());
+        grad_v[mode][1] = gradient(v.y());
+    }
+
+    assert(allclose(grad_x[0], grad_x[1], 1e-5f, 1e-5f));
+    assert(allclose(grad_v[0][0], grad_v[1][0], 1e-5f, 1e-5f));
+    assert(allclose(grad_v[0][1], grad_v[1][1], 1e-5f, 1e-5f));
+
+    CheckpointStatistics stats = FloatD::checkpoint_stats_();
+    assert(stats.regions == 1 && stats.nodes > 20);
+    assert(stats.bytes_total > 0 && stats.bytes_peak == stats.bytes_total);
+
+    /* Regions that don't depend on differentiable variables */
+    FloatD y = checkpoint([](const FloatD &x) { return x * 2.f; }, FloatD(1.f));
+    assert(y.index_() == 0 && y == 2.f);
+}
+
+ENOKI_TEST(test42_hvp) {
+    auto f = [](const auto &p) {
+        return hsum(sin(p.x()) * sqr(p.y()) + exp(p.x() * p.z()) +
+                    p.y() * p.z() + 3.f * p.x());
+    };
+
+    auto grad = [&](const Vector3fX &p) {
+        Vector3fD pd(p);
+        set_requires_gradient(pd);
+        backward(f(pd));
+        return Vector3fX(gradient(pd));
+    };
+
+    size_t size = 100;
+    Vector3fX p(linspace<FloatX>(-1.f, 1.f, size),
+                linspace<FloatX>(0.f, 2.f, size),
+                linspace<FloatX>(.5f, 1.f, size)),
+              v(linspace<FloatX>(1.f, -1.f, size),
+                linspace<FloatX>(.5f, 1.5f, size),
+                linspace<FloatX>(-2.f, 0.f, size));
+
+    /* Compare against central differences of the gradient */
+    Vector3fX hv = hvp(f, Vector3fD(p), Vector3fD(v));
+    const float eps = 1e-2f;
+    Vector3fX fd = (grad(p + eps * v) - grad(p - eps * v)) * (.5f / eps);
+    for (size_t i = 0; i < 3; ++i)
+        assert(allclose(hv[i], fd[i], 1e-3f, 1e-3f));
+
+    /* Scalar-valued differentiable arrays, and linear functions */
+    FloatD x = linspace<FloatD>(-1.f, 1.f, size),
+           w = linspace<FloatD>(2.f, 3.f, size);
+    FloatX hv2 = hvp([](const auto &x) { return hsum(x * x * x); }, x, w);
+    assert(allclose(hv2, 6.f * detach(x) * detach(w)));
+    FloatX hv3 = hvp([](const auto &x) { return hsum(2.f * x); }, x, w);
+    assert(hv3.size() == size && all(eq(hv3, 0.f)));
+}
+
+ENOKI_TEST(test43_jacobian_sparse) {
+    /* Tridiagonal Jacobian: y_i = sin(x_{i-1}) * x_i + x_{i+1}^2 */
+    size_t n = 50;
+    std::vector<FloatD> x(n), y(n + 1);
+    for (size_t i = 0; i < n; ++i) {
+        x[i] = FloatD(.1f * (float) i);
+        set_requires_gradient(x[i]);
+    }
+    for (size_t i = 0; i < n; ++i) {
+        y[i] = x[i];
+        if (i > 0)
+            y[i] *= sin(x[i - 1]);
+        if (i + 1 < n)
+            y[i] += sqr(x[i + 1]);
+    }
+    y[n] = FloatD(1.f); /* Constant output: empty row */
+
+    std::vector<FloatD> inputs = x;
+    inputs.push_back(FloatD(2.f)); /* Constant input: empty column */
+
+    SparseJacobian<float> jac = jacobian_sparse(y, inputs);
+    assert(jac.rows == n + 1 && jac.cols == n + 1);
+    assert(jac.colors == 3);
+    assert(jac.row_offset.size() == n + 2 && jac.row_offset[n] == jac.row_offset[n + 1]);
+    assert(jac.col_index.size() == 3 * n - 2);
+
+    for (size_t i = 0; i < n; ++i) {
+        float xm = i > 0 ? .1f * (float) (i - 1) : 0.f,
+              xi = .1f * (float) i,
+              xp = .1f * (float) (i + 1);
+        for (uint32_t k = jac.row_offset[i]; k < jac.row_offset[i + 1]; ++k) {
+            uint32_t j = jac.col_index[k];
+            float ref;
+            if (j + 1 == i)
+                ref = std::cos(xm) * xi;
+            else if (j == i)
+                ref = i > 0 ? std::sin(xm) : 1.f;
+            else if (j == i + 1)
+                ref = 2.f * xp;
+            else
+                ref = -1.f;
+            assert(std::abs(jac.values[k] - ref) < 1e-5f);
+        }
+    }
+
+    /* Compare a row against a reverse-mode pass */
+    backward(y[7]);
+    for (uint32_t k = jac.row_offset[7]; k < jac.row_offset[8]; ++k)
+        assert(std::abs(gradient(x[jac.col_index[k]]).coeff(0) - jac.values[k]) < 1e-5f);
+}
+
+ENOKI_TEST(test44_edge_kinds) {
+    /* Unit, negated, scalar, zero, merged and full edge weights */
+    FloatD x = linspace<FloatD>(0.f, 1.f, 10), c = 3.f;
+    set_requires_gradient(x);
+    set_requires_gradient(c);
+    FloatD y = (x + c) - x * 2.f + (-x) * 0.f + x / 4.f + c * x + (x + x) * x;
+    backward(hsum(y));
+    assert(allclose(gradient(x), 2.25f + 4.f * detach(x)));
+    assert(allclose(gradient(c), 10.f + hsum(detach(x))));
+}
+
+ENOKI_TEST(test45_freeze) {
+    FloatX xv = linspace<FloatX>(0.f, 1.f, 10);
+    FloatX gy = linspace<FloatX>(1.f, 2.f, 10), tx = linspace<FloatX>(-1.f, 1.f, 10);
+    FrozenGraph<FloatX> graph;
+    {
+        FloatD x = xv, w = 2.f, u = 3.f;
+        set_requires_gradient(x);
+        set_requires_gradient(w);
+        FloatD y = sin(x) * w + sqr(x), s = hsum(y * x);
+        graph = freeze(std::vector<FloatD>{ y, s }, std::vector<FloatD>{ x, w, u });
+    }
+    assert(graph.input_count() == 3 && graph.output_count() == 2);
+
+    /* Replay after the original graph was freed */
+    FloatX dy = cos(xv) * 2.f + 2.f * xv, y = sin(xv) * 2.f + sqr(xv);
+    for (float gs : { .5f, 2.f }) {
+        std::vector<FloatX> g = graph.backward({ gy, FloatX(gs) });
+        assert(g.size() == 3);
+        assert(allclose(g[0], gy * dy + gs * (dy * xv + y)));
+        assert(allclose(g[1], hsum(gy * sin(xv)) + gs * hsum(sin(xv) * xv)));
+        assert(g[2] == zero<FloatX>(1));
+    }
+
+    for (float tw : { 0.f, 1.f }) {
+        std::vector<FloatX> t = graph.forward({ tx, FloatX(tw), FloatX(1.f) });
+        assert(t.size() == 2);
+        assert(allclose(t[0], dy * tx + sin(xv) * tw));
+        assert(allclose(t[1], hsum((dy * xv + y) * tx + sin(xv) * xv * tw)));
+    }
+
+    /* Special edges can't be copied */
+    FloatD x = xv;
+    set_requires_gradient(x);
+    FloatD z = gather<FloatD>(x * x, UInt32D(1, 2, 3));
+    bool thrown = false;
+    try {
+        freeze(std::vector<FloatD>{ z }, std::vector<FloatD>{ x });
+    } catch (const std::runtime_error &) {
+        thrown = true;
+    }
+    assert(thrown);
+}
+
+ENOKI_TEST(test46_simplify_cost_model) {
+    /* Same gradients with and without graph simplification */
+    FloatX ref;
+    for (int simplify = 0; simplify < 2; ++simplify) {
+        FloatD x = linspace<FloatD>(0.f, 1.f, 100), w = 2.f;
+        set_requires_gradient(x);
+        set_requires_gradient(w);
+        FloatD y = x;
+        for (int i = 0; i < 10; ++i)
+            y = (y + w) * .5f + sin(y) * x - w;
+        FloatD s = hsum(y);
+        if (simplify)
+            my_backward(s);
+        else
+            backward(s);
+        if (simplify)
+            assert(allclose(gradient(x), ref));
+        else
+            ref = gradient(x);
+    }
+    std::string stats = FloatD::whos_();
+    assert(stats.find("Graph simplification") != std::string::npos);
+    assert(stats.find(": 0 collapsed") == std::string::npos);
+}
+
+ENOKI_TEST(test47_dump_graph) {
+    FloatD x = linspace<FloatD>(0.f, 1.f, 10), c = 3.f;
+    set_requires_gradient(x);
+    set_requires_gradient(c);
+    set_label(x, "x");
+    FloatD y = (x + c) * x - x;
+    set_label(y, "y");
+
+    std::stringstream ss;
+    dump_graph(y, ss);
+    GraphDump dump = read_graph(ss);
+    assert(dump.scalar_size == sizeof(float));
+
+    /* Nodes in topological order (sources first), output last */
+    const GraphDump::Node &out = dump.nodes.back();
+    assert(out.index == y.index_() && out.size == 10);
+    assert(dump.label(out) == "'y'" && dump.label(dump.nodes.front()) == "'x'");
+
+    size_t full = 0, unit = 0;
+    for (const GraphDump::Edge &edge : dump.edges) {
+        full += edge.kind == GraphDump::EdgeKind::Full;
+        unit += edge.kind == GraphDump::EdgeKind::Identity ||
+                edge.kind == GraphDump::EdgeKind::Negate;
+    }
+    assert(dump.nodes.size() == 5 && full == 2 && unit == 4);
+    assert(dump.weight_bytes() == 2 * 10 * sizeof(float));
+
+    /* Operation names and prefixes are kept at the default log level */
+    size_t n_mul = 0;
+    for (const GraphDump::Node &node : dump.nodes)
+        n_mul += dump.label(node) == "mul";
+    assert(n_mul == 1);
+
+    FloatD::push_prefix_("scope");
+    FloatD z = sin(x) * x + 2.f;
+    FloatD::pop_prefix_();
+    std::string gv = graphviz(z);
+    assert(gv.find("label=\"scope\"") != std::string::npos);
+    assert(gv.find("sin") != std::string::npos && gv.find("E/I") != std::string::npos);
+
+    /* The entire tape contains at least the same nodes */
+    std::stringstream ss2;
+    dump_graph<FloatD>(ss2);
+    assert(read_graph(ss2).nodes.size() >= dump.nodes.size());
+
+    /* Truncated dumps are detected */
+    std::string data = ss.str();
+    std::stringstream ss3(data.substr(0, data.size() - 3));
+    bool thrown = false;
+    try {
+        read_graph(ss3);
+    } catch (const std::runtime_error &) {
+        thrown = true;
+    }
+    assert(thrown);
+}
+
+ENOKI_TEST(test48_profiler) {
+    FloatD::profile_reset_();
+    FloatD::set_profiling_(true);
+
+    FloatD x = linspace<FloatD>(0.f, 1.f, 1000);
+    set_requires_gradient(x);
+    FloatD::push_prefix_("layer1");
+    FloatD y = sin(x) * x;
+    FloatD::pop_prefix_();
+    FloatD::push_prefix_("layer2");
+    FloatD z = sin(y) + y;
+    FloatD::pop_prefix_();
+    backward(hsum(z));
+    FloatD::set_profiling_(false);
+
+    std::vector<ProfileEntry> profile = FloatD::profile_();
+    size_t sin_nodes = 0, nodes = 0;
+    for (const ProfileEntry &entry : profile) {
+        nodes += entry.backward_nodes;
+        if (entry.label == "sin") {
+            sin_nodes += entry.backward_nodes;
+            assert(entry.weight_bytes == 1000 * sizeof(float));
+            assert(entry.grad_bytes == 1000 * sizeof(float));
+        }
+        assert(entry.forward_nodes == 0);
+    }
+    assert(sin_nodes == 2 && nodes >= 5);
+
+    /* Merged per prefix, ordered by decreasing time */
+    std::vector<ProfileEntry> scopes = FloatD::profile_(true);
+    size_t found = 0;
+    for (size_t i = 0; i < scopes.size(); ++i) {
+        assert(scopes[i].label.empty());
+        if (scopes[i].prefix == "layer1" || scopes[i].prefix == "layer2") {
+            assert(scopes[i].backward_nodes == 2);
+            found++;
+        }
+        if (i > 0)
+            assert(scopes[i - 1].backward_time >= scopes[i].backward_time);
+    }
+    assert(found == 2);
+
+    FloatD::profile_reset_();
+    assert(FloatD::profile_().empty());
+}
+
+ENOKI_TEST(test49_tape_context) {
+    auto job = [](float scale) {
+        FloatD x = linspace<FloatD>(0.f, 1.f, 100);
+        set_requires_gradient(x);
+        for (int i = 0; i < 50; ++i) {
+            FloatD y = hsum(sin(x * scale) * x);
+            backward(y);
+            FloatX ref = cos(detach(x) * scale) * scale * detach(x) + sin(detach(x) * scale);
+            if (!allclose(gradient(x), ref))
+                return false;
+        }
+        return true;
+    };
+
+    /* Independent jobs on separate tapes */
+    std::vector<std::thread> threads;
+    std::vector<int> result(4, 0);
+    for (int i = 0; i < 4; ++i) {
+        threads.emplace_back([&, i]() {
+            TapeContext<FloatX> context;
+            TapeScope<FloatX> scope(context);
+            result[i] = job(1.f + (float) i) ? 1 : 0;
+        });
+    }
+    for (auto &thread : threads)
+        thread.join();
+    assert(result == std::vector<int>(4, 1));
+
+    /* Scopes nest, and variables of the global tape remain intact */
+    FloatD x = 2.f;
+    set_requires_gradient(x);
+    FloatD y = x * x;
+    {
+        TapeContext<FloatX> context;
+        TapeScope<FloatX> scope(context);
+        assert(job(3.f));
+    }
+    backward(y);
+    assert(gradient(x) == FloatX(4.f));
+}
+
+ENOKI_TEST(test50_tape_context_after_global) {
+    /* Record on the global tape and on a context within the same function */
+    FloatD a = 1.f;
+    set_requires_gradient(a);
+    set_label(a, "global_a");
+    FloatD b = a * a;
+    {
+        TapeContext<FloatX> context;
+        TapeScope<FloatX> scope(context);
+        FloatD x = 3.f;
+        set_requires_gradient(x);
+        set_label(x, "context_x");
+        FloatD y = x * x;
+        std::string w = FloatD::whos_();
+        assert(w.find("context_x") != std::string::npos);
+        assert(w.find("global_a") == std::string::npos);
+        backward(y);
+        assert(gradient(x) == FloatX(6.f));
+    }
+    std::string w = FloatD::whos_();
+    assert(w.find("context_x") == std::string::npos);
+    assert(w.find("global_a") != std::string::npos);
+    backward(b);
+    assert(gradient(a) == FloatX(2.f));
+}
+
+ENOKI_TEST(test51_freeze_eval) {
+    FloatX xv = linspace<FloatX>(0.1f, 1.f, 10), gy = linspace<FloatX>(1.f, 2.f, 10);
+    FloatX c = linspace<FloatX>(-1.f, 1.f, 10);
+    FrozenGraph<FloatX> graph;
+    {
+        FloatD::set_record_primal_(true);
+        FloatD x = xv, w = 2.f;
+        set_requires_gradient(x);
+        set_requires_gradient(w);
+        FloatD y = sin(x) * w + sqr(x) + select(FloatD(c) > 0.f, exp(x), x / w),
+               s = hsum(y * x);
+        graph = freeze(std::vector<FloatD>{ y, s }, std::vector<FloatD>{ x, w });
+        FloatD::set_record_primal_(false);
+    }
+    assert(graph.replayable());
+
+    /* Re-evaluate at new input values after the original graph was freed */
+    for (float offset : { 0.f, .5f, 1.f }) {
+        FloatX x = xv + offset, w = FloatX(2.f + offset);
+        std::vector<FloatX> out = graph.eval({ x, w });
+        FloatX y  = sin(x) * w + sqr(x) + select(c > 0.f, exp(x), x / w),
+               dy = cos(x) * w + 2.f * x + select(c > 0.f, exp(x), rcp(w)),
+               dw = sin(x) - select(c > 0.f, zero<FloatX>(10), x / sqr(w));
+        assert(out.size() == 2);
+        assert(allclose(out[0], y) && allclose(out[1], hsum(y * x)));
+
+        std::vector<FloatX> g = graph.backward({ gy, FloatX(1.f) });
+        assert(allclose(g[0], gy * dy + dy * x + y));
+        assert(allclose(g[1], hsum(gy * dw + dw * x)));
+
+        std::vector<FloatX> t = graph.forward({ FloatX(1.f), FloatX(0.f) });
+        assert(allclose(t[0], dy));
+    }
+
+    /* Graphs recorded without operands can't be re-evaluated */
+    FloatD x = xv;
+    set_requires_gradient(x);
+    FloatD y = x * x;
+    FrozenGraph<FloatX> graph2 = freeze(std::vector<FloatD>{ y }, std::vector<FloatD>{ x });
+    assert(!graph2.replayable());
+    bool thrown = false;
+    try {
+        graph2.eval({ xv });
+    } catch (const std::runtime_error &) {
+        thrown = true;
+    }
+    assert(thrown);
+}
+
+ENOKI_TEST(test52_freeze_eval_ops) {
+    /* Every operation supported by FrozenGraph::eval() must produce the same
+       values and derivatives as the DiffArray implementation at a new point */
+    using Func = FloatD (*)(const FloatD *);
+    struct Case { ReplayOp op; size_t n_args; Func f; };
+    const Case cases[] = {
+        { ReplayOp::Add,    2, [](const FloatD *a) { return a[0].add_(a[1]); } },
+        { ReplayOp::Sub,    2, [](const FloatD *a) { return a[0].sub_(a[1]); } },
+        { ReplayOp::Mul,    2, [](const FloatD *a) { return a[0].mul_(a[1]); } },
+        { ReplayOp::Div,    2, [](const FloatD *a) { return a[0].div_(a[1]); } },
+        { ReplayOp::Fmadd,  3, [](const FloatD *a) { return a[0].fmadd_(a[1], a[2]); } },
+        { ReplayOp::Fmsub,  3, [](const FloatD *a) { return a[0].fmsub_(a[1], a[2]); } },
+        { ReplayOp::Fnmadd, 3, [](const FloatD *a) { return a[0].fnmadd_(a[1], a[2]); } },
+        { ReplayOp::Fnmsub, 3, [](const FloatD *a) { return a[0].fnmsub_(a[1], a[2]); } },
+        { ReplayOp::Neg,    1, [](const FloatD *a) { return a[0].neg_(); } },
+        { ReplayOp::Abs,    1, [](const FloatD *a) { return a[0].sub_(FloatD(.45f)).abs_(); } },
+        { ReplayOp::Sqrt,   1, [](const FloatD *a) { return a[0].sqrt_(); } },
+        { ReplayOp::Cbrt,   1, [](const FloatD *a) { return a[0].cbrt_(); } },
+        { ReplayOp::Rcp,    1, [](const FloatD *a) { return a[0].rcp_(); } },
+        { ReplayOp::Rsqrt,  1, [](const FloatD *a) { return a[0].rsqrt_(); } },
+        { ReplayOp::Min,    2, [](const FloatD *a) { return a[0].min_(a[1]); } },
+        { ReplayOp::Max,    2, [](const FloatD *a) { return a[0].max_(a[1]); } },
+        { ReplayOp::Select, 2, [](const FloatD *a) {
+              FloatD c = linspace<FloatD>(-1.f, 1.f, 10);
+              return FloatD::select_(c > 0.f, a[0], a[1]);
+          } },
+        { ReplayOp::Sin,    1, [](const FloatD *a) { return a[0].sin_(); } },
+        { ReplayOp::Cos,    1, [](const FloatD *a) { return a[0].cos_(); } },
+        { ReplayOp::Tan,    1, [](const FloatD *a) { return a[0].tan_(); } },
+        { ReplayOp::Csc,    1, [](const FloatD *a) { return a[0].csc_(); } },
+        { ReplayOp::Sec,    1, [](const FloatD *a) { return a[0].sec_(); } },
+        { ReplayOp::Cot,    1, [](const FloatD *a) { return a[0].cot_(); } },
+        { ReplayOp::Asin,   1, [](const FloatD *a) { return a[0].asin_(); } },
+        { ReplayOp::Acos,   1, [](const FloatD *a) { return a[0].acos_(); } },
+        { ReplayOp::Atan,   1, [](const FloatD *a) { return a[0].atan_(); } },
+        { ReplayOp::Atan2,  2, [](const FloatD *a) { return a[0].atan2_(a[1]); } },
+        { ReplayOp::Sinh,   1, [](const FloatD *a) { return a[0].sinh_(); } },
+        { ReplayOp::Cosh,   1, [](const FloatD *a) { return a[0].cosh_(); } },
+        { ReplayOp::Csch,   1, [](const FloatD *a) { return a[0].csch_(); } },
+        { ReplayOp::Sech,   1, [](const FloatD *a) { return a[0].sech_(); } },
+        { ReplayOp::Tanh,   1, [](const FloatD *a) { return a[0].tanh_(); } },
+        { ReplayOp::Asinh,  1, [](const FloatD *a) { return a[0].asinh_(); } },
+        { ReplayOp::Acosh,  1, [](const FloatD *a) { return a[0].add_(FloatD(1.f)).acosh_(); } },
+        { ReplayOp::Atanh,  1, [](const FloatD *a) { return a[0].atanh_(); } },
+        { ReplayOp::Exp,    1, [](const FloatD *a) { return a[0].exp_(); } },
+        { ReplayOp::Log,    1, [](const FloatD *a) { return a[0].log_(); } },
+        { ReplayOp::Hsum,   1, [](const FloatD *a) { return a[0].hsum_(); } },
+        { ReplayOp::Hprod,  1, [](const FloatD *a) { return a[0].mul_(FloatD(2.f)).hprod_(); } },
+    };
+    assert(sizeof(cases) / sizeof(Case) == (size_t) ReplayOp::Hprod + 1);
+
+    /* The point of the replay moves the operands of 'min', 'max' and 'abs'
+       across their branches */
+    auto input = [](size_t k, float shift) {
+        switch (k) {
+            case 0:  return linspace<FloatX>(.1f, .8f, 10) + shift;
+            case 1:  return linspace<FloatX>(.8f, .2f, 10) - .5f * shift;
+            default: return linspace<FloatX>(.3f, .6f, 10) + .25f * shift;
+        }
+    };
+
+    for (size_t i = 0; i < sizeof(cases) / sizeof(Case); ++i) {
+        const Case &c = cases[i];
+        assert((size_t) c.op == i);
+
+        FrozenGraph<FloatX> graph;
+        {
+            FloatD::set_record_primal_(true);
+            std::vector<FloatD> x;
+            for (size_t k = 0; k < c.n_args; ++k) {
+                x.emplace_back(input(k, 0.f));
+                set_requires_gradient(x.back());
+            }
+            FloatD y = c.f(x.data());
+            graph = freeze(std::vector<FloatD>{ y }, x);
+            FloatD::set_record_primal_(false);
+        }
+        assert(graph.replayable());
+
+        for (float shift : { .05f, .1f }) {
+            std::vector<FloatD> x;
+            std::vector<FloatX> xv;
+            for (size_t k = 0; k < c.n_args; ++k) {
+                xv.push_back(input(k, shift));
+                x.emplace_back(xv.back());
+                set_requires_gradient(x.back());
+            }
+            FloatD y = c.f(x.data());
+            FloatX grad_y = full<FloatX>(1.f, slices(y));
+            FloatD s = hsum(y);
+            backward(s);
+
+            std::vector<FloatX> out = graph.eval(xv);
+            assert(allclose(out[0], detach(y), 1e-5f, 1e-6f));
+            std::vector<FloatX> g = graph.backward({ grad_y });
+            for (size_t k = 0; k < c.n_args; ++k)
+                assert(allclose(g[k], gradient(x[k]), 1e-5f, 1e-6f));
+        }
+    }
+}
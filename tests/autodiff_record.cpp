@@ -0,0 +1,109 @@
+/*
+    tests/autodiff_record.cpp -- benchmarks the recording and replay of
+    computation graphs consisting of many small operations
+
+    Enoki is a C++ template library that enables transparent vectorization
+    of numerical kernels using SIMD instruction sets available on current
+    processor architectures.
+
+    Copyright (c) 2019 Wenzel Jakob <wenzel.jakob@epfl.ch>
+
+    All rights reserved. Use of this source code is governed by a BSD-style
+    license that can be found in the LICENSE file.
+*/
+
+#include <enoki/dynamic.h>
+#include <enoki/autodiff.h>
+#include <chrono>
+#include <iostream>
+
+using namespace enoki;
+
+using FloatX  = DynamicArray<Packet<float>>;
+using FloatDS = DiffArray<float>;
+using FloatDX = DiffArray<FloatX>;
+
+auto clk() { return std::chrono::high_resolution_clock::now(); }
+
+template <typename T> float clkdiff(T a, T b) {
+    return std::chrono::duration<float>(b - a).count() * 1000;
+}
+
+/// Record 'reps' graphs of 'n' steps z = sin(z) + z * 0.5 (3 nodes each) and differentiate them
+template <typename Float>
+void benchmark(const char *name, size_t reps, size_t n, bool labels = false) {
+    float time_record = 0.f, time_backward = 0.f;
+    Float::set_profiling_(labels);
+
+    for (size_t rep = 0; rep < reps; ++rep) {
+        Float x = 0.5f;
+        set_requires_gradient(x);
+
+        auto time_start = clk();
+        Float z = x;
+        for (size_t i = 0; i < n; ++i)
+            z = sin(z) + z * 0.5f;
+        auto time_mid = clk();
+        backward(z);
+        auto time_end = clk();
+
+        time_record += clkdiff(time_start, time_mid);
+        time_backward += clkdiff(time_mid, time_end);
+    }
+
+    Float::set_profiling_(false);
+    Float::profile_reset_();
+
+    float nodes = (float) (reps * n * 3);
+    std::cerr << name << ": recorded " << nodes * 1e-6f << "M nodes in "
+              << time_record << " ms (" << nodes / (time_record * 1e3f)
+              << "M nodes/s), backward: " << time_backward << " ms" << std::endl;
+}
+
+/// Differentiate the same graph at 'reps' leaf values, by recording it anew or via FrozenGraph::eval()
+template <typename Float>
+void benchmark_replay(const char *name, size_t reps, size_t n) {
+    using Value = value_t<Float>;
+    float time_record = 0.f, time_replay = 0.f;
+
+    for (size_t rep = 0; rep < reps; ++rep) {
+        auto time_start = clk();
+        Float x = 0.5f + (float) rep * 1e-3f;
+        set_requires_gradient(x);
+        Float z = x;
+        for (size_t i = 0; i < n; ++i)
+            z = sin(z) + z * 0.5f;
+        backward(z);
+        time_record += clkdiff(time_start, clk());
+    }
+
+    FrozenGraph<Value> graph;
+    {
+        Float::set_record_primal_(true);
+        Float x = 0.5f;
+        set_requires_gradient(x);
+        Float z = x;
+        for (size_t i = 0; i < n; ++i)
+            z = sin(z) + z * 0.5f;
+        graph = freeze(std::vector<Float>{ z }, std::vector<Float>{ x });
+        Float::set_record_primal_(false);
+    }
+
+    for (size_t rep = 0; rep < reps; ++rep) {
+        auto time_start = clk();
+        graph.eval({ Value(0.5f + (float) rep * 1e-3f) });
+        graph.backward({ Value(1.f) });
+        time_replay += clkdiff(time_start, clk());
+    }
+
+    std::cerr << name << ": " << reps << " x record + backward: " << time_record
+              << " ms, eval + backward: " << time_replay << " ms" << std::endl;
+}
+
+int main(int /* argc */, char ** /* argv */) {
+    benchmark<FloatDS>("DiffArray<float>", 50, 20000);
+    benchmark<FloatDS>("DiffArray<float>, labels", 50, 20000, true);
+    benchmark<FloatDX>("DiffArray<FloatX>", 5, 20000);
+    benchmark_replay<FloatDS>("DiffArray<float>", 50, 20000);
+    return 0;
+}
@@ -154,3 +154,88 @@ ENOKI_TEST(test03_call_with_structure) {
     assert(all_nested(eq(t, Vector3f(2, 3, 4))));
     delete a;
 }
+
+ENOKI_TEST(test04_call_dynamic_partition) {
+    std::vector<Test *> instances;
+    for (int i = 0; i < 100; ++i)
+        instances.push_back(new Test(i * 1000));
+
+    size_t n = 10007;
+    TestX pointers;
+    Int32X index = arange<Int32X>(n), ref;
+    set_slices(pointers, n);
+    set_slices(ref, n);
+
+    for (size_t i = 0; i < n; ++i) {
+        size_t k = (i * 7919) % 101;
+        pointers.coeff(i) = k < 100 ? instances[k] : nullptr;
+        ref.coeff(i) = k < 100 ? int32_t(i + k * 1000) : 0;
+    }
+
+    auto partitioned = partition(pointers);
+    assert(partitioned.size() == 101);
+    size_t total = 0;
+    for (auto &[instance, perm] : partitioned) {
+        for (size_t i = 0; i < perm.size(); ++i)
+            assert(pointers.coeff(perm.coeff(i)) == instance);
+        total += perm.size();
+    }
+    assert(total == n);
+
+    Int32X result = pointers->func1(index);
+    assert(result == ref);
+
+    for (Test *t : instances)
+        delete t;
+}
+
+ENOKI_TEST(test05_call_dynamic_compaction) {
+    Test *a = new Test(10), *b = new Test(20);
+
+    size_t n = 1000;
+    TestX pointers;
+    Int32X index = arange<Int32X>(n), ref;
+    set_slices(pointers, n);
+    set_slices(ref, n);
+
+    /* 'a' covers 90% of the entries, 'b' 5%, the rest is empty */
+    for (size_t i = 0; i < n; ++i) {
+        size_t k = i % 20;
+        pointers.coeff(i) = k < 18 ? a : (k == 18 ? b : nullptr);
+        ref.coeff(i) = k < 18 ? int32_t(i + 10) : (k == 18 ? int32_t(i + 20) : 0);
+    }
+
+    float threshold = call_compaction_threshold();
+    call_set_stats_enabled(true);
+
+    for (float t : { 0.f, .5f, 2.f }) {
+        call_set_compaction_threshold(t);
+        call_stats_reset();
+
+        Int32X result = pointers->func1(index);
+        assert(result == ref);
+
+        CallStatistics stats = call_stats();
+        assert(stats.calls == 1 && stats.instances == 2);
+        assert(stats.lanes_active == 950);
+        if (t == 0.f) {
+            assert(stats.masked == 2 && stats.compacted == 0);
+            assert(stats.lanes_processed == 2 * n);
+        } else if (t == .5f) {
+            assert(stats.masked == 1 && stats.compacted == 1);
+            assert(stats.lanes_processed == n + 50);
+        } else {
+            assert(stats.masked == 0 && stats.compacted == 2);
+            assert(stats.utilization() == 1.f);
+        }
+    }
+
+    call_set_stats_enabled(false);
+    call_set_compaction_threshold(threshold);
+    call_stats_reset();
+    Int32X result = pointers->func1(index);
+    assert(result == ref && call_stats().calls == 0);
+
+    delete a;
+    delete b;
+}
@@ -0,0 +1,312 @@
+/*
+    tests/cpu.cpp -- tests the CPU tracing JIT backend
+
+    Enoki is a C++ template library that enables transparent vectorization
+    of numerical kernels using SIMD instruction sets available on current
+    processor architectures.
+
+    Copyright (c) 2019 Wenzel Jakob <wenzel.jakob@epfl.ch>
+
+    All rights reserved. Use of this source code is governed by a BSD-style
+    license that can be found in the LICENSE file.
+*/
+
+#include "test.h"
+#include <enoki/cpu.h>
+#include <sys/stat.h>
+
+using FloatC   = CPUArray<float>;
+using DoubleC  = CPUArray<double>;
+using Int32C   = CPUArray<int32_t>;
+using UInt32C  = CPUArray<uint32_t>;
+using UInt64C  = CPUArray<uint64_t>;
+using MaskC    = mask_t<FloatC>;
+using Vector3fC = Array<FloatC, 3>;
+
+ENOKI_TEST(test01_cpu_arithmetic) {
+    FloatC x = arange<FloatC>(1000),
+           y = fmadd(x, x, 2.f) - x / 4.f;
+    assert(y.size() == 1000);
+    for (size_t i = 0; i < 1000; i += 37) {
+        float xi = (float) i;
+        assert(std::abs(y[i] - (xi * xi + 2.f - xi / 4.f)) <= 1e-6f * (xi * xi + 2.f));
+    }
+
+    /* Scalars broadcast, and the trace can be extended after evaluation */
+    FloatC z = y + 1.f;
+    assert(z[999] == y[999] + 1.f);
+    assert(hsum(FloatC(1.f, 2.f, 3.f))[0] == 6.f);
+    assert(FloatC(3.f).size() == 1);
+
+    DoubleC l = linspace<DoubleC>(0.0, 1.0, 11);
+    assert(std::abs(l[5] - .5) < 1e-12 && l[10] == 1.0);
+
+    FloatC w = zero<FloatC>(10) + full<FloatC>(2.f, 10);
+    assert(w.size() == 10 && w[9] == 2.f);
+}
+
+ENOKI_TEST(test02_cpu_math) {
+    FloatC x = linspace<FloatC>(-3.f, 3.f, 101),
+           s = sin(x), c = cos(x), e = exp(x),
+           l = log(abs(x) + 1.f), r = sqrt(abs(x)),
+           f = floor(x), t = tanh(x);
+    for (size_t i = 0; i < 101; ++i) {
+        float xi = x[i];
+        assert(std::abs(s[i] - std::sin(xi)) < 1e-6f);
+        assert(std::abs(c[i] - std::cos(xi)) < 1e-6f);
+        assert(std::abs(e[i] - std::exp(xi)) < 1e-5f * std::exp(xi));
+        assert(std::abs(l[i] - std::log(std::abs(xi) + 1.f)) < 1e-6f);
+        assert(std::abs(r[i] - std::sqrt(std::abs(xi))) < 1e-6f);
+        assert(std::abs(t[i] - std::tanh(xi)) < 1e-6f);
+        assert(f[i] == std::floor(xi));
+    }
+}
+
+ENOKI_TEST(test03_cpu_masks) {
+    FloatC x = arange<FloatC>(100);
+    MaskC m = x > 50.f && x <= 90.f;
+    assert(count(m) == 40 && any(m) && !all(m) && none(x < 0.f));
+
+    FloatC y = select(m, x, -x);
+    assert(y[50] == -50.f && y[51] == 51.f && y[91] == -91.f);
+
+    FloatC z = x;
+    z[x < 10.f] = 0.f;
+    assert(z[9] == 0.f && z[10] == 10.f);
+
+    FloatC c = compress(x, m);
+    assert(c.size() == 40 && c[0] == 51.f && c[39] == 90.f);
+}
+
+ENOKI_TEST(test04_cpu_gather_scatter) {
+    FloatC src = arange<FloatC>(16) * 2.f;
+    UInt32C idx(3u, 1u, 4u, 1u, 5u);
+
+    FloatC g = gather<FloatC>(src, idx);
+    assert(g.size() == 5 && g[0] == 6.f && g[3] == 2.f && g[4] == 10.f);
+
+    FloatC g2 = gather<FloatC>(src, idx, idx > 2u);
+    assert(g2[0] == 6.f && g2[1] == 0.f);
+
+    FloatC dst = empty<FloatC>(8);
+    scatter(dst, FloatC(0.f) + arange<FloatC>(8), arange<UInt32C>(8));
+    scatter_add(dst, FloatC(10.f, 20.f, 30.f), UInt32C(0u, 0u, 7u));
+    assert(dst[0] == 30.f && dst[1] == 1.f && dst[7] == 37.f);
+}
+
+ENOKI_TEST(test05_cpu_horizontal) {
+    Int32C x = arange<Int32C>(10) - 3;
+    assert(hsum(x)[0] == 15 && hmax(x)[0] == 6 && hmin(x)[0] == -3);
+    assert(hprod(Int32C(1, 2, 3, 4))[0] == 24);
+
+    Int32C p = psum(x), r = reverse(x);
+    assert(p[0] == -3 && p[9] == 15 && r[0] == 6 && r[9] == -3);
+}
+
+ENOKI_TEST(test06_cpu_integer) {
+    UInt32C x = arange<UInt32C>(64) * 12345u + 7u;
+    Int32C  xi(x);
+    FloatC  xf(x);
+    assert(xi[10] == 123457 && xf[10] == 123457.f);
+    assert(Int32C(FloatC(-2.5f, 2.5f))[0] == -2);
+
+    UInt32C bits = reinterpret_array<UInt32C>(FloatC(1.f));
+    assert(bits[0] == 0x3f800000u);
+
+    assert((x >> 3)[10] == (123457u >> 3) && (x << 4)[10] == (123457u << 4));
+    assert((x & 0xFFu)[10] == (123457u & 0xFFu) && (x ^ x)[10] == 0u);
+    assert(popcnt(x)[10] == 7 && lzcnt(x)[10] == 15 && tzcnt(UInt32C(8u))[0] == 3);
+    assert(lzcnt(UInt32C(0u))[0] == 32 && (x % 10u)[10] == 7u);
+    assert(mulhi(UInt32C(0x80000000u), UInt32C(6u))[0] == 3u);
+
+    UInt64C y = UInt64C(x) << 20;
+    assert(y[10] == (uint64_t) 123457 << 20);
+
+    /* Bitwise operations on floating point values */
+    FloatC z = linspace<FloatC>(-1.f, 1.f, 3);
+    assert(abs(z)[0] == 1.f && mulsign(FloatC(2.f), z)[0] == -2.f);
+}
+
+ENOKI_TEST(test07_cpu_nested) {
+    Vector3fC v(arange<FloatC>(10), 1.f, 2.f);
+    FloatC n = norm(v);
+    assert(std::abs(n[3] - std::sqrt(14.f)) < 1e-6f);
+
+    Vector3fC w = normalize(v);
+    assert(std::abs(w.x()[3] * n[3] - 3.f) < 1e-5f);
+}
+
+ENOKI_TEST(test08_cpu_kernel_cache) {
+    char dir[] = "/tmp/enoki-cache-XXXXXX";
+    assert(mkdtemp(dir) != nullptr);
+    setenv("ENOKI_CACHE_DIR", dir, 1);
+
+    auto run = []() {
+        FloatC x = arange<FloatC>(100);
+        FloatC y = x * 1234.5f + 6789.f;
+        assert(y[99] == 99.f * 1234.5f + 6789.f);
+    };
+
+    auto stats = []() {
+        size_t hits, hits_disk, misses;
+        cpu_kernel_cache_stats(&hits, &hits_disk, &misses);
+        return std::make_tuple(hits, hits_disk, misses);
+    };
+
+    /* A fresh context with an empty cache directory compiles the kernel */
+    cpu_init();
+    run();
+    assert(stats() == std::make_tuple((size_t) 0, (size_t) 0, (size_t) 1));
+
+    /* ... and reuses it when the same trace is evaluated again */
+    run();
+    assert(stats() == std::make_tuple((size_t) 1, (size_t) 0, (size_t) 1));
+
+    /* A new context (e.g. another process) loads it from disk */
+    cpu_init();
+    run();
+    assert(stats() == std::make_tuple((size_t) 0, (size_t) 1, (size_t) 0));
+
+    cpu_shutdown();
+    unsetenv("ENOKI_CACHE_DIR");
+    std::string cmd = std::string("rm -rf ") + dir;
+    assert(system(cmd.c_str()) == 0);
+}
+
+ENOKI_TEST(test09_cpu_interpreter) {
+    auto run = []() {
+        FloatC x = linspace<FloatC>(-3.f, 3.f, 1001);
+        UInt32C i = arange<UInt32C>(1001) * 2654435761u;
+        MaskC m = x > 0.5f || x < -2.f;
+
+        FloatC table = arange<FloatC>(100) * 0.5f, dst = zero<FloatC>(100);
+        scatter_add(dst, x, i % 100u, m);
+
+        return std::make_tuple(
+            FloatC(fmadd(sin(x), exp(x), 1.f / (abs(x) + 1.f))),
+            FloatC(select(m, floor(x * 2.f), sqrt(abs(x)))),
+            UInt32C(popcnt(i) + lzcnt(i) * 3u + tzcnt(i) + (i >> 7) + mulhi(i, 12345u)),
+            Int32C(Int32C(x * 100.f) - Int32C(i & 0xFFu)),
+            FloatC(gather<FloatC>(table, i % 100u, m)),
+            dst);
+    };
+
+    auto compiled = run();
+    cpu_set_interpreter(true);
+    size_t launches_0, ops_0, ops_max_0;
+    cpu_kernel_stats(&launches_0, &ops_0, &ops_max_0);
+    auto interpreted = run();
+    cpu_set_interpreter(false);
+
+    size_t launches, ops, ops_max;
+    cpu_kernel_stats(&launches, &ops, &ops_max);
+    assert(launches > launches_0 && ops > ops_0 && ops_max >= 20);
+
+    for (size_t k = 0; k < 1001; ++k) {
+        float a = std::get<0>(compiled)[k], b = std::get<0>(interpreted)[k];
+        assert(std::abs(a - b) <= 1e-6f * std::max(std::abs(a), 1.f));
+        assert(std::get<1>(compiled)[k] == std::get<1>(interpreted)[k]);
+        assert(std::get<2>(compiled)[k] == std::get<2>(interpreted)[k]);
+        assert(std::get<3>(compiled)[k] == std::get<3>(interpreted)[k]);
+        assert(std::get<4>(compiled)[k] == std::get<4>(interpreted)[k]);
+    }
+    for (size_t k = 0; k < 100; ++k) {
+        float a = std::get<5>(compiled)[k], b = std::get<5>(interpreted)[k];
+        assert(std::abs(a - b) <= 1e-5f * std::max(std::abs(a), 1.f));
+    }
+}
+
+ENOKI_TEST(test10_cpu_schedule) {
+    /* Kernel fusion and dead code elimination (src/trace.h, shared with the
+       CUDA backend) exercised through the interpreter */
+    cpu_set_interpreter(true);
+    FloatC x = linspace<FloatC>(0.f, 1.f, 100), w = linspace<FloatC>(1.f, 2.f, 50);
+    cpu_eval();
+
+    auto run = [&](bool dead_code, size_t &launches, size_t &ops) {
+        size_t launches_0, ops_0, ops_max;
+        cpu_kernel_stats(&launches_0, &ops_0, &ops_max);
+
+        FloatC y = x * 2.f + 1.f, tmp = y * y, z = tmp + x, v = w * w;
+        if (dead_code) {
+            FloatC dead = sin(x) * 3.f + tmp;
+            FloatC dead2 = dead * dead;
+        }
+        tmp = FloatC();
+        cpu_eval();
+
+        cpu_kernel_stats(&launches, &ops, &ops_max);
+        launches -= launches_0;
+        ops -= ops_0;
+
+        for (size_t k = 0; k < 100; ++k) {
+            float xk = (float) k / 99.f, yk = xk * 2.f + 1.f;
+            assert(std::abs(z[k] - (yk * yk + xk)) <= 1e-5f);
+            if (k < 50) {
+                float wk = 1.f + (float) k / 49.f;
+                assert(std::abs(v[k] - wk * wk) <= 1e-5f);
+            }
+        }
+
+        /* Evaluated variables are loaded rather than recomputed */
+        size_t launches_1, ops_1;
+        cpu_kernel_stats(&launches_0, &ops_0, &ops_max);
+        FloatC z2 = z + y;
+        cpu_eval();
+        cpu_kernel_stats(&launches_1, &ops_1, &ops_max);
+        assert(launches_1 - launches_0 == 1 && ops_1 - ops_0 == 1);
+        assert(std::abs(z2[7] - (z[7] + y[7])) <= 1e-6f);
+    };
+
+    size_t launches_ref, ops_ref, launches, ops;
+    run(false, launches_ref, ops_ref);
+    run(true, launches, ops);
+    cpu_set_interpreter(false);
+
+    /* One kernel per array size, and no work for unreferenced variables */
+    assert(launches_ref == 2 && launches == 2);
+    assert(ops == ops_ref);
+}
+
+ENOKI_TEST(test11_cpu_paths_and_large_kernels) {
+    /* Temporary and cache directories whose names must be quoted */
+    char dir[] = "/tmp/enoki dir'XXXXXX";
+    assert(mkdtemp(dir) != nullptr);
+    std::string tmp = std::string(dir) + "/tmp dir",
+                cache = std::string(dir) + "/cache dir";
+    assert(mkdir(tmp.c_str(), 0700) == 0);
+
+    const char *tmp_old = getenv("TMPDIR");
+    std::string tmp_old_value = tmp_old ? tmp_old : "";
+    setenv("TMPDIR", tmp.c_str(), 1);
+    setenv("ENOKI_CACHE_DIR", cache.c_str(), 1);
+    cpu_init();
+    bool interpret = cpu_interpreter();
+    cpu_set_interpreter(false);
+
+    /* Kernels exceeding the block size of parallel launches (if enabled),
+       with and without side effects */
+    size_t n = 1000000;
+    FloatC x = arange<FloatC>(n), y = x * 2.f + 1.f,
+           hist = zero<FloatC>(1000);
+    scatter_add(hist, full<FloatC>(1.f, n), arange<UInt32C>(n) % 1000u);
+
+    for (size_t k : { (size_t) 0, (size_t) 16383, (size_t) 16384, (size_t) 654321, n - 1 })
+        assert(y[k] == (float) k * 2.f + 1.f);
+    for (size_t k = 0; k < 1000; ++k)
+        assert(hist[k] == 1000.f);
+
+    size_t hits, hits_disk, misses;
+    cpu_kernel_cache_stats(&hits, &hits_disk, &misses);
+    assert(misses > 0);
+
+    cpu_set_interpreter(interpret);
+    cpu_shutdown();
+    unsetenv("ENOKI_CACHE_DIR");
+    if (tmp_old)
+        setenv("TMPDIR", tmp_old_value.c_str(), 1);
+    else
+        unsetenv("TMPDIR");
+    std::string cmd = std::string("rm -rf \"") + dir + "\"";
+    assert(system(cmd.c_str()) == 0);
+}
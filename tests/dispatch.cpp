@@ -0,0 +1,85 @@
+/*
+    tests/dispatch.cpp -- tests runtime selection of functions compiled for
+    several instruction sets
+
+    Enoki is a C++ template library that enables transparent vectorization
+    of numerical kernels using SIMD instruction sets available on current
+    processor architectures.
+
+    Copyright (c) 2019 Wenzel Jakob <wenzel.jakob@epfl.ch>
+
+    All rights reserved. Use of this source code is governed by a BSD-style
+    license that can be found in the LICENSE file.
+*/
+
+#include "test.h"
+#include "dispatch.h"
+#include <vector>
+
+ENOKI_TEST(test01_dispatch_isa) {
+    Isa isa = host_isa();
+    assert(isa >= Isa::Generic && isa <= Isa::AVX512_SKX);
+    assert(host_isa() == isa);
+    assert(strcmp(isa_name(Isa::AVX2), "avx2") == 0);
+
+    /* The dispatcher forwards to the variant matching the host */
+    size_t expected = kernels::generic::packet_size();
+#if defined(ENOKI_DISPATCH_HAS_SSE42)
+    if (isa >= Isa::SSE42)
+        expected = kernels::sse42::packet_size();
+    assert(kernels::sse42::packet_size() == 4);
+#endif
+#if defined(ENOKI_DISPATCH_HAS_AVX)
+    if (isa >= Isa::AVX)
+        expected = kernels::avx::packet_size();
+    assert(kernels::avx::packet_size() == 8);
+#endif
+#if defined(ENOKI_DISPATCH_HAS_AVX2)
+    if (isa >= Isa::AVX2)
+        expected = kernels::avx2::packet_size();
+    assert(kernels::avx2::packet_size() == 8);
+#endif
+#if defined(ENOKI_DISPATCH_HAS_AVX512_SKX)
+    if (isa >= Isa::AVX512_SKX)
+        expected = kernels::avx512_skx::packet_size();
+    assert(kernels::avx512_skx::packet_size() == 16);
+#endif
+    assert(kernels::packet_size() == expected);
+}
+
+ENOKI_TEST(test02_dispatch_variants) {
+    using Func = void (*)(const float *, float *, size_t);
+    std::vector<std::pair<Isa, Func>> variants = {
+        { Isa::Generic, &kernels::generic::falloff },
+#if defined(ENOKI_DISPATCH_HAS_SSE42)
+        { Isa::SSE42, &kernels::sse42::falloff },
+#endif
+#if defined(ENOKI_DISPATCH_HAS_AVX)
+        { Isa::AVX, &kernels::avx::falloff },
+#endif
+#if defined(ENOKI_DISPATCH_HAS_AVX2)
+        { Isa::AVX2, &kernels::avx2::falloff },
+#endif
+#if defined(ENOKI_DISPATCH_HAS_AVX512_SKX)
+        { Isa::AVX512_SKX, &kernels::avx512_skx::falloff },
+#endif
+        { host_isa(), &kernels::falloff }
+    };
+
+    const size_t n = 1027;
+    std::vector<float> x(n), y(n);
+    for (size_t i = 0; i < n; ++i)
+        x[i] = -5.f + 10.f * (float) i / (float) (n - 1);
+
+    for (auto const &v : variants) {
+        /* Only run variants that are supported by this machine */
+        if (v.first > host_isa())
+            continue;
+        std::fill(y.begin(), y.end(), 0.f);
+        v.second(x.data(), y.data(), n);
+        for (size_t i = 0; i < n; ++i) {
+            float ref = std::exp(-x[i] * x[i] * .25f) * std::sqrt(std::abs(x[i]) + 1.f);
+            assert(std::abs(y[i] - ref) < 1e-6f);
+        }
+    }
+}
@@ -0,0 +1,22 @@
+/*
+    tests/dispatch.h -- functions compiled once per instruction set (see
+    dispatch_kernel.cpp)
+
+    Enoki is a C++ template library that enables transparent vectorization
+    of numerical kernels using SIMD instruction sets available on current
+    processor architectures.
+
+    Copyright (c) 2019 Wenzel Jakob <wenzel.jakob@epfl.ch>
+
+    All rights reserved. Use of this source code is governed by a BSD-style
+    license that can be found in the LICENSE file.
+*/
+
+#pragma once
+
+#include <enoki/dispatch.h>
+
+NAMESPACE_BEGIN(kernels)
+ENOKI_DISPATCH(size_t, packet_size, (), ())
+ENOKI_DISPATCH(void, falloff, (const float *x, float *y, size_t n), (x, y, n))
+NAMESPACE_END(kernels)
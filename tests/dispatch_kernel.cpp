@@ -0,0 +1,37 @@
+/*
+    tests/dispatch_kernel.cpp -- compiled once per instruction set via
+    enoki_dispatch_sources()
+
+    Enoki is a C++ template library that enables transparent vectorization
+    of numerical kernels using SIMD instruction sets available on current
+    processor architectures.
+
+    Copyright (c) 2019 Wenzel Jakob <wenzel.jakob@epfl.ch>
+
+    All rights reserved. Use of this source code is governed by a BSD-style
+    license that can be found in the LICENSE file.
+*/
+
+#include <enoki/array.h>
+#include "dispatch.h"
+
+ENOKI_DISPATCH_BEGIN(kernels)
+
+using namespace enoki;
+using FloatP = Packet<float>;
+
+template <typename Value> Value falloff(Value x) {
+    return exp(-x * x * .25f) * sqrt(abs(x) + 1.f);
+}
+
+size_t packet_size() { return FloatP::Size; }
+
+void falloff(const float *x, float *y, size_t n) {
+    size_t i = 0;
+    for (; i + FloatP::Size <= n; i += FloatP::Size)
+        store_unaligned(y + i, falloff(load_unaligned<FloatP>(x + i)));
+    for (; i < n; ++i)
+        y[i] = falloff(Array<float, 1>(x[i])).x();
+}
+
+ENOKI_DISPATCH_END(kernels)
@@ -0,0 +1,173 @@
+/*
+    tests/dual.cpp -- tests forward mode differentiation using dual numbers
+
+    Enoki is a C++ template library that enables transparent vectorization
+    of numerical kernels using SIMD instruction sets available on current
+    processor architectures.
+
+    Copyright (c) 2019 Wenzel Jakob <wenzel.jakob@epfl.ch>
+
+    All rights reserved. Use of this source code is governed by a BSD-style
+    license that can be found in the LICENSE file.
+*/
+
+#include "test.h"
+#include <enoki/dual.h>
+#include <enoki/matrix.h>
+#include <enoki/special.h>
+
+using Float    = float;
+using FloatP   = Packet<Float>;
+using DoubleP  = Packet<double>;
+using Dual2f   = DualArray<Float, 2>;
+using Dual1d   = DualArray<double, 1>;
+using Dual3fP  = DualArray<FloatP, 3>;
+using Vector3d = Array<Dual2f, 3>;
+
+/// Compare the tangent of 'func' against central finite differences on [lo, hi]
+template <typename Func> void check_derivative(Func func, double lo, double hi) {
+    const double eps = 1e-6;
+    for (size_t i = 0; i < 11; ++i) {
+        double xv = lo + (hi - lo) * double(i) / 10.0;
+        Dual1d x = xv;
+        set_tangent(x, 0, 1.0);
+        Dual1d y  = func(x),
+               y0 = func(Dual1d(xv - eps)),
+               y1 = func(Dual1d(xv + eps));
+        double fd = (detach(y1) - detach(y0)) * (.5 / eps);
+        assert(std::abs(tangent(y, 0) - fd) <= 1e-5 * std::max(std::abs(fd), 1.0));
+    }
+}
+
+ENOKI_TEST(test01_dual_arithmetic) {
+    Dual2f x = 3.f, y = 5.f;
+    set_tangent(x, 0, 1.f);
+    set_tangent(y, 1, 1.f);
+
+    Dual2f z = fmadd(x, y, x / y) - sqr(x) + 2.f;
+    assert(detach(z) == 3.f * 5.f + 3.f / 5.f - 9.f + 2.f);
+    assert(std::abs(tangent(z, 0) - (5.f + 1.f / 5.f - 6.f)) < 1e-6f);
+    assert(std::abs(tangent(z, 1) - (3.f - 3.f / 25.f)) < 1e-6f);
+
+    /* Constants have zero tangents */
+    Dual2f c(4.f);
+    assert(tangent(c, 0) == 0.f && tangent(c, 1) == 0.f);
+    assert(tangent(c * x, 0) == 4.f && tangent(c * x, 1) == 0.f);
+    assert(tangent(floor(x * y), 0) == 0.f);
+}
+
+ENOKI_TEST(test02_dual_math) {
+    auto check = [](auto func, double lo, double hi) {
+        check_derivative(func, lo, hi);
+    };
+    check([](auto x) { return sin(x); }, -3, 3);
+    check([](auto x) { return cos(x); }, -3, 3);
+    check([](auto x) { return tan(x); }, -1, 1);
+    check([](auto x) { return cot(x); }, .1, 1);
+    check([](auto x) { return csc(x); }, .1, 1);
+    check([](auto x) { return asin(x); }, -.9, .9);
+    check([](auto x) { return acos(x); }, -.9, .9);
+    check([](auto x) { return atan(x); }, -3, 3);
+    check([](auto x) { return atan2(x, x * x + 1.0); }, -3, 3);
+    check([](auto x) { return atan2(1.0 - x, x); }, .1, 3);
+    check([](auto x) { return sinh(x); }, -3, 3);
+    check([](auto x) { return cosh(x); }, -3, 3);
+    check([](auto x) { return tanh(x); }, -3, 3);
+    check([](auto x) { return asinh(x); }, -3, 3);
+    check([](auto x) { return acosh(x); }, 1.1, 3);
+    check([](auto x) { return atanh(x); }, -.9, .9);
+    check([](auto x) { return exp(x); }, -3, 3);
+    check([](auto x) { return log(x); }, .1, 3);
+    check([](auto x) { return pow(x, 2.5); }, .1, 3);
+    check([](auto x) { return sqrt(x); }, .1, 3);
+    check([](auto x) { return cbrt(x); }, .1, 3);
+    check([](auto x) { return rsqrt(x); }, .1, 3);
+    check([](auto x) { return rcp(x); }, .1, 3);
+    check([](auto x) { return abs(x) * x; }, -3, 3);
+    check([](auto x) { return hypot(x, 2.0); }, -3, 3);
+    check([](auto x) { return copysign(2.0, x) * x; }, .1, 3);
+    check([](auto x) { return mulsign(x, x - 1.0); }, -2.9, 3.1);
+    check([](auto x) { return min(x, x * x) + max(x, -x); }, -2.9, 3.1);
+    check([](auto x) { return ldexp(x, Dual1d(3.0)); }, -3, 3);
+}
+
+ENOKI_TEST(test03_dual_special) {
+    auto check = [](auto func, double lo, double hi) {
+        check_derivative(func, lo, hi);
+    };
+    check([](auto x) { return erf(x); }, -3, 3);
+    check([](auto x) { return erfinv(x); }, -.9, .9);
+    check([](auto x) { return lgamma(x); }, .2, 5);
+    check([](auto x) { return tgamma(x); }, .2, 5);
+    check([](auto x) { return dawson(x); }, -3, 3);
+
+    /* Analytic derivative of erf() */
+    Dual3fP x = linspace<FloatP>(-2.f, 2.f);
+    set_tangent(x, 2, 1.f);
+    Dual3fP y = erf(x);
+    FloatP ref = Float(M_2_SQRTPI) * exp(-sqr(detach(x)));
+    assert(all(abs(tangent(y, 2) - ref) < 1e-5f));
+    assert(all(eq(tangent(y, 0), 0.f)));
+}
+
+ENOKI_TEST(test04_dual_vector_matrix) {
+    /* Gradient of a vector norm along two directions */
+    Vector3d v(1.f, 2.f, 3.f);
+    set_tangent(v, 0, Array<Float, 3>(1.f, 0.f, 0.f));
+    set_tangent(v, 1, Array<Float, 3>(0.f, 1.f, 1.f));
+    Dual2f n = norm(v);
+    Float n_ref = std::sqrt(14.f);
+    assert(std::abs(detach(n) - n_ref) < 1e-6f);
+    assert(std::abs(tangent(n, 0) - 1.f / n_ref) < 1e-6f);
+    assert(std::abs(tangent(n, 1) - 5.f / n_ref) < 1e-6f);
+
+    Array<Float, 3> tv = tangent(normalize(v), 1);
+    Array<Float, 3> dir(0.f, 1.f, 1.f), vd(1.f, 2.f, 3.f);
+    Array<Float, 3> tv_ref = (dir - vd * dot(vd, dir) / 14.f) / n_ref;
+    assert(hmax(abs(tv - tv_ref)) < 1e-6f);
+
+    /* Derivative of a matrix inverse: d(A^-1) = -A^-1 dA A^-1 */
+    using Matrix3f = Matrix<Float, 3>;
+    using Matrix3d = Matrix<Dual2f, 3>;
+    Matrix3f a(4.f, 1.f, 2.f,
+               0.f, 3.f, 1.f,
+               1.f, 0.f, 5.f),
+             da(0.f, 1.f, 0.f,
+                2.f, 0.f, 0.f,
+                0.f, 0.f, 1.f);
+    Matrix3d ad(a);
+    set_tangent(ad, 0, da);
+    Matrix3d inv = inverse(ad);
+    Matrix3f inv_ref = inverse(a),
+             dinv_ref = -inv_ref * da * inv_ref;
+    assert(hmax_nested(abs(detach(inv) - inv_ref)) < 1e-6f);
+    assert(hmax_nested(abs(tangent(inv, 0) - dinv_ref)) < 1e-5f);
+    assert(hmax_nested(abs(tangent(inv, 1))) == 0.f);
+    assert(std::abs(tangent(det(ad), 0) - det(a) * trace(inv_ref * da)) < 1e-4f);
+}
+
+ENOKI_TEST(test05_dual_masks_horizontal) {
+    Dual3fP x = linspace<FloatP>(-1.f, 1.f);
+    set_tangent(x, 0, 1.f);
+    set_tangent(x, 1, detach(x));
+
+    /* Select and masked assignment */
+    Dual3fP y = select(x > 0.f, x * x, -x);
+    y[x > .5f] = 2.f * x;
+    FloatP xv = detach(x),
+           t0 = select(xv > .5f, 2.f, select(xv > 0.f, 2.f * xv, -1.f));
+    assert(tangent(y, 0) == t0);
+    assert(tangent(y, 1) == t0 * xv);
+    assert(all(eq(tangent(y, 2), 0.f)));
+
+    /* Horizontal operations produce scalar dual numbers */
+    DualArray<Float, 3> s = hsum(x * x), m = hmax(x);
+    assert(std::abs(tangent(s, 0) - 2.f * hsum(xv)) < 1e-5f);
+    assert(std::abs(tangent(s, 1) - 2.f * hsum(xv * xv)) < 1e-5f);
+    assert(detach(m) == hmax(xv) && tangent(m, 0) == 1.f &&
+           tangent(m, 1) == detach(m));
+
+    /* Conversion between precisions preserves tangents */
+    DualArray<DoubleP, 3> xd(x);
+    assert(tangent(xd, 1) == DoubleP(xv));
+}
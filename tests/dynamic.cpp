@@ -316,3 +316,76 @@ ENOKI_TEST(array_float_04_test09_mask_packet) { test09_packet_from_struct<float,
 ENOKI_TEST(array_float_08_test09_mask_packet) { test09_packet_from_struct<float,   8>();  }
 ENOKI_TEST(array_float_16_test09_mask_packet) { test09_packet_from_struct<float,   16>();  }
 ENOKI_TEST(array_float_32_test09_mask_packet) { test09_packet_from_struct<float,   32>();  }
+
+template <typename T, size_t PacketSize> void test10_psum() {
+    using ValueX = DynamicArray<Array<T, PacketSize>>;
+
+    for (size_t n : { 1, 5, 100, 40000 }) {
+        ValueX x;
+        set_slices(x, n);
+        for (size_t i = 0; i < n; ++i)
+            x.coeff(i) = T(i % 5);
+
+        ValueX incl = psum(x),
+               excl = psum_exclusive(x);
+
+        T accum = 0;
+        for (size_t i = 0; i < n; ++i) {
+            assert(excl.coeff(i) == accum);
+            accum += x.coeff(i);
+            assert(incl.coeff(i) == accum);
+        }
+        assert(hsum(x) == accum);
+    }
+}
+
+ENOKI_TEST(array_int32_04_test10_psum) { test10_psum<int32_t, 4>();  }
+ENOKI_TEST(array_int32_08_test10_psum) { test10_psum<int32_t, 8>();  }
+ENOKI_TEST(array_int32_16_test10_psum) { test10_psum<int32_t, 16>(); }
+ENOKI_TEST(array_int32_32_test10_psum) { test10_psum<int32_t, 32>(); }
+ENOKI_TEST(array_float_04_test10_psum) { test10_psum<float,   4>();  }
+ENOKI_TEST(array_float_08_test10_psum) { test10_psum<float,   8>();  }
+ENOKI_TEST(array_float_16_test10_psum) { test10_psum<float,   16>(); }
+ENOKI_TEST(array_float_32_test10_psum) { test10_psum<float,   32>(); }
+
+template <typename T, size_t PacketSize> void test11_lazy() {
+    using ValueX = DynamicArray<Array<T, PacketSize>>;
+
+    for (size_t n : { 1, 5, 100, 40000 }) {
+        ValueX a = arange<ValueX>(n) * T(0.25) + T(1),
+               b = a * T(2), c(T(3));
+
+        ValueX r1 = lazy(a) * b + c,
+               r2 = fmadd(lazy(a), b, T(1)) - sqrt(lazy(b)) / T(2),
+               r3 = eval(min(-lazy(a), c) + max(T(2) * lazy(a), b));
+
+        for (size_t i = 0; i < n; ++i) {
+            T ai = a.coeff(i), bi = b.coeff(i);
+            T ref1 = ai * bi + T(3),
+              ref2 = ai * bi + T(1) - std::sqrt(bi) / T(2);
+            assert(std::abs(r1.coeff(i) - ref1) <= T(1e-6) * ref1);
+            assert(std::abs(r2.coeff(i) - ref2) <= T(1e-6) * ref2);
+            assert(r3.coeff(i) == -ai + bi);
+        }
+
+        /* Expressions may reference the array they are assigned to */
+        ValueX d = a;
+        d = lazy(d) * d + T(1);
+        assert(d.size() == n);
+        for (size_t i = 0; i < n; ++i)
+            assert(d.coeff(i) == a.coeff(i) * a.coeff(i) + T(1));
+    }
+
+    bool caught = false;
+    try {
+        ValueX bad = lazy(ValueX(T(1), T(2))) + ValueX(T(1), T(2), T(3));
+    } catch (const std::runtime_error &) {
+        caught = true;
+    }
+    assert(caught);
+}
+
+ENOKI_TEST(array_float_04_test11_lazy) { test11_lazy<float, 4>();  }
+ENOKI_TEST(array_float_08_test11_lazy) { test11_lazy<float, 8>();  }
+ENOKI_TEST(array_float_16_test11_lazy) { test11_lazy<float, 16>(); }
+ENOKI_TEST(array_float_32_test11_lazy) { test11_lazy<float, 32>(); }
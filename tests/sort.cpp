@@ -0,0 +1,110 @@
+/*
+    tests/sort.cpp -- tests radix sort, argsort and key-value sort
+
+    Enoki is a C++ template library that enables transparent vectorization
+    of numerical kernels using SIMD instruction sets available on current
+    processor architectures.
+
+    Copyright (c) 2019 Wenzel Jakob <wenzel.jakob@epfl.ch>
+
+    All rights reserved. Use of this source code is governed by a BSD-style
+    license that can be found in the LICENSE file.
+*/
+
+#include "test.h"
+#include <enoki/sort.h>
+#include <enoki/random.h>
+#include <algorithm>
+#include <vector>
+
+template <typename T> void test01_sort() {
+    using ValueX  = DynamicArray<Packet<T>>;
+    using UInt64P = Packet<uint64_t, Packet<T>::Size>;
+    using RNG     = PCG32<UInt64P>;
+
+    for (size_t size : { 0, 1, 2, 17, 1000, 200001 }) {
+        ValueX x;
+        set_slices(x, size);
+
+        RNG rng;
+        for (size_t i = 0; i < size; ++i) {
+            uint64_t r = rng.next_uint64().coeff(0);
+            T value;
+            if constexpr (std::is_floating_point_v<T>)
+                value = T((int64_t) (r % 20001) - 10000) * T(.5);
+            else if constexpr (std::is_signed_v<T>)
+                value = T(r);
+            else
+                value = T(r % 1000);
+            x.coeff(i) = value;
+        }
+
+        std::vector<T> ref(size);
+        for (size_t i = 0; i < size; ++i)
+            ref[i] = x.coeff(i);
+        std::stable_sort(ref.begin(), ref.end());
+
+        ValueX sorted = sort(x);
+        auto perm = argsort(x);
+        assert(sorted.size() == size && perm.size() == size);
+
+        for (size_t i = 0; i < size; ++i) {
+            assert(sorted.coeff(i) == ref[i]);
+            assert(x.coeff(perm.coeff(i)) == ref[i]);
+            /* Stability */
+            if (i > 0 && ref[i - 1] == ref[i])
+                assert(perm.coeff(i - 1) < perm.coeff(i));
+        }
+    }
+}
+
+ENOKI_TEST(test01_sort_int32)  { test01_sort<int32_t>();  }
+ENOKI_TEST(test01_sort_uint32) { test01_sort<uint32_t>(); }
+ENOKI_TEST(test01_sort_int64)  { test01_sort<int64_t>();  }
+ENOKI_TEST(test01_sort_uint64) { test01_sort<uint64_t>(); }
+ENOKI_TEST(test01_sort_float)  { test01_sort<float>();    }
+ENOKI_TEST(test01_sort_double) { test01_sort<double>();   }
+
+ENOKI_TEST(test02_sort_special_floats) {
+    using FloatX = DynamicArray<Packet<float>>;
+    float inf = std::numeric_limits<float>::infinity();
+    FloatX x = { 3.f, -0.f, inf, -1.f, 0.f, -inf, 1e-30f, -1e30f };
+    FloatX y = sort(x);
+    FloatX ref = { -inf, -1e30f, -1.f, -0.f, 0.f, 1e-30f, 3.f, inf };
+    for (size_t i = 0; i < ref.size(); ++i)
+        assert(memcmp(&y.coeff(i), &ref.coeff(i), sizeof(float)) == 0);
+}
+
+template <typename Value> struct Record {
+    Value time;
+    Array<Value, 2> pos;
+    ENOKI_STRUCT(Record, time, pos)
+};
+
+ENOKI_STRUCT_SUPPORT(Record, time, pos)
+
+ENOKI_TEST(test03_sort_by_key) {
+    using UInt32X = DynamicArray<Packet<uint32_t>>;
+    using FloatX  = DynamicArray<Packet<float>>;
+
+    size_t size = 1001;
+    UInt32X keys = (arange<UInt32X>(size) * 7919u) % 101u;
+    Record<FloatX> records;
+    set_slices(records, size);
+    records.time = arange<FloatX>(size);
+    records.pos.x() = arange<FloatX>(size) * 2.f;
+    records.pos.y() = arange<FloatX>(size) * 3.f;
+
+    auto [keys2, records2] = sort_by_key(keys, records);
+    for (size_t i = 0; i < size; ++i) {
+        size_t j = (size_t) records2.time.coeff(i);
+        assert(keys.coeff(j) == keys2.coeff(i));
+        assert(records2.pos.x().coeff(i) == 2.f * (float) j);
+        assert(records2.pos.y().coeff(i) == 3.f * (float) j);
+        if (i > 0) {
+            assert(keys2.coeff(i - 1) <= keys2.coeff(i));
+            if (keys2.coeff(i - 1) == keys2.coeff(i))
+                assert(records2.time.coeff(i - 1) < records2.time.coeff(i));
+        }
+    }
+}
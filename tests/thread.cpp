@@ -0,0 +1,233 @@
+/*
+    tests/thread.cpp -- tests the work-stealing thread pool
+
+    Enoki is a C++ template library that enables transparent vectorization
+    of numerical kernels using SIMD instruction sets available on current
+    processor architectures.
+
+    Copyright (c) 2019 Wenzel Jakob <wenzel.jakob@epfl.ch>
+
+    All rights reserved. Use of this source code is governed by a BSD-style
+    license that can be found in the LICENSE file.
+*/
+
+#include "test.h"
+#include <enoki/thread.h>
+#include <atomic>
+
+using Float   = float;
+using FloatP  = Packet<Float>;
+using FloatX  = DynamicArray<FloatP>;
+using UInt32P = Packet<uint32_t>;
+using UInt32X = DynamicArray<UInt32P>;
+
+ENOKI_TEST(test01_parallel_for) {
+    for (size_t size : { 0, 1, 7, 1000, 123457 }) {
+        for (size_t grain : { 1, 3, 64, 1000000 }) {
+            std::unique_ptr<std::atomic<uint32_t>[]> visited(
+                new std::atomic<uint32_t>[size]);
+            for (size_t i = 0; i < size; ++i)
+                visited[i] = 0;
+
+            parallel_for(size, grain, [&](size_t begin, size_t end) {
+                assert(begin < end && end <= size && end - begin <= grain);
+                for (size_t i = begin; i < end; ++i)
+                    visited[i]++;
+            });
+
+            for (size_t i = 0; i < size; ++i)
+                assert(visited[i] == 1);
+        }
+    }
+}
+
+ENOKI_TEST(test02_parallel_for_nested) {
+    std::atomic<size_t> count { 0 };
+    parallel_for(64, 1, [&](size_t, size_t) {
+        parallel_for(100, 7, [&](size_t begin, size_t end) {
+            count += end - begin;
+        });
+    });
+    assert(count == 6400);
+}
+
+ENOKI_TEST(test03_parallel_for_exception) {
+    bool caught = false;
+    try {
+        parallel_for(1000, 10, [&](size_t begin, size_t) {
+            if (begin == 500)
+                throw std::runtime_error("test");
+        });
+    } catch (const std::runtime_error &e) {
+        caught = std::string(e.what()) == "test";
+    }
+    assert(caught);
+}
+
+ENOKI_TEST(test04_vectorize_parallel) {
+    size_t size = 1000003;
+    FloatX x = linspace<FloatX>(-10.f, 10.f, size),
+           y = linspace<FloatX>(3.f, 4.f, size);
+
+    auto func = [](auto &&x, auto &&y) {
+        return sin(x) * y + exp(-x * x);
+    };
+
+    FloatX ref = vectorize(func, x, y),
+           result = vectorize_parallel(func, x, y);
+
+    assert(result.size() == size);
+    assert(memcmp(ref.data(), result.data(), size * sizeof(Float)) == 0);
+}
+
+ENOKI_TEST(test05_vectorize_parallel_inplace) {
+    size_t size = 100001;
+    UInt32X x = arange<UInt32X>(size), y;
+    set_slices(y, size);
+
+    vectorize_parallel(
+        [](auto &&y, auto &&x) { y = x * x + 1u; },
+        y, x
+    );
+
+    assert(y == x * x + 1u);
+}
+
+ENOKI_TEST(test06_vectorize_parallel_safe) {
+    size_t size = 50001;
+    FloatX x = linspace<FloatX>(0.f, 1.f, size);
+    FloatX y = 2.f;
+
+    FloatX result = vectorize_parallel_safe(
+        [](auto &&x, auto &&y) { return x * y; }, x, y);
+
+    assert(y.size() == size);
+    assert(result == x * 2.f);
+}
+
+ENOKI_TEST(test07_parallel_for_packets) {
+    size_t size = 100003;
+    FloatX x = linspace<FloatX>(0.f, 1.f, size), y;
+    set_slices(y, size);
+
+    parallel_for(x, 1000, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i)
+            packet(y, i) = packet(x, i) * 2.f;
+    });
+
+    assert(y == x * 2.f);
+}
+
+ENOKI_TEST(test08_thread_set_count) {
+    size_t count = thread_count();
+
+    for (size_t n : { 1, 2, 5 }) {
+        thread_set_count(n);
+        assert(thread_count() == n);
+
+        std::atomic<size_t> total { 0 };
+        parallel_for(100000, 10, [&](size_t begin, size_t end) {
+            total += end - begin;
+        });
+        assert(total == 100000);
+    }
+
+    thread_set_affinity(true);
+    assert(thread_affinity() && thread_count() == 5);
+    FloatX x = linspace<FloatX>(0.f, 1.f, 100000);
+    assert(vectorize_parallel([](auto &&x) { return x + 1.f; }, x) == x + 1.f);
+    thread_set_affinity(false);
+
+    thread_set_count(count);
+    assert(thread_count() == count);
+}
+
+ENOKI_TEST(test09_parallel_reductions) {
+    size_t size = 3000017, threads = thread_count();
+    FloatX x = sin(linspace<FloatX>(0.f, 1000.f, size)) * 1000.f;
+    auto mask = x > 0.f;
+
+    Float sum = hsum(x), prod = hprod(x * 1e-6f + 1.f), kahan = hsum_kahan(x);
+    for (size_t n : { 1, 3, 8 }) {
+        thread_set_count(n);
+        Float v = hsum_parallel(x);
+        assert(memcmp(&sum, &v, sizeof(Float)) == 0);
+        v = hprod_parallel(x * 1e-6f + 1.f);
+        assert(memcmp(&prod, &v, sizeof(Float)) == 0);
+        v = hsum_kahan_parallel(x);
+        assert(memcmp(&kahan, &v, sizeof(Float)) == 0);
+        assert(hmin_parallel(x) == hmin(x));
+        assert(hmax_parallel(x) == hmax(x));
+        assert(count_parallel(mask) == count(mask));
+        assert(any_parallel(mask) && !all_parallel(mask));
+        assert(all_parallel(x < 2000.f) && !any_parallel(x > 2000.f));
+    }
+    thread_set_count(threads);
+
+    /* Compare against a double precision reference */
+    double ref = 0.0;
+    for (size_t i = 0; i < size; ++i)
+        ref += (double) x.coeff(i);
+    assert(std::abs(kahan - ref) <= std::abs(sum - ref));
+    assert(std::abs(kahan - ref) < 1e-2 * std::abs(ref) + 1.f);
+
+    FloatX empty;
+    assert(hsum_parallel(empty) == 0.f && hsum_kahan_parallel(empty) == 0.f);
+}
+
+ENOKI_TEST(test10_parallel_psum) {
+    size_t threads = thread_count();
+
+    for (size_t size : { 1, 13, 16384, 1000003 }) {
+        UInt32X x = arange<UInt32X>(size) % 7u;
+        FloatX y = sin(linspace<FloatX>(0.f, 100.f, size));
+
+        UInt32X ref_incl, ref_excl;
+        set_slices(ref_incl, size);
+        set_slices(ref_excl, size);
+        uint32_t accum = 0;
+        for (size_t i = 0; i < size; ++i) {
+            ref_excl.coeff(i) = accum;
+            accum += x.coeff(i);
+            ref_incl.coeff(i) = accum;
+        }
+
+        assert(psum(x) == ref_incl);
+        assert(psum_exclusive(x) == ref_excl);
+
+        FloatX y_incl = psum(y), y_excl = psum_exclusive(y);
+        for (size_t n : { 1, 4 }) {
+            thread_set_count(n);
+            assert(psum_parallel(x) == ref_incl);
+            assert(psum_exclusive_parallel(x) == ref_excl);
+            FloatX y2 = psum_parallel(y), y3 = psum_exclusive_parallel(y);
+            assert(memcmp(y2.data(), y_incl.data(), size * sizeof(Float)) == 0);
+            assert(memcmp(y3.data(), y_excl.data(), size * sizeof(Float)) == 0);
+        }
+    }
+
+    thread_set_count(threads);
+}
+
+ENOKI_TEST(test11_parallel_sort) {
+    size_t size = 1000003, threads = thread_count();
+    FloatX x = sin(linspace<FloatX>(0.f, 1000.f, size)) * 1000.f;
+    UInt32X keys = (arange<UInt32X>(size) * 2654435761u) >> 20;
+
+    FloatX x_sorted = sort(x);
+    UInt32X perm = argsort(keys);
+    auto [keys_sorted, x_perm] = sort_by_key(keys, x);
+
+    for (size_t i = 1; i < size; ++i)
+        assert(x_sorted.coeff(i - 1) <= x_sorted.coeff(i));
+
+    for (size_t n : { 1, 4 }) {
+        thread_set_count(n);
+        assert(sort_parallel(x) == x_sorted);
+        assert(argsort_parallel(keys) == perm);
+        auto [keys2, x2] = sort_by_key_parallel(keys, x);
+        assert(keys2 == keys_sorted && x2 == x_perm);
+    }
+
+    thread_set_count(threads);
+}